@@ -60,6 +60,11 @@
  * References:	AGWPE TCP/IP API Tutorial
  *		http://uz7ho.org.ua/includes/agwpeapi.htm
  *
+ *		Nothing here waits for a reply.  Commands can be sent from any
+ *		thread, including the callbacks.  The library keeps track of
+ *		'Y' replies so an application can keep many connected mode
+ *		links busy at once.  See agwlib_outstanding_frames.
+ *
  * Usage:	See  appclient.c and appserver.c  for examples of how to use this.
  *
  *---------------------------------------------------------------*/
@@ -75,6 +80,8 @@
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <errno.h>
 #endif
@@ -167,12 +174,51 @@ struct agw_hdr_s {		/* Command header. */
 };
 
 
-struct agw_cmd_s {		/* Complete command with header and data. */
 
-  struct agw_hdr_s hdr;			/* Command header. */
-  char data[AX25_MAX_PACKET_LEN];	/* Possible variable length data. */
+/*
+ * Keep track of the connected mode links so the application can
+ * do flow control without waiting for a 'Y' reply each time.
+ *
+ * When a 'Y' request is sent, we remember how many data frames had
+ * been sent so far.  When the reply comes back, the number of frames
+ * outstanding is the count in the reply plus everything sent since
+ * the request.  Only one 'Y' request is in flight for each link
+ * so the replies can't get mixed up.
+ */
+
+struct link_s {
+	int in_use;
+	int chan;
+	char own_call[10];		// call_from when we send to the TNC.
+	char remote_call[10];		// call_to when we send to the TNC.
+
+	int sent;			// Number of 'D' data frames sent on this link.
+	int y_pending;			// A 'Y' request has been sent with no reply yet.
+	int y_mark;			// Value of "sent" when the 'Y' request was sent.
+	int y_count;			// Frame count from most recent 'Y' reply, -1 if none yet.
+					// Add (sent - y_mark) to get the current estimate.
+	int disc_pending;		// Disconnect when nothing is outstanding.
 };
 
+#define AGWLIB_MAX_LINKS 128
+
+static struct link_s s_link[AGWLIB_MAX_LINKS];
+static dw_mutex_t s_link_mutex;
+
+static struct link_s *find_link (int chan, char *own_call, char *remote_call, int create);
+static void forget_links (void);
+static void link_housekeeping (void);
+
+
+/*
+ * Several threads can send to the TNC.  For example, the application's
+ * main thread and callbacks from the listening thread.
+ * Don't let the header of one command get mixed up with the data of another.
+ */
+
+static dw_mutex_t s_send_mutex;
+
+static int send_to_tnc (struct agw_hdr_s *hdr, char *data, int data_len);
 
 
 /*-------------------------------------------------------------------
@@ -212,7 +258,7 @@ static int (*s_tnc_init_func)(void);	// Call after establishing socket.
 
 #if __WIN32__
 #define THREAD_F unsigned __stdcall
-#else 
+#else
 #define THREAD_F void *
 #endif
 
@@ -221,7 +267,7 @@ static HANDLE tnc_listen_th;
 static THREAD_F tnc_listen_thread (void *arg);
 #else
 static pthread_t tnc_listen_tid;
-static THREAD_F tnc_listen_thread (void *arg);	
+static THREAD_F tnc_listen_thread (void *arg);
 #endif
 
 
@@ -235,6 +281,10 @@ int agwlib_init (char *host, char *port, int (*init_func)(void))
 	s_tnc_sock = -1;
 	s_tnc_init_func = init_func;
 
+	dw_mutex_init (&s_send_mutex);
+	dw_mutex_init (&s_link_mutex);
+	memset (s_link, 0, sizeof(s_link));
+
 	dwsock_init();
 
 	s_tnc_sock = dwsock_connect (host, port, "TNC", 0, 0, tncaddr);
@@ -290,20 +340,32 @@ int agwlib_init (char *host, char *port, int (*init_func)(void))
  * Outputs:	s_tnc_sock	- File descriptor for communicating with TNC.
  *				  Will be -1 if not connected.
  *
+ * Description:	Read as much as is available, rather than one header and
+ *		one data part at a time, then dispatch every complete
+ *		message in the buffer.  The callbacks get a pointer into
+ *		the receive buffer so the data is not copied again.
+ *
+ *		Wake up at least once a second for link_housekeeping.
+ *
  *--------------------------------------------------------------------*/
 
-static void process_from_tnc (struct agw_cmd_s *cmd);
+static void process_from_tnc (struct agw_hdr_s *hdr, char *data, int data_len);
+
+#define RX_BUF_SIZE (16 * 1024)		// Must be more than header + AX25_MAX_PACKET_LEN + 1.
+					// The last byte is never filled by a receive so
+					// there is always room to terminate the final message.
+
+static char s_rx_buf[RX_BUF_SIZE];
 
 
 #if __WIN32__
 static unsigned __stdcall tnc_listen_thread (void *arg)
 #else
-static void * tnc_listen_thread (void *arg)	
-#endif	
+static void * tnc_listen_thread (void *arg)
+#endif
 {
 	char tncaddr[DWSOCK_IPADDR_LEN];
-
-	struct agw_cmd_s cmd;
+	int rx_len = 0;			// Number of bytes in s_rx_buf.
 
 	while (1) {
 
@@ -318,6 +380,9 @@ static void * tnc_listen_thread (void *arg)
 	    // avoid confusion with the AX.25 connect.
 	    dw_printf ("Attempting to reattach to network TNC...\n");
 
+	    rx_len = 0;
+	    forget_links ();		// Any replies we were waiting for are gone.
+
 	    s_tnc_sock = dwsock_connect (s_tnc_host, s_tnc_port, "TNC", 0, 0, tncaddr);
 
 	    if (s_tnc_sock != -1) {
@@ -335,86 +400,110 @@ static void * tnc_listen_thread (void *arg)
 	    SLEEP_SEC(5);
 	  }
 	  else {
-	    int n = SOCK_RECV (s_tnc_sock, (char *)(&cmd.hdr), sizeof(cmd.hdr));
+	    fd_set readfds;
+	    struct timeval tv;
 
-	    if (n == -1) {
-	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf ("Lost communication with network TNC. Will try to reattach.\n");
-	      dwsock_close (s_tnc_sock);
-	      s_tnc_sock = -1;
+	    FD_ZERO (&readfds);
+	    FD_SET (s_tnc_sock, &readfds);
+	    tv.tv_sec = 1;
+	    tv.tv_usec = 0;
+
+	    if (select (s_tnc_sock + 1, &readfds, NULL, NULL, &tv) == 0) {
+	      link_housekeeping ();
 	      continue;
 	    }
-	    else if (n != sizeof(cmd.hdr)) {
+
+	    // Always keep one byte free for the nul terminator added below.
+
+	    int n = SOCK_RECV (s_tnc_sock, s_rx_buf + rx_len, sizeof(s_rx_buf) - 1 - rx_len);
+
+	    if (n <= 0) {
 	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf ("Error reading message header from network TNC.\n");
-	      dw_printf ("Tried to read %d bytes but got only %d.\n", (int)sizeof(cmd.hdr), n);
-	      dw_printf ("Closing socket to TNC.   Will try to reattach.\n");
+	      dw_printf ("Lost communication with network TNC. Will try to reattach.\n");
 	      dwsock_close (s_tnc_sock);
 	      s_tnc_sock = -1;
 	      continue;
 	    }
+	    rx_len += n;
 
 /*
- * Take some precautions to guard against bad data which could cause problems later.
+ * Process every complete message in the buffer.
  */
-	    if (cmd.hdr.portx < 0 || cmd.hdr.portx >= MAX_CHANS) {
-	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf ("Invalid channel number, %d, in command '%c', from network TNC.\n",
-			cmd.hdr.portx, cmd.hdr.datakind);
-	      cmd.hdr.portx = 0;	// avoid subscript out of bounds, try to keep going.
-	    }
+	    int offset = 0;
 
-/*
- * Call to/from fields are 10 bytes but contents must not exceed 9 characters.
- * It's not guaranteed that unused bytes will contain 0 so we
- * don't issue error message in this case. 
- */
-	    cmd.hdr.call_from[sizeof(cmd.hdr.call_from)-1] = '\0';
-	    cmd.hdr.call_to[sizeof(cmd.hdr.call_to)-1] = '\0';
+	    while (rx_len - offset >= (int)sizeof(struct agw_hdr_s)) {
+
+	      struct agw_hdr_s hdr;
+
+	      memcpy (&hdr, s_rx_buf + offset, sizeof(hdr));	// Buffer might not be aligned.
 
 /*
  * Following data must fit in available buffer.
  * Leave room for an extra nul byte terminator at end later.
  */
+	      int data_len = netle2host(hdr.data_len_NETLE);
 
-	    int data_len = netle2host(cmd.hdr.data_len_NETLE);
-
-	    if (data_len < 0 || data_len > (int)(sizeof(cmd.data) - 1)) {
+	      if (data_len < 0 || data_len > AX25_MAX_PACKET_LEN) {
 
-	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf ("Invalid message from network TNC.\n");
-	      dw_printf ("Data Length of %d is out of range.\n", data_len);
-	
-	      /* This is a bad situation. */
-	      /* If we tried to read again, the header probably won't be there. */
-	      /* No point in trying to continue reading.  */
-
-	      dw_printf ("Closing connection to TNC.\n");
-	      dwsock_close (s_tnc_sock);
-	      s_tnc_sock = -1;
-	      continue;
-	    }
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Invalid message from network TNC.\n");
+	        dw_printf ("Data Length of %d is out of range.\n", data_len);
 
-	    cmd.data[0] = '\0';
+	        /* This is a bad situation. */
+	        /* If we tried to read again, the header probably won't be there. */
+	        /* No point in trying to continue reading.  */
 
-	    if (data_len > 0) {
-	      n = SOCK_RECV (s_tnc_sock, cmd.data, data_len);
-	      if (n != data_len) {
-	        text_color_set(DW_COLOR_ERROR);
-	        dw_printf ("Error getting message data from network TNC.\n");
-	        dw_printf ("Tried to read %d bytes but got only %d.\n", data_len, n);
-	        dw_printf ("Closing socket to network TNC.\n\n");
+	        dw_printf ("Closing connection to TNC.\n");
 	        dwsock_close (s_tnc_sock);
 	        s_tnc_sock = -1;
-	        continue;
+	        break;
 	      }
-	      if (n >= 0) {
-		cmd.data[n] = '\0';	// Terminate so it can be used as a C string.
+
+	      if (rx_len - offset < (int)sizeof(hdr) + data_len) {
+	        break;		// Wait for the rest.
+	      }
+
+/*
+ * Take some precautions to guard against bad data which could cause problems later.
+ */
+	      if (hdr.portx >= MAX_CHANS) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Invalid channel number, %d, in command '%c', from network TNC.\n",
+			hdr.portx, hdr.datakind);
+	        hdr.portx = 0;	// avoid subscript out of bounds, try to keep going.
 	      }
 
-	      process_from_tnc (&cmd);
+/*
+ * Call to/from fields are 10 bytes but contents must not exceed 9 characters.
+ * It's not guaranteed that unused bytes will contain 0 so we
+ * don't issue error message in this case.
+ */
+	      hdr.call_from[sizeof(hdr.call_from)-1] = '\0';
+	      hdr.call_to[sizeof(hdr.call_to)-1] = '\0';
+
+/*
+ * Terminate data so it can be used as a C string.
+ * This clobbers the first byte of the next message, if any, so put it back after.
+ */
+	      char *data = s_rx_buf + offset + sizeof(hdr);
+	      char save = data[data_len];
+
+	      data[data_len] = '\0';
+	      process_from_tnc (&hdr, data, data_len);
+	      data[data_len] = save;
+
+	      offset += sizeof(hdr) + data_len;
+	    }
+
+	    if (s_tnc_sock == -1) {
+	      continue;
+	    }
+
+	    if (offset > 0 && offset < rx_len) {
+	      memmove (s_rx_buf, s_rx_buf + offset, rx_len - offset);
+	    }
+	    rx_len -= offset;
 
-	    } // additional data after command header
 	  } // s_tnc_sock != -1
 	} // while (1)
 
@@ -428,26 +517,35 @@ static void * tnc_listen_thread (void *arg)
  * messages that come from the TNC.
  */
 
-static void process_from_tnc (struct agw_cmd_s *cmd)
+static void process_from_tnc (struct agw_hdr_s *hdr, char *data, int data_len)
 {
-	int data_len = netle2host(cmd->hdr.data_len_NETLE);
-	//int session;
-
+	struct link_s *lp;
 
-	switch (cmd->hdr.datakind) {
+	switch (hdr->datakind) {
 
 	  case 'C':						// AX.25 Connection Received
-	    {	    
-	      //agw_cb_C_connection_received (cmd->hdr.portx, cmd->hdr.call_from, cmd->hdr.call_to, data_len, cmd->data);
+	    {
+	      // Start with clean flow control information.
+	      dw_mutex_lock (&s_link_mutex);
+	      lp = find_link (hdr->portx, hdr->call_to, hdr->call_from, 1);
+	      if (lp != NULL) {
+	        lp->sent = 0;
+	        lp->y_pending = 0;
+	        lp->y_count = -1;
+	        lp->disc_pending = 0;
+	      }
+	      dw_mutex_unlock (&s_link_mutex);
+
+	      //agw_cb_C_connection_received (hdr->portx, hdr->call_from, hdr->call_to, data_len, data);
 	      // TODO:  compute session id
 	      // There are two different cases to consider here.
-	      if (strncmp(cmd->data, "*** CONNECTED To Station", 24) == 0) {
+	      if (strncmp(data, "*** CONNECTED To Station", 24) == 0) {
 	        // Incoming: Other station initiated the connect request.
-	        on_C_connection_received (cmd->hdr.portx, cmd->hdr.call_from, cmd->hdr.call_to, 1, cmd->data);
+	        on_C_connection_received (hdr->portx, hdr->call_from, hdr->call_to, 1, data);
 	      }
-	      else if (strncmp(cmd->data, "*** CONNECTED With Station", 26) == 0) {
+	      else if (strncmp(data, "*** CONNECTED With Station", 26) == 0) {
 	        // Outgoing: Other station accepted my connect request.
-	        on_C_connection_received (cmd->hdr.portx, cmd->hdr.call_from, cmd->hdr.call_to, 0, cmd->data);
+	        on_C_connection_received (hdr->portx, hdr->call_from, hdr->call_to, 0, data);
 	      }
 	      else {
 // TBD
@@ -455,13 +553,20 @@ static void process_from_tnc (struct agw_cmd_s *cmd)
 	    }
 	    break;
 
-	  case 'D':						// Connected AX.25 Data	
-	    // FIXME: should probably add pid here.		
-	    agw_cb_D_connected_data (cmd->hdr.portx, cmd->hdr.call_from, cmd->hdr.call_to, data_len, cmd->data);
+	  case 'D':						// Connected AX.25 Data
+	    // FIXME: should probably add pid here.
+	    agw_cb_D_connected_data (hdr->portx, hdr->call_from, hdr->call_to, data_len, data);
 	    break;
 
-	  case 'd':						// Disconnected				
-	    agw_cb_d_disconnected (cmd->hdr.portx, cmd->hdr.call_from, cmd->hdr.call_to, data_len, cmd->data);
+	  case 'd':						// Disconnected
+	    dw_mutex_lock (&s_link_mutex);
+	    lp = find_link (hdr->portx, hdr->call_to, hdr->call_from, 0);
+	    if (lp != NULL) {
+	      lp->in_use = 0;
+	    }
+	    dw_mutex_unlock (&s_link_mutex);
+
+	    agw_cb_d_disconnected (hdr->portx, hdr->call_from, hdr->call_to, data_len, data);
 	    break;
 
  	  case 'R':						// Reply to Request for version number.
@@ -482,20 +587,42 @@ static void process_from_tnc (struct agw_cmd_s *cmd)
 
 // TODO: Maybe fill in more someday.
 
-	  case 'g':						// Reply to capabilities of a port.  
+	  case 'g':						// Reply to capabilities of a port.
 	    break;
 	  case 'K':						// Received AX.25 frame in raw format. (Enabled with 'k' command.)
 	    break;
 	  case 'U':						// Received AX.25 frame in monitor format. (Enabled with 'm' command.)
 	    break;
-	  case 'y':						// Outstanding frames waiting on a Port   
+	  case 'y':						// Outstanding frames waiting on a Port
 	    break;
 
-	  case 'Y':						// How many frames waiting for transmit for a particular station 
+	  case 'Y':						// How many frames waiting for transmit for a particular station
 	    {
-	    int *p = (int*)(cmd->data);
-	    int frame_count = netle2host(*p);
-	    agw_cb_Y_outstanding_frames_for_station (cmd->hdr.portx, cmd->hdr.call_from, cmd->hdr.call_to, frame_count);
+	    int count_NETLE = 0;
+	    int disconnect = 0;
+
+	    if (data_len >= 4) {
+	      memcpy (&count_NETLE, data, 4);
+	    }
+	    int frame_count = netle2host(count_NETLE);
+
+	    dw_mutex_lock (&s_link_mutex);
+	    lp = find_link (hdr->portx, hdr->call_from, hdr->call_to, 0);
+	    if (lp != NULL) {
+	      lp->y_pending = 0;
+	      lp->y_count = frame_count;
+	      if (lp->disc_pending && frame_count + lp->sent - lp->y_mark == 0) {
+	        lp->disc_pending = 0;
+	        disconnect = 1;
+	      }
+	    }
+	    dw_mutex_unlock (&s_link_mutex);
+
+	    if (disconnect) {
+	      agwlib_d_disconnect (hdr->portx, hdr->call_from, hdr->call_to);
+	    }
+
+	    agw_cb_Y_outstanding_frames_for_station (hdr->portx, hdr->call_from, hdr->call_to, frame_count);
 	    }
 	    break;
 
@@ -506,6 +633,159 @@ static void process_from_tnc (struct agw_cmd_s *cmd)
 } // end process_from_tnc
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        send_to_tnc
+ *
+ * Purpose:     Send a command, and any data part, to the TNC.
+ *
+ * Inputs:	hdr		- Command header.  data_len_NETLE is filled in here.
+ *
+ *		data		- Data part or NULL.  Sent from where it is, without copying.
+ *
+ *		data_len	- Number of data bytes.
+ *
+ * Returns:	Number of bytes sent for success, -1 for error.
+ *
+ * Description:	The header and data go out in a single system call so they
+ *		end up in one TCP segment rather than two.
+ *
+ *--------------------------------------------------------------------*/
+
+static int send_to_tnc (struct agw_hdr_s *hdr, char *data, int data_len)
+{
+	int total = sizeof(*hdr) + data_len;
+	int n;
+
+	hdr->data_len_NETLE = host2netle(data_len);
+
+	dw_mutex_lock (&s_send_mutex);
+
+#if __WIN32__
+	WSABUF wbuf[2];
+	DWORD sent = 0;
+
+	wbuf[0].buf = (char*)hdr;
+	wbuf[0].len = sizeof(*hdr);
+	wbuf[1].buf = data;
+	wbuf[1].len = data_len;
+	n = WSASend (s_tnc_sock, wbuf, data_len > 0 ? 2 : 1, &sent, 0, NULL, NULL) == 0 ? (int)sent : -1;
+#else
+	struct iovec iov[2];
+	struct msghdr msg;
+
+	iov[0].iov_base = hdr;
+	iov[0].iov_len = sizeof(*hdr);
+	iov[1].iov_base = data;
+	iov[1].iov_len = data_len;
+	memset (&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = data_len > 0 ? 2 : 1;
+#if __APPLE__
+	n = sendmsg (s_tnc_sock, &msg, 0);
+#else
+	n = sendmsg (s_tnc_sock, &msg, MSG_NOSIGNAL);
+#endif
+#endif
+
+	dw_mutex_unlock (&s_send_mutex);
+
+	return (n == total ? n : -1);
+
+} // end send_to_tnc
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        find_link
+ *
+ * Purpose:     Find the flow control information for a link.
+ *
+ * Inputs:	chan		- Radio channel number.
+ *
+ *		own_call	- My callsign.
+ *
+ *		remote_call	- Callsign of other station.
+ *
+ *		create		- If true, add it if not found.
+ *
+ * Returns:	Pointer to table entry or NULL if not found or table is full.
+ *
+ * Description:	Caller must hold s_link_mutex.
+ *
+ *--------------------------------------------------------------------*/
+
+static struct link_s *find_link (int chan, char *own_call, char *remote_call, int create)
+{
+	int i;
+	struct link_s *avail = NULL;
+
+	for (i = 0; i < AGWLIB_MAX_LINKS; i++) {
+	  struct link_s *lp = &(s_link[i]);
+	  if (lp->in_use) {
+	    if (lp->chan == chan &&
+			strcmp(lp->own_call, own_call) == 0 &&
+			strcmp(lp->remote_call, remote_call) == 0) {
+	      return (lp);
+	    }
+	  }
+	  else if (avail == NULL) {
+	    avail = lp;
+	  }
+	}
+
+	if ( ! create || avail == NULL) {
+	  return (NULL);
+	}
+
+	memset (avail, 0, sizeof(struct link_s));
+	avail->in_use = 1;
+	avail->chan = chan;
+	strlcpy (avail->own_call, own_call, sizeof(avail->own_call));
+	strlcpy (avail->remote_call, remote_call, sizeof(avail->remote_call));
+	avail->y_count = -1;
+	return (avail);
+
+} // end find_link
+
+
+static void forget_links (void)
+{
+	dw_mutex_lock (&s_link_mutex);
+	memset (s_link, 0, sizeof(s_link));
+	dw_mutex_unlock (&s_link_mutex);
+}
+
+
+/*
+ * Called about once a second from the listening thread.
+ * Links waiting to be disconnected need to know when
+ * everything has been acknowledged.
+ */
+
+static void link_housekeeping (void)
+{
+	int i;
+
+	for (i = 0; i < AGWLIB_MAX_LINKS; i++) {
+	  int chan;
+	  char own_call[10];
+	  char remote_call[10];
+
+	  dw_mutex_lock (&s_link_mutex);
+	  int ask = s_link[i].in_use && s_link[i].disc_pending && ! s_link[i].y_pending;
+	  chan = s_link[i].chan;
+	  strlcpy (own_call, s_link[i].own_call, sizeof(own_call));
+	  strlcpy (remote_call, s_link[i].remote_call, sizeof(remote_call));
+	  dw_mutex_unlock (&s_link_mutex);
+
+	  if (ask) {
+	    agwlib_Y_outstanding_frames_for_station (chan, own_call, remote_call);
+	  }
+	}
+
+} // end link_housekeeping
+
 
 /*-------------------------------------------------------------------
  *
@@ -523,13 +803,13 @@ static void process_from_tnc (struct agw_cmd_s *cmd)
 
 int agwlib_X_register_callsign (int chan, char *call_from)
 {
-	struct agw_cmd_s cmd;
+	struct agw_hdr_s hdr;
 
-	memset (&cmd.hdr, 0, sizeof(cmd.hdr));
-	cmd.hdr.portx = chan;
-	cmd.hdr.datakind = 'X';
-	strlcpy (cmd.hdr.call_from, call_from, sizeof(cmd.hdr.call_from));
-	return (SOCK_SEND(s_tnc_sock, (char*)(&cmd), sizeof(cmd.hdr) + netle2host(cmd.hdr.data_len_NETLE)));
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.portx = chan;
+	hdr.datakind = 'X';
+	strlcpy (hdr.call_from, call_from, sizeof(hdr.call_from));
+	return (send_to_tnc (&hdr, NULL, 0));
 }
 
 
@@ -551,13 +831,13 @@ int agwlib_X_register_callsign (int chan, char *call_from)
 
 int agwlib_x_unregister_callsign (int chan, char *call_from)
 {
-	struct agw_cmd_s cmd;
+	struct agw_hdr_s hdr;
 
-	memset (&cmd.hdr, 0, sizeof(cmd.hdr));
-	cmd.hdr.portx = chan;
-	cmd.hdr.datakind = 'x';
-	strlcpy (cmd.hdr.call_from, call_from, sizeof(cmd.hdr.call_from));
-	return (SOCK_SEND(s_tnc_sock, (char*)(&cmd), sizeof(cmd.hdr) + netle2host(cmd.hdr.data_len_NETLE)));
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.portx = chan;
+	hdr.datakind = 'x';
+	strlcpy (hdr.call_from, call_from, sizeof(hdr.call_from));
+	return (send_to_tnc (&hdr, NULL, 0));
 }
 
 
@@ -575,11 +855,11 @@ int agwlib_x_unregister_callsign (int chan, char *call_from)
 
 int agwlib_G_ask_port_information (void)
 {
-	struct agw_cmd_s cmd;
+	struct agw_hdr_s hdr;
 
-	memset (&cmd.hdr, 0, sizeof(cmd.hdr));
-	cmd.hdr.datakind = 'G';
-	int n = SOCK_SEND(s_tnc_sock, (char*)(&cmd), sizeof(cmd.hdr) + netle2host(cmd.hdr.data_len_NETLE));
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.datakind = 'G';
+	int n = send_to_tnc (&hdr, NULL, 0);
 	return (n > 0 ? 0 : -1);
 }
 
@@ -606,16 +886,16 @@ int agwlib_G_ask_port_information (void)
 
 int agwlib_C_connect (int chan, char *call_from, char *call_to)
 {
-	struct agw_cmd_s cmd;
+	struct agw_hdr_s hdr;
 
-	memset (&cmd.hdr, 0, sizeof(cmd.hdr));
-	cmd.hdr.portx = chan;
-	cmd.hdr.datakind = 'C';
-	cmd.hdr.pid = 0xF0;	// Shouldn't matter because this appears
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.portx = chan;
+	hdr.datakind = 'C';
+	hdr.pid = 0xF0;	// Shouldn't matter because this appears
 				// only in Information frame, not connect sequence.
-	strlcpy (cmd.hdr.call_from, call_from, sizeof(cmd.hdr.call_from));
-	strlcpy (cmd.hdr.call_to, call_to, sizeof(cmd.hdr.call_to));
-	return (SOCK_SEND(s_tnc_sock, (char*)(&cmd), sizeof(cmd.hdr) + netle2host(cmd.hdr.data_len_NETLE)));
+	strlcpy (hdr.call_from, call_from, sizeof(hdr.call_from));
+	strlcpy (hdr.call_to, call_to, sizeof(hdr.call_to));
+	return (send_to_tnc (&hdr, NULL, 0));
 }
 
 
@@ -641,14 +921,14 @@ int agwlib_C_connect (int chan, char *call_from, char *call_to)
 
 int agwlib_d_disconnect (int chan, char *call_from, char *call_to)
 {
-	struct agw_cmd_s cmd;
-
-	memset (&cmd.hdr, 0, sizeof(cmd.hdr));
-	cmd.hdr.portx = chan;
-	cmd.hdr.datakind = 'd';
-	strlcpy (cmd.hdr.call_from, call_from, sizeof(cmd.hdr.call_from));
-	strlcpy (cmd.hdr.call_to, call_to, sizeof(cmd.hdr.call_to));
-	return (SOCK_SEND(s_tnc_sock, (char*)(&cmd), sizeof(cmd.hdr) + netle2host(cmd.hdr.data_len_NETLE)));
+	struct agw_hdr_s hdr;
+
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.portx = chan;
+	hdr.datakind = 'd';
+	strlcpy (hdr.call_from, call_from, sizeof(hdr.call_from));
+	strlcpy (hdr.call_to, call_to, sizeof(hdr.call_to));
+	return (send_to_tnc (&hdr, NULL, 0));
 }
 
 
@@ -676,26 +956,36 @@ int agwlib_d_disconnect (int chan, char *call_from, char *call_to)
  * Description:	This should only be done when we are known to have
  *		an established link to other station.
  *
+ *		The data is sent from where it is, without copying.
+ *		The frame is counted for agwlib_outstanding_frames.
+ *
  *--------------------------------------------------------------------*/
 
 int agwlib_D_send_connected_data (int chan, int pid, char *call_from, char *call_to, int data_len, char *data)
 {
-	struct agw_cmd_s cmd;
+	struct agw_hdr_s hdr;
 
-	memset (&cmd.hdr, 0, sizeof(cmd.hdr));
-	cmd.hdr.portx = chan;
-	cmd.hdr.datakind = 'D';
-	cmd.hdr.pid = pid;		// Normally 0xF0 but other special cases are possible.
-	strlcpy (cmd.hdr.call_from, call_from, sizeof(cmd.hdr.call_from));
-	strlcpy (cmd.hdr.call_to, call_to, sizeof(cmd.hdr.call_to));
-	cmd.hdr.data_len_NETLE = host2netle(data_len);
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.portx = chan;
+	hdr.datakind = 'D';
+	hdr.pid = pid;		// Normally 0xF0 but other special cases are possible.
+	strlcpy (hdr.call_from, call_from, sizeof(hdr.call_from));
+	strlcpy (hdr.call_to, call_to, sizeof(hdr.call_to));
 
-// FIXME: DANGER possible buffer overflow, Need checking.
-
-	assert (data_len <= sizeof(cmd.data));
+	if (data_len < 0 || data_len > AX25_MAX_INFO_LEN) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("agwlib: Connected data length %d is out of range.\n", data_len);
+	  return (-1);
+	}
 
-	memcpy (cmd.data, data, data_len);
-	return (SOCK_SEND(s_tnc_sock, (char*)(&cmd), sizeof(cmd.hdr) + netle2host(cmd.hdr.data_len_NETLE)));
+	dw_mutex_lock (&s_link_mutex);
+	int n = send_to_tnc (&hdr, data, data_len);
+	struct link_s *lp = find_link (chan, hdr.call_from, hdr.call_to, 1);
+	if (lp != NULL && n > 0) {
+	  lp->sent++;
+	}
+	dw_mutex_unlock (&s_link_mutex);
+	return (n);
 }
 
 
@@ -730,18 +1020,115 @@ int agwlib_D_send_connected_data (int chan, int pid, char *call_from, char *call
  *
  *		See server.c for a more precise definition of exactly how this is defined.
  *
+ *		Nothing is sent, and 0 is returned, if an earlier request
+ *		for the same link has not been answered yet.  It is fine to
+ *		call this frequently; requests don't pile up.
+ *
  *--------------------------------------------------------------------*/
 
 int agwlib_Y_outstanding_frames_for_station (int chan, char *call_from, char *call_to)
 {
-	struct agw_cmd_s cmd;
-
-	memset (&cmd.hdr, 0, sizeof(cmd.hdr));
-	cmd.hdr.portx = chan;
-	cmd.hdr.datakind = 'Y';
-	strlcpy (cmd.hdr.call_from, call_from, sizeof(cmd.hdr.call_from));
-	strlcpy (cmd.hdr.call_to, call_to, sizeof(cmd.hdr.call_to));
-	return (SOCK_SEND(s_tnc_sock, (char*)(&cmd), sizeof(cmd.hdr) + netle2host(cmd.hdr.data_len_NETLE)));
+	struct agw_hdr_s hdr;
+	struct link_s *lp;
+	int n;
+
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.portx = chan;
+	hdr.datakind = 'Y';
+	strlcpy (hdr.call_from, call_from, sizeof(hdr.call_from));
+	strlcpy (hdr.call_to, call_to, sizeof(hdr.call_to));
+
+	dw_mutex_lock (&s_link_mutex);
+	lp = find_link (chan, hdr.call_from, hdr.call_to, 1);
+	if (lp != NULL && lp->y_pending) {
+	  dw_mutex_unlock (&s_link_mutex);
+	  return (0);
+	}
+	n = send_to_tnc (&hdr, NULL, 0);
+	if (lp != NULL && n > 0) {
+	  lp->y_pending = 1;
+	  lp->y_mark = lp->sent;
+	}
+	dw_mutex_unlock (&s_link_mutex);
+	return (n);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        agwlib_outstanding_frames
+ *
+ * Purpose:     Estimate how many frames are still waiting for transmission
+ *		or acknowledgement on a link, without asking the TNC.
+ *
+ * Inputs:	chan		- Radio channel number, first is 0.
+ *
+ *		call_from	- My callsign.
+ *
+ *		call_to		- Callsign of remote station.
+ *
+ * Returns:	Count from the most recent 'Y' reply plus any data frames
+ *		sent after that request.  -1 if there has been no reply yet.
+ *
+ * Description:	Use this for flow control.  Keep asking with
+ *		agwlib_Y_outstanding_frames_for_station and, each time
+ *		agw_cb_Y_outstanding_frames_for_station is called, send
+ *		more data if this is below the desired amount.
+ *		There is no need to wait for the reply before sending more.
+ *
+ *--------------------------------------------------------------------*/
+
+int agwlib_outstanding_frames (int chan, char *call_from, char *call_to)
+{
+	struct link_s *lp;
+	int count = -1;
+
+	dw_mutex_lock (&s_link_mutex);
+	lp = find_link (chan, call_from, call_to, 0);
+	if (lp != NULL && lp->y_count >= 0) {
+	  count = lp->y_count + lp->sent - lp->y_mark;
+	}
+	dw_mutex_unlock (&s_link_mutex);
+	return (count);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        agwlib_d_disconnect_after_sent
+ *
+ * Purpose:     Disconnect from remote station after everything sent
+ *		has been acknowledged.
+ *
+ * Inputs:	chan		- Radio channel number, first is 0.
+ *
+ *		call_from	- My callsign.
+ *
+ *		call_to		- Callsign of remote station.
+ *
+ * Returns:	Number of bytes sent for success, -1 for error.
+ *
+ * Description:	This returns right away.  The listening thread keeps asking
+ *		with 'Y' and sends the disconnect request when the count is zero.
+ *		Use this, rather than sleeping, for a final message such as
+ *		a sign off or "too many users."
+ *
+ *--------------------------------------------------------------------*/
+
+int agwlib_d_disconnect_after_sent (int chan, char *call_from, char *call_to)
+{
+	struct link_s *lp;
+
+	dw_mutex_lock (&s_link_mutex);
+	lp = find_link (chan, call_from, call_to, 1);
+	if (lp == NULL) {
+	  dw_mutex_unlock (&s_link_mutex);
+	  return (agwlib_d_disconnect (chan, call_from, call_to));
+	}
+	lp->disc_pending = 1;
+	dw_mutex_unlock (&s_link_mutex);
+
+	return (agwlib_Y_outstanding_frames_for_station (chan, call_from, call_to));
 }
 
 
@@ -26,6 +26,13 @@ int agwlib_D_send_connected_data (int chan, int pid, char *call_from, char *call
 
 int agwlib_Y_outstanding_frames_for_station (int chan, char *call_from, char *call_to);
 
+int agwlib_d_disconnect_after_sent (int chan, char *call_from, char *call_to);
+
+
+// Flow control for connected data.  No waiting for the TNC.
+
+int agwlib_outstanding_frames (int chan, char *call_from, char *call_to);
+
 
 
 // The application must define these.
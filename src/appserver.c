@@ -39,6 +39,11 @@
  * Description:	This attaches to an instance of Dire Wolf via the AGW network interface.
  *		It processes commands from other radio stations and responds.
  *
+ *		Many users can be connected at once.  Nothing here waits for
+ *		the TNC.  Bulk data (the "test" command) is driven by the
+ *		replies to 'Y' requests so each session keeps about TT_WINDOW
+ *		frames queued up, no matter how many sessions there are.
+ *
  *---------------------------------------------------------------*/
 
 
@@ -106,15 +111,18 @@ struct session_s {
 	int tt_length;				// Bytes in info part.
 	int tt_next;				// Next sequence to send.
 
-	volatile int tx_queue_len;		// Number in transmit queue.  For flow control.
+	volatile int tx_queue_len;		// Number in transmit queue.  From most recent 'Y' reply.
 };
 
-#define MAX_SESSIONS  12
+#define MAX_SESSIONS  100
+
+#define TT_WINDOW 128		// Keep no more than this many frames queued up for each session.
 
 static struct session_s session[MAX_SESSIONS];
 
 static int find_session (int chan, char *addr, int create);
 static void poll_timing_test (void);
+static void tt_fill (int s);
 
 
 
@@ -206,7 +214,7 @@ int main (int argc, char *argv[])
 
 
 	while (1) {
-	  SLEEP_SEC(1);		// other places based on 1 second assumption.
+	  SLEEP_MS(100);
 	  poll_timing_test ();
 	}
 
@@ -215,7 +223,13 @@ int main (int argc, char *argv[])
 
 
 
-static void poll_timing_test (void) 
+/*
+ * Ask about the transmit queue for every session with a timing test in progress.
+ * Nothing is sent if the previous request has not been answered yet.
+ * The reply, in agw_cb_Y_outstanding_frames_for_station, queues up more data.
+ */
+
+static void poll_timing_test (void)
 {
 	int s;
 	for (s = 0; s < MAX_SESSIONS; s++) {
@@ -223,39 +237,53 @@ static void poll_timing_test (void)
 	  if (session[s].tt_count == 0) {
 	     continue;	// nothing to do
 	  }
-	  else if (session[s].tt_next <= session[s].tt_count) {
-	    int rem = session[s].tt_count - session[s].tt_next + 1;  // remaining to send.
-	    agwlib_Y_outstanding_frames_for_station (session[s].channel, mycall, session[s].client_addr);
-	    SLEEP_MS(10);
-	    if (session[s].tx_queue_len > 128) continue;  // enough queued up for now.
-	    if (rem > 64) rem = 64;	// add no more than 64 at a time.
-	    int i;
-	    for (i = 0; i < rem; i++) {
-	      char c = 'a';
-	      char stuff[AX25_MAX_INFO_LEN+2];
-	      snprintf (stuff, sizeof(stuff), "%06d ", session[s].tt_next);
-	      int k;
-	      for (k = strlen(stuff); k < session[s].tt_length - 1; k++) {
-	        stuff[k] = c;
-		c++;
-		if (c == 'z' + 1) c = 'A';
-	        if (c == 'Z' + 1) c = '0';
-	        if (c == '9' + 1) c = 'a';
-	      }
-	      stuff[k++] = '\r';
-	      stuff[k++] = '\0';
-	      agwlib_D_send_connected_data (session[s].channel, 0xF0, mycall, session[s].client_addr, strlen(stuff), stuff);
-	      session[s].tt_next++;
-	    }
-	  }
-	  else {
-	    // All done queuing up the packets.
-	    // Wait until they have all been sent and ack'ed by other end.
+	  agwlib_Y_outstanding_frames_for_station (session[s].channel, mycall, session[s].client_addr);
+	}
+
+}  // end poll_timing_test
+
+
+
+/*
+ * Queue up more frames for the timing test, or send the summary when
+ * everything has been sent and acknowledged.
+ * Called from the TNC listening thread so it doesn't need locking.
+ */
+
+static void tt_fill (int s)
+{
+	if (session[s].tt_count == 0) {
+	  return;
+	}
 
-	    agwlib_Y_outstanding_frames_for_station (session[s].channel, mycall, session[s].client_addr);
-	    SLEEP_MS(10);
+	int outstanding = agwlib_outstanding_frames (session[s].channel, mycall, session[s].client_addr);
+	if (outstanding < 0) {
+	  return;		// Don't know yet.
+	}
 
-	    if (session[s].tx_queue_len > 0) continue;  // not done yet.
+	if (session[s].tt_next <= session[s].tt_count) {
+	  int room = TT_WINDOW - outstanding;
+	  while (room > 0 && session[s].tt_next <= session[s].tt_count) {
+	    char c = 'a';
+	    char stuff[AX25_MAX_INFO_LEN+2];
+	    snprintf (stuff, sizeof(stuff), "%06d ", session[s].tt_next);
+	    int k;
+	    for (k = strlen(stuff); k < session[s].tt_length - 1; k++) {
+	      stuff[k] = c;
+	      c++;
+	      if (c == 'z' + 1) c = 'A';
+	      if (c == 'Z' + 1) c = '0';
+	      if (c == '9' + 1) c = 'a';
+	    }
+	    stuff[k++] = '\r';
+	    stuff[k++] = '\0';
+	    agwlib_D_send_connected_data (session[s].channel, 0xF0, mycall, session[s].client_addr, strlen(stuff), stuff);
+	    session[s].tt_next++;
+	    room--;
+	  }
+	}
+	else if (outstanding == 0) {
+	    // All done queuing up the packets and they have all been sent and ack'ed by other end.
 
 	    int elapsed = time(NULL) - session[s].tt_start_time;
 	    if (elapsed <= 0) elapsed = 1;	// avoid divide by 0
@@ -269,10 +297,9 @@ static void poll_timing_test (void)
 
 	    agwlib_D_send_connected_data (session[s].channel, 0xF0, mycall, session[s].client_addr, strlen(summary), summary);
 	    session[s].tt_count = 0;	// all done.
-	  }
 	}
 
-}  // end poll_timing_test
+}  // end tt_fill
 
 
 
@@ -371,10 +398,8 @@ void on_C_connection_received (int chan, char *call_from, char *call_to, int inc
 	  snprintf (greeting, sizeof(greeting), "Sorry, maximum number of users has been exceeded.  Try again later.\r");
 	  agwlib_D_send_connected_data (chan, 0xF0, mycall, call_from, strlen(greeting), greeting);
 
-	  // FIXME: Ideally we'd want to wait until nothing in the outgoing queue
-	  // to that station so we know the rejection message was received.
-	  SLEEP_SEC (10);
-	  agwlib_d_disconnect (chan, mycall, call_from);
+	  // Disconnect when we know the rejection message was received.
+	  agwlib_d_disconnect_after_sent (chan, mycall, call_from);
 	}
 
 } /* end agw_cb_C_connection_received */
@@ -529,8 +554,9 @@ void agw_cb_D_connected_data (int chan, char *call_from, char *call_to, int data
 	  if (pcount != NULL) {
 	    session[s].tt_count = atoi(pcount);
 	  }
-	    
-	  // The background polling will take it from here. 
+
+	  // Replies to 'Y' requests will take it from here.
+	  agwlib_Y_outstanding_frames_for_station (chan, mycall, call_from);
 	}
 	else if (strcasecmp(pcmd, "bye") == 0) {
 
@@ -539,10 +565,8 @@ void agw_cb_D_connected_data (int chan, char *call_from, char *call_to, int data
 	  char greeting[80];
 	  strlcpy (greeting, "Thank you folks for kindly droppin' in.  Y'all come on back now, ya hear?\r", sizeof(greeting));
 	  agwlib_D_send_connected_data (chan, 0xF0, mycall, call_from, strlen(greeting), greeting);
-	  // Ideally we'd want to wait until nothing in the outgoing queue
-	  // to that station so we know the message was received.
-	  SLEEP_SEC (10);
-	  agwlib_d_disconnect (chan, mycall, call_from);
+	  // Disconnect when we know the message was received.
+	  agwlib_d_disconnect_after_sent (chan, mycall, call_from);
 	}
 	else if (strcasecmp(pcmd, "help") == 0 || strcasecmp(pcmd, "?") == 0) {
 
@@ -635,7 +659,7 @@ void agw_cb_G_port_information (int num_chan_avail, char *chan_descriptions[])
  *
  * Name:        agw_cb_Y_outstanding_frames_for_station
  *
- * Purpose:     Process the "disconnected" command from the TNC.
+ * Purpose:     Process the "outstanding frames" reply from the TNC.
  *		
  * Inputs:	chan		- Radio channel.
  *
@@ -645,7 +669,7 @@ void agw_cb_G_port_information (int num_chan_avail, char *chan_descriptions[])
  *
  *		frame_count
  *
- * Description:	Remove from the sessions table.
+ * Description:	Queue up more data for a timing test in progress.
  *
  *--------------------------------------------------------------------*/
 
@@ -657,18 +681,13 @@ void agw_cb_Y_outstanding_frames_for_station (int chan, char *call_from, char *c
 
 	s = find_session (chan, call_to, 0);
 
-	text_color_set(DW_COLOR_DEBUG);		// FIXME temporary
- 	dw_printf ("debug ----------------------> session %d, callback Y outstanding frame_count %d\n", s, frame_count);
-
 // Update the transmit queue length
 
 	if (s >= 0) {
 	  session[s].tx_queue_len  = frame_count;
+	  tt_fill (s);
 	}
-	else {
-	  text_color_set(DW_COLOR_ERROR);
- 	  dw_printf ("Oops!  Did not expect to be here.\n");
-	}
+	// Otherwise, probably a rejected user waiting to be disconnected.
 
 } /* end agw_cb_Y_outstanding_frames_for_station */
 
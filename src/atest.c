@@ -69,6 +69,15 @@
 #include <time.h>
 #include <getopt.h>
 #include <ctype.h>
+#include <errno.h>
+
+#if ! __WIN32__
+#include <sys/types.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#endif
 
 
 #define ATEST_C 1
@@ -138,8 +147,21 @@ static struct {
 } wav_data;
 
 
-static FILE *fp;
-static int e_o_f;
+/*
+ * The whole file is memory mapped, rather than read a byte at a time,
+ * so decoding a large recording is limited by the demodulators, not I/O.
+ * Samples are taken directly from here in decode_samples.
+ */
+
+static unsigned char *wav_map = NULL;	/* Start of file. */
+static size_t wav_map_len;		/* Size of file. */
+static size_t wav_pos;			/* Current position while reading the header. */
+static unsigned char *wav_next;		/* Next audio sample. */
+static unsigned char *wav_end;		/* End of audio data. */
+
+static void map_file (char *fname);
+static void unmap_file (void);
+
 static int packets_decoded_one = 0;
 static int packets_decoded_total = 0;
 static int decimate = 0;		/* Reduce that sampling rate if set. */
@@ -192,14 +214,28 @@ static char P_opt[16] = "";		// Demodulator profiles.
 static int d_x_opt = 1;			// FX.25 debug.
 static int d_o_opt = 0;			// "-d o" option for DCD output control. */	
 static int d_2_opt = 0;			// "-d 2" option for IL2P details. */
+static int d_b_opt = 0;			// "-d b" option for bit buffer memory statistics. */
 static int dcd_count = 0;
 static int dcd_missing_errors = 0;
+static int p_opt = 1;			// Number of processes for decoding in parallel.
+static double s_opt = 0;		// Segment length, in seconds, when decoding in parallel.  0 for automatic.
+static int b_opt = 0;			// Benchmark frame start search with this many slicers.
+
+static long wav_data_offset;		/* Where the audio begins in the file. */
+
+static double read_wav_header (char *fname);
+static void decode_samples (void);
+static void print_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, fec_type_t fec_type, retry_t retries, char *spectrum);
+static double parallel_decode (int num_files, char **file_names);
+static void bit_benchmark (int nslicers);
+
+static FILE *seg_fp = NULL;		/* Parallel decoding child process writes frames here rather than printing. */
+static int seg_first_sample;		/* Frames decoded before this belong to the previous segment. */
 
 
 int main (int argc, char *argv[])
 {
 
-	int err;
 	int c;
 	int channel;
 
@@ -267,7 +303,7 @@ int main (int argc, char *argv[])
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "B:P:D:U:gjJF:L:G:012he:d:",
+          c = getopt_long(argc, argv, "B:P:D:U:gjJF:L:G:012he:d:p:s:b:",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -386,6 +422,43 @@ int main (int argc, char *argv[])
 	       my_audio_config.recv_ber = atof(optarg);
 	       break;
 
+	     case 'p':				/* -p number of processes for parallel decoding. */
+
+	       p_opt = atoi(optarg);
+	       if (p_opt < 1 || p_opt > 256) {
+	         text_color_set(DW_COLOR_ERROR);
+	         dw_printf ("Number of processes for -p must be in range of 1 to 256.\n");
+	         exit (EXIT_FAILURE);
+	       }
+#if __WIN32__
+	       if (p_opt > 1) {
+	         text_color_set(DW_COLOR_ERROR);
+	         dw_printf ("-p is not available for Windows.  Using one process.\n");
+	         p_opt = 1;
+	       }
+#endif
+	       break;
+
+	     case 's':				/* -s segment length, in seconds, for parallel decoding. */
+
+	       s_opt = atof(optarg);
+	       if (s_opt <= 0) {
+	         text_color_set(DW_COLOR_ERROR);
+	         dw_printf ("Segment length for -s must be a positive number of seconds.\n");
+	         exit (EXIT_FAILURE);
+	       }
+	       break;
+
+	     case 'b':				/* -b benchmark frame start search with n slicers. */
+
+	       b_opt = atoi(optarg);
+	       if (b_opt < 1 || b_opt > MAX_SLICERS) {
+	         text_color_set(DW_COLOR_ERROR);
+	         dw_printf ("Number of slicers for -b must be in range of 1 to %d.\n", MAX_SLICERS);
+	         exit (EXIT_FAILURE);
+	       }
+	       break;
+
 	     case 'd':				/* Debug message options. */
 
 	       for (char *p=optarg; *p!='\0'; p++) {
@@ -393,6 +466,7 @@ int main (int argc, char *argv[])
 	           case 'x':  d_x_opt++; break;			// FX.25
 	           case 'o':  d_o_opt++; break;			// DCD output control
 	           case '2':  d_2_opt++; break;			// IL2P debug out
+	           case 'b':  d_b_opt++; break;			// Bit buffer statistics
 	           default: break;
 	        }
 	       }
@@ -533,6 +607,11 @@ int main (int argc, char *argv[])
 
 	memcpy (&my_audio_config.achan[1], &my_audio_config.achan[0], sizeof(my_audio_config.achan[0]));
 
+	if (b_opt > 0) {
+	  bit_benchmark (b_opt);
+	  exit (EXIT_SUCCESS);
+	}
+
 
 	if (optind >= argc) {
 	  text_color_set(DW_COLOR_ERROR);
@@ -545,23 +624,167 @@ int main (int argc, char *argv[])
 
 	start_time = dtime_now();
 
-	while (optind < argc) {
+	if (p_opt > 1) {
+	  if (d_o_opt) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("\"-d o\" can't be used with -p.\n");
+	    exit (EXIT_FAILURE);
+	  }
+	  total_filetime = parallel_decode (argc - optind, argv + optind);
+	}
+	else while (optind < argc) {
+
+	one_filetime = read_wav_header (argv[optind]);
+	total_filetime += one_filetime;
+		
+/*
+ * Initialize the AFSK demodulator and HDLC decoder.
+ * Needs to be done for each file because they could have different sample rates.
+ */
+	multi_modem_init (&my_audio_config);
+	packets_decoded_one = 0;
+
+	decode_samples ();
 
-	fp = fopen(argv[optind], "rb");
-        if (fp == NULL) {
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n\n");
+
+#if EXPERIMENT_G
+
+	for (j=0; j<MAX_SUBCHANS; j++) {
+	  float db = 20.0 * log10f(space_gain[j]);
+	  dw_printf ("%+.1f dB, %d\n", db, count[j]);
+	}
+#endif
+#if EXPERIMENT_H
+
+	for (j=0; j<MAX_SUBCHANS; j++) {
+	  dw_printf ("%d\n", count[j]);
+	}
+#endif
+
+	dw_printf ("%d from %s\n", packets_decoded_one, argv[optind]);
+	packets_decoded_total += packets_decoded_one;
+
+	unmap_file ();
+	optind++;
+	}
+
+	elapsed = dtime_now() - start_time;
+
+	dw_printf ("%d packets decoded in %.3f seconds.  %.1f x realtime\n", packets_decoded_total, elapsed, total_filetime/elapsed);
+	if (d_o_opt) {
+	  dw_printf ("DCD count = %d\n", dcd_count);
+	  dw_printf ("DCD missing errors = %d\n", dcd_missing_errors);
+	}
+	if (d_b_opt) {
+	  rrbb_print_stats ();
+	}
+
+	if (error_if_less_than != -1 && packets_decoded_total < error_if_less_than) {
 	  text_color_set(DW_COLOR_ERROR);
-          dw_printf ("Couldn't open file for read: %s\n", argv[optind]);
-	  //perror ("more info?");
-          exit (EXIT_FAILURE);
-        }
+	  dw_printf ("\n * * * TEST FAILED: number decoded is less than %d * * * \n", error_if_less_than);
+	  exit (EXIT_FAILURE);
+	}
+	if (error_if_greater_than != -1 && packets_decoded_total > error_if_greater_than) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n * * * TEST FAILED: number decoded is greater than %d * * * \n", error_if_greater_than);
+	  exit (EXIT_FAILURE);
+	}
+
+	exit (EXIT_SUCCESS);
+}
+
+
+/*
+ * Make the whole file available in memory.
+ * It is memory mapped so nothing is read until needed and pages
+ * already processed can be dropped.  Windows simply reads it in.
+ */
+
+static void map_file (char *fname)
+{
+#if __WIN32__
+	FILE *fp = fopen(fname, "rb");
+	if (fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't open file for read: %s\n", fname);
+	  exit (EXIT_FAILURE);
+	}
+	fseek (fp, 0L, SEEK_END);
+	wav_map_len = ftell (fp);
+	fseek (fp, 0L, SEEK_SET);
+	wav_map = malloc (wav_map_len + 1);
+	if (wav_map == NULL || fread (wav_map, 1, wav_map_len, fp) != wav_map_len) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't read file: %s\n", fname);
+	  exit (EXIT_FAILURE);
+	}
+	fclose (fp);
+#else
+	struct stat st;
+	int fd = open (fname, O_RDONLY);
+	if (fd < 0 || fstat (fd, &st) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't open file for read: %s\n", fname);
+	  exit (EXIT_FAILURE);
+	}
+	wav_map_len = st.st_size;
+	wav_map = wav_map_len > 0 ? mmap (NULL, wav_map_len, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+	close (fd);
+	if (wav_map == MAP_FAILED) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't map file %s into memory: %s\n", fname, wav_map_len > 0 ? strerror(errno) : "empty file");
+	  exit (EXIT_FAILURE);
+	}
+	madvise (wav_map, wav_map_len, MADV_SEQUENTIAL);
+#endif
+	wav_pos = 0;
+	wav_next = wav_end = wav_map;
+}
+
+static void unmap_file (void)
+{
+	if (wav_map != NULL) {
+#if __WIN32__
+	  free (wav_map);
+#else
+	  munmap (wav_map, wav_map_len);
+#endif
+	  wav_map = NULL;
+	}
+}
+
+/* Take the next part of the header.  Zero fill if beyond end of file. */
+
+static void map_read (void *dest, size_t len)
+{
+	size_t avail = wav_pos < wav_map_len ? wav_map_len - wav_pos : 0;
+
+	memset (dest, 0, len);
+	memcpy (dest, wav_map + wav_pos, len < avail ? len : avail);
+	wav_pos += len;
+}
+
+
+/*
+ * Open .WAV file and read the header.
+ * Set audio configuration to match and set wav_next & wav_end to the audio data.
+ * Returns duration in seconds.
+ */
+
+static double read_wav_header (char *fname)
+{
+	double duration;
+
+	map_file (fname);
 
 /*
  * Read the file header.  
  * Doesn't handle all possible cases but good enough for our purposes.
  */
 
-        err= fread (&header, (size_t)12, (size_t)1, fp);
-	(void)(err);
+	map_read (&header, (size_t)12);
 
 	if (strncmp(header.riff, "RIFF", 4) != 0 || strncmp(header.wave, "WAVE", 4) != 0) {
 	  text_color_set(DW_COLOR_ERROR);
@@ -569,11 +792,11 @@ int main (int argc, char *argv[])
           exit (EXIT_FAILURE);
 	}
 
-	err = fread (&chunk, (size_t)8, (size_t)1, fp);
+	map_read (&chunk, (size_t)8);
 
 	if (strncmp(chunk.id, "LIST", 4) == 0) {
-	  err = fseek (fp, (long)chunk.datasize, SEEK_CUR);
-	  err = fread (&chunk, (size_t)8, (size_t)1, fp);
+	  wav_pos += (unsigned)chunk.datasize;
+	  map_read (&chunk, (size_t)8);
 	}
 
 	if (strncmp(chunk.id, "fmt ", 4) != 0) {
@@ -587,9 +810,11 @@ int main (int argc, char *argv[])
 	  exit(EXIT_FAILURE);
 	}
 
-        err = fread (&format, (size_t)chunk.datasize, (size_t)1, fp);	
+	map_read (&format, (size_t)chunk.datasize);
 
-	err = fread (&wav_data, (size_t)8, (size_t)1, fp);
+	map_read (&wav_data, (size_t)8);
+
+	wav_data_offset = wav_pos;
 
 	if (strncmp(wav_data.data, "data", 4) != 0) {
 	  text_color_set(DW_COLOR_ERROR);
@@ -615,6 +840,21 @@ int main (int argc, char *argv[])
 	  exit (EXIT_FAILURE);
 	}
 
+/*
+ * Some recorders write the header before they know the size.
+ * Use what is actually there if the file is shorter than the header claims.
+ */
+	if (wav_pos > wav_map_len) {
+	  wav_pos = wav_map_len;
+	}
+	if ((size_t)(unsigned)wav_data.datasize > wav_map_len - wav_pos) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("WAV file header says %u audio bytes but only %d are in the file.\n", (unsigned)wav_data.datasize, (int)(wav_map_len - wav_pos));
+	  wav_data.datasize = (int)(wav_map_len - wav_pos);
+	}
+	wav_next = wav_map + wav_pos;
+	wav_end = wav_next + wav_data.datasize;
+
         my_audio_config.adev[0].samples_per_sec = format.nsamplespersec;
 	my_audio_config.adev[0].bits_per_sample = format.wbitspersample;
  	my_audio_config.adev[0].num_channels = format.nchannels;
@@ -629,43 +869,44 @@ int main (int argc, char *argv[])
 		my_audio_config.adev[0].samples_per_sec,
 		my_audio_config.adev[0].bits_per_sample,
 		my_audio_config.adev[0].num_channels);
-	one_filetime = (double) wav_data.datasize /
+	duration = (double) wav_data.datasize /
 		((my_audio_config.adev[0].bits_per_sample / 8) * my_audio_config.adev[0].num_channels * my_audio_config.adev[0].samples_per_sec);
-	total_filetime += one_filetime;
 
 	dw_printf ("%d audio bytes in file.  Duration = %.1f seconds.\n",
 		(int)(wav_data.datasize),
-		one_filetime);
+		duration);
 	dw_printf ("Fix Bits level = %d\n", my_audio_config.achan[0].fix_bits);
-		
+
+	return (duration);
+}
+
+
 /*
- * Initialize the AFSK demodulator and HDLC decoder.
- * Needs to be done for each file because they could have different sample rates.
+ * Feed audio samples from the file to the demodulators until end of data.
  */
-	multi_modem_init (&my_audio_config);
-	packets_decoded_one = 0;
-
 
-	e_o_f = 0;
-	while ( ! e_o_f) 
-	{
+static void decode_samples (void)
+{
+	int num_channels = my_audio_config.adev[0].num_channels;
+	int bytes_per_sample = my_audio_config.adev[0].bits_per_sample / 8;
 
+	/* Conversion is the same as demod_get_sample but without */
+	/* a couple function calls for every byte. */
 
+	while (wav_next + num_channels * bytes_per_sample <= wav_end) 
+	{
           int audio_sample;
           int c;
 
-          for (c=0; c<my_audio_config.adev[0].num_channels; c++)
+          for (c=0; c<num_channels; c++)
           {
-
-            /* This reads either 1 or 2 bytes depending on */
-            /* bits per sample.  */
-
-            audio_sample = demod_get_sample (ACHAN2ADEV(c));
-
-            if (audio_sample >= 256 * 256) {
-               e_o_f = 1;
-	       continue;
+	    if (bytes_per_sample == 2) {
+	      audio_sample = (signed short)(wav_next[0] | (wav_next[1] << 8));	/* little endian */
+	    }
+	    else {
+	      audio_sample = (wav_next[0] - 128) * 256;			/* unsigned 0..255 */
 	    }
+	    wav_next += bytes_per_sample;
 
 	    if (c == 0) sample_number++;
 
@@ -679,87 +920,89 @@ int main (int argc, char *argv[])
                 /* process_rec_frame, below, is called. */
 
 	}
-	text_color_set(DW_COLOR_INFO);
-	dw_printf ("\n\n");
-
-#if EXPERIMENT_G
-
-	for (j=0; j<MAX_SUBCHANS; j++) {
-	  float db = 20.0 * log10f(space_gain[j]);
-	  dw_printf ("%+.1f dB, %d\n", db, count[j]);
-	}
-#endif
-#if EXPERIMENT_H
+}
 
-	for (j=0; j<MAX_SUBCHANS; j++) {
-	  dw_printf ("%d\n", count[j]);
-	}
-#endif
 
-	dw_printf ("%d from %s\n", packets_decoded_one, argv[optind]);
-	packets_decoded_total += packets_decoded_one;
+/*
+ * Simulate sample from the audio device.
+ * Needed for demod_get_sample which decode_samples no longer uses.
+ */
 
-	fclose (fp);
-	optind++;
+int audio_get (int a)
+{
+	if (wav_next >= wav_end) {
+	  return (-1);
 	}
+	return (*wav_next++);
+}
 
-	elapsed = dtime_now() - start_time;
 
-	dw_printf ("%d packets decoded in %.3f seconds.  %.1f x realtime\n", packets_decoded_total, elapsed, total_filetime/elapsed);
-	if (d_o_opt) {
-	  dw_printf ("DCD count = %d\n", dcd_count);
-	  dw_printf ("DCD missing errors = %d\n", dcd_missing_errors);
-	}
 
-	if (error_if_less_than != -1 && packets_decoded_total < error_if_less_than) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("\n * * * TEST FAILED: number decoded is less than %d * * * \n", error_if_less_than);
-	  exit (EXIT_FAILURE);
-	}
-	if (error_if_greater_than != -1 && packets_decoded_total > error_if_greater_than) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("\n * * * TEST FAILED: number decoded is greater than %d * * * \n", error_if_greater_than);
-	  exit (EXIT_FAILURE);
-	}
-
-	exit (EXIT_SUCCESS);
-}
+/*
+ * This is called when we have a good frame.
+ */
 
 
 /*
- * Simulate sample from the audio device.
+ * What a parallel decoding child process sends back for each frame.
+ * The frame bytes follow.
  */
 
-int audio_get (int a)
-{
-	int ch;
-
-	if (wav_data.datasize <= 0) {
-	  e_o_f = 1;
-	  return (-1);
-	}
+typedef struct seg_frame_s {
+	int chan;
+	int subchan;
+	int slice;
+	alevel_t alevel;
+	fec_type_t fec_type;
+	retry_t retries;
+	int sample_number;		/* When it was decoded. */
+	int dcd_missing;
+	int flen;
+	char spectrum[MAX_SUBCHANS*MAX_SLICERS+1];
+} seg_frame_t;
 
-	ch = getc(fp);
-	wav_data.datasize--;
 
-	if (ch < 0) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Unexpected end of file.\n");
-	  e_o_f = 1;
+void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, fec_type_t fec_type, retry_t retries, char *spectrum)
+{	
+	if (seg_fp != NULL) {
+
+/* Parallel decoding.  Keep only the frames belonging to this segment. */
+
+	  if (sample_number >= seg_first_sample) {
+	    seg_frame_t f;
+	    unsigned char fbuf[AX25_MAX_PACKET_LEN];
+
+	    memset (&f, 0, sizeof(f));
+	    f.chan = chan;
+	    f.subchan = subchan;
+	    f.slice = slice;
+	    f.alevel = alevel;
+	    f.fec_type = fec_type;
+	    f.retries = retries;
+	    f.sample_number = sample_number;
+	    f.dcd_missing = ! hdlc_rec_data_detect_any(chan);
+	    f.flen = ax25_pack (pp, fbuf);
+	    strlcpy (f.spectrum, spectrum, sizeof(f.spectrum));
+
+	    fwrite (&f, sizeof(f), 1, seg_fp);
+	    fwrite (fbuf, f.flen, 1, seg_fp);
+	  }
+	  ax25_delete (pp);
+	  return;
 	}
 
-	return (ch);
-}
+	if ( ! hdlc_rec_data_detect_any(chan)) dcd_missing_errors++;
 
+	print_frame (chan, subchan, slice, pp, alevel, fec_type, retries, spectrum);
+}
 
 
 /*
- * This is called when we have a good frame.
+ * Display the frame.
  */
 
-void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, fec_type_t fec_type, retry_t retries, char *spectrum)
-{	
-	
+static void print_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alevel, fec_type_t fec_type, retry_t retries, char *spectrum)
+{
 	char stemp[500];
 	unsigned char *pinfo;
 	int info_len;
@@ -768,7 +1011,6 @@ void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alev
 	char alevel_text[AX25_ALEVEL_TO_TEXT_SIZE];
 
 	packets_decoded_one++;
-	if ( ! hdlc_rec_data_detect_any(chan)) dcd_missing_errors++;
 
 	ax25_format_addrs (pp, stemp);
 
@@ -915,7 +1157,263 @@ void dlq_rec_frame (int chan, int subchan, int slice, packet_t pp, alevel_t alev
 
 	ax25_delete (pp);
 
-} /* end fake dlq_append */
+} /* end print_frame */
+
+
+#if ! __WIN32__
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        parallel_decode
+ *
+ * Purpose:     Decode recordings using multiple processes, for -p option.
+ *
+ * Inputs:	num_files	- Number of .WAV files.
+ *		file_names	- Their names.
+ *
+ * Returns:	Total duration of all files, in seconds.
+ *
+ * Description:	Each file is cut into segments of -s seconds and each
+ *		segment is decoded by a separate process, up to -p of them
+ *		at once.  All of the demodulator state is global so separate
+ *		processes are the easy way to run the same code side by side.
+ *
+ *		A segment begins decoding early, by the time of the longest
+ *		possible frame, so nothing is lost at the boundaries.  A frame
+ *		belongs to the segment where it is decoded, using the same
+ *		sample number as a single process would.  Frames decoded
+ *		during the overlap are dropped because the previous segment
+ *		has them.
+ *
+ *		Frames come back in a temporary file for each segment and
+ *		are displayed in the original order, as if decoded in one
+ *		pass, as soon as all earlier segments are done.
+ *
+ *--------------------------------------------------------------------*/
+
+typedef struct seg_file_s {
+	char *name;
+	long data_offset;		/* Where audio begins in file. */
+	int block_align;		/* Bytes for one sample time, all channels. */
+	int num_samples;		/* Sample times in file. */
+	int samples_per_sec;
+	int bits_per_sample;
+	int num_channels;
+} seg_file_t;
+
+typedef struct seg_job_s {
+	int file;			/* Index into files. */
+	int first_sample;		/* Frames decoded before this belong to the previous segment. */
+	int start_sample;		/* Start decoding here, earlier by the overlap. */
+	int end_sample;			/* Stop decoding here. */
+	FILE *out;			/* Frames found. */
+	int done;
+	int failed;
+} seg_job_t;
+
+
+static void decode_segment (seg_file_t *sf, seg_job_t *job)
+{
+
+/* Anything else printed would be mixed up with other processes.  The parent has already shown the setup. */
+
+	if (freopen ("/dev/null", "w", stdout) == NULL) {
+	  _exit (EXIT_FAILURE);
+	}
+
+	map_file (sf->name);
+	wav_next = wav_map + sf->data_offset + (size_t)(job->start_sample) * sf->block_align;
+	wav_end = wav_map + sf->data_offset + (size_t)(job->end_sample) * sf->block_align;
+
+	my_audio_config.adev[0].samples_per_sec = sf->samples_per_sec;
+	my_audio_config.adev[0].bits_per_sample = sf->bits_per_sample;
+	my_audio_config.adev[0].num_channels = sf->num_channels;
+	my_audio_config.chan_medium[0] = MEDIUM_RADIO;
+	if (sf->num_channels == 2) {
+	  my_audio_config.chan_medium[1] = MEDIUM_RADIO;
+	}
+
+	multi_modem_init (&my_audio_config);
+
+	sample_number = job->start_sample - 1;
+	seg_first_sample = job->first_sample;
+	seg_fp = job->out;
+
+	decode_samples ();
+
+	unmap_file ();
+	fflush (seg_fp);
+	fflush (stdout);
+	_exit (EXIT_SUCCESS);
+}
+
+
+static double parallel_decode (int num_files, char **file_names)
+{
+	seg_file_t *files = calloc (num_files, sizeof(seg_file_t));
+	seg_job_t *jobs = NULL;
+	int num_jobs = 0;
+	int next_start = 0;		/* Next job to start. */
+	int next_print = 0;		/* Next job to display. */
+	int running = 0;
+	double total_time = 0;
+	int n;
+
+/*
+ * The longest frame, with bit stuffing, FEC, and preamble, determines
+ * how far back a segment must start.
+ */
+	int baud = my_audio_config.achan[0].baud;
+	double overlap_sec = ((AX25_MAX_PACKET_LEN + 512) * 8. * 1.25) / baud + 1.;
+	double seg_sec = s_opt > 0 ? s_opt : 300.;
+
+	if (seg_sec < 10. * overlap_sec) {
+	  seg_sec = 10. * overlap_sec;
+	  if (s_opt > 0) {
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("Segment length of %.0f seconds is too short for %d baud.  Using %.0f seconds, 10 times the overlap.\n", s_opt, baud, seg_sec);
+	  }
+	}
+
+	for (n = 0; n < num_files; n++) {
+	  seg_file_t *sf = &files[n];
+	  int seg_samples, overlap_samples, start;
+
+	  total_time += read_wav_header (file_names[n]);
+	  unmap_file ();
+	  multi_modem_init (&my_audio_config);
+
+	  sf->name = file_names[n];
+	  sf->data_offset = wav_data_offset;
+	  sf->samples_per_sec = my_audio_config.adev[0].samples_per_sec;
+	  sf->bits_per_sample = my_audio_config.adev[0].bits_per_sample;
+	  sf->num_channels = my_audio_config.adev[0].num_channels;
+	  sf->block_align = sf->bits_per_sample / 8 * sf->num_channels;
+	  sf->num_samples = wav_data.datasize / sf->block_align;
+
+	  seg_samples = (int)(seg_sec * sf->samples_per_sec);
+	  overlap_samples = (int)(overlap_sec * sf->samples_per_sec);
+
+	  start = 0;
+	  do {
+	    seg_job_t *job;
+
+	    jobs = realloc (jobs, (num_jobs + 1) * sizeof(seg_job_t));
+	    job = &jobs[num_jobs++];
+	    memset (job, 0, sizeof(seg_job_t));
+	    job->file = n;
+	    job->first_sample = start;
+	    job->start_sample = start > overlap_samples ? start - overlap_samples : 0;
+	    job->end_sample = start + seg_samples < sf->num_samples ? start + seg_samples : sf->num_samples;
+	    start += seg_samples;
+	  } while (start < sf->num_samples);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Decoding %d segment%s of up to %.0f seconds, using %d processes.\n",
+			num_jobs, num_jobs == 1 ? "" : "s", seg_sec, p_opt);
+
+	while (next_print < num_jobs) {
+
+/* Start more while we are below the limit. */
+
+	  while (next_start < num_jobs && running < p_opt) {
+	    seg_job_t *job = &jobs[next_start];
+	    pid_t pid;
+
+	    job->out = tmpfile ();
+	    if (job->out == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Can't create temporary file.\n");
+	      exit (EXIT_FAILURE);
+	    }
+	    fflush (stdout);
+	    pid = fork ();
+	    if (pid == 0) {
+	      decode_segment (&files[job->file], job);	/* Does not return. */
+	    }
+	    if (pid < 0) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Can't create another process.\n");
+	      exit (EXIT_FAILURE);
+	    }
+	    job->done = - (int)pid;		/* Negative while running. */
+	    running++;
+	    next_start++;
+	  }
+
+/* Display, in order, everything that is finished. */
+
+	  while (next_print < num_jobs && jobs[next_print].done > 0) {
+	    seg_job_t *job = &jobs[next_print];
+	    seg_frame_t f;
+	    unsigned char fbuf[AX25_MAX_PACKET_LEN];
+
+	    if (job->first_sample == 0) {
+	      packets_decoded_one = 0;
+	    }
+	    if (job->failed) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Decoding failed for segment starting at %.1f seconds of %s.\n",
+			(double)(job->first_sample) / files[job->file].samples_per_sec, files[job->file].name);
+	    }
+
+	    rewind (job->out);
+	    while (fread (&f, sizeof(f), 1, job->out) == 1 &&
+			f.flen > 0 && f.flen <= AX25_MAX_PACKET_LEN &&
+			fread (fbuf, f.flen, 1, job->out) == 1) {
+	      packet_t pp = ax25_from_frame (fbuf, f.flen, f.alevel);
+
+	      if (pp != NULL) {
+	        sample_number = f.sample_number;
+	        my_audio_config.adev[0].samples_per_sec = files[job->file].samples_per_sec;
+	        dcd_missing_errors += f.dcd_missing;
+	        print_frame (f.chan, f.subchan, f.slice, pp, f.alevel, f.fec_type, f.retries, f.spectrum);
+	      }
+	    }
+	    fclose (job->out);
+
+	    if (next_print == num_jobs - 1 || jobs[next_print+1].file != job->file) {
+	      text_color_set(DW_COLOR_INFO);
+	      dw_printf ("\n\n");
+	      dw_printf ("%d from %s\n", packets_decoded_one, files[job->file].name);
+	      packets_decoded_total += packets_decoded_one;
+	    }
+	    next_print++;
+	  }
+
+/* Wait for another to finish. */
+
+	  if (running > 0) {
+	    int status;
+	    pid_t pid = wait (&status);
+	    int k;
+
+	    if (pid > 0) {
+	      for (k = next_print; k < next_start; k++) {
+	        if (jobs[k].done == - (int)pid) {
+	          jobs[k].done = 1;
+	          jobs[k].failed = ! WIFEXITED(status) || WEXITSTATUS(status) != EXIT_SUCCESS;
+	        }
+	      }
+	      running--;
+	    }
+	  }
+	}
+
+	free (jobs);
+	free (files);
+	return (total_time);
+}
+
+#else
+
+static double parallel_decode (int num_files, char **file_names)
+{
+	return (0);		/* Not used.  -p is always 1 for Windows. */
+}
+
+#endif
 
 
 void ptt_set (int ot, int chan, int ptt_signal)
@@ -960,6 +1458,71 @@ int get_input (int it, int chan)
 	return -1;
 }
 
+/*------------------------------------------------------------------
+ *
+ * Name:        bit_benchmark
+ *
+ * Purpose:     Measure how fast received bits are searched for frames.
+ *
+ * Inputs:	nslicers	- Number of slicers.  Each gets every bit.
+ *
+ * Description:	Pseudo random bits go straight to hdlc_rec_bit, without
+ *		the demodulator, so this is only the HDLC flag, FX.25 tag
+ *		and IL2P sync word search.  It is done once with everything
+ *		enabled and again with FX.25 and IL2P turned off, as with
+ *		FX25RX OFF and IL2PRX OFF in the configuration file.
+ *
+ *		The -B option picks scrambled or not.
+ *		Result is total bits handled by all slicers divided by time,
+ *		in other words, how fast one slicer would be on its own.
+ *
+ *------------------------------------------------------------------*/
+
+static void bit_benchmark (int nslicers)
+{
+	enum { NBITS = 1 << 20, REPS = 20 };
+	static unsigned char bits[NBITS];
+	unsigned int seed = 1;
+	int is_scrambled = my_audio_config.achan[0].modem_type == MODEM_SCRAMBLE;
+
+	for (int n = 0; n < NBITS; n++) {
+	  seed = seed * 1103515245 + 12345;
+	  bits[n] = (seed >> 16) & 1;
+	}
+
+	fx25_init (0);
+	il2p_init (0);
+	my_audio_config.chan_medium[0] = MEDIUM_RADIO;
+
+	for (int off = 0; off <= 1; off++) {
+
+	  my_audio_config.achan[0].fx25_rec_disable = off;
+	  my_audio_config.achan[0].il2p_rec_disable = off;
+	  multi_modem_init (&my_audio_config);
+
+	  double start = dtime_monotonic();
+
+	  for (int r = 0; r < REPS; r++) {
+	    for (int n = 0; n < NBITS; n++) {
+	      for (int k = 0; k < nslicers; k++) {
+	        hdlc_rec_bit (0, 0, k, bits[n], is_scrambled, 0);
+	      }
+	    }
+	  }
+
+	  double elapsed = dtime_monotonic() - start;
+
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("%d bps%s, %d slicer%s, FX.25 and IL2P %s:  %.1f million bits/sec per slicer.\n",
+			my_audio_config.achan[0].baud, is_scrambled ? " scrambled" : "",
+			nslicers, nslicers == 1 ? "" : "s", off ? "off" : "on",
+			(double)NBITS * REPS * nslicers / elapsed / 1e6);
+	}
+
+} /* end bit_benchmark */
+
+
+
 static void usage (void) {
 
 	text_color_set(DW_COLOR_ERROR);
@@ -995,7 +1558,11 @@ static void usage (void) {
 	dw_printf ("               1 = Try to fix only a single bit.  \n");
 	dw_printf ("               more = Try modifying more bits to get a good CRC.\n");
 	dw_printf ("\n");
+	dw_printf ("        -b n   Measure speed of searching received bits for the start of\n");
+	dw_printf ("               HDLC, FX.25 and IL2P frames with n slicers.  No audio file.\n");
+	dw_printf ("\n");
 	dw_printf ("        -d x   Debug information for FX.25.  Repeat for more detail.\n");
+	dw_printf ("        -d b   Memory used for raw received bit buffers.\n");
 	dw_printf ("\n");
 	dw_printf ("        -L     Error if less than this number decoded.\n");
 	dw_printf ("\n");
@@ -1004,6 +1571,11 @@ static void usage (void) {
 	dw_printf ("        -P m   Select  the  demodulator  type such as D (default for 300 bps),\n");
 	dw_printf ("               E+ (default for 1200 bps), PQRS for 2400 bps, etc.\n");
 	dw_printf ("\n");
+	dw_printf ("        -p n   Decode using n processes in parallel.  Long recordings\n");
+	dw_printf ("               are split into segments and several files are done at once.\n");
+	dw_printf ("        -s n   Segment length in seconds for -p.  Default 300.\n");
+	dw_printf ("               At least 10 times the longest frame time.\n");
+	dw_printf ("\n");
 	dw_printf ("        -0     Use channel 0 (left) of stereo audio (default).\n");
 	dw_printf ("        -1     use channel 1 (right) of stereo audio.\n");
 	dw_printf ("        -2     decode both channels of stereo audio.\n");
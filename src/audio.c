@@ -110,6 +110,9 @@ static struct adev_s {
 
 	int bytes_per_frame;		/* number of bytes for a sample from all channels. */
 					/* e.g. 4 for stereo 16 bit. */
+
+	int tstamp_bad;			/* Capture timestamp was not close to the time of */
+					/* day.  Warning has been issued. */
 #elif USE_SNDIO
 	struct sio_hdl *sndio_in_handle;
 	struct sio_hdl *sndio_out_handle;
@@ -441,7 +444,11 @@ int audio_open (struct audio_s *pa)
 
 	        /* Do we need to adjust any properties of stdin? */
 
-	        adev[a].inbuf_size_in_bytes = 1024; 
+	        /* Formerly 1024 which meant a read() for every 512 samples */
+	        /* when decoding a file.  A pipe from something like rtl_fm */
+	        /* returns whatever is available so this doesn't add latency. */
+
+	        adev[a].inbuf_size_in_bytes = 32768; 
 	    
 	        break;
 
@@ -701,6 +708,28 @@ static int set_alsa_params (int a, snd_pcm_t *handle, struct audio_s *pa, char *
 	}
 
 	snd_pcm_hw_params_free (hw_params);
+
+	/* For input, ask for timestamps so audio_get can figure out when */
+	/* the samples were captured rather than when we got around to */
+	/* reading them.  Not fatal if the driver won't do it. */
+	/* They must be time of day, like dtime_realtime, not the monotonic */
+	/* clock which some configurations use by default. */
+
+	if (*inout == 'i') {
+	  snd_pcm_sw_params_t *sw_params;
+
+	  adev[a].tstamp_bad = 0;
+	  if (snd_pcm_sw_params_malloc (&sw_params) == 0) {
+	    if (snd_pcm_sw_params_current (handle, sw_params) < 0 ||
+	        snd_pcm_sw_params_set_tstamp_mode (handle, sw_params, SND_PCM_TSTAMP_ENABLE) < 0 ||
+	        snd_pcm_sw_params_set_tstamp_type (handle, sw_params, SND_PCM_TSTAMP_TYPE_GETTIMEOFDAY) < 0 ||
+	        snd_pcm_sw_params (handle, sw_params) < 0) {
+	      text_color_set(DW_COLOR_DEBUG);
+	      dw_printf ("Audio device %d can't supply capture timestamps.  Using time of read instead.\n", a);
+	    }
+	    snd_pcm_sw_params_free (sw_params);
+	  }
+	}
 	
 	/* A "frame" is one sample for all channels. */
 
@@ -1070,6 +1099,29 @@ int audio_get (int a)
 			n, 
 			save_audio_config_p->statistics_interval);
 
+		/* Refine the capture time.  At tstamp, 'avail' frames had */
+		/* been captured after the last one we just read. */
+		/* If that's more than a second away from the time of day, */
+		/* the driver is using some other clock.  Stay with the time */
+		/* of the read, which audio_stats keeps with frames read. */
+
+	        snd_pcm_uframes_t avail;
+	        snd_htimestamp_t tstamp;
+
+	        if (snd_pcm_htimestamp (adev[a].audio_in_handle, &avail, &tstamp) == 0 && tstamp.tv_sec != 0) {
+	          double t = (double)tstamp.tv_sec + tstamp.tv_nsec * 0.000000001 -
+				(double)avail / save_audio_config_p->adev[a].samples_per_sec;
+	          double now = dtime_realtime();
+
+	          if (t > now - 1.0 && t < now + 1.0) {
+	            audio_stats_capture_time (a, t);
+	          }
+	          else if ( ! adev[a].tstamp_bad) {
+	            adev[a].tstamp_bad = 1;
+	            text_color_set(DW_COLOR_DEBUG);
+	            dw_printf ("Audio device %d capture timestamp is %.1f seconds from time of day.  Using time of read instead.\n", a, t - now);
+	          }
+	        }
 	      }
 	      else if (n == 0) {
 
@@ -31,7 +31,8 @@ enum ptt_method_e {
 	PTT_METHOD_GPIO,	/* General purpose I/O, Linux only. */
 	PTT_METHOD_LPT,	    	/* Parallel printer port, Linux only. */
 	PTT_METHOD_HAMLIB, 	/* HAMLib, Linux only. */
-	PTT_METHOD_CM108 };	/* GPIO pin of CM108/CM119/etc.  Linux only. */
+	PTT_METHOD_CM108,	/* GPIO pin of CM108/CM119/etc.  Linux only. */
+	PTT_METHOD_GPIOD };	/* GPIO character device.  Linux only. */
 
 typedef enum ptt_method_e ptt_method_t;
 
@@ -146,6 +147,14 @@ struct audio_s {
 					/* Redundant but it makes things quicker and simpler */
 					/* than always searching thru above. */
 
+	int diversity_primary[MAX_CHANS];
+					/* DIVERSITY command groups radio channels */
+					/* which hear the same frequency.  This is the */
+					/* first channel in the group, or -1 if not in one. */
+
+	int diversity_window;		/* Time, in milliseconds, to wait for other */
+					/* copies of a frame from the same group. */
+
 	/* Properties for each radio channel, common to receive and transmit. */
 	/* Can be different for each radio channel. */
 
@@ -192,6 +201,9 @@ struct audio_s {
 
 	    int il2p_invert_polarity;	// 1 means invert on transmit.  Receive handles either automatically.
 
+	    int fx25_rec_disable;	// Don't look for FX.25 or IL2P in received bits.
+	    int il2p_rec_disable;	// Zero, the default, means listen for it.
+
 	    enum v26_e { V26_UNSPECIFIED=0, V26_A, V26_B } v26_alternative;
 
 					// Original implementation used alternative A for 2400 bbps PSK.
@@ -274,7 +286,7 @@ struct audio_s {
 	
 	    struct {  		
 
-	        ptt_method_t ptt_method; /* none, serial port, GPIO, LPT, HAMLIB, CM108. */
+	        ptt_method_t ptt_method; /* none, serial port, GPIO, LPT, HAMLIB, CM108, GPIOD. */
 
 	        char ptt_device[128];	/* Serial device name for PTT.  e.g. COM1 or /dev/ttyS0 */
 					/* Also used for HAMLIB.  Could be host:port when model is 1. */
@@ -307,6 +319,9 @@ struct audio_s {
 
 					/* This could probably be collapsed into ptt_device instead of being separate. */
 
+					/* For GPIOD, this is the chip name, e.g. gpiochip0, from the */
+					/* configuration file and out_gpio_num is the line offset. */
+
 	        int ptt_lpt_bit;	/* Bit number for parallel printer port.  */
 					/* Bit 0 = pin 2, ..., bit 7 = pin 9. */
 
@@ -331,9 +346,9 @@ struct audio_s {
 #define NUM_ICTYPES 1		/* number of values above. i.e. last value +1. */
 
 	    struct {
-		ptt_method_t method;	/* none, serial port, GPIO, LPT. */
+		ptt_method_t method;	/* none, GPIO, GPIOD. */
 
-		int in_gpio_num;	/* GPIO number */
+		int in_gpio_num;	/* GPIO number, or line offset for GPIOD. */
 
 		char in_gpio_name[MAX_GPIO_NAME_LEN];
 					/* originally, gpio number NN was assumed to simply */
@@ -341,6 +356,7 @@ struct audio_s {
 					/* the case for CubieBoard where it was longer. */
 					/* This is filled in by ptt_init so we don't have to */
 					/* recalculate it each time we access it. */
+					/* For GPIOD, this is the chip name from the configuration file. */
 
 		int invert;		/* 1 = active low */
 	    } ictrl[NUM_ICTYPES];
@@ -372,6 +388,10 @@ struct audio_s {
 
 	    int fulldup;		/* Full Duplex. */
 
+	    int maxtxtime;		/* Limit for bundling frames into one transmission, */
+					/* including txdelay and txtail.  10 mS units. */
+					/* Default 0 means no limit. */
+
 	} achan[MAX_CHANS];
 
 #ifdef USE_HAMLIB
@@ -429,6 +449,9 @@ struct audio_s {
 #define DEFAULT_FIX_BITS RETRY_NONE	// Interesting research project but even a single bit fix up
 					// will occasionally let corrupted packets through.
 
+#define DEFAULT_DIVERSITY_WINDOW 150	// Milliseconds.  Enough to cover different audio
+					// buffering delays on separate sound cards.
+
 /* 
  * Standard for AFSK on VHF FM. 
  * Reversing mark and space makes no difference because
@@ -44,6 +44,11 @@
  *
  *		We also add a command line option to adjust the time
  *		between reports or turn them off entirely.
+ *
+ *		Every buffer read passes through here so this is also
+ *		where we keep the time reference used to figure out when
+ *		a received frame was actually captured.  See
+ *		audio_stats_time_ref below.
  *		
  * Revisions: 	This is new in version 1.3.
  *
@@ -66,7 +71,22 @@
 #include "audio_stats.h"
 #include "textcolor.h"
 #include "demod.h"		/* for alevel_t & demod_get_audio_level() */
+#include "dtime_now.h"
+
+
+/*
+ * Time reference for each audio device.
+ *
+ * frames_read is the total number of frames (one sample for each channel)
+ * obtained from the device since start up.  capture_time is the time,
+ * in dtime_realtime() format, when the last of those was captured.
+ *
+ * These are only touched by the receive thread for the device so no lock
+ * is needed.  The same thread runs the demodulators and HDLC decoders.
+ */
 
+static long long frames_read[MAX_ADEVS];
+static double capture_time[MAX_ADEVS];
 
 
 /*------------------------------------------------------------------
@@ -105,12 +125,17 @@ void audio_stats (int adev, int nchan, int nsamp, int interval)
 	static int suppress_first[MAX_ADEVS];
 
 
+	assert (adev >= 0 && adev < MAX_ADEVS);
+
+	if (nsamp > 0) {
+	  frames_read[adev] += nsamp;
+	  capture_time[adev] = dtime_realtime();
+	}
+
 	if (interval <= 0) {
 	  return;
 	}
 
-	assert (adev >= 0 && adev < MAX_ADEVS);
-
 /*
  * Print information about the sample rate as a troubleshooting aid.
  * I've never seen an issue with Windows or x86 Linux but the Raspberry Pi
@@ -177,5 +202,69 @@ void audio_stats (int adev, int nchan, int nsamp, int interval)
 	  }      
 	}
 
-}   /* end audio_stats.c */
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        audio_stats_capture_time
+ *
+ * Purpose:     Replace the time, of the most recent audio_stats call,
+ *		with something better when the audio system can tell us.
+ *
+ * Inputs:	adev	- Audio device number.
+ *
+ *		t	- When the last frame of the buffer was captured,
+ *			  in dtime_realtime() format.
+ *
+ * Description:	audio_stats uses the time when the read returned.
+ *		That can be late by up to a period if the samples were
+ *		sitting in the driver's buffer.  For ALSA, we can get a
+ *		hardware timestamp and the number of frames still waiting,
+ *		which is much closer to the truth.
+ *
+ *----------------------------------------------------------------*/
+
+void audio_stats_capture_time (int adev, double t)
+{
+	assert (adev >= 0 && adev < MAX_ADEVS);
+
+	if (t > 0) {
+	  capture_time[adev] = t;
+	}
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        audio_stats_time_ref
+ *
+ * Purpose:     Get the time reference for an audio device.
+ *
+ * Inputs:	adev	- Audio device number.
+ *
+ * Outputs:	frames	- Number of frames read from the device so far.
+ *
+ *		t	- When the last of those was captured.
+ *
+ * Returns:	1 for success, 0 if nothing has been read from the
+ *		device yet.  e.g. atest doesn't use the audio device.
+ *
+ * Description:	Frame n, counting from 1, was captured at about
+ *
+ *			t - (frames - n) / samples_per_sec
+ *
+ *----------------------------------------------------------------*/
+
+int audio_stats_time_ref (int adev, long long *frames, double *t)
+{
+	assert (adev >= 0 && adev < MAX_ADEVS);
+
+	*frames = frames_read[adev];
+	*t = capture_time[adev];
+
+	return (frames_read[adev] > 0);
+}
+
+/* end audio_stats.c */
 
@@ -5,3 +5,7 @@
 
 extern void audio_stats (int adev, int nchan, int nsamp, int interval);
 
+extern void audio_stats_capture_time (int adev, double t);
+
+extern int audio_stats_time_ref (int adev, long long *frames, double *t);
+
@@ -0,0 +1,356 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      ax25_cc.c
+ *
+ * Purpose:   	Round trip time measurement and congestion control
+ *		for connected mode links.
+ *
+ * Description:	Originally T1 was adjusted from the time remaining on T1
+ *		when it was stopped.  That measures from the most recent I frame
+ *		sent, not the one being acknowledged, and can't tell whether
+ *		the acknowledgement was for the original or a retransmission.
+ *		The window size was fixed by MAXFRAME / EMAXFRAME or XID.
+ *		On a busy channel, a full window of frames just makes more
+ *		collisions and more retries.
+ *
+ *		Here we keep track of when each I frame was sent.
+ *
+ *		Round trip time is sampled when a frame is acknowledged, but
+ *		only if it was sent exactly once (Karn's algorithm).
+ *		Smoothed RTT and its variation are combined for T1 as in TCP
+ *		(RFC 6298).
+ *
+ *		Time is measured on a "link clock" which stops while the radio
+ *		channel is busy, the same way timer T1 is paused.  Otherwise
+ *		our own transmit time and other stations would be counted.
+ *
+ *		The effective window starts at the configured / negotiated
+ *		maximum so a clean link behaves exactly as before.
+ *		A timeout, with I frames outstanding, drops it to 1.
+ *		A REJ or SREJ cuts it in half.  Only one decrease happens for
+ *		losses among frames sent before the previous decrease.
+ *		Each new frame acknowledged increases it: by 1 below the
+ *		slow start threshold, then by 1/window, i.e. about one frame
+ *		per round trip.
+ *
+ *		Statistics for each link are printed when it is disconnected.
+ *
+ *---------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <string.h>
+
+#include "textcolor.h"
+#include "ax25_cc.h"
+
+
+#define CWND_INITIAL 127.	// Anything at least as large as the maximum window.
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_init
+ *
+ * Purpose:     Initialize for a new link.
+ *
+ * Inputs:	cc	- Congestion control state, part of the link state machine.
+ *
+ *		now	- Current time.
+ *
+ *--------------------------------------------------------------------*/
+
+void ax25_cc_init (struct ax25_cc_s *cc, double now)
+{
+	memset (cc, 0, sizeof(struct ax25_cc_s));
+	cc->cwnd = CWND_INITIAL;
+	cc->ssthresh = CWND_INITIAL;
+	cc->start_time = now;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_restart
+ *
+ * Purpose:     Forget about outstanding frames when V(S) and V(A) are reset.
+ *
+ * Description:	This happens when the link is established or reset.
+ *		The RTT estimate is kept because the path is the same.
+ *		Statistics are also kept so they cover the whole session.
+ *
+ *--------------------------------------------------------------------*/
+
+void ax25_cc_restart (struct ax25_cc_s *cc)
+{
+	memset (cc->sent_count, 0, sizeof(cc->sent_count));
+	cc->cwnd = CWND_INITIAL;
+	cc->ssthresh = CWND_INITIAL;
+	cc->in_recovery = 0;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_channel_busy
+ *		ax25_cc_clock
+ *
+ * Purpose:     Maintain the link clock which does not advance while
+ *		the radio channel is busy.
+ *
+ *--------------------------------------------------------------------*/
+
+void ax25_cc_channel_busy (struct ax25_cc_s *cc, int busy, double now)
+{
+	if (busy && cc->busy_since == 0) {
+	  cc->busy_since = now;
+	}
+	else if ( ! busy && cc->busy_since != 0) {
+	  cc->busy_total += now - cc->busy_since;
+	  cc->busy_since = 0;
+	}
+}
+
+double ax25_cc_clock (struct ax25_cc_s *cc, double now)
+{
+	double t = now - cc->busy_total;
+
+	if (cc->busy_since != 0) {
+	  t -= now - cc->busy_since;
+	}
+	return (t);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_sent
+ *
+ * Purpose:     Note that an I frame has been sent.
+ *
+ * Inputs:	ns	- N(S) of the frame.
+ *
+ *		len	- Length of information part.
+ *
+ *		now	- Current time.
+ *
+ * Description:	A second send for the same N(S), before it is acknowledged,
+ *		is a retransmission.
+ *
+ *--------------------------------------------------------------------*/
+
+void ax25_cc_sent (struct ax25_cc_s *cc, int ns, int len, double now)
+{
+	ns &= 127;
+
+	if (cc->sent_count[ns] != 0) {
+	  if (cc->sent_count[ns] < 100) cc->sent_count[ns]++;
+	  cc->i_resent++;
+	}
+	else {
+	  cc->sent_count[ns] = 1;
+	  cc->sent_seq[ns] = cc->next_seq++;
+	  cc->sent_len[ns] = len;
+	  cc->i_sent++;
+	}
+	cc->sent_at[ns] = ax25_cc_clock (cc, now);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_acked
+ *
+ * Purpose:     Note that an I frame has been acknowledged.
+ *
+ * Inputs:	ns	- N(S) of the frame.
+ *
+ *		now	- Current time.
+ *
+ * Description:	Take an RTT sample, unless it was sent more than once,
+ *		and open up the window.
+ *
+ *--------------------------------------------------------------------*/
+
+void ax25_cc_acked (struct ax25_cc_s *cc, int ns, double now)
+{
+	ns &= 127;
+
+	if (cc->sent_count[ns] == 0) {
+	  return;		// Not outstanding.
+	}
+
+	if (cc->sent_count[ns] == 1) {
+	  float r = ax25_cc_clock (cc, now) - cc->sent_at[ns];
+	  if (r < 0) r = 0;
+
+	  if ( ! cc->have_rtt) {
+	    cc->srtt = r;
+	    cc->rttvar = r / 2;
+	    cc->have_rtt = 1;
+	    cc->rtt_min = r;
+	    cc->rtt_max = r;
+	  }
+	  else {
+	    float err = r - cc->srtt;
+	    if (err < 0) err = - err;
+	    cc->rttvar = 3./4. * cc->rttvar + 1./4. * err;
+	    cc->srtt = 7./8. * cc->srtt + 1./8. * r;
+	    if (r < cc->rtt_min) cc->rtt_min = r;
+	    if (r > cc->rtt_max) cc->rtt_max = r;
+	  }
+	  cc->rtt_samples++;
+	}
+
+	if (cc->in_recovery && cc->sent_seq[ns] >= cc->recover_seq) {
+	  cc->in_recovery = 0;	// Something sent after the last decrease got thru.
+	}
+
+	if ( ! cc->in_recovery && cc->cwnd < CWND_INITIAL) {
+	  if (cc->cwnd < cc->ssthresh) {
+	    cc->cwnd += 1;
+	  }
+	  else {
+	    cc->cwnd += 1 / cc->cwnd;
+	  }
+	}
+
+	cc->i_acked++;
+	cc->bytes_acked += cc->sent_len[ns];
+	cc->sent_count[ns] = 0;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_loss
+ *
+ * Purpose:     Reduce the window because frames were lost.
+ *
+ * Inputs:	timeout	- True for T1 expiry with I frames outstanding.
+ *			  False for REJ or SREJ.
+ *
+ *--------------------------------------------------------------------*/
+
+void ax25_cc_loss (struct ax25_cc_s *cc, int timeout)
+{
+	if (timeout) {
+	  cc->timeouts++;
+	}
+	else {
+	  cc->rejects++;
+	}
+
+	if (cc->in_recovery) {
+	  if (timeout) {
+	    cc->cwnd = 1;	// Still nothing getting thru.
+	  }
+	  return;		// Otherwise already reduced for this window of frames.
+	}
+
+	// cwnd might be the initial large value.  Start from what it effectively was.
+	// ax25_cc_window stores that in ssthresh when clipping.
+
+	float w = cc->cwnd < cc->ssthresh ? cc->cwnd : cc->ssthresh;
+
+	cc->ssthresh = w / 2 < 1 ? 1 : w / 2;
+	cc->cwnd = timeout ? 1 : cc->ssthresh;
+	cc->in_recovery = 1;
+	cc->recover_seq = cc->next_seq;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_window
+ *
+ * Purpose:     Get the effective window size.
+ *
+ * Inputs:	k_maxframe	- Configured or negotiated maximum.
+ *
+ * Returns:	Number of I frames which may be outstanding, 1 .. k_maxframe.
+ *
+ *--------------------------------------------------------------------*/
+
+int ax25_cc_window (struct ax25_cc_s *cc, int k_maxframe)
+{
+	if (cc->cwnd > k_maxframe) {
+	  cc->cwnd = k_maxframe;
+	}
+	if (cc->ssthresh > k_maxframe) {
+	  cc->ssthresh = k_maxframe;
+	}
+	if (cc->cwnd < 1) {
+	  cc->cwnd = 1;
+	}
+	return ((int)(cc->cwnd));
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_t1
+ *
+ * Returns:	Suggested T1 value, in seconds, or 0 if there is not
+ *		a valid RTT measurement yet.
+ *
+ *--------------------------------------------------------------------*/
+
+float ax25_cc_t1 (struct ax25_cc_s *cc)
+{
+	if ( ! cc->have_rtt) {
+	  return (0);
+	}
+	return (cc->srtt + 4 * cc->rttvar);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        ax25_cc_print_stats
+ *
+ * Purpose:     Summarize a session.
+ *
+ *--------------------------------------------------------------------*/
+
+void ax25_cc_print_stats (struct ax25_cc_s *cc, int stream_id, double now)
+{
+	double elapsed = now - cc->start_time;
+
+	if (cc->i_sent == 0) {
+	  return;
+	}
+	if (elapsed < 1) elapsed = 1;
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Stream %d: Sent %ld bytes in %.0f seconds, %.0f bytes/sec.  %d I frames, %d resent, %d timeouts, %d REJ/SREJ.\n",
+		stream_id, cc->bytes_acked, elapsed, cc->bytes_acked / elapsed,
+		cc->i_sent, cc->i_resent, cc->timeouts, cc->rejects);
+	if (cc->rtt_samples > 0) {
+	  dw_printf ("Stream %d: Round trip %.2f sec (min %.2f, max %.2f, %d samples), window %d.\n",
+		stream_id, cc->srtt, cc->rtt_min, cc->rtt_max, cc->rtt_samples, (int)(cc->cwnd));
+	}
+}
+
+/* end ax25_cc.c */
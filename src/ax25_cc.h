@@ -0,0 +1,85 @@
+
+/* ax25_cc.h */
+
+#ifndef AX25_CC_H
+#define AX25_CC_H 1
+
+
+/*
+ * Round trip time measurement and congestion control for one
+ * connected mode link.  See ax25_cc.c for details.
+ *
+ * Nothing here knows about the link state machine.  Times are passed
+ * in so it can be driven by a simulated channel for testing.
+ */
+
+struct ax25_cc_s {
+
+// "Link clock" - wall clock time less time that the radio channel was busy.
+// This is the same time base as timer T1, which is paused while the channel is busy.
+
+	double busy_since;		// When channel became busy, 0 if not busy now.
+	double busy_total;		// Accumulated busy time, seconds.
+
+// Round trip time.  Jacobson / Karels as in RFC 6298.
+
+	int have_rtt;			// Set after the first valid sample.
+	float srtt;			// Smoothed round trip time, seconds.
+	float rttvar;			// Round trip time variation, seconds.
+
+// Information about each I frame not yet acknowledged.  Indexed by N(S).
+
+	char sent_count[128];		// Times sent.  0 if not outstanding.
+					// Karn:  Don't use for RTT if more than 1.
+	double sent_at[128];		// Link clock when last sent.
+	int sent_seq[128];		// Value of next_seq when first sent.
+	short sent_len[128];		// Information part length.
+
+	int next_seq;			// Counts new I frames sent, ignoring retransmissions.
+
+// Window.  Additive increase, multiplicative decrease.
+
+	float cwnd;			// Current window.  Clipped to 1 .. k_maxframe when used.
+	float ssthresh;			// Increase quickly below this, slowly above.
+	int recover_seq;		// Only one decrease for losses among frames sent before this.
+	int in_recovery;
+
+// Statistics.
+
+	double start_time;		// Wall clock when link was established.
+	int i_sent;			// New I frames sent.
+	int i_resent;			// I frames sent again.
+	int i_acked;			// I frames acknowledged.
+	long bytes_acked;		// Information bytes acknowledged.
+	int rtt_samples;
+	float rtt_min;
+	float rtt_max;
+	int timeouts;			// T1 expired with I frames outstanding.
+	int rejects;			// Retransmission requested by REJ or SREJ.
+};
+
+
+void ax25_cc_init (struct ax25_cc_s *cc, double now);
+
+void ax25_cc_restart (struct ax25_cc_s *cc);
+
+void ax25_cc_channel_busy (struct ax25_cc_s *cc, int busy, double now);
+
+double ax25_cc_clock (struct ax25_cc_s *cc, double now);
+
+void ax25_cc_sent (struct ax25_cc_s *cc, int ns, int len, double now);
+
+void ax25_cc_acked (struct ax25_cc_s *cc, int ns, double now);
+
+void ax25_cc_loss (struct ax25_cc_s *cc, int timeout);
+
+int ax25_cc_window (struct ax25_cc_s *cc, int k_maxframe);
+
+float ax25_cc_t1 (struct ax25_cc_s *cc);
+
+void ax25_cc_print_stats (struct ax25_cc_s *cc, int stream_id, double now);
+
+
+#endif
+
+/* end ax25_cc.h */
@@ -183,6 +183,7 @@
 #include "dlq.h"
 #include "tq.h"
 #include "ax25_link.h"
+#include "ax25_cc.h"
 #include "dtime_now.h"
 #include "server.h"
 #include "ptt.h"
@@ -430,6 +431,10 @@ typedef struct ax25_dlsm_s {
 
 	int peak_rc_value;			// Peak value of retry count (rc).
 
+// Round trip time, effective window size, throughput.
+
+	struct ax25_cc_s cc;
+
 
 // For sending data.
 
@@ -524,7 +529,8 @@ static reg_callsign_t *reg_callsign_list = NULL;
 // asking for it again.  When we update V(A), we should be able to remove the saved
 // transmitted data, and everything preceding it, from S->txdata_by_ns[].
 
-#define SET_VA(n) {	S->va = (n);								\
+#define SET_VA(n) {	cc_acked_thru (S, (n));							\
+			S->va = (n);								\
 		    	if (s_debug_variables) {						\
 			  text_color_set(DW_COLOR_DEBUG);					\
 		          dw_printf ("V(A) = %d at %s %d\n", S->va, __func__, __LINE__);	\
@@ -575,9 +581,10 @@ static int AX25MODULO(int n, int m, const char *file, const char *func, int line
 
 // Test whether we can send more or if we need to wait
 // because we have reached 'maxframe' outstanding frames.
+// The effective window can be smaller when the channel is losing frames.  See ax25_cc.c.
 // Argument must be 'S'.
 
-#define WITHIN_WINDOW_SIZE(x) (x->vs != AX25MODULO(x->va + x->k_maxframe, x->modulo, __FILE__, __func__, __LINE__))
+#define WITHIN_WINDOW_SIZE(x) (AX25MODULO(x->vs - x->va, x->modulo, __FILE__, __func__, __LINE__) < ax25_cc_window(&(x->cc), x->k_maxframe))
 
 
 // Timer macros to provide debug output with location from where they are called.
@@ -634,6 +641,7 @@ static void i_frame_pop_off_queue (ax25_dlsm_t *S);
 static void discard_i_queue (ax25_dlsm_t *S);
 static void invoke_retransmission (ax25_dlsm_t *S, int nr_input);
 static void check_i_frame_ackd (ax25_dlsm_t *S, int nr);
+static void cc_acked_thru (ax25_dlsm_t *S, int nr);
 static void check_need_for_response (ax25_dlsm_t *S, ax25_frame_type_t frame_type, cmdres_t cr, int pf);
 static void enquiry_response (ax25_dlsm_t *S, ax25_frame_type_t frame_type, int f);
 
@@ -839,6 +847,7 @@ static ax25_dlsm_t *get_link_handle (char addrs[AX25_MAX_ADDRS][AX25_MAX_ADDR_LE
 	}
 	p->magic1 = MAGIC1;
 	p->start_time = dtime_now();
+	ax25_cc_init (&(p->cc), p->start_time);
 	p->stream_id = next_stream_id++;
 	p->modulo = 8;
 
@@ -1239,7 +1248,8 @@ void dl_data_request (dlq_item_t *E)
 	  while (remaining_len > 0) {
 	    int this_len = MIN(remaining_len, S->n1_paclen);
 
-	    cdata_t *new_txdata = cdata_new(E->txdata->pid, E->txdata->data + offset, this_len);
+	    // Refer to part of the original rather than making a copy.
+	    cdata_t *new_txdata = cdata_slice(E->txdata, offset, this_len);
 	    data_request_good_size (S, new_txdata);
 
 	    offset += this_len;
@@ -1339,21 +1349,18 @@ void dl_data_request (dlq_item_t *E)
 
 // First segment.
 
+	// The segment header has to go in front of the data so these can't
+	// be slices of the original.  Build them in place rather than
+	// on the stack and then copying.
+
 	int seglen;
-	struct {
-	  char header;		// 0x80 + number of segments to follow.
-	  char original_pid;
-	  char segdata[AX25_N1_PACLEN_MAX];
-	} first_segment;
 	cdata_t *new_txdata;
 
 	nseg_to_follow--;
 
-	first_segment.header = 0x80 | nseg_to_follow;
-	first_segment.original_pid = E->txdata->pid;
 	seglen = MIN(S->n1_paclen - 2, remaining_len);
 
-	if (seglen < 1 || seglen > S->n1_paclen - 2 || seglen > remaining_len || seglen > (int)(sizeof(first_segment.segdata))) {
+	if (seglen < 1 || seglen > S->n1_paclen - 2 || seglen > remaining_len || seglen > AX25_N1_PACLEN_MAX) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("INTERNAL ERROR, Segmentation line %d, data length = %d, N1 = %d, segment length = %d, number to follow = %d\n",
 					__LINE__, E->txdata->len, S->n1_paclen, seglen, nseg_to_follow);
@@ -1362,9 +1369,10 @@ void dl_data_request (dlq_item_t *E)
 	  return;
 	}
 
-	memcpy (first_segment.segdata, E->txdata->data + orig_offset, seglen);
-
-	new_txdata = cdata_new(AX25_PID_SEGMENTATION_FRAGMENT, (char*)(&first_segment), seglen+2);
+	new_txdata = cdata_new(AX25_PID_SEGMENTATION_FRAGMENT, NULL, seglen+2);
+	new_txdata->data[0] = 0x80 | nseg_to_follow;		// First + number of segments to follow.
+	new_txdata->data[1] = E->txdata->pid;			// Original pid.
+	memcpy (new_txdata->data + 2, E->txdata->data + orig_offset, seglen);
 
 	data_request_good_size (S, new_txdata);
 
@@ -1375,17 +1383,11 @@ void dl_data_request (dlq_item_t *E)
 // Subsequent segments.
 
 	do {
-	  struct {
-	    char header;		// Number of segments to follow.
-	    char segdata[AX25_N1_PACLEN_MAX];
-	  } subsequent_segment;
-
 	  nseg_to_follow--;
 
-	  subsequent_segment.header = nseg_to_follow;
 	  seglen = MIN(S->n1_paclen - 1, remaining_len);
 
-	  if (seglen < 1 || seglen > S->n1_paclen - 1 || seglen > remaining_len || seglen > (int)(sizeof(subsequent_segment.segdata))) {
+	  if (seglen < 1 || seglen > S->n1_paclen - 1 || seglen > remaining_len || seglen > AX25_N1_PACLEN_MAX) {
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("INTERNAL ERROR, Segmentation line %d, data length = %d, N1 = %d, segment length = %d, number to follow = %d\n",
 					__LINE__, E->txdata->len, S->n1_paclen, seglen, nseg_to_follow);
@@ -1394,9 +1396,9 @@ void dl_data_request (dlq_item_t *E)
 	    return;
 	  }
 
-	  memcpy (subsequent_segment.segdata, E->txdata->data + orig_offset, seglen);
-
-	  new_txdata = cdata_new(AX25_PID_SEGMENTATION_FRAGMENT, (char*)(&subsequent_segment), seglen+1);
+	  new_txdata = cdata_new(AX25_PID_SEGMENTATION_FRAGMENT, NULL, seglen+1);
+	  new_txdata->data[0] = nseg_to_follow;			// Number of segments to follow.
+	  memcpy (new_txdata->data + 1, E->txdata->data + orig_offset, seglen);
 
 	  data_request_good_size (S, new_txdata);
 
@@ -1780,6 +1782,8 @@ void dl_client_cleanup (dlq_item_t *E)
 	      dw_printf ("%d  TEST frames received\n",  S->count_recv_frame_type[frame_type_U_TEST]);
 
 	      dw_printf ("%d  peak retry count\n",      S->peak_rc_value);
+
+	      ax25_cc_print_stats (&(S->cc), S->stream_id, dtime_now());
 	    }
 
 	    if (s_debug_client_app) {
@@ -2063,6 +2067,8 @@ void lm_channel_busy (dlq_item_t *E)
 
 	  if (E->chan == S->chan) {
 
+	    ax25_cc_channel_busy (&(S->cc), busy, dtime_now());
+
 	    if (busy && ! S->radio_channel_busy) {
 	      S->radio_channel_busy = 1;
 	      PAUSE_T1;
@@ -3663,6 +3669,12 @@ static void rr_rnr_frame (ax25_dlsm_t *S, int ready, cmdres_t cr, int pf, int nr
 static void rej_frame (ax25_dlsm_t *S, cmdres_t cr, int pf, int nr)
 {
 
+	// Something was lost.  Send fewer at once.
+
+	if (S->state == state_3_connected || S->state == state_4_timer_recovery) {
+	  ax25_cc_loss (&(S->cc), 0);
+	}
+
 	switch (S->state) {
 
 	  case 	state_0_disconnected:
@@ -3923,6 +3935,12 @@ static int resend_for_srej (ax25_dlsm_t *S, int nr, unsigned char *info, int inf
 static void srej_frame (ax25_dlsm_t *S, cmdres_t cr, int f, int nr, unsigned char *info, int info_len)
 {
 
+	// Something was lost.  Send fewer at once.
+
+	if (S->state == state_3_connected || S->state == state_4_timer_recovery) {
+	  ax25_cc_loss (&(S->cc), 0);
+	}
+
 	switch (S->state) {
 
 	  case 	state_0_disconnected:
@@ -4131,6 +4149,7 @@ static int resend_for_srej (ax25_dlsm_t *S, int nr, unsigned char *info, int inf
 	if (txdata != NULL) {
 	  packet_t pp = ax25_i_frame (S->addrs, S->num_addr, cr, S->modulo, i_frame_nr, i_frame_ns, p, txdata->pid, (unsigned char *)(txdata->data), txdata->len);
 	  // dw_printf ("calling lm_data_request for I frame, %s line %d\n", __func__, __LINE__);
+	  ax25_cc_sent (&(S->cc), i_frame_ns, txdata->len, dtime_now());
 	  lm_data_request (S->chan, TQ_PRIO_1_LO, pp);
 	  num_resent++;
 	}
@@ -4165,6 +4184,7 @@ static int resend_for_srej (ax25_dlsm_t *S, int nr, unsigned char *info, int inf
 	  txdata = S->txdata_by_ns[i_frame_ns];
 	  if (txdata != NULL) {
 	    packet_t pp = ax25_i_frame (S->addrs, S->num_addr, cr, S->modulo, i_frame_nr, i_frame_ns, p, txdata->pid, (unsigned char *)(txdata->data), txdata->len);
+	    ax25_cc_sent (&(S->cc), i_frame_ns, txdata->len, dtime_now());
 	    lm_data_request (S->chan, TQ_PRIO_1_LO, pp);
 	    num_resent++;
 	  }
@@ -4256,6 +4276,7 @@ static void sabm_e_frame (ax25_dlsm_t *S, int extended, int p)
 
 	    clear_exception_conditions (S);
 
+	    ax25_cc_restart (&(S->cc));
 	    SET_VS(0);
 	    SET_VA(0);
 	    SET_VR(0);
@@ -4375,6 +4396,7 @@ static void sabm_e_frame (ax25_dlsm_t *S, int extended, int p)
 	      }
 	      STOP_T1;
 	      START_T3;
+	      ax25_cc_restart (&(S->cc));
 	      SET_VS(0);
 	      SET_VA(0);
 	      SET_VR(0);
@@ -4782,6 +4804,7 @@ static void ua_frame (ax25_dlsm_t *S, int f)
 				// Since there is nothing outstanding where we expect a response, T1 would
 				// not be started.
 #endif
+	      ax25_cc_restart (&(S->cc));
 	      SET_VS(0);
 	      SET_VA(0);
 	      SET_VR(0);
@@ -5390,6 +5413,9 @@ static void t1_expiry (ax25_dlsm_t *S)
 
 	  case 	state_3_connected:
 
+	    if (S->va != S->vs) {
+	      ax25_cc_loss (&(S->cc), 1);
+	    }
 	    SET_RC(1);
 	    transmit_enquiry (S);
 	    enter_new_state (S, state_4_timer_recovery, __func__, __LINE__);
@@ -5444,6 +5470,9 @@ static void t1_expiry (ax25_dlsm_t *S)
 	      enter_new_state (S, state_0_disconnected, __func__, __LINE__);
 	    }
 	    else {
+	      if (S->va != S->vs) {
+	        ax25_cc_loss (&(S->cc), 1);
+	      }
 	      SET_RC(S->rc+1);
 	      if (S->rc > S->peak_rc_value) S->peak_rc_value = S->rc;	// gather statistics.
 
@@ -5998,6 +6027,7 @@ static void invoke_retransmission (ax25_dlsm_t *S, int nr_input)
 	    packet_t pp = ax25_i_frame (S->addrs, S->num_addr, cr, S->modulo, nr, ns, p,
 		S->txdata_by_ns[ns]->pid, (unsigned char *)(S->txdata_by_ns[ns]->data), S->txdata_by_ns[ns]->len);
 
+	    ax25_cc_sent (&(S->cc), ns, S->txdata_by_ns[ns]->len, dtime_now());
 	    lm_data_request (S->chan, TQ_PRIO_1_LO, pp);
 	    // Keep it around in case we need to send again.
 
@@ -6074,6 +6104,32 @@ static void check_i_frame_ackd (ax25_dlsm_t *S, int nr)
 
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	cc_acked_thru
+ *
+ * Purpose:	Inform congestion control that I frames have been acknowledged.
+ *
+ * Inputs:	S	- Data Link State Machine.
+ *		nr	- New value for V(A).  Frames from current V(A) thru nr-1 are acknowledged.
+ *
+ * Description:	Called from SET_VA before V(A) is updated.
+ *
+ *------------------------------------------------------------------------------*/
+
+static void cc_acked_thru (ax25_dlsm_t *S, int nr)
+{
+	double now = dtime_now();
+	int n;
+
+	for (n = S->va; n != nr; n = AX25MODULO(n + 1, S->modulo, __FILE__, __func__, __LINE__)) {
+	  ax25_cc_acked (&(S->cc), n, now);
+	}
+
+} /* end cc_acked_thru */
+
+
+
 /*------------------------------------------------------------------------------
  *
  * Name:	check_need_for_response
@@ -6193,7 +6249,14 @@ static void select_t1_value (ax25_dlsm_t *S)
 
 	if (S->rc == 0) {
 
-	  if (S->t1_remaining_when_last_stopped >= 0) {		// Negative means invalid, don't use it.
+	  if (S->cc.have_rtt) {
+
+	    // Better:  Measured from when each I frame was sent until it was acknowledged,
+	    // excluding frames sent more than once.  See ax25_cc.c.
+
+	    S->srt = S->cc.srtt;
+	  }
+	  else if (S->t1_remaining_when_last_stopped >= 0) {		// Negative means invalid, don't use it.
 
 	    // This is an IIR low pass filter.
 	    // Algebraically equivalent to version in AX.25 protocol spec but I think the
@@ -6222,6 +6285,12 @@ static void select_t1_value (ax25_dlsm_t *S)
 	  }
 
 	  S->t1v = S->srt * 2;
+
+	  // Allow more if the round trip time varies a lot.
+
+	  if (ax25_cc_t1(&(S->cc)) > S->t1v) {
+	    S->t1v = ax25_cc_t1(&(S->cc));
+	  }
 	}
 	else {
 	
@@ -6481,6 +6550,7 @@ static void i_frame_pop_off_queue (ax25_dlsm_t *S)
 	        //dw_printf ("calling lm_data_request for I frame, %s line %d\n", __func__, __LINE__);
 	      }
 
+	      ax25_cc_sent (&(S->cc), ns, txdata->len, dtime_now());
 	      lm_data_request (S->chan, TQ_PRIO_1_LO, pp);
 
 	      // Stash in sent array in case it gets lost and needs to be sent again.
@@ -6575,6 +6645,8 @@ static void enter_new_state (ax25_dlsm_t *S, enum dlsm_state_e new_state, const
 	       S->state != state_3_connected &&  S->state != state_4_timer_recovery ) {
 
 	  ptt_set (OCTYPE_CON, S->chan, 1);		// Turn on connected indicator if configured.
+
+	  S->cc.start_time = dtime_now();		// For throughput statistics.
 	}
 	else if (( new_state != state_3_connected && new_state != state_4_timer_recovery) &&
 	         (  S->state == state_3_connected ||  S->state == state_4_timer_recovery ) ) {
@@ -6583,6 +6655,9 @@ static void enter_new_state (ax25_dlsm_t *S, enum dlsm_state_e new_state, const
 							// Ideally we should look at any other link state machines
 							// for this channel and leave the indicator on if any
 							// are connected.  I'm not that worried about it.
+
+	  ax25_cc_print_stats (&(S->cc), S->stream_id, dtime_now());
+	  ax25_cc_init (&(S->cc), dtime_now());	// Start over if same link is used again.
 	}
 
 	S->state = new_state;
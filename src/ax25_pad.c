@@ -167,6 +167,7 @@
 
 #include <stdlib.h>
 #include <string.h>
+#include <stddef.h>
 #include <assert.h>
 #include <stdio.h>
 #include <ctype.h>
@@ -192,6 +193,8 @@ static volatile int new_count = 0;
 static volatile int delete_count = 0;
 static volatile int last_seq_num = 0;
 
+static void parse_addrs (packet_t this_p);
+
 #if AX25MEMDEBUG
 
 int ax25memdebug = 0;
@@ -277,10 +280,56 @@ packet_t ax25_new (void)
 	this_p->seq = last_seq_num;
 	this_p->magic2 = MAGIC;
 	this_p->num_addr = (-1);
+	this_p->frame_data = this_p->frame_inline;
+	this_p->frame_size = AX25_INLINE_LEN;
 
 	return (this_p);
 }
 
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_frame_reserve
+ * 
+ * Purpose:	Make sure there is room for the frame to grow.
+ *
+ * Inputs:	this_p	- Packet object.
+ *
+ *		len	- Frame length, without CRC, about to be used.
+ *
+ * Description:	The frame starts out in the small buffer inside the packet
+ *		object.  If it will no longer fit, move it to a separate
+ *		buffer large enough for any frame.  This happens only once
+ *		for a packet, and not at all for typical APRS.
+ *
+ *		Any pointers into the frame data, such as from ax25_get_info,
+ *		are no longer valid after this.
+ *
+ *------------------------------------------------------------------------------*/
+
+void ax25_frame_reserve (packet_t this_p, int len)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+	assert (len >= 0 && len <= AX25_MAX_PACKET_LEN);
+
+	if (len + 1 <= this_p->frame_size) {
+	  return;
+	}
+
+	unsigned char *big = malloc (AX25_MAX_PACKET_LEN + 1);
+	if (big == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("ERROR - can't allocate memory in ax25_frame_reserve.\n");
+	}
+	assert (big != NULL);
+
+	memcpy (big, this_p->frame_data, (size_t)(this_p->frame_len));
+	big[this_p->frame_len] = 0;
+	this_p->frame_data = big;
+	this_p->frame_size = AX25_MAX_PACKET_LEN + 1;
+}
+
 /*------------------------------------------------------------------------------
  *
  * Name:	ax25_delete
@@ -322,6 +371,10 @@ void ax25_delete (packet_t this_p)
 	this_p->magic1 = 0;
 	this_p->magic1 = 0;
 
+	if (this_p->frame_data != this_p->frame_inline) {
+	  free (this_p->frame_data);
+	}
+
 	//memset (this_p, 0, sizeof (struct packet_s));
 	free (this_p);
 }
@@ -593,6 +646,7 @@ packet_t ax25_from_text (char *monitor, int strict)
 /*
  * Append the info part.  
  */
+	ax25_frame_reserve (this_p, this_p->frame_len + info_len);
 	memcpy ((char*)(this_p->frame_data+this_p->frame_len), info_part, info_len);
 	this_p->frame_len += info_len;
 
@@ -665,6 +719,7 @@ packet_t ax25_from_frame (unsigned char *fbuf, int flen, alevel_t alevel)
 
 /* Copy the whole thing intact. */
 
+	ax25_frame_reserve (this_p, flen);
 	memcpy (this_p->frame_data, fbuf, flen);
 	this_p->frame_data[flen] = 0;
 	this_p->frame_len = flen;
@@ -707,8 +762,17 @@ packet_t ax25_dup (packet_t copy_from)
 
 	save_seq = this_p->seq;
 
-	memcpy (this_p, copy_from, sizeof (struct packet_s));
+	/* Everything up to the frame contents, then only as much of */
+	/* those as is used, rather than the maximum possible size. */
+
+	memcpy (this_p, copy_from, offsetof(struct packet_s, frame_data));
 	this_p->seq = save_seq;
+	this_p->frame_len = 0;		/* Nothing in new frame_data yet for reserve to move. */
+
+	ax25_frame_reserve (this_p, copy_from->frame_len);
+	this_p->frame_len = copy_from->frame_len;
+	memcpy (this_p->frame_data, copy_from->frame_data, (size_t)(copy_from->frame_len));
+	this_p->frame_data[copy_from->frame_len] = 0;
 
 #if AX25MEMDEBUG
 	if (ax25memdebug) {	
@@ -1041,6 +1105,7 @@ void ax25_set_addr (packet_t this_p, int n, char *ad)
 	    this_p->frame_data[n*7+i] = atemp[i] << 1;
 	  }
 	  ax25_set_ssid (this_p, n, ssid_temp);
+	  this_p->addrs_valid = 0;
 	}
 	else if (n == this_p->num_addr) {		
 
@@ -1115,6 +1180,8 @@ void ax25_insert_addr (packet_t this_p, int n, char *ad)
 	  return;
 	}
 
+	ax25_frame_reserve (this_p, this_p->frame_len + 7);
+
 	CLEAR_LAST_ADDR_FLAG;
 
 	this_p->num_addr++;
@@ -1230,7 +1297,9 @@ int ax25_get_num_addr (packet_t this_p)
 	}
 
 /* Otherwise, determine the number ofaddresses. */
+/* Anything that changes the addresses gets here so forget parsed ones. */
 
+	this_p->addrs_valid = 0;
 	this_p->num_addr = 0;		/* Number of addresses extracted. */
 	
 	addr_bytes = 0;
@@ -1326,6 +1395,14 @@ void ax25_get_addr_with_ssid (packet_t this_p, int n, char *station)
 	  return;
 	}
 
+	if ( ! this_p->addrs_valid) {
+	  parse_addrs (this_p);
+	}
+	if ( ! this_p->addrs[n].odd) {
+	  memcpy (station, this_p->addrs[n].text, sizeof(this_p->addrs[n].text));
+	  return;
+	}
+
 	// At one time this would stop at the first space, on the assumption we would have only trailing spaces.
 	// Then there was a forum discussion where someone encountered the address " WIDE2" with a leading space.
 	// In that case, we would have returned a zero length string here.
@@ -1409,6 +1486,15 @@ void ax25_get_addr_no_ssid (packet_t this_p, int n, char *station)
 	  return;
 	}
 
+	if ( ! this_p->addrs_valid) {
+	  parse_addrs (this_p);
+	}
+	if ( ! this_p->addrs[n].odd) {
+	  memcpy (station, this_p->addrs[n].text, this_p->addrs[n].call_len);
+	  station[this_p->addrs[n].call_len] = '\0';
+	  return;
+	}
+
 	// At one time this would stop at the first space, on the assumption we would have only trailing spaces.
 	// Then there was a forum discussion where someone encountered the address " WIDE2" with a leading space.
 	// In that case, we would have returned a zero length string here.
@@ -1435,6 +1521,169 @@ void ax25_get_addr_no_ssid (packet_t this_p, int n, char *station)
 } /* end ax25_get_addr_no_ssid */
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_get_addr_key
+ * 
+ * Purpose:	Return specified address as a number for quick comparisons.
+ *
+ * Inputs:	n	- Index of address.   Use the symbols 
+ *			  AX25_DESTINATION, AX25_SOURCE, AX25_REPEATER1, etc.
+ *
+ * Assumption:	ax25_from_text or ax25_from_frame was called first.
+ *
+ * Returns:	Callsign and SSID packed as described for AX25_KEY_CALL_MASK.
+ *		Same as ax25_addr_key() of the ax25_get_addr_with_ssid result,
+ *		unless the callsign contains "-", so comparing keys gives the
+ *		same answer as strcmp.  0 for an invalid index.
+ *
+ *------------------------------------------------------------------------------*/
+
+uint64_t ax25_get_addr_key (packet_t this_p, int n)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	if (n < 0 || n >= this_p->num_addr) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Internal error: ax25_get_addr_key(%d), num_addr=%d\n", n, this_p->num_addr);
+	  return (0);
+	}
+
+	if ( ! this_p->addrs_valid) {
+	  parse_addrs (this_p);
+	}
+	return (this_p->addrs[n].key);
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_addr_key
+ * 
+ * Purpose:	Convert an address from text to a number for quick comparisons.
+ *
+ * Inputs:	station	- Callsign with optional SSID, e.g. "WB2OSZ-15".
+ *
+ * Returns:	Callsign and SSID packed as described for AX25_KEY_CALL_MASK.
+ *		0 if it does not fit in an AX.25 address, which can't
+ *		match the key of any address in a frame.
+ *
+ * Description:	Typically used once for something like MYCALL so
+ *		addresses in many packets can be compared to it.
+ *		Upper and lower case are different, as with strcmp.
+ *
+ *------------------------------------------------------------------------------*/
+
+uint64_t ax25_addr_key (const char *station)
+{
+	uint64_t key = 0;
+	int ssid = 0;
+	int i;
+
+	for (i = 0; station[i] != '\0' && station[i] != '-'; i++) {
+	  if (i >= 6) {
+	    return (0);
+	  }
+	  key |= (uint64_t)(station[i] & 0x7f) << (7 * i);
+	}
+	if (i == 0) {
+	  return (0);
+	}
+	for ( ; i < 6; i++) {
+	  key |= (uint64_t)' ' << (7 * i);
+	}
+
+	const char *p = strchr (station, '-');
+	if (p != NULL) {
+	  p++;
+	  if ( ! isdigit(p[0]) || (p[1] != '\0' && ( ! isdigit(p[1]) || p[2] != '\0'))) {
+	    return (0);
+	  }
+	  ssid = atoi (p);
+	  if (ssid > 15) {
+	    return (0);
+	  }
+	}
+	return (key | ((uint64_t)ssid << AX25_KEY_SSID_SHIFT));
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	parse_addrs
+ * 
+ * Purpose:	Take apart all of the addresses once, rather than every
+ *		time ax25_get_addr_with_ssid and friends are called.
+ *
+ * Outputs:	this_p->addrs
+ *
+ * Description:	Produces the same text as the slow path in
+ *		ax25_get_addr_with_ssid.  Anything unusual, that would
+ *		get an error message there, is marked as odd so the
+ *		slow path is still used for it.
+ *
+ *------------------------------------------------------------------------------*/
+
+static void parse_addrs (packet_t this_p)
+{
+	for (int n = 0; n < this_p->num_addr && n < AX25_MAX_ADDRS; n++) {
+	  struct ax25_addr_s *a = &(this_p->addrs[n]);
+	  unsigned char *pf = this_p->frame_data + n * 7;
+	  int len;
+
+	  a->odd = 0;
+	  for (int i = 0; i < 6; i++) {
+	    a->text[i] = (pf[i] >> 1) & 0x7f;
+	  }
+	  a->text[6] = '\0';
+
+	  // Trim trailing spaces exactly as ax25_get_addr_with_ssid does.
+
+	  for (int i = 5; i >= 0; i--) {
+	    if (a->text[i] == '\0') {
+	      a->odd = 1;
+	    }
+	    else if (a->text[i] == ' ') {
+	      a->text[i] = '\0';
+	    }
+	    else {
+	      break;
+	    }
+	  }
+	  len = strlen(a->text);
+	  if (len == 0) {
+	    a->odd = 1;
+	  }
+	  a->call_len = len;
+
+	  a->key = 0;
+	  for (int i = 0; i < 6; i++) {
+	    a->key |= (uint64_t)(i < len ? a->text[i] : ' ') << (7 * i);
+	  }
+
+	  int ssid = (pf[6] & SSID_SSID_MASK) >> SSID_SSID_SHIFT;
+	  a->key |= (uint64_t)ssid << AX25_KEY_SSID_SHIFT;
+
+	  if (len == 0) {
+	    a->key = 0;		// Same as ax25_addr_key("").
+	  }
+
+	  if (ssid >= 10) {
+	    a->text[len++] = '-';
+	    a->text[len++] = '1';
+	    a->text[len++] = '0' + ssid - 10;
+	  }
+	  else if (ssid > 0) {
+	    a->text[len++] = '-';
+	    a->text[len++] = '0' + ssid;
+	  }
+	  a->text[len] = '\0';
+	}
+	this_p->addrs_valid = 1;
+}
+
+
 /*------------------------------------------------------------------------------
  *
  * Name:	ax25_get_ssid
@@ -1494,6 +1743,7 @@ void ax25_set_ssid (packet_t this_p, int n, int ssid)
 	if (n >= 0 && n < this_p->num_addr) {
 	  this_p->frame_data[n*7+6] =   (this_p->frame_data[n*7+6] & ~ SSID_SSID_MASK) |
 		((ssid << SSID_SSID_SHIFT) & SSID_SSID_MASK) ;
+	  this_p->addrs_valid = 0;
 	}
 	else {
 	  text_color_set(DW_COLOR_ERROR);
@@ -1734,7 +1984,10 @@ void ax25_set_info (packet_t this_p, unsigned char *new_info_ptr, int new_info_l
 
 	if (new_info_len < 0) new_info_len = 0;
 	if (new_info_len > AX25_MAX_INFO_LEN) new_info_len = AX25_MAX_INFO_LEN;
-	memcpy (old_info_ptr, new_info_ptr, new_info_len);
+
+	int offset = old_info_ptr - this_p->frame_data;
+	ax25_frame_reserve (this_p, offset + new_info_len);
+	memcpy (this_p->frame_data + offset, new_info_ptr, new_info_len);
 	this_p->frame_len += new_info_len;
 }
 
@@ -1897,6 +2150,71 @@ double ax25_get_release_time (packet_t this_p)
 }
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_set_rx_time
+ *
+ * Purpose:	Remember when a received frame was captured.
+ *
+ * Inputs:	this_p		- Current packet object.
+ *
+ *		rx_time		- Time, as returned by dtime_realtime(), when the
+ *				  audio sample at the end of the frame was captured.
+ *				  0 if not known.
+ *
+ *		rx_sample	- Number of that sample, for the channel, counting
+ *				  from start up.
+ *
+ * Description:	This is set when the frame comes out of the HDLC decoder, before
+ *		any of the queueing and processing delays, so it is suitable for
+ *		time difference of arrival or latency measurements.
+ *
+ *------------------------------------------------------------------------------*/
+
+void ax25_set_rx_time (packet_t this_p, double rx_time, long long rx_sample)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	this_p->rx_time = rx_time;
+	this_p->rx_sample = rx_sample;
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_get_rx_time
+ *
+ * Purpose:	Get capture time of received frame.  0 if unknown.
+ *
+ *------------------------------------------------------------------------------*/
+
+double ax25_get_rx_time (packet_t this_p)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	return (this_p->rx_time);
+}
+
+
+/*------------------------------------------------------------------------------
+ *
+ * Name:	ax25_get_rx_sample
+ *
+ * Purpose:	Get audio sample number at end of received frame.  0 if unknown.
+ *
+ *------------------------------------------------------------------------------*/
+
+long long ax25_get_rx_sample (packet_t this_p)
+{
+	assert (this_p->magic1 == MAGIC);
+	assert (this_p->magic2 == MAGIC);
+
+	return (this_p->rx_sample);
+}
+
+
 /*------------------------------------------------------------------------------
  *
  * Name:	ax25_set_modulo
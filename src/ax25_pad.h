@@ -9,6 +9,8 @@
 #ifndef AX25_PAD_H
 #define AX25_PAD_H 1
 
+#include <stdint.h>		// uint64_t
+
 
 #define AX25_MAX_REPEATERS 8
 #define AX25_MIN_ADDRS 2	/* Destination & Source. */
@@ -56,6 +58,16 @@
 
 #define AX25_MAX_PACKET_LEN ( AX25_MAX_ADDRS * 7 + 2 + 3 + AX25_MAX_INFO_LEN)
 
+/*
+ * Most frames are much smaller than the maximum so the frame contents
+ * are kept inside the packet object when they fit.  Only larger frames
+ * get a separate AX25_MAX_PACKET_LEN buffer.
+ * Must be at least enough for the maximum number of addresses,
+ * control, and protocol id.
+ */
+
+#define AX25_INLINE_LEN 128
+
 
 /*
  * packet_t is a pointer to a packet object.
@@ -70,8 +82,32 @@
 #define AX25_PID_ESCAPE_CHARACTER 0xff
 
 
+/*
+ * An address as a number, for quick comparisons.
+ * Callsign in the low 42 bits, 7 bits for each of the 6 characters,
+ * padded with spaces, and SSID in the next 4.
+ * Use  key & AX25_KEY_CALL_MASK  to ignore the SSID.
+ */
+
+#define AX25_KEY_CALL_MASK 0x3ffffffffffULL
+#define AX25_KEY_SSID_SHIFT 42
+
+
 #ifdef AX25_PAD_C	/* Keep this hidden - implementation could change. */
 
+/*
+ * Addresses taken apart, done once when first needed, rather than
+ * every time ax25_get_addr_with_ssid is called.
+ */
+
+struct ax25_addr_s {
+	uint64_t key;		/* See AX25_KEY_CALL_MASK. */
+	char text[10];		/* With any SSID, e.g. "WB2OSZ-15". */
+	unsigned char call_len;	/* Length of the callsign part of text. */
+	unsigned char odd;	/* Empty or contains nul character. */
+				/* Take the slow path with error messages. */
+};
+
 struct packet_s {
 
 	int magic1;		/* for error checking. */
@@ -81,6 +117,12 @@ struct packet_s {
 	double release_time;	/* Time stamp in format returned by dtime_now(). */
 				/* When to release from the SATgate mode delay queue. */
 
+	double rx_time;		/* When the end of a received frame was captured by the */
+				/* audio device, in dtime_realtime() format.  0 if unknown. */
+
+	long long rx_sample;	/* Same thing as number of audio samples for the channel */
+				/* since start up.  0 if not received over the radio. */
+
 #define MAGIC 0x41583235
 
 	struct packet_s *nextp;	/* Pointer to next in queue. */
@@ -137,8 +179,21 @@ struct packet_s {
 				/* For U frames:   	set to 0 - not applicable */
 				/* For I & S frames:	8 or 128 if known.  0 if unknown. */
 
-	unsigned char frame_data[AX25_MAX_PACKET_LEN+1];
+	int addrs_valid;	/* True if addrs matches the frame.  Anything */
+				/* changing an address must clear this. */
+
+	struct ax25_addr_s addrs[AX25_MAX_ADDRS];
+
+	unsigned char *frame_data;
 				/* Raw frame contents, without the CRC. */
+				/* Points to frame_inline or, for a large frame, */
+				/* a separate buffer.  Use ax25_frame_reserve before */
+				/* making the frame longer. */
+
+	int frame_size;		/* Bytes available at frame_data, */
+				/* including one for a nul terminator. */
+
+	unsigned char frame_inline[AX25_INLINE_LEN];
 				
 
 	int magic2;		/* Will get stomped on if above overflows. */
@@ -383,6 +438,9 @@ extern int ax25_get_num_repeaters (packet_t this_p);
 extern void ax25_get_addr_with_ssid (packet_t pp, int n, char *station);
 extern void ax25_get_addr_no_ssid (packet_t pp, int n, char *station);
 
+extern uint64_t ax25_get_addr_key (packet_t pp, int n);
+extern uint64_t ax25_addr_key (const char *station);
+
 extern int ax25_get_ssid (packet_t pp, int n);
 extern void ax25_set_ssid (packet_t this_p, int n, int ssid);
 
@@ -409,6 +467,10 @@ extern packet_t ax25_get_nextp (packet_t this_p);
 extern void ax25_set_release_time (packet_t this_p, double release_time);
 extern double ax25_get_release_time (packet_t this_p);
 
+extern void ax25_set_rx_time (packet_t this_p, double rx_time, long long rx_sample);
+extern double ax25_get_rx_time (packet_t this_p);
+extern long long ax25_get_rx_sample (packet_t this_p);
+
 extern void ax25_set_modulo (packet_t this_p, int modulo);
 extern int ax25_get_modulo (packet_t this_p);
 
@@ -431,6 +493,7 @@ extern int ax25_get_pid (packet_t this_p);
 
 extern int ax25_get_frame_len (packet_t this_p);
 extern unsigned char *ax25_get_frame_data_ptr (packet_t this_p);
+extern void ax25_frame_reserve (packet_t this_p, int len);
 
 extern unsigned short ax25_dedupe_crc (packet_t pp);
 
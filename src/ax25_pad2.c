@@ -157,6 +157,8 @@ extern int ax25memdebug;
 
 static int set_addrs (packet_t pp, char addrs[AX25_MAX_ADDRS][AX25_MAX_ADDR_LEN], int num_addr, cmdres_t cr);
 
+static void reserve_frame (packet_t pp, unsigned char *pinfo, int info_len);
+
 //#if AX25MEMDEBUG
 //#undef AX25MEMDEBUG
 //#endif
@@ -260,6 +262,8 @@ packet_t ax25_u_frame (char addrs[AX25_MAX_ADDRS][AX25_MAX_ADDR_LEN], int num_ad
 	  }
 	}
 
+	reserve_frame (this_p, pinfo, info_len);
+
 	p = this_p->frame_data + this_p->frame_len;
 	*p++ = ctrl;	
 	this_p->frame_len++;
@@ -430,6 +434,8 @@ packet_t ax25_s_frame (char addrs[AX25_MAX_ADDRS][AX25_MAX_ADDR_LEN], int num_ad
 	    break;
 	}
 
+	reserve_frame (this_p, pinfo, info_len);
+
 	p = this_p->frame_data + this_p->frame_len;
 
 	if (modulo == 8) {
@@ -582,6 +588,8 @@ packet_t ax25_i_frame (char addrs[AX25_MAX_ADDRS][AX25_MAX_ADDR_LEN], int num_ad
 	  ns &= (modulo - 1);
 	}
 
+	reserve_frame (this_p, pinfo, info_len);
+
 	p = this_p->frame_data + this_p->frame_len;
 
 	if (modulo == 8) {
@@ -927,6 +935,70 @@ int main ()
 	  }
 	}
 
+/* Addresses are taken apart once and kept.  Make sure changes are noticed. */
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\nParsed addresses and keys\n");
+
+	char station[AX25_MAX_ADDR_LEN];
+	packet_t pp2;
+
+	pp = ax25_from_text ("WB2OSZ-15>APDW17,W2UB,wide2-2*:test", 0);
+	assert (pp != NULL);
+
+	for (int n = 0; n < ax25_get_num_addr(pp); n++) {
+	  ax25_get_addr_with_ssid (pp, n, station);
+	  assert (ax25_get_addr_key(pp, n) == ax25_addr_key(station));
+	}
+	ax25_get_addr_no_ssid (pp, AX25_SOURCE, station);
+	assert (strcmp(station, "WB2OSZ") == 0);
+	assert (ax25_get_addr_key(pp, AX25_SOURCE) == ax25_addr_key("WB2OSZ-15"));
+	assert ((ax25_get_addr_key(pp, AX25_SOURCE) & AX25_KEY_CALL_MASK) == ax25_addr_key("WB2OSZ"));
+	assert (ax25_get_addr_key(pp, AX25_REPEATER_2) == ax25_addr_key("wide2-2"));
+	assert (ax25_get_addr_key(pp, AX25_REPEATER_2) != ax25_addr_key("WIDE2-2"));
+
+	ax25_set_addr (pp, AX25_REPEATER_1, "N0CALL-7");
+	ax25_get_addr_with_ssid (pp, AX25_REPEATER_1, station);
+	assert (strcmp(station, "N0CALL-7") == 0);
+
+	ax25_set_ssid (pp, AX25_SOURCE, 3);
+	ax25_get_addr_with_ssid (pp, AX25_SOURCE, station);
+	assert (strcmp(station, "WB2OSZ-3") == 0);
+
+	ax25_insert_addr (pp, AX25_REPEATER_1, "DIGI1");
+	assert (ax25_get_addr_key(pp, AX25_REPEATER_2) == ax25_addr_key("N0CALL-7"));
+
+	pp2 = ax25_dup (pp);
+	ax25_remove_addr (pp, AX25_REPEATER_1);
+	assert (ax25_get_addr_key(pp, AX25_REPEATER_1) == ax25_addr_key("N0CALL-7"));
+	assert (ax25_get_addr_key(pp2, AX25_REPEATER_1) == ax25_addr_key("DIGI1"));
+	ax25_delete (pp);
+	ax25_delete (pp2);
+
+/* Copy of a frame too long for the small buffer inside the packet object. */
+
+	unsigned char long_info[300];
+	for (int n = 0; n < (int)sizeof(long_info); n++) long_info[n] = 'A' + n % 26;
+
+	pp = ax25_from_text ("WB2OSZ-15>APDW17:x", 0);
+	assert (pp != NULL);
+	ax25_set_info (pp, long_info, sizeof(long_info));
+	assert (ax25_get_frame_len(pp) > AX25_INLINE_LEN);
+
+	pp2 = ax25_dup (pp);
+	assert (ax25_get_frame_len(pp2) == ax25_get_frame_len(pp));
+	assert (memcmp(ax25_get_frame_data_ptr(pp2), ax25_get_frame_data_ptr(pp), ax25_get_frame_len(pp)) == 0);
+	assert (ax25_get_frame_data_ptr(pp2) != ax25_get_frame_data_ptr(pp));
+	ax25_delete (pp);
+	assert (ax25_get_info(pp2, &pinfo) == (int)sizeof(long_info));
+	assert (memcmp(pinfo, long_info, sizeof(long_info)) == 0);
+	ax25_delete (pp2);
+
+	assert (ax25_addr_key("") == 0);
+	assert (ax25_addr_key("TOOLONG") == 0);
+	assert (ax25_addr_key("W2UB-16") == 0);
+	assert (ax25_addr_key("W2UB-") == 0);
+
 	text_color_set(DW_COLOR_REC);
 	dw_printf ("\n----------\n\n");
 	dw_printf ("\nSUCCESS!\n");
@@ -938,4 +1010,28 @@ int main ()
 #endif
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	reserve_frame
+ * 
+ * Purpose:	Make room for control, protocol id, and information part
+ *		after the addresses.
+ *
+ * Inputs:	pp		- Packet object with addresses already set.
+ *		pinfo, info_len	- Information part, if any.  Larger than
+ *				  AX25_MAX_INFO_LEN will be truncated by the caller.
+ *
+ *------------------------------------------------------------------------------*/
+
+static void reserve_frame (packet_t pp, unsigned char *pinfo, int info_len)
+{
+	int len = 0;
+
+	if (pinfo != NULL && info_len > 0) {
+	  len = info_len < AX25_MAX_INFO_LEN ? info_len : AX25_MAX_INFO_LEN;
+	}
+	ax25_frame_reserve (pp, pp->frame_len + 3 + len);
+}
+
+
 /* end ax25_pad2.c */
@@ -26,6 +26,15 @@
  *		
  * Description:	Transmit periodic messages as specified in the config file.
  *
+ *		The thread sleeps until the next scheduled beacon.
+ *		For SmartBeaconing, it used to also wake up every few
+ *		seconds to check the GPS for a change of speed or direction.
+ *		Now each new GPS fix is checked as it arrives, in the GPS
+ *		reader thread, and the beacon thread is woken up only if
+ *		that makes the next tracker beacon sooner.  Corner pegging
+ *		is then noticed within one fix and nothing wakes up while
+ *		sitting still.
+ *
  *---------------------------------------------------------------*/
 
 //#define DEBUG 1
@@ -67,6 +76,82 @@ static struct audio_s        *g_modem_config_p;
 static struct misc_config_s  *g_misc_config_p;
 static struct igate_config_s *g_igate_config_p;
 
+/*
+ * New settings after the configuration file has been read again.
+ * beacon_thread switches over to these when it wakes up.
+ */
+
+static dw_mutex_t reconfig_mutex;
+
+static struct misc_config_s  *g_new_misc_config_p = NULL;
+static struct igate_config_s *g_new_igate_config_p = NULL;
+
+/*
+ * Settings passed to beacon_reconfig belong to us from then on.
+ * The ones from startup do not.
+ */
+
+static int g_misc_config_owned = 0;
+
+static void retire_misc_config (struct misc_config_s *pconfig);
+
+static int beacon_thread_started = 0;
+
+
+/*
+ * Wake up beacon_thread before the next scheduled beacon.
+ * Used for new settings and when a GPS fix makes the next
+ * tracker beacon sooner.
+ */
+
+#if __WIN32__
+static HANDLE wake_up_event;
+#else
+static pthread_mutex_t wake_up_mutex;
+static pthread_cond_t wake_up_cond;
+static int wake_up_pending = 0;
+#endif
+
+static void beacon_wake_up (void);
+
+static void beacon_gps_notify (dwgps_info_t *gpsinfo);
+
+
+/*
+ * SmartBeaconing state.
+ * Shared between beacon_thread and the GPS reader thread.
+ */
+
+static dw_mutex_t sb_mutex;
+
+static int sb_number_of_tbeacons = 0;	/* Number of tracker beacons. */
+
+static time_t sb_prev_time = 0;		/* Time of most recent transmission. */
+static float sb_prev_course = 0;	/* Most recent course reported. */
+
+static time_t sb_next_time = 0;		/* Earliest scheduled tracker beacon. */
+
+/*
+ * Copy of the SmartBeaconing settings so the GPS reader thread
+ * never looks at a configuration that is being replaced.
+ * Same meanings as sb_... in struct misc_config_s.
+ * Only beacon_thread changes it once running, so beacon_thread
+ * itself can read it without sb_mutex.
+ */
+
+static struct sb_param_s {
+	int configured;
+	int fast_speed;
+	int fast_rate;
+	int slow_speed;
+	int slow_rate;
+	int turn_time;
+	int turn_angle;
+	int turn_slope;
+} sb_param;
+
+static void sb_save_param (struct misc_config_s *pconfig);
+
 
 #if __WIN32__
 static unsigned __stdcall beacon_thread (void *arg);
@@ -90,6 +175,10 @@ static time_t sb_calculate_next_time (time_t now,
 
 static void beacon_send (int j, dwgps_info_t *gpsinfo);
 
+static int beacon_prepare (struct misc_config_s *pconfig, struct igate_config_s *pigate);
+
+static void start_beacon_thread (void);
+
 
 /*-------------------------------------------------------------------
  *
@@ -120,15 +209,7 @@ static void beacon_send (int j, dwgps_info_t *gpsinfo);
 
 void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct igate_config_s *pigate)
 {
-	time_t now;
-	struct tm tm;
-	int j;
 	int count;
-#if __WIN32__
-	HANDLE beacon_th;
-#else
-	pthread_t beacon_tid;
-#endif
 
 
 
@@ -146,6 +227,48 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 	g_misc_config_p = pconfig;
 	g_igate_config_p = pigate;
 
+	dw_mutex_init (&reconfig_mutex);
+
+	count = beacon_prepare (pconfig, pigate);
+
+/* 
+ * Start up thread for processing only if at least one is valid.
+ */
+
+	if (count >= 1) {
+	  start_beacon_thread ();
+	}
+
+
+} /* end beacon_init */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        beacon_prepare
+ *
+ * Purpose:     Check beacon configuration and calculate the first
+ *		transmission time for each.
+ *
+ * Inputs:	pconfig		- misc. configuration from config file.
+ *
+ *		pigate		- IGate configuration.
+ *
+ * Outputs:	pconfig->beacon[].btype is set to BEACON_IGNORE for
+ *		any with serious errors.  pconfig->beacon[].next is set.
+ *
+ * Returns:	Number of beacons which are usable.
+ *
+ *--------------------------------------------------------------------*/
+
+static int beacon_prepare (struct misc_config_s *pconfig, struct igate_config_s *pigate)
+{
+	time_t now;
+	struct tm tm;
+	int j;
+	int count;
+
 /*
  * Precompute the packet contents so any errors are 
  * Reported once at start up time rather than for each transmission.
@@ -158,8 +281,8 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 // optional, or not allowed for each beacon type.  Options which
 // are not applicable are often silently ignored, causing confusion.
 
-	for (j=0; j<g_misc_config_p->num_beacons; j++) {
-	  int chan = g_misc_config_p->beacon[j].sendto_chan;
+	for (j=0; j<pconfig->num_beacons; j++) {
+	  int chan = pconfig->beacon[j].sendto_chan;
 
 	  if (chan < 0) chan = 0;	/* For IGate, use channel 0 call. */
 	  if (chan >= MAX_CHANS) chan = 0;	// For ICHANNEL, use channel 0 call.
@@ -171,16 +294,16 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 			 strcasecmp(g_modem_config_p->achan[chan].mycall, "N0CALL") != 0 &&
 			 strcasecmp(g_modem_config_p->achan[chan].mycall, "NOCALL") != 0) {
 
-              switch (g_misc_config_p->beacon[j].btype) {
+              switch (pconfig->beacon[j].btype) {
 
 	        case BEACON_OBJECT:
 
 		  /* Object name is required. */
 
-		  if (strlen(g_misc_config_p->beacon[j].objname) == 0) {
+		  if (strlen(pconfig->beacon[j].objname) == 0) {
 	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Config file, line %d: OBJNAME is required for OBEACON.\n", g_misc_config_p->beacon[j].lineno);
-		    g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+	            dw_printf ("Config file, line %d: OBJNAME is required for OBEACON.\n", pconfig->beacon[j].lineno);
+		    pconfig->beacon[j].btype = BEACON_IGNORE;
 		    continue;
 		  }
 		  /* Fall thru.  Ignore any warning about missing break. */
@@ -189,22 +312,22 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 
 		  /* Location is required. */
 
-		  if (g_misc_config_p->beacon[j].lat == G_UNKNOWN || g_misc_config_p->beacon[j].lon == G_UNKNOWN) {
+		  if (pconfig->beacon[j].lat == G_UNKNOWN || pconfig->beacon[j].lon == G_UNKNOWN) {
 	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Config file, line %d: Latitude and longitude are required.\n", g_misc_config_p->beacon[j].lineno);
-		    g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+	            dw_printf ("Config file, line %d: Latitude and longitude are required.\n", pconfig->beacon[j].lineno);
+		    pconfig->beacon[j].btype = BEACON_IGNORE;
 		    continue;
 		  }	
 
 		  /* INFO and INFOCMD are only for Custom Beacon. */
 
-		  if (g_misc_config_p->beacon[j].custom_info != NULL || g_misc_config_p->beacon[j].custom_infocmd != NULL) {
+		  if (pconfig->beacon[j].custom_info != NULL || pconfig->beacon[j].custom_infocmd != NULL) {
 	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Config file, line %d: INFO or INFOCMD are allowed only for custom beacon.\n", g_misc_config_p->beacon[j].lineno);
+	            dw_printf ("Config file, line %d: INFO or INFOCMD are allowed only for custom beacon.\n", pconfig->beacon[j].lineno);
 	            dw_printf ("INFO and INFOCMD allow you to specify contents of the Information field so it\n");
 	            dw_printf ("so it would not make sense to use these with other beacon types which construct\n");
 	            dw_printf ("the Information field. Perhaps you want to use COMMENT or COMMENTCMD option.\n");
-		    //g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+		    //pconfig->beacon[j].btype = BEACON_IGNORE;
 		    continue;
 		  }	
 		  break;
@@ -219,8 +342,8 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 		    if (fix == DWFIX_NOT_INIT) {
 
 	              text_color_set(DW_COLOR_ERROR);
-	              dw_printf ("Config file, line %d: GPS must be configured to use TBEACON.\n", g_misc_config_p->beacon[j].lineno);
-	              g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+	              dw_printf ("Config file, line %d: GPS must be configured to use TBEACON.\n", pconfig->beacon[j].lineno);
+	              pconfig->beacon[j].btype = BEACON_IGNORE;
 #if __WIN32__
 	              dw_printf ("You must specify the GPSNMEA command in your configuration file.\n");
 	              dw_printf ("This contains the name of the serial port where the receiver is connected.\n");
@@ -235,13 +358,13 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 
 		  /* INFO and INFOCMD are only for Custom Beacon. */
 
-		  if (g_misc_config_p->beacon[j].custom_info != NULL || g_misc_config_p->beacon[j].custom_infocmd != NULL) {
+		  if (pconfig->beacon[j].custom_info != NULL || pconfig->beacon[j].custom_infocmd != NULL) {
 	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Config file, line %d: INFO or INFOCMD are allowed only for custom beacon.\n", g_misc_config_p->beacon[j].lineno);
+	            dw_printf ("Config file, line %d: INFO or INFOCMD are allowed only for custom beacon.\n", pconfig->beacon[j].lineno);
 	            dw_printf ("INFO and INFOCMD allow you to specify contents of the Information field so it\n");
 	            dw_printf ("so it would not make sense to use these with other beacon types which construct\n");
 	            dw_printf ("the Information field. Perhaps you want to use COMMENT or COMMENTCMD option.\n");
-		    //g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+		    //pconfig->beacon[j].btype = BEACON_IGNORE;
 		    continue;
 		  }	
 		  break;
@@ -250,10 +373,10 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 
 		  /* INFO or INFOCMD is required. */
 
-		  if (g_misc_config_p->beacon[j].custom_info == NULL && g_misc_config_p->beacon[j].custom_infocmd == NULL) {
+		  if (pconfig->beacon[j].custom_info == NULL && pconfig->beacon[j].custom_infocmd == NULL) {
 	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Config file, line %d: INFO or INFOCMD is required for custom beacon.\n", g_misc_config_p->beacon[j].lineno);
-		    g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+	            dw_printf ("Config file, line %d: INFO or INFOCMD is required for custom beacon.\n", pconfig->beacon[j].lineno);
+		    pconfig->beacon[j].btype = BEACON_IGNORE;
 		    continue;
 		  }	
 		  break;
@@ -262,14 +385,14 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 
 		  /* Doesn't make sense if IGate is not configured. */
 
-	          if (strlen(g_igate_config_p->t2_server_name) == 0 ||
-	              strlen(g_igate_config_p->t2_login) == 0 ||
-	              strlen(g_igate_config_p->t2_passcode) == 0) {
+	          if (strlen(pigate->t2_server_name) == 0 ||
+	              strlen(pigate->t2_login) == 0 ||
+	              strlen(pigate->t2_passcode) == 0) {
 
 	            text_color_set(DW_COLOR_ERROR);
-	            dw_printf ("Config file, line %d: Doesn't make sense to use IBEACON without IGate Configured.\n", g_misc_config_p->beacon[j].lineno);
+	            dw_printf ("Config file, line %d: Doesn't make sense to use IBEACON without IGate Configured.\n", pconfig->beacon[j].lineno);
 	            dw_printf ("IBEACON has been disabled.\n");
-		    g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+		    pconfig->beacon[j].btype = BEACON_IGNORE;
 		    continue;
 		  }
 		  break;
@@ -280,14 +403,14 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 	    }
 	    else {
 	      text_color_set(DW_COLOR_ERROR);
-	      dw_printf ("Config file, line %d: MYCALL must be set for beacon on channel %d. \n", g_misc_config_p->beacon[j].lineno, chan);
-	      g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+	      dw_printf ("Config file, line %d: MYCALL must be set for beacon on channel %d. \n", pconfig->beacon[j].lineno, chan);
+	      pconfig->beacon[j].btype = BEACON_IGNORE;
 	    }
 	  }
 	  else {
 	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Config file, line %d: Invalid channel number %d for beacon. \n", g_misc_config_p->beacon[j].lineno, chan);
-	    g_misc_config_p->beacon[j].btype = BEACON_IGNORE;
+	    dw_printf ("Config file, line %d: Invalid channel number %d for beacon. \n", pconfig->beacon[j].lineno, chan);
+	    pconfig->beacon[j].btype = BEACON_IGNORE;
 	  }
 	}
 
@@ -298,8 +421,8 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 	now = time(NULL);
 	localtime_r (&now, &tm);
 
-	for (j=0; j<g_misc_config_p->num_beacons; j++) {
-	  struct beacon_s *bp = & (g_misc_config_p->beacon[j]);
+	for (j=0; j<pconfig->num_beacons; j++) {
+	  struct beacon_s *bp = & (pconfig->beacon[j]);
 #if DEBUG
 
 	  text_color_set(DW_COLOR_DEBUG);
@@ -357,44 +480,217 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
 	    while (bp->delay < 5) bp->delay += bp->every;
 	  }
 
-	  g_misc_config_p->beacon[j].next = now + g_misc_config_p->beacon[j].delay;
+	  pconfig->beacon[j].next = now + pconfig->beacon[j].delay;
 	}
 
 
-/* 
- * Start up thread for processing only if at least one is valid.
- */
-
 	count = 0;
-	for (j=0; j<g_misc_config_p->num_beacons; j++) {
-          if (g_misc_config_p->beacon[j].btype != BEACON_IGNORE) {
+	for (j=0; j<pconfig->num_beacons; j++) {
+          if (pconfig->beacon[j].btype != BEACON_IGNORE) {
 	    count++;
 	  }
 	}
+	return (count);
 
-	if (count >= 1) {
+} /* end beacon_prepare */
 
+
+
+static void start_beacon_thread (void)
+{
 #if __WIN32__
-	  beacon_th = (HANDLE)_beginthreadex (NULL, 0, &beacon_thread, NULL, 0, NULL);
-	  if (beacon_th == NULL) {
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Could not create beacon thread\n");
-	    return;
-	  }
+	HANDLE beacon_th;
 #else
-	  int e;
+	pthread_t beacon_tid;
+	int e;
+#endif
 
-	  e = pthread_create (&beacon_tid, NULL, beacon_thread, NULL);
-	  if (e != 0) {
-	    text_color_set(DW_COLOR_ERROR);
-	    perror("Could not create beacon thread");
-	    return;
-	  }
+	dw_mutex_init (&sb_mutex);
+	sb_save_param (g_misc_config_p);
+
+#if __WIN32__
+	wake_up_event = CreateEvent (NULL, 0, 0, NULL);		// Auto reset.
+#else
+	pthread_mutex_init (&wake_up_mutex, NULL);
+	pthread_cond_init (&wake_up_cond, NULL);
+#endif
+
+#if __WIN32__
+	beacon_th = (HANDLE)_beginthreadex (NULL, 0, &beacon_thread, NULL, 0, NULL);
+	if (beacon_th == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create beacon thread\n");
+	  return;
+	}
+#else
+	e = pthread_create (&beacon_tid, NULL, beacon_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create beacon thread");
+	  return;
+	}
+#endif
+	beacon_thread_started = 1;
+
+	dwgps_set_notify (beacon_gps_notify);
+
+} /* end start_beacon_thread */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        beacon_wake_up
+ *
+ * Purpose:     Get beacon_thread to look at the schedule again now.
+ *
+ *--------------------------------------------------------------------*/
+
+static void beacon_wake_up (void)
+{
+#if __WIN32__
+	SetEvent (wake_up_event);
+#else
+	pthread_mutex_lock (&wake_up_mutex);
+	wake_up_pending = 1;
+	pthread_cond_signal (&wake_up_cond);
+	pthread_mutex_unlock (&wake_up_mutex);
 #endif
+}
+
+
+/*
+ * Sleep until the given time or beacon_wake_up is called.
+ */
+
+static void wait_for_wake_up (time_t until)
+{
+#if __WIN32__
+	time_t now = time(NULL);
+	if (until > now) {
+	  WaitForSingleObject (wake_up_event, (DWORD)(until - now) * 1000);
 	}
+#else
+	struct timespec abstime;
 
+	abstime.tv_sec = until;
+	abstime.tv_nsec = 0;
 
-} /* end beacon_init */
+	pthread_mutex_lock (&wake_up_mutex);
+	if ( ! wake_up_pending) {
+	  pthread_cond_timedwait (&wake_up_cond, &wake_up_mutex, &abstime);
+	}
+	wake_up_pending = 0;
+	pthread_mutex_unlock (&wake_up_mutex);
+#endif
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        beacon_gps_notify
+ *
+ * Purpose:     Check a new GPS fix against the SmartBeaconing schedule.
+ *
+ * Inputs:	gpsinfo		- Latest from GPS.
+ *
+ * Description:	This is called from the GPS reader thread for every fix.
+ *		It's a small amount of arithmetic.  Only if the result is
+ *		earlier than the next tracker beacon already scheduled,
+ *		e.g. a sharp turn or speeding up, do we wake up the
+ *		beacon thread to do the rest.
+ *
+ *--------------------------------------------------------------------*/
+
+static void beacon_gps_notify (dwgps_info_t *gpsinfo)
+{
+	int wake = 0;
+
+	if (gpsinfo->fix < DWFIX_2D) {
+	  return;
+	}
+
+	dw_mutex_lock (&sb_mutex);
+
+	if (sb_param.configured && sb_number_of_tbeacons > 0) {
+	  time_t now = time(NULL);
+	  time_t tnext = sb_calculate_next_time (now,
+			DW_KNOTS_TO_MPH(gpsinfo->speed_knots), gpsinfo->track,
+			sb_prev_time, sb_prev_course);
+	  wake = tnext < sb_next_time;
+	}
+
+	dw_mutex_unlock (&sb_mutex);
+
+	if (wake) {
+	  beacon_wake_up ();
+	}
+
+} /* end beacon_gps_notify */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        beacon_reconfig
+ *
+ * Purpose:     Switch to new beacon settings after the configuration
+ *		file has been read again.
+ *
+ * Inputs:	pconfig		- New misc. configuration.
+ *				  Only the beacon and SmartBeaconing parts are used.
+ *				  Allocated with malloc.  It belongs to us now and
+ *				  is freed when something newer replaces it.
+ *
+ *		pigate		- New IGate configuration.
+ *
+ * Description:	The new configuration is checked and scheduled here.
+ *		beacon_thread picks it up the next time it wakes up so
+ *		we never change the beacon table out from under it.
+ *
+ *--------------------------------------------------------------------*/
+
+void beacon_reconfig (struct misc_config_s *pconfig, struct igate_config_s *pigate)
+{
+	int count;
+
+	count = beacon_prepare (pconfig, pigate);
+
+	dw_mutex_lock (&reconfig_mutex);
+	if (beacon_thread_started) {
+	  if (g_new_misc_config_p != NULL) {
+	    /* Replaced before beacon_thread ever looked at it. */
+	    retire_misc_config (g_new_misc_config_p);
+	  }
+	  g_new_misc_config_p = pconfig;
+	  g_new_igate_config_p = pigate;
+	  beacon_wake_up ();
+	}
+	else {
+	  if (g_misc_config_owned) {
+	    retire_misc_config (g_misc_config_p);
+	  }
+	  g_misc_config_p = pconfig;
+	  g_misc_config_owned = 1;
+	  g_igate_config_p = pigate;
+	  if (count >= 1) {
+	    start_beacon_thread ();
+	  }
+	}
+	dw_mutex_unlock (&reconfig_mutex);
+
+} /* end beacon_reconfig */
+
+
+/*
+ * Free settings that have been replaced.
+ * Never for the ones from startup.  Other parts of the application use those.
+ */
+
+static void retire_misc_config (struct misc_config_s *pconfig)
+{
+	misc_config_free (pconfig);
+	free (pconfig);
+}
 
 
 
@@ -410,7 +706,8 @@ void beacon_init (struct audio_s *pmodem, struct misc_config_s *pconfig, struct
  *
  * Outputs:	g_misc_config_p->beacon[].next_time
  *
- * Description:	Go to sleep until it is time for the next beacon.
+ * Description:	Go to sleep until it is time for the next beacon,
+ *		or something changes the schedule.
  *		Transmit any beacons scheduled for now.
  *		Repeat.
  *
@@ -433,13 +730,6 @@ static void * beacon_thread (void *arg)
 	int number_of_tbeacons;		/* Number of tracker beacons. */
 
 
-/*
- * SmartBeaconing state.
- */
-	time_t sb_prev_time = 0;	/* Time of most recent transmission. */
-	float sb_prev_course = 0;	/* Most recent course reported. */
-
-
 #if DEBUG
 	struct tm tm;
 	char hms[20];
@@ -464,6 +754,7 @@ static void * beacon_thread (void *arg)
 	    number_of_tbeacons++;
 	  }
 	}
+	sb_number_of_tbeacons = number_of_tbeacons;
 
 	now = time(NULL);
 
@@ -471,25 +762,58 @@ static void * beacon_thread (void *arg)
 
 	  dwgps_info_t gpsinfo;
 
+/*
+ * Switch over to new settings if the configuration file was read again.
+ */
+	  dw_mutex_lock (&reconfig_mutex);
+	  if (g_new_misc_config_p != NULL) {
+	    if (g_misc_config_owned) {
+	      retire_misc_config (g_misc_config_p);
+	    }
+	    g_misc_config_owned = 1;
+	    g_misc_config_p = g_new_misc_config_p;
+	    g_igate_config_p = g_new_igate_config_p;
+	    g_new_misc_config_p = NULL;
+	    g_new_igate_config_p = NULL;
+
+	    number_of_tbeacons = 0;
+	    for (j=0; j<g_misc_config_p->num_beacons; j++) {
+	      if (g_misc_config_p->beacon[j].btype == BEACON_TRACKER) {
+	        number_of_tbeacons++;
+	      }
+	    }
+
+	    dw_mutex_lock (&sb_mutex);
+	    sb_number_of_tbeacons = number_of_tbeacons;
+	    dw_mutex_unlock (&sb_mutex);
+
+	    sb_save_param (g_misc_config_p);
+	  }
+	  dw_mutex_unlock (&reconfig_mutex);
+
 /* 
- * Sleep until time for the earliest scheduled or
- * the soonest we could transmit due to corner pegging.
+ * Sleep until time for the earliest scheduled.
+ * beacon_gps_notify wakes us up sooner if a GPS fix calls for
+ * an earlier tracker beacon.
  */
-	  
+	  time_t tracker_next = now + 60 * 60;
+
 	  earliest = now + 60 * 60;
 	  for (j=0; j<g_misc_config_p->num_beacons; j++) {
 	    if (g_misc_config_p->beacon[j].btype != BEACON_IGNORE) {
 	      earliest = MIN(g_misc_config_p->beacon[j].next, earliest);
 	    }
+	    if (g_misc_config_p->beacon[j].btype == BEACON_TRACKER) {
+	      tracker_next = MIN(g_misc_config_p->beacon[j].next, tracker_next);
+	    }
 	  }
 
-	  if (g_misc_config_p->sb_configured && number_of_tbeacons > 0) {
-	    earliest = MIN(now + g_misc_config_p->sb_turn_time, earliest);
-            earliest = MIN(now + g_misc_config_p->sb_fast_rate, earliest);
-	  }
+	  dw_mutex_lock (&sb_mutex);
+	  sb_next_time = tracker_next;
+	  dw_mutex_unlock (&sb_mutex);
 
-	  if (earliest > now) {
-	    SLEEP_SEC (earliest - now);
+	  if (earliest > now && g_new_misc_config_p == NULL) {
+	    wait_for_wake_up (earliest);
 	  }
 
 /*
@@ -597,8 +921,10 @@ static void * beacon_thread (void *arg)
 		  /* Remember most recent tracker beacon. */
 	          /* Compute next time if not turning. */
 
+		  dw_mutex_lock (&sb_mutex);
 		  sb_prev_time = now;
 		  sb_prev_course = gpsinfo.track;
+		  dw_mutex_unlock (&sb_mutex);
 
 	          bp->next = sb_calculate_next_time (now,
 			DW_KNOTS_TO_MPH(gpsinfo.speed_knots), gpsinfo.track,
@@ -666,15 +992,14 @@ static void * beacon_thread (void *arg)
  *
  *		last_xmit_course	- Direction included in most recent transmission.
  *
- * Global In:	g_misc_config_p->
- *			sb_configured	TRUE if SmartBeaconing is configured.
- *			sb_fast_speed	MPH
- *			sb_fast_rate	seconds
- *			sb_slow_speed	MPH
- *			sb_slow_rate	seconds
- *			sb_turn_time	seconds
- *			sb_turn_angle	degrees
- *			sb_turn_slope	degrees * MPH
+ * Global In:	sb_param.
+ *			fast_speed	MPH
+ *			fast_rate	seconds
+ *			slow_speed	MPH
+ *			slow_rate	seconds
+ *			turn_time	seconds
+ *			turn_angle	degrees
+ *			turn_slope	degrees * MPH
  *
  * Returns:	Time of next transmission.
  *		Could vary from now to sb_slow_rate in the future.
@@ -709,17 +1034,17 @@ static time_t sb_calculate_next_time (time_t now,
  */
 
 	if (current_speed_mph == G_UNKNOWN) {
-	  beacon_rate = (int)roundf((g_misc_config_p->sb_fast_rate + g_misc_config_p->sb_slow_rate) / 2.);
+	  beacon_rate = (int)roundf((sb_param.fast_rate + sb_param.slow_rate) / 2.);
 	}
-	else if (current_speed_mph > g_misc_config_p->sb_fast_speed) {
-	  beacon_rate = g_misc_config_p->sb_fast_rate;
+	else if (current_speed_mph > sb_param.fast_speed) {
+	  beacon_rate = sb_param.fast_rate;
 	}
-	else if (current_speed_mph < g_misc_config_p->sb_slow_speed) {
-	  beacon_rate = g_misc_config_p->sb_slow_rate;
+	else if (current_speed_mph < sb_param.slow_speed) {
+	  beacon_rate = sb_param.slow_rate;
 	}
 	else {
-	  /* Can't divide by 0 assuming sb_slow_speed > 0. */
-	  beacon_rate = (int)roundf(( g_misc_config_p->sb_fast_rate * g_misc_config_p->sb_fast_speed ) / current_speed_mph);
+	  /* Can't divide by 0 assuming slow_speed > 0. */
+	  beacon_rate = (int)roundf(( sb_param.fast_rate * sb_param.fast_speed ) / current_speed_mph);
 	}
 
 	if (g_tracker_debug_level >= 2) {
@@ -736,11 +1061,11 @@ static time_t sb_calculate_next_time (time_t now,
 		current_course != G_UNKNOWN && last_xmit_course != G_UNKNOWN) {
 
 	  float change = heading_change(current_course, last_xmit_course);
-	  float turn_threshold = g_misc_config_p->sb_turn_angle +
-			g_misc_config_p->sb_turn_slope / current_speed_mph;
+	  float turn_threshold = sb_param.turn_angle +
+			sb_param.turn_slope / current_speed_mph;
 
 	  if (change > turn_threshold &&
-		  now >= last_xmit_time + g_misc_config_p->sb_turn_time) {
+		  now >= last_xmit_time + sb_param.turn_time) {
 
 	    if (g_tracker_debug_level >= 2) {
 	      text_color_set(DW_COLOR_DEBUG);
@@ -756,6 +1081,27 @@ static time_t sb_calculate_next_time (time_t now,
 } /* end sb_calculate_next_time */
 
 
+/*
+ * Take a copy of the SmartBeaconing settings for sb_calculate_next_time.
+ * Called before the beacon thread starts and by the beacon thread
+ * when it switches to new settings.
+ */
+
+static void sb_save_param (struct misc_config_s *pconfig)
+{
+	dw_mutex_lock (&sb_mutex);
+	sb_param.configured = pconfig->sb_configured;
+	sb_param.fast_speed = pconfig->sb_fast_speed;
+	sb_param.fast_rate = pconfig->sb_fast_rate;
+	sb_param.slow_speed = pconfig->sb_slow_speed;
+	sb_param.slow_rate = pconfig->sb_slow_rate;
+	sb_param.turn_time = pconfig->sb_turn_time;
+	sb_param.turn_angle = pconfig->sb_turn_angle;
+	sb_param.turn_slope = pconfig->sb_turn_slope;
+	dw_mutex_unlock (&sb_mutex);
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        beacon_send
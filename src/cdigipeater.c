@@ -48,7 +48,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <ctype.h>	/* for isdigit, isupper */
-#include "regex.h"
+#include "digimatch.h"
 #include <unistd.h>
 
 #include "ax25_pad.h"
@@ -59,7 +59,7 @@
 
 
 static packet_t cdigipeat_match (int from_chan, packet_t pp, char *mycall_rec, char *mycall_xmit, 
-				int has_alias, regex_t *alias, int to_chan, char *cfilter_str);
+				int has_alias, digimatch_t *alias, int to_chan, char *cfilter_str);
 
 
 /*
@@ -234,12 +234,10 @@ void cdigipeater (int from_chan, packet_t pp)
 
 
 static packet_t cdigipeat_match (int from_chan, packet_t pp, char *mycall_rec, char *mycall_xmit, 
-				int has_alias, regex_t *alias, int to_chan, char *cfilter_str)
+				int has_alias, digimatch_t *alias, int to_chan, char *cfilter_str)
 {
 	int r;
 	char repeater[AX25_MAX_ADDR_LEN];
-	int err;
-	char err_msg[100];
 
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -316,8 +314,7 @@ static packet_t cdigipeat_match (int from_chan, packet_t pp, char *mycall_rec, c
 	  text_color_set(DW_COLOR_DEBUG);
 	  dw_printf ("Checking %s for alias match.\n", repeater);
 #endif
-	  err = regexec(alias,repeater,0,NULL,0);
-	  if (err == 0) {
+	  if (digimatch(alias, repeater)) {
 	    packet_t result;
 
 	    result = ax25_dup (pp);
@@ -327,11 +324,6 @@ static packet_t cdigipeat_match (int from_chan, packet_t pp, char *mycall_rec, c
 	    ax25_set_h (result, r);
 	    return (result);
 	  }
-	  else if (err != REG_NOMATCH) {
-	    regerror(err, alias, err_msg, sizeof(err_msg));
-	    text_color_set (DW_COLOR_ERROR);
-	    dw_printf ("%s\n", err_msg);
-	  }
 	}
 	else {
 #if DEBUG
@@ -3,7 +3,7 @@
 #ifndef CDIGIPEATER_H
 #define CDIGIPEATER_H 1
 
-#include "regex.h"
+#include "digimatch.h"
 
 #include "direwolf.h"		/* for MAX_CHANS */
 #include "ax25_pad.h"		/* for packet_t */
@@ -31,7 +31,7 @@ struct cdigi_config_s {
 						// result in a crash.  (fixed v1.5)
 						// Not needed for [APRS] DIGIPEAT because
 						// the alias is mandatory there.
-	regex_t	alias[MAX_CHANS][MAX_CHANS];
+	digimatch_t alias[MAX_CHANS][MAX_CHANS];
 
 	char *cfilter_str[MAX_CHANS][MAX_CHANS];
 						// NULL or optional Packet Filter strings such as "t/m".
@@ -910,66 +910,95 @@ int cm108_set_gpio_pin (char *name, int num, int state)
 
 /*-------------------------------------------------------------------
  *
- * Name:	cm108_write
+ * Name:	cm108_open_dev
  *
- * Purpose:	Set the GPIO pins of the CM108 or similar.
+ * Purpose:	Get an open handle for the CM108 or similar device.
  *
  * Inputs:	name		- Name of device such as /dev/hidraw2.
  *
- *		iomask		- Bit mask for I/O direction.
- *				  LSB is GPIO1, bit 1 is GPIO2, etc.
- *				  1 for output, 0 for input.
- *
- *		iodata		- Output data, same bit order as iomask.
- *
- * Returns:	0 for success.  -1 for error.
+ * Returns:	Pointer to cache entry with open handle or NULL for error.
  *
  * Errors:	A descriptive error message will be printed for any problem.
  *
- * Description:	This is the lowest level function.
- *		An application probably wants to use cm108_set_gpio_pin.
+ * Description:	Originally the device was opened and closed again for
+ *		every PTT transition.  Now we keep it open after first use
+ *		so keying the transmitter is a single write.
+ *		If a write fails, the handle is closed and we will try to
+ *		open it again next time.  (e.g. adapter was unplugged.)
+ *
+ *		ptt_init sets the initial state, and fills in the table,
+ *		before the transmit threads start.  After that, each
+ *		channel only uses its own entry.
  *
  *------------------------------------------------------------------*/
 
-static int cm108_write (char *name, int iomask, int iodata)
+#define CM108_MAX_OPEN 8		// Number of different devices we can keep open.
+
+static struct cm108_dev_s {
+	char name[128];			// Same size as ptt_device in audio.h.
+#if __WIN32__
+	hid_device *handle;		// NULL if not open.
+#else
+	int fd;				// -1 if not open.
+#endif
+} cm108_dev[CM108_MAX_OPEN];
+
+static int cm108_num_dev = 0;
+
+
+static struct cm108_dev_s *cm108_open_dev (char *name)
 {
+	struct cm108_dev_s *d = NULL;
+	int i;
+
+	for (i = 0; i < cm108_num_dev && d == NULL; i++) {
+	  if (strcmp(cm108_dev[i].name, name) == 0) {
+	    d = &cm108_dev[i];
+	  }
+	}
 
+	if (d == NULL) {
+	  if (cm108_num_dev >= CM108_MAX_OPEN) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Too many different CM108 devices.  Maximum is %d.\n", CM108_MAX_OPEN);
+	    return (NULL);
+	  }
+	  d = &cm108_dev[cm108_num_dev];
+	  strlcpy (d->name, name, sizeof(d->name));
 #if __WIN32__
+	  d->handle = NULL;
+#else
+	  d->fd = -1;
+#endif
+	  cm108_num_dev++;
+	}
 
-	//text_color_set(DW_COLOR_DEBUG);
-	//dw_printf ("TEMP DEBUG cm108_write:  %s %d %d\n", name, iomask, iodata);
+#if __WIN32__
 
-	hid_device *handle = hid_open_path(name);
-	if (handle == NULL) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Could not open %s for write\n", name);
-	  return (-1);
+	if (d->handle != NULL) {
+	  return (d);
 	}
 
-	unsigned char io[5];
-	io[0] = 0;
-	io[1] = 0;
-	io[2] = iodata;
-	io[3] = iomask;
-	io[4] = 0;
+	//text_color_set(DW_COLOR_DEBUG);
+	//dw_printf ("TEMP DEBUG cm108_open_dev:  %s\n", name);
 
-	int res = hid_write(handle, io, sizeof(io));
-	if (res < 0) {
+	d->handle = hid_open_path(name);
+	if (d->handle == NULL) {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("Write failed to %s\n", name);
-	  return (-1);
+	  dw_printf ("Could not open %s for write\n", name);
+	  return (NULL);
 	}
 
-	hid_close(handle);
-
 #else
-	int fd;
 	struct hidraw_devinfo info;
-	char io[5];
 	int n;
 
+	if (d->fd >= 0) {
+	  return (d);
+	}
+
 	//text_color_set(DW_COLOR_DEBUG);
-	//dw_printf ("TEMP DEBUG cm108_write:  %s %d %d\n", name, iomask, iodata);
+	//dw_printf ("TEMP DEBUG cm108_open_dev:  %s\n", name);
 
 /*
  * By default, the USB HID are accessible only by root:
@@ -1004,8 +1033,8 @@ static int cm108_write (char *name, int iomask, int iodata)
  * audio group to use the USB Audio adapter for sound.
  */
 
-	fd = open (name, O_WRONLY);
-	if (fd == -1) {
+	d->fd = open (name, O_WRONLY);
+	if (d->fd == -1) {
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("Could not open %s for write, errno=%d\n", name, errno);
 	  if (errno == EACCES) {		// 13
@@ -1014,24 +1043,65 @@ static int cm108_write (char *name, int iomask, int iodata)
 	    dw_printf ("rather than root-only access like this:\n");
 	    dw_printf ("    crw------- 1 root root 247, 0 Sep 24 09:40 %s\n", name);
 	  }
-	  return (-1);
+	  return (NULL);
 	}
 
 	// Just for fun, let's get the device information.
+	// Now that we keep it open, this happens only once.
 
 #if 1
-	n = ioctl(fd, HIDIOCGRAWINFO, &info);
+	n = ioctl(d->fd, HIDIOCGRAWINFO, &info);
 	if (n == 0) {
 	  if ( ! GOOD_DEVICE(info.vendor, info.product)) {
 	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("ioctl HIDIOCGRAWINFO failed for %s. errno = %d.\n", name, errno);
+	    dw_printf ("%s is not a supported device type.  Proceed at your own risk.  vid=%04x pid=%04x\n", name, info.vendor, info.product);
 	  }
 	}
 	else {
 	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("%s is not a supported device type.  Proceed at your own risk.  vid=%04x pid=%04x\n", name, info.vendor, info.product);
+	  dw_printf ("ioctl HIDIOCGRAWINFO failed for %s. errno = %d.\n", name, errno);
 	}
 #endif
+
+#endif
+	return (d);
+
+}  /* end cm108_open_dev */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:	cm108_write
+ *
+ * Purpose:	Set the GPIO pins of the CM108 or similar.
+ *
+ * Inputs:	name		- Name of device such as /dev/hidraw2.
+ *
+ *		iomask		- Bit mask for I/O direction.
+ *				  LSB is GPIO1, bit 1 is GPIO2, etc.
+ *				  1 for output, 0 for input.
+ *
+ *		iodata		- Output data, same bit order as iomask.
+ *
+ * Returns:	0 for success.  -1 for error.
+ *
+ * Errors:	A descriptive error message will be printed for any problem.
+ *
+ * Description:	This is the lowest level function.
+ *		An application probably wants to use cm108_set_gpio_pin.
+ *
+ *------------------------------------------------------------------*/
+
+static int cm108_write (char *name, int iomask, int iodata)
+{
+	struct cm108_dev_s *d = cm108_open_dev(name);
+
+	if (d == NULL) {
+	  return (-1);
+	}
+
+	unsigned char io[5];
+
 	// To make a long story short, I think we need 0 for the first two bytes.
 
 	io[0] = 0;
@@ -1046,7 +1116,23 @@ static int cm108_write (char *name, int iomask, int iodata)
 	// Writing 5 bytes works.
 	// I have no idea why.  From the CMedia datasheet it looks like we need 4.
 
-	n = write (fd, io, sizeof(io));
+#if __WIN32__
+
+	int res = hid_write(d->handle, io, sizeof(io));
+	if (res < 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Write failed to %s\n", name);
+
+	  // Maybe it was unplugged.  Try opening again next time.
+	  hid_close(d->handle);
+	  d->handle = NULL;
+	  return (-1);
+	}
+
+#else
+	int n;
+
+	n = write (d->fd, io, sizeof(io));
 	if (n != sizeof(io)) {
 	  //  Errors observed during development.
 	  //  as pi		EACCES          13      /* Permission denied */
@@ -1062,12 +1148,12 @@ static int cm108_write (char *name, int iomask, int iodata)
 	    dw_printf ("    crw------- 1 root root 247, 0 Sep 24 09:40 %s\n", name);
 	  }
 
-	  close (fd);
+	  // Maybe it was unplugged.  Try opening again next time.
+	  close (d->fd);
+	  d->fd = -1;
 	  return (-1);
 	}
 
-	close (fd);
-
 #endif
 	return (0);
 
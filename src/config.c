@@ -677,6 +677,178 @@ static char *split (char *string, int rest_of_line)
 
 
 
+/*------------------------------------------------------------------
+ *
+ * Name:	config_fopen
+ *
+ * Purpose:	Open the configuration file.
+ *
+ * Inputs:	fname		- Name from -c command line option or default.
+ *
+ * Outputs:	filepath	- Where it was actually found.
+ *
+ * Returns:	File pointer or NULL if not found.
+ *
+ * Description:	Windows:  File must be in current working directory.
+ *
+ *		Linux: Search current directory then home directory.
+ *
+ *----------------------------------------------------------------*/
+
+static FILE *config_fopen (char *fname, char *filepath, size_t filepath_size)
+{
+	FILE *fp;
+
+	strlcpy(filepath, fname, filepath_size);
+
+	fp = fopen (filepath, "r");
+	
+#ifndef __WIN32__
+	if (fp == NULL && strcmp(fname, "direwolf.conf") == 0) {
+	/* Failed to open the default location.  Try home dir. */
+	  char *p;
+
+	  strlcpy (filepath, "", filepath_size);
+
+	  p = getenv("HOME");
+	  if (p != NULL) {
+	    strlcpy (filepath, p, filepath_size);
+	    strlcat (filepath, "/direwolf.conf", filepath_size);
+	    fp = fopen (filepath, "r");
+	  } 
+	}
+#endif
+	return (fp);
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	config_file_exists
+ *
+ * Purpose:	Check that the configuration file can be read
+ *		before trying to read it again while running.
+ *		config_init would suggest the -c option, which
+ *		doesn't make sense at that point.
+ *
+ * Inputs:	fname		- Name from -c command line option or default.
+ *
+ * Returns:	1 if it could be opened.
+ *
+ *----------------------------------------------------------------*/
+
+int config_file_exists (char *fname)
+{
+	char filepath[128];
+	FILE *fp;
+
+	fp = config_fopen (fname, filepath, sizeof(filepath));
+	if (fp == NULL) {
+	  return (0);
+	}
+	fclose (fp);
+	return (1);
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	misc_config_free
+ *
+ * Purpose:	Release everything config_init allocated inside
+ *		a misc. configuration.
+ *
+ * Inputs:	p		- Filled in by config_init.
+ *
+ * Description:	The structure itself is not freed.
+ *		Used when the configuration file is read again
+ *		and an earlier copy is no longer needed.
+ *
+ *----------------------------------------------------------------*/
+
+void misc_config_free (struct misc_config_s *p)
+{
+	int j;
+
+	for (j = 0; j < p->num_beacons; j++) {
+	  struct beacon_s *b = &(p->beacon[j]);
+
+	  free (b->source);
+	  free (b->dest);
+	  free (b->via);
+	  free (b->custom_info);
+	  free (b->custom_infocmd);
+	  free (b->comment);
+	  free (b->commentcmd);
+	}
+
+	for (j = 0; j < p->v20_count; j++) {
+	  free (p->v20_addrs[j]);
+	}
+	free (p->v20_addrs);
+
+	for (j = 0; j < p->noxid_count; j++) {
+	  free (p->noxid_addrs[j]);
+	}
+	free (p->noxid_addrs);
+
+	memset (p, 0, sizeof(struct misc_config_s));
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	tt_config_free
+ *
+ * Purpose:	Release everything config_init allocated inside
+ *		an APRStt configuration.
+ *
+ * Inputs:	p		- Filled in by config_init.
+ *
+ * Description:	The location and macro list, and the macro definitions.
+ *		The structure itself is not freed.
+ *
+ *----------------------------------------------------------------*/
+
+void tt_config_free (struct tt_config_s *p)
+{
+	int j;
+
+	if (p->ttloc_ptr != NULL) {
+	  for (j = 0; j < p->ttloc_len; j++) {
+	    if (p->ttloc_ptr[j].type == TTLOC_MACRO) {
+	      free (p->ttloc_ptr[j].macro.definition);
+	    }
+	  }
+	  free (p->ttloc_ptr);
+	}
+
+	memset (p, 0, sizeof(struct tt_config_s));
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	igate_config_free
+ *
+ * Purpose:	Release everything config_init allocated inside
+ *		an IGate configuration.
+ *
+ * Inputs:	p		- Filled in by config_init.
+ *
+ * Description:	Only the IGFILTER string, so far.
+ *		The structure itself is not freed.
+ *
+ *----------------------------------------------------------------*/
+
+void igate_config_free (struct igate_config_s *p)
+{
+	free (p->t2_filter);
+
+	memset (p, 0, sizeof(struct igate_config_s));
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        config_init
@@ -697,6 +869,12 @@ static char *split (char *string, int rest_of_line)
  *	
  *		p_misc_config	- Everything else.  This wasn't thought out well.
  *
+ * Returns:	0 for success.
+ *		-1 if the configuration can't be used:  the file can't be
+ *		opened, ADEVICE has no device name, or PTT needs support
+ *		missing from this build.  The caller decides whether to
+ *		quit or keep running with what it had before.
+ *
  * Description:	Apply default values for various parameters then read the 
  *		the configuration file which can override those values.
  *
@@ -718,7 +896,7 @@ static void rtfm()
 	dw_printf ("    additional topics:    https://github.com/wb2osz/direwolf-doc\n");
 }
 
-void config_init (char *fname, struct audio_s *p_audio_config, 
+int config_init (char *fname, struct audio_s *p_audio_config, 
 			struct digi_config_s *p_digi_config,
 			struct cdigi_config_s *p_cdigi_config,
 			struct tt_config_s *p_tt_config,
@@ -746,6 +924,11 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 	p_audio_config->igate_vchannel = -1;		// none.
 
+	for (int ch = 0; ch < MAX_CHANS; ch++) {
+	  p_audio_config->diversity_primary[ch] = -1;
+	}
+	p_audio_config->diversity_window = DEFAULT_DIVERSITY_WINDOW;
+
 	/* First audio device is always available with defaults. */
 	/* Others must be explicitly defined before use. */
 
@@ -811,6 +994,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	  p_audio_config->achan[channel].txdelay = DEFAULT_TXDELAY;				
 	  p_audio_config->achan[channel].txtail = DEFAULT_TXTAIL;				
 	  p_audio_config->achan[channel].fulldup = DEFAULT_FULLDUP;
+	  p_audio_config->achan[channel].maxtxtime = 0;
 	}
 
 	p_audio_config->fx25_auto_enable = AX25_N2_RETRY_DEFAULT / 2;
@@ -909,9 +1093,15 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 	strlcpy (p_misc_config->gpsnmea_port, "", sizeof(p_misc_config->gpsnmea_port));
 	strlcpy (p_misc_config->waypoint_serial_port, "", sizeof(p_misc_config->waypoint_serial_port));
+	p_misc_config->waypoint_serial_rate = 480;
+	p_misc_config->waypoint_serial_hold = 5;
+	p_misc_config->waypoint_udp_rate = 0;
+	p_misc_config->waypoint_udp_hold = 0;
 
 	p_misc_config->log_daily_names = 0;
 	strlcpy (p_misc_config->log_path, "", sizeof(p_misc_config->log_path));
+	strlcpy (p_misc_config->events_path, "", sizeof(p_misc_config->events_path));
+	p_misc_config->events_cbor = 0;
 
 	/* connected mode. */
 
@@ -953,33 +1143,14 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 // TODO: Would be better to have a search list and loop thru it.
 
-        strlcpy(filepath, fname, sizeof(filepath));
-
-        fp = fopen (filepath, "r");
-	
-#ifndef __WIN32__
-	if (fp == NULL && strcmp(fname, "direwolf.conf") == 0) {
-	/* Failed to open the default location.  Try home dir. */
-	  char *p;
-
-
-          strlcpy (filepath, "", sizeof(filepath));
-
-	  p = getenv("HOME");
-	  if (p != NULL) {
-	    strlcpy (filepath, p, sizeof(filepath));
-	    strlcat (filepath, "/direwolf.conf", sizeof(filepath));
-	    fp = fopen (filepath, "r");
-	  } 
-	}
-#endif
+	fp = config_fopen (fname, filepath, sizeof(filepath));
 	if (fp == NULL)	{
 	  // TODO: not exactly right for all situations.
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("ERROR - Could not open config file %s\n", filepath);
 	  dw_printf ("Try using -c command line option for alternate location.\n");
 	  rtfm();
-	  exit(EXIT_FAILURE);
+	  return (-1);
 	}
 	
 	dw_printf ("\nReading config file %s\n", filepath);
@@ -1037,7 +1208,8 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("Config file: Missing name of audio device for ADEVICE command on line %d.\n", line);
 	      rtfm();
-	      exit(EXIT_FAILURE);
+	      fclose (fp);
+	      return (-1);
 	    }
 
 	    p_audio_config->adev[adevice].defined = 1;
@@ -1262,6 +1434,67 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	  }
 
+/*
+ * DIVERSITY chan chan ... [ WINDOW=ms ]	- Combine frames from radios hearing the same frequency.
+ *
+ *	The first channel is the primary.  Frames heard on any of them
+ *	are reported once, as the primary channel.  See diversity.c.
+ */
+
+	  else if (strcasecmp(t, "DIVERSITY") == 0) {
+	    int members[MAX_CHANS];
+	    int num_members = 0;
+	    int ok = 1;
+
+	    while ((t = split(NULL,0)) != NULL) {
+	      if (strncasecmp(t, "WINDOW=", 7) == 0) {
+	        int w = atoi(t+7);
+	        if (w >= 10 && w <= 2000) {
+	          p_audio_config->diversity_window = w;
+	        }
+	        else {
+	          text_color_set(DW_COLOR_ERROR);
+	          dw_printf ("Line %d: DIVERSITY WINDOW must be in range of 10 to 2000 milliseconds.\n", line);
+	        }
+	        continue;
+	      }
+
+	      int n = atoi(t);
+	      if (n < 0 || n >= MAX_CHANS) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Line %d: DIVERSITY channel number must be in range of 0 to %d.\n", line, MAX_CHANS-1);
+	        ok = 0;
+	        break;
+	      }
+	      if (p_audio_config->diversity_primary[n] >= 0) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Line %d: DIVERSITY channel %d is already in another group.\n", line, n);
+	        ok = 0;
+	        break;
+	      }
+	      for (int m = 0; m < num_members; m++) {
+	        if (members[m] == n) {
+	          text_color_set(DW_COLOR_ERROR);
+	          dw_printf ("Line %d: DIVERSITY channel %d is listed more than once.\n", line, n);
+	          ok = 0;
+	        }
+	      }
+	      if ( ! ok) break;
+	      members[num_members++] = n;
+	    }
+
+	    if (ok && num_members < 2) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: DIVERSITY needs at least two channel numbers.\n", line);
+	      ok = 0;
+	    }
+	    if (ok) {
+	      for (int m = 0; m < num_members; m++) {
+	        p_audio_config->diversity_primary[members[m]] = members[0];
+	      }
+	    }
+	  }
+
 /*
  * MYCALL station
  */
@@ -1747,6 +1980,7 @@ void config_init (char *fname, struct audio_s *p_audio_config,
  *
  * xxx  serial-port [-]rts-or-dtr [ [-]rts-or-dtr ]
  * xxx  GPIO  [-]gpio-num
+ * xxx  GPIOD  chip-name  [-]line-num
  * xxx  LPT  [-]bit-num
  * PTT  RIG  model  port [ rate ]
  * PTT  RIG  AUTO  port [ rate ]
@@ -1808,6 +2042,40 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 		p_audio_config->achan[channel].octrl[ot].ptt_invert = 0;
 	      }
 	      p_audio_config->achan[channel].octrl[ot].ptt_method = PTT_METHOD_GPIO;
+#endif
+	    }
+	    else if (strcasecmp(t, "GPIOD") == 0) {
+
+/* GPIO character device case, Linux only. */
+
+#if USE_GPIOD
+	      t = split(NULL,0);
+	      if (t == NULL) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Config file line %d: Missing GPIO chip name for %s.\n", line, otname);
+	        continue;
+	      }
+	      strlcpy (p_audio_config->achan[channel].octrl[ot].out_gpio_name, t, sizeof(p_audio_config->achan[channel].octrl[ot].out_gpio_name));
+
+	      t = split(NULL,0);
+	      if (t == NULL) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Config file line %d: Missing GPIO line number for %s.\n", line, otname);
+	        continue;
+	      }
+
+	      if (*t == '-') {
+	        p_audio_config->achan[channel].octrl[ot].out_gpio_num = atoi(t+1);
+		p_audio_config->achan[channel].octrl[ot].ptt_invert = 1;
+	      }
+	      else {
+	        p_audio_config->achan[channel].octrl[ot].out_gpio_num = atoi(t);
+		p_audio_config->achan[channel].octrl[ot].ptt_invert = 0;
+	      }
+	      p_audio_config->achan[channel].octrl[ot].ptt_method = PTT_METHOD_GPIOD;
+#else
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Config file line %d: %s with GPIOD is only available on Linux with the GPIO character device.\n", line, otname);
 #endif
 	    }
 	    else if (strcasecmp(t, "LPT") == 0) {
@@ -1899,7 +2167,8 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 #if __WIN32__
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("Config file line %d: Windows version of direwolf does not support HAMLIB.\n", line);
-	      exit (EXIT_FAILURE);
+	      fclose (fp);
+	      return (-1);
 #else
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("Config file line %d: %s with RIG is only available when hamlib support is enabled.\n", line, otname);
@@ -1997,7 +2266,8 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      dw_printf ("You must rebuild direwolf with CM108 Audio Adapter GPIO PTT support.\n");
 	      dw_printf ("See Interface Guide for details.\n");
 	      rtfm();
-	      exit (EXIT_FAILURE);
+	      fclose (fp);
+	      return (-1);
 #endif
 	    }
 	    else  {
@@ -2088,7 +2358,8 @@ void config_init (char *fname, struct audio_s *p_audio_config,
  *
  * TXINH - TX holdoff input
  *
- * TXINH GPIO [-]gpio-num (only type supported so far)
+ * TXINH GPIO [-]gpio-num
+ * TXINH GPIOD chip-name [-]line-num
  */
 
 	  else if (strcasecmp(t, "TXINH") == 0) {
@@ -2125,6 +2396,38 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 		p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].invert = 0;
 	      }
 	      p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].method = PTT_METHOD_GPIO;
+#endif
+	    }
+	    else if (strcasecmp(t, "GPIOD") == 0) {
+
+#if USE_GPIOD
+	      t = split(NULL,0);
+	      if (t == NULL) {
+	        text_color_set(DW_COLOR_ERROR);
+		dw_printf ("Config file line %d: Missing GPIO chip name for %s.\n", line, itname);
+		continue;
+	      }
+	      strlcpy (p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].in_gpio_name, t, sizeof(p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].in_gpio_name));
+
+	      t = split(NULL,0);
+	      if (t == NULL) {
+	        text_color_set(DW_COLOR_ERROR);
+		dw_printf ("Config file line %d: Missing GPIO line number for %s.\n", line, itname);
+		continue;
+	      }
+
+	      if (*t == '-') {
+	        p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].in_gpio_num = atoi(t+1);
+		p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].invert = 1;
+	      }
+	      else {
+	        p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].in_gpio_num = atoi(t);
+		p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].invert = 0;
+	      }
+	      p_audio_config->achan[channel].ictrl[ICTYPE_TXINH].method = PTT_METHOD_GPIOD;
+#else
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Config file line %d: %s with GPIOD is only available on Linux with the GPIO character device.\n", line, itname);
 #endif
 	    }
 	  }
@@ -2274,6 +2577,30 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	  }
 
+/*
+ * MAXTXTIME n		- Maximum time for one transmission when bundling frames. n = 10 mS units.
+ *			  Zero means no limit.  A single frame is always sent even if longer.
+ */
+
+	  else if (strcasecmp(t, "MAXTXTIME") == 0) {
+	    int n;
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing time for MAXTXTIME command.\n", line);
+	      continue;
+	    }
+	    n = atoi(t);
+            if (n >= 0 && n <= 6000) {
+	      p_audio_config->achan[channel].maxtxtime = n;
+	    }
+	    else {
+	      p_audio_config->achan[channel].maxtxtime = 0;
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf ("Line %d: Invalid maximum transmit time.  Range is 0 (no limit) to 6000 (60 seconds).\n", line);
+   	    }
+	  }
+
 /*
  * SPEECH  script 
  *
@@ -2405,6 +2732,41 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	  }
 
 
+/*
+ * FX25RX  ON|OFF		- Look for FX.25 in received bits.  Default on.
+ * IL2PRX  ON|OFF		- Look for IL2P in received bits.  Default on.
+ *
+ *				The cost is small but there is no reason
+ *				to pay it for a protocol nobody uses on
+ *				the channel.  HDLC is always decoded.
+ */
+
+	  else if (strcasecmp(t, "FX25RX") == 0 || strcasecmp(t, "IL2PRX") == 0) {
+	    int *pdisable = strcasecmp(t, "FX25RX") == 0 ?
+				&(p_audio_config->achan[channel].fx25_rec_disable) :
+				&(p_audio_config->achan[channel].il2p_rec_disable);
+	    char cmd[8];
+	    strlcpy (cmd, t, sizeof(cmd));
+
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Missing ON or OFF for %s command.\n", line, cmd);
+	      continue;
+	    }
+	    if (strcasecmp(t, "ON") == 0 || strcmp(t, "1") == 0) {
+	      *pdisable = 0;
+	    }
+	    else if (strcasecmp(t, "OFF") == 0 || strcmp(t, "0") == 0) {
+	      *pdisable = 1;
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Line %d: Expected ON or OFF for %s command, not \"%s\".\n", line, cmd, t);
+	    }
+	  }
+
+
 /*
  * ==================== APRS Digipeater parameters ====================
  */
@@ -2486,9 +2848,9 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      dw_printf ("Config file: Missing alias pattern on line %d.\n", line);
 	      continue;
 	    }
-	    e = regcomp (&(p_digi_config->alias[from_chan][to_chan]), t, REG_EXTENDED|REG_NOSUB);
+	    e = digimatch_comp (&(p_digi_config->alias[from_chan][to_chan]), t);
 	    if (e != 0) {
-	      regerror (e, &(p_digi_config->alias[from_chan][to_chan]), message, sizeof(message));
+	      digimatch_error (e, &(p_digi_config->alias[from_chan][to_chan]), message, sizeof(message));
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("Config file: Invalid alias matching pattern on line %d:\n%s\n", 
 							line, message);
@@ -2501,9 +2863,9 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      dw_printf ("Config file: Missing wide pattern on line %d.\n", line);
 	      continue;
 	    }
-	    e = regcomp (&(p_digi_config->wide[from_chan][to_chan]), t, REG_EXTENDED|REG_NOSUB);
+	    e = digimatch_comp (&(p_digi_config->wide[from_chan][to_chan]), t);
 	    if (e != 0) {
-	      regerror (e, &(p_digi_config->wide[from_chan][to_chan]), message, sizeof(message));
+	      digimatch_error (e, &(p_digi_config->wide[from_chan][to_chan]), message, sizeof(message));
 	      text_color_set(DW_COLOR_ERROR);
 	      dw_printf ("Config file: Invalid wide matching pattern on line %d:\n%s\n", 
 							line, message);
@@ -2719,12 +3081,12 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 
 	    t = split(NULL,0);
 	    if (t != NULL) {
-	      e = regcomp (&(p_cdigi_config->alias[from_chan][to_chan]), t, REG_EXTENDED|REG_NOSUB);
+	      e = digimatch_comp (&(p_cdigi_config->alias[from_chan][to_chan]), t);
 	      if (e == 0) {
 	        p_cdigi_config->has_alias[from_chan][to_chan] = 1;
 	      }
 	      else {
-	        regerror (e, &(p_cdigi_config->alias[from_chan][to_chan]), message, sizeof(message));
+	        digimatch_error (e, &(p_cdigi_config->alias[from_chan][to_chan]), message, sizeof(message));
 	        text_color_set(DW_COLOR_ERROR);
 	        dw_printf ("Config file: Invalid alias matching pattern on line %d:\n%s\n",
 							line, message);
@@ -4889,9 +5251,12 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 /*
  * WAYPOINT		- Generate WPL and AIS NMEA sentences for display on map.
  *
- * WAYPOINT  serial-device [ formats ]
- * WAYPOINT  host:udpport [ formats ]
- *		  
+ * WAYPOINT  serial-device [ formats ] [ RATE=bytes-per-sec ] [ HOLD=seconds ]
+ * WAYPOINT  host:udpport [ formats ] [ RATE=bytes-per-sec ] [ HOLD=seconds ]
+ *
+ *	RATE and HOLD apply to the destination on the same line.
+ *	RATE=0 means no limit.  HOLD is the minimum time between
+ *	updates for the same station.  See waypoint.c.
  */
 	  else if (strcasecmp(t, "waypoint") == 0) {
 
@@ -4905,8 +5270,13 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    /* If there is a ':' in the name, split it into hostname:udpportnum. */
 	    /* Otherwise assume it is serial port name. */
 
+	    int *prate = &(p_misc_config->waypoint_serial_rate);
+	    int *phold = &(p_misc_config->waypoint_serial_hold);
+
 	    char *p = strchr (t, ':');
 	    if (p != NULL) {
+	      prate = &(p_misc_config->waypoint_udp_rate);
+	      phold = &(p_misc_config->waypoint_udp_hold);
 	      *p = '\0';
 	      int n = atoi(p+1);
               if (n >= MIN_IP_PORT_NUMBER && n <= MAX_IP_PORT_NUMBER) {
@@ -4925,10 +5295,31 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	      strlcpy (p_misc_config->waypoint_serial_port, t, sizeof(p_misc_config->waypoint_serial_port));
 	    }
 	
-	    /* Anything remaining is the formats to enable. */
+	    /* Anything remaining is the formats to enable and options. */
 
-	    t = split(NULL,1);
-	    if (t != NULL) {
+	    while ((t = split(NULL,0)) != NULL) {
+	      if (strncasecmp(t, "RATE=", 5) == 0) {
+	        int n = atoi(t+5);
+	        if (n >= 0) {
+	          *prate = n;
+	        }
+	        else {
+	          text_color_set(DW_COLOR_ERROR);
+	          dw_printf ("Line %d: Invalid RATE for WAYPOINT.\n", line);
+	        }
+	        continue;
+	      }
+	      if (strncasecmp(t, "HOLD=", 5) == 0) {
+	        int n = atoi(t+5);
+	        if (n >= 0 && n <= 600) {
+	          *phold = n;
+	        }
+	        else {
+	          text_color_set(DW_COLOR_ERROR);
+	          dw_printf ("Line %d: WAYPOINT HOLD must be in range of 0 to 600 seconds.\n", line);
+	        }
+	        continue;
+	      }
 	      for ( ; *t != '\0' ; t++ ) {
 	        switch (toupper(*t)) {
 	          case 'N':
@@ -5008,6 +5399,35 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	    }
 	  }
 
+/*
+ * EVENTS	- Structured event for each frame received or transmitted.
+ *
+ *	EVENTS  path  [ JSON | CBOR ]
+ *
+ *		path is a file name or unix: followed by Unix domain socket name.
+ */
+	  else if (strcasecmp(t, "events") == 0) {
+	    t = split(NULL,0);
+	    if (t == NULL) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Config file: Missing file or socket name for EVENTS on line %d.\n", line);
+	      continue;
+	    }
+	    strlcpy (p_misc_config->events_path, t, sizeof(p_misc_config->events_path));
+	    p_misc_config->events_cbor = 0;
+
+	    t = split(NULL,0);
+	    if (t != NULL) {
+	      if (strcasecmp(t, "CBOR") == 0) {
+	        p_misc_config->events_cbor = 1;
+	      }
+	      else if (strcasecmp(t, "JSON") != 0) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Config file: EVENTS format on line %d should be JSON or CBOR.  Using JSON.\n", line);
+	      }
+	    }
+	  }
+
 /*
  * BEACON channel delay every message
  *
@@ -5501,6 +5921,8 @@ void config_init (char *fname, struct audio_s *p_audio_config,
 	  p_misc_config->maxv22 = p_misc_config->retry / 3;
 	}
 
+	return (0);
+
 } /* end config_init */
 
 
@@ -96,6 +96,14 @@ struct misc_config_s {
 
 	int waypoint_udp_portnum;	/* UDP port. */
 
+	int waypoint_serial_rate;	/* Maximum bytes per second sent to each destination. */
+	int waypoint_udp_rate;		/* 0 for no limit.  Serial port defaults to 480, */
+					/* which is all a 4800 baud port can take. */
+
+	int waypoint_serial_hold;	/* Minimum seconds between updates for the same station. */
+	int waypoint_udp_hold;		/* Anything newer in that time replaces what was */
+					/* waiting, rather than adding another one. */
+
 	int waypoint_formats;	/* Which sentence formats should be generated? */
 
 #define WPL_FORMAT_NMEA_GENERIC 0x01		/* N	$GPWPL */
@@ -109,6 +117,10 @@ struct misc_config_s {
 
 	char log_path[80];	/* Either directory or full file name depending on above. */
 
+	char events_path[80];	/* Structured event stream.  File name or unix:socket.  Empty to disable. */
+
+	int events_cbor;	/* True for CBOR rather than JSON. */
+
 	int dns_sd_enabled;	/* DNS Service Discovery announcement enabled. */
 	char dns_sd_name[64];	/* Name announced on dns-sd; defaults to "Dire Wolf on <hostname>" */
 
@@ -246,13 +258,21 @@ struct misc_config_s {
 
 
 
-extern void config_init (char *fname, struct audio_s *p_modem, 
+extern int config_init (char *fname, struct audio_s *p_modem, 
 			struct digi_config_s *digi_config,
 			struct cdigi_config_s *cdigi_config,
 			struct tt_config_s *p_tt_config,
 			struct igate_config_s *p_igate_config,
 			struct misc_config_s *misc_config);
 
+extern int config_file_exists (char *fname);
+
+extern void misc_config_free (struct misc_config_s *p);
+
+extern void tt_config_free (struct tt_config_s *p);
+
+extern void igate_config_free (struct igate_config_s *p);
+
 
 
 #endif /* CONFIG_H */
@@ -0,0 +1,179 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	digimatch.c
+ *
+ * Purpose:	Match digipeater addresses against the alias and
+ *		WIDEn-N patterns from the configuration file.
+ *
+ * Description:	Originally digipeat_match called regexec for each
+ *		pattern, for every packet, for every from/to channel pair.
+ *		On a busy digipeater with several ports, that adds up.
+ *
+ *		The patterns are general regular expressions so we
+ *		continue to use regcomp / regexec for the actual matching.
+ *		However, the result depends only on the address, and a
+ *		digipeater sees the same few (WIDE1-1, WIDE2-1, WIDE2-2,
+ *		and a handful of callsigns) over and over again.
+ *
+ *		The address, up to 9 characters, is packed into 63 bits.
+ *		The result is remembered in a small direct mapped table.
+ *		A collision simply replaces the older entry so the
+ *		worst case is the same as before.
+ *
+ *		This is used only from the receive queue processing
+ *		thread so no locking is needed.
+ *
+ *---------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "textcolor.h"
+#include "digimatch.h"
+
+
+#define MAX_PACKED_LEN 9		// 7 bits each in 63 bits.
+#define RESULT_BIT (1ULL << 63)
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	digimatch_comp
+ *
+ * Purpose:	Compile a pattern from the configuration file.
+ *
+ * Inputs:	m		- Matcher to fill in.
+ *		pattern		- Regular expression.
+ *
+ * Returns:	0 for success or regcomp error code.
+ *		Use digimatch_error to get readable message.
+ *
+ *---------------------------------------------------------------*/
+
+int digimatch_comp (digimatch_t *m, const char *pattern)
+{
+	int e;
+
+	m->pattern = NULL;
+	m->memo = NULL;
+	e = regcomp (&(m->re), pattern, REG_EXTENDED|REG_NOSUB);
+	if (e == 0) {
+	  m->pattern = strdup (pattern);
+	}
+	return (e);
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	digimatch_free
+ *
+ * Purpose:	Release resources after successful digimatch_comp.
+ *		Does nothing for a matcher that was never set up.
+ *
+ *---------------------------------------------------------------*/
+
+void digimatch_free (digimatch_t *m)
+{
+	if (m->pattern != NULL) {
+	  regfree (&(m->re));
+	  free (m->pattern);
+	  m->pattern = NULL;
+	}
+	if (m->memo != NULL) {
+	  free (m->memo);
+	  m->memo = NULL;
+	}
+}
+
+
+void digimatch_error (int err, digimatch_t *m, char *message, size_t message_size)
+{
+	regerror (err, &(m->re), message, message_size);
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	digimatch
+ *
+ * Purpose:	Does the address match the pattern?
+ *
+ * Inputs:	m		- Matcher from digimatch_comp.
+ *		addr		- Address with SSID, e.g. WIDE2-1.
+ *
+ * Returns:	1 for match, 0 for no match or error.
+ *
+ *---------------------------------------------------------------*/
+
+int digimatch (digimatch_t *m, const char *addr)
+{
+	uint64_t key = 0;
+	int n;
+	int err;
+	uint64_t *slot = NULL;
+
+	n = strlen(addr);
+
+	if (n >= 1 && n <= MAX_PACKED_LEN) {
+	  int i;
+
+	  for (i = 0; i < n; i++) {
+	    key = (key << 7) | (addr[i] & 0x7f);
+	  }
+
+	  if (m->memo == NULL) {
+	    m->memo = calloc (DIGIMATCH_MEMO_SIZE, sizeof(uint64_t));
+	  }
+	  if (m->memo != NULL) {
+	    slot = &(m->memo[((key * 0x9E3779B97F4A7C15ULL) >> 32) & (DIGIMATCH_MEMO_SIZE - 1)]);
+
+	    if ((*slot & ~RESULT_BIT) == key) {
+	      return ((*slot & RESULT_BIT) != 0);
+	    }
+	  }
+	}
+
+	err = regexec (&(m->re), addr, 0, NULL, 0);
+
+	if (err != 0 && err != REG_NOMATCH) {
+	  char err_msg[100];
+
+	  regerror (err, &(m->re), err_msg, sizeof(err_msg));
+	  text_color_set (DW_COLOR_ERROR);
+	  dw_printf ("%s\n", err_msg);
+	  return (0);		// Don't remember errors.
+	}
+
+	if (slot != NULL) {
+	  *slot = key | (err == 0 ? RESULT_BIT : 0);
+	}
+
+	return (err == 0);
+
+} /* end digimatch */
+
+/* end digimatch.c */
@@ -0,0 +1,49 @@
+
+/* digimatch.h */
+
+#ifndef DIGIMATCH_H
+#define DIGIMATCH_H 1
+
+#include <stdint.h>
+
+#include "regex.h"
+
+
+/*
+ * Digipeater alias / WIDEn-N matching.
+ *
+ * The configuration file supplies a regular expression.
+ * The result depends only on the address so we remember
+ * the answer, keyed by callsign and SSID, for addresses
+ * already seen.  After the first few packets, a digipeater
+ * decision is a table lookup rather than a regexec.
+ */
+
+#define DIGIMATCH_MEMO_SIZE 64		// Must be power of 2.
+
+typedef struct digimatch_s {
+
+	char *pattern;			// Original pattern from configuration file.
+					// Kept so a new configuration can be compared.
+					// NULL if not set or regcomp failed.
+
+	regex_t re;			// Compiled pattern from configuration file.
+
+	uint64_t *memo;			// Previous results.  Allocated on first use.
+					// Each is packed address with result in MSB.
+					// 0 for unused.
+} digimatch_t;
+
+
+int digimatch_comp (digimatch_t *m, const char *pattern);
+
+void digimatch_error (int err, digimatch_t *m, char *message, size_t message_size);
+
+int digimatch (digimatch_t *m, const char *addr);
+
+void digimatch_free (digimatch_t *m);
+
+
+#endif
+
+/* end digimatch.h */
@@ -62,7 +62,7 @@
 #include <assert.h>
 #include <stdio.h>
 #include <ctype.h>	/* for isdigit, isupper */
-#include "regex.h"
+#include "digimatch.h"
 #include <unistd.h>
 
 #include "ax25_pad.h"
@@ -74,7 +74,7 @@
 
 
 static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, char *mycall_xmit, 
-				regex_t *uidigi, regex_t *uitrace, int to_chan, enum preempt_e preempt, char *atgp, char *type_filter);
+				digimatch_t *uidigi, digimatch_t *uitrace, int to_chan, enum preempt_e preempt, char *atgp, char *type_filter);
 
 
 /*
@@ -125,6 +125,31 @@ void digipeater_init (struct audio_s *p_audio_config, struct digi_config_s *p_di
 
 
 
+/*------------------------------------------------------------------------------
+ *
+ * Name:	digipeater_reconfig
+ * 
+ * Purpose:	Switch to new rules after the configuration file has been read again.
+ *
+ * Inputs:	p_digi_config	- New digipeater configuration details.
+ *		
+ * Description:	This must be called from the same thread that calls digipeater()
+ *		so a packet never sees a mixture of old and new rules.
+ *		Recently transmitted packets are remembered unless the 
+ *		duplicate detection time was changed.
+ *
+ *------------------------------------------------------------------------------*/
+
+void digipeater_reconfig (struct digi_config_s *p_digi_config) 
+{
+	if (p_digi_config->dedupe_time != save_digi_config_p->dedupe_time) {
+	  dedupe_init (p_digi_config->dedupe_time);
+	}
+	save_digi_config_p = p_digi_config;
+}
+
+
+
 
 /*------------------------------------------------------------------------------
  *
@@ -295,14 +320,12 @@ void digipeater (int from_chan, packet_t pp)
 
 
 static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, char *mycall_xmit, 
-				regex_t *alias, regex_t *wide, int to_chan, enum preempt_e preempt, char *atgp, char *filter_str)
+				digimatch_t *alias, digimatch_t *wide, int to_chan, enum preempt_e preempt, char *atgp, char *filter_str)
 {
-	char source[AX25_MAX_ADDR_LEN];
+	uint64_t mykey;
 	int ssid;
 	int r;
 	char repeater[AX25_MAX_ADDR_LEN];
-	int err;
-	char err_msg[100];
 
 /*
  * First check if filtering has been configured.
@@ -348,6 +371,10 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	ax25_get_addr_with_ssid(pp, r, repeater);
 	ssid = ax25_get_ssid(pp, r);
 
+	// Compare addresses to my call as numbers rather than strings.
+
+	mykey = ax25_addr_key (mycall_rec);
+
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
 	dw_printf ("First unused digipeater is %s, ssid=%d\n", repeater, ssid);
@@ -364,7 +391,7 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
  * correctly.  I would expect it only for testing purposes.
  */
 	
-	if (strcmp(repeater, mycall_rec) == 0) {
+	if (ax25_get_addr_key(pp, r) == mykey) {
 	  packet_t result;
 
 	  result = ax25_dup (pp);
@@ -382,8 +409,7 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
  * Alternatively we might feed everything transmitted into
  * dedupe_remember rather than only frames out of digipeater.
  */
-	ax25_get_addr_with_ssid(pp, AX25_SOURCE, source);
-	if (strcmp(source, mycall_rec) == 0) {
+	if (ax25_get_addr_key(pp, AX25_SOURCE) == mykey) {
 	  return (NULL);
 	}
 
@@ -421,8 +447,7 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
  * My call should be an implied member of this set.
  * In this implementation, we already caught it further up.
  */
-	err = regexec(alias,repeater,0,NULL,0);
-	if (err == 0) {
+	if (digimatch(alias, repeater)) {
 	  packet_t result;
 
 	  result = ax25_dup (pp);
@@ -432,11 +457,6 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	  ax25_set_h (result, r);
 	  return (result);
 	}
-	else if (err != REG_NOMATCH) {
-	  regerror(err, alias, err_msg, sizeof(err_msg));
-	  text_color_set (DW_COLOR_ERROR);
-	  dw_printf ("%s\n", err_msg);
-	}
 
 /* 
  * If preemptive digipeating is enabled, try matching my call 
@@ -458,8 +478,8 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	    //text_color_set (DW_COLOR_DEBUG);
 	    //dw_printf ("test match %d %s\n", r2, repeater2);
 
-	    if (strcmp(repeater2, mycall_rec) == 0 ||
-	        regexec(alias,repeater2,0,NULL,0) == 0) {
+	    if (ax25_get_addr_key(pp, r2) == mykey ||
+	        digimatch(alias, repeater2)) {
 	      packet_t result;
 
 	      result = ax25_dup (pp);
@@ -526,8 +546,7 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
  * For the wide pattern, we check the ssid and decrement it.
  */
 
-	err = regexec(wide,repeater,0,NULL,0);
-	if (err == 0) {
+	if (digimatch(wide, repeater)) {
 
 // Special hack added for ATGP to behave like some combination of options in some old TNC
 // so the via path does not continue to grow and exceed the 8 available positions.
@@ -599,11 +618,6 @@ static packet_t digipeat_match (int from_chan, packet_t pp, char *mycall_rec, ch
 	    return (result);
 	  }
 	} 
-	else if (err != REG_NOMATCH) {
-	  regerror(err, wide, err_msg, sizeof(err_msg));
-	  text_color_set (DW_COLOR_ERROR);
-	  dw_printf ("%s\n", err_msg);
-	}
 
 
 /*
@@ -672,9 +686,9 @@ void digi_regen (int from_chan, packet_t pp)
 
 static char mycall[12];
 
-static regex_t alias_re;     
+static digimatch_t alias_re;     
 
-static regex_t wide_re;   
+static digimatch_t wide_re;   
 
 static int failed;
 
@@ -788,17 +802,17 @@ int main (int argc, char *argv[])
 /* 
  * Compile the patterns. 
  */
-	e = regcomp (&alias_re, "^WIDE[4-7]-[1-7]|CITYD$", REG_EXTENDED|REG_NOSUB);
+	e = digimatch_comp (&alias_re, "^WIDE[4-7]-[1-7]|CITYD$");
 	if (e != 0) {
-	  regerror (e, &alias_re, message, sizeof(message));
+	  digimatch_error (e, &alias_re, message, sizeof(message));
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("\n%s\n\n", message);
 	  exit (1);
 	}
 
-	e = regcomp (&wide_re, "^WIDE[1-7]-[1-7]$|^TRACE[1-7]-[1-7]$|^MA[1-7]-[1-7]$|^HOP[1-7]-[1-7]$", REG_EXTENDED|REG_NOSUB);
+	e = digimatch_comp (&wide_re, "^WIDE[1-7]-[1-7]$|^TRACE[1-7]-[1-7]$|^MA[1-7]-[1-7]$|^HOP[1-7]-[1-7]$");
 	if (e != 0) {
-	  regerror (e, &wide_re, message, sizeof(message));
+	  digimatch_error (e, &wide_re, message, sizeof(message));
 	  text_color_set(DW_COLOR_ERROR);
 	  dw_printf ("\n%s\n\n", message);
 	  exit (1);
@@ -2,7 +2,7 @@
 #ifndef DIGIPEATER_H
 #define DIGIPEATER_H 1
 
-#include "regex.h"
+#include "digimatch.h"
 
 #include "direwolf.h"		/* for MAX_CHANS */
 #include "ax25_pad.h"		/* for packet_t */
@@ -29,9 +29,9 @@ struct digi_config_s {
  * Rules for each of the [from_chan][to_chan] combinations.
  */
 
-	regex_t	alias[MAX_CHANS][MAX_CHANS];
+	digimatch_t alias[MAX_CHANS][MAX_CHANS];
 
-	regex_t	wide[MAX_CHANS][MAX_CHANS];
+	digimatch_t wide[MAX_CHANS][MAX_CHANS];
 
 	int	enabled[MAX_CHANS][MAX_CHANS];
 
@@ -57,6 +57,12 @@ struct digi_config_s {
 
 extern void digipeater_init (struct audio_s *p_audio_config, struct digi_config_s *p_digi_config);
 
+/*
+ * Call after configuration file has been read again.
+ */
+
+extern void digipeater_reconfig (struct digi_config_s *p_digi_config);
+
 /*
  * Call this for each packet received.
  * Suitable packets will be queued for transmission.
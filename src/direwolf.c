@@ -97,6 +97,8 @@
 #include "decode_aprs.h"
 #include "encode_aprs.h"
 #include "textcolor.h"
+#include "textasync.h"
+#include "evstream.h"
 #include "server.h"
 #include "kiss.h"
 #include "kissnet.h"
@@ -129,6 +131,8 @@
 #include "dwsock.h"
 #include "dns_sd_dw.h"
 #include "dlq.h"		// for fec_type_t definition.
+#include "reload.h"
+#include "tablecache.h"
 
 
 //static int idx_decoded = 0;
@@ -137,6 +141,7 @@
 static BOOL cleanup_win (int);
 #else
 static void cleanup_linux (int);
+static void cleanup_signal_init (void);
 #endif
 
 static void usage ();
@@ -209,6 +214,7 @@ int main (int argc, char *argv[])
 	char T_opt_timestamp[40];
 	
 	int t_opt = 1;		/* Text color option. */				
+	enum text_async_e O_opt = TEXT_ASYNC_WAIT;	/* Console output: asynchronous, wait if behind. */
 	int a_opt = 0;		/* "-a n" interval, in seconds, for audio statistics report.  0 for none. */
 	int g_opt = 0;		/* G3RUH mode, ignoring default for speed. */				
 	int j_opt = 0;		/* 2400 bps PSK compatible with direwolf <= 1.5 */
@@ -329,7 +335,8 @@ int main (int argc, char *argv[])
 	SetConsoleCtrlHandler ((PHANDLER_ROUTINE)cleanup_win, TRUE);
 #else
 	setlinebuf (stdout);
-	signal (SIGINT, cleanup_linux);
+	reload_signal_init ();		/* Before any threads are created, */
+	cleanup_signal_init ();		/* including the one made here. */
 #endif
 
 
@@ -421,7 +428,7 @@ int main (int argc, char *argv[])
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "hP:B:gjJD:U:c:px:r:b:n:d:q:t:ul:L:Sa:E:T:e:X:AI:i:",
+          c = getopt_long(argc, argv, "hP:B:gjJD:U:c:px:r:b:n:d:q:t:ul:L:Sa:E:T:e:X:AI:i:O:",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -659,6 +666,19 @@ int main (int argc, char *argv[])
 	  case 't':				/* Was handled earlier. */
 	    break;
 
+	  case 'O':				/* Console output. */
+
+	    switch (optarg[0]) {
+	      case 'a':  O_opt = TEXT_ASYNC_DROP; break;
+	      case 'w':  O_opt = TEXT_ASYNC_WAIT; break;
+	      case 's':  O_opt = TEXT_ASYNC_OFF; break;
+	      default:
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Invalid console output option \"%s\".  Expecting a, w, or s.\n", optarg);
+	        usage ();
+	    }
+	    break;
+
 
 	  case 'u':				/* Print UTF-8 test and exit. */
 
@@ -760,6 +780,12 @@ int main (int argc, char *argv[])
 
 	}
 
+/*
+ * Console output from a separate thread so decoding never waits for it.
+ * Must be before any other threads are created.
+ */
+	text_async_init (O_opt);
+
 /*
  * Get all types of configuration settings from configuration file.
  *
@@ -774,7 +800,9 @@ int main (int argc, char *argv[])
 
 	(void)dwsock_init();
 
-	config_init (config_file, &audio_config, &digi_config, &cdigi_config, &tt_config, &igate_config, &misc_config);
+	if (config_init (config_file, &audio_config, &digi_config, &cdigi_config, &tt_config, &igate_config, &misc_config) != 0) {
+	  exit (EXIT_FAILURE);
+	}
 
 	if (r_opt != 0) {
 	  audio_config.adev[0].samples_per_sec = r_opt;
@@ -994,8 +1022,11 @@ int main (int argc, char *argv[])
 
 /*
  * Initialize the demodulator(s) and layer 2 decoder (HDLC, IL2P).
+ * Filters generated last time are saved in a file to speed up startup.
  */
+	tablecache_open (NULL);
 	multi_modem_init (&audio_config);
+	tablecache_close ();
 	fx25_init (d_x_opt);
 	il2p_init (d_2_opt);
 
@@ -1098,7 +1129,10 @@ int main (int argc, char *argv[])
 
 /*
  * Initialize the digipeater and IGate functions.
+ * SIGHUP reads the configuration file again and updates these.
  */
+	reload_init (config_file, &audio_config, &digi_config, &cdigi_config, &igate_config, &misc_config, d_f_opt);
+
 	digipeater_init (&audio_config, &digi_config);
 	igate_init (&audio_config, &igate_config, &digi_config, d_i_opt);
 	cdigipeater_init (&audio_config, &cdigi_config);
@@ -1137,6 +1171,7 @@ int main (int argc, char *argv[])
  */
 
 	log_init(misc_config.log_daily_names, misc_config.log_path);
+	evstream_init (misc_config.events_path, misc_config.events_cbor ? EVSTREAM_CBOR : EVSTREAM_JSON);
 	mheard_init (d_m_opt);
 	beacon_init (&audio_config, &misc_config, &igate_config);
 
@@ -1317,7 +1352,13 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 
 	if (strlen(audio_config.timestamp_format) > 0) {
 	  char tstmp[100];
-	  timestamp_user_format (tstmp, sizeof(tstmp), audio_config.timestamp_format);
+	  // When it was heard, not when we got around to printing it.
+	  if (ax25_get_rx_time(pp) > 0) {
+	    timestamp_user_format_time (tstmp, sizeof(tstmp), audio_config.timestamp_format, ax25_get_rx_time(pp));
+	  }
+	  else {
+	    timestamp_user_format (tstmp, sizeof(tstmp), audio_config.timestamp_format);
+	  }
 	  strlcpy (ts, " ", sizeof(ts));	// space after channel.
 	  strlcat (ts, tstmp, sizeof(ts));
 	}
@@ -1462,6 +1503,10 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 
 	  log_write (chan, &A, pp, alevel, retries);
 
+	  // Structured event for other applications.
+
+	  evstream_rec (chan, subchan, slice, pp, alevel, fec_type, retries, spectrum, &A);
+
 	  // temp experiment.
 	  //log_rr_bits (&A, pp);
 
@@ -1510,6 +1555,9 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 		A.g_comment);
 	  }
 	}
+	else {
+	  evstream_rec (chan, subchan, slice, pp, alevel, fec_type, retries, spectrum, NULL);
+	}
 
 
 /* Send to another application if connected. */
@@ -1522,6 +1570,18 @@ void app_process_rec_packet (int chan, int subchan, int slice, packet_t pp, alev
 	flen = ax25_pack(pp, fbuf);
 
 	server_send_rec_packet (chan, pp, fbuf, flen);					// AGW net protocol
+
+	// Capture time goes, just ahead of the frame, only to KISS clients which
+	// asked for it with "TIMESTAMP:ON".  See kiss_set_hardware.
+
+	if (ax25_get_rx_time(pp) > 0) {
+	  char rxtime[40];
+	  snprintf (rxtime, sizeof(rxtime), "RXTIME:%.6f", ax25_get_rx_time(pp));
+	  kissnet_send_rec_packet (chan, KISS_CMD_RX_TIME, (unsigned char *)rxtime, strlen(rxtime), NULL, -1);
+	  kissserial_send_rec_packet (chan, KISS_CMD_RX_TIME, (unsigned char *)rxtime, strlen(rxtime), NULL, -1);
+	  kisspt_send_rec_packet (chan, KISS_CMD_RX_TIME, (unsigned char *)rxtime, strlen(rxtime), NULL, -1);
+	}
+
 	kissnet_send_rec_packet (chan, KISS_CMD_DATA_FRAME, fbuf, flen, NULL, -1);	// KISS TCP
 	kissserial_send_rec_packet (chan, KISS_CMD_DATA_FRAME, fbuf, flen, NULL, -1);	// KISS serial port
 	kisspt_send_rec_packet (chan, KISS_CMD_DATA_FRAME, fbuf, flen, NULL, -1);	// KISS pseudo terminal
@@ -1628,7 +1688,9 @@ static BOOL cleanup_win (int ctrltype)
 	if (ctrltype == CTRL_C_EVENT || ctrltype == CTRL_CLOSE_EVENT) {
 	  text_color_set(DW_COLOR_INFO);
 	  dw_printf ("\nQRT\n");
+	  xmit_print_stats ();
 	  log_term ();
+	  evstream_term ();
 	  ptt_term ();
 	  waypoint_term ();
 	  dwgps_term ();
@@ -1645,13 +1707,58 @@ static void cleanup_linux (int x)
 {
 	text_color_set(DW_COLOR_INFO);
 	dw_printf ("\nQRT\n");
+	xmit_print_stats ();
 	log_term ();
+	evstream_term ();
 	ptt_term ();
 	dwgps_term ();
 	SLEEP_SEC(1);
 	exit(0);
 }
 
+
+/*
+ * Ctrl-C (SIGINT) and kill (SIGTERM) are taken by a thread waiting for
+ * them rather than a signal handler.  Cleaning up prints, takes locks,
+ * and closes things.  In a handler, that could deadlock with whatever
+ * thread was interrupted while holding the same lock.
+ * As for SIGHUP in reload.c, the signals must be blocked before any
+ * other threads are created so this is the only one that gets them.
+ */
+
+static void * cleanup_thread (void *arg)
+{
+	sigset_t set;
+	int sig = 0;
+
+	sigemptyset (&set);
+	sigaddset (&set, SIGINT);
+	sigaddset (&set, SIGTERM);
+
+	while (sigwait (&set, &sig) != 0) {
+	  ;
+	}
+	cleanup_linux (sig);
+	return (NULL);
+}
+
+static void cleanup_signal_init (void)
+{
+	sigset_t set;
+	pthread_t tid;
+
+	sigemptyset (&set);
+	sigaddset (&set, SIGINT);
+	sigaddset (&set, SIGTERM);
+	pthread_sigmask (SIG_BLOCK, &set, NULL);
+
+	if (pthread_create (&tid, NULL, cleanup_thread, NULL) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create thread for Ctrl-C");
+	  pthread_sigmask (SIG_UNBLOCK, &set, NULL);	// Just terminate without cleanup.
+	}
+}
+
 #endif
 
 
@@ -1712,6 +1819,10 @@ static void usage (char **argv)
 	dw_printf ("       x             x = Silence FX.25 information.\n");
 	dw_printf ("    -t n           Text colors.  0=disabled. 1=default.  2,3,4,... alternatives.\n");
 	dw_printf ("                     Use 9 to test compatibility with your terminal.\n");
+	dw_printf ("    -O x           Console output:\n");
+	dw_printf ("       a             a = From separate thread.  Discard lines if console can't keep up.\n");
+	dw_printf ("       w             w = From separate thread.  Wait if console can't keep up.  (default)\n");
+	dw_printf ("       s             s = Synchronous, as in earlier versions.\n");
 	dw_printf ("    -a n           Audio statistics interval in seconds.  0 to disable.\n");
 #if __WIN32__
 #else
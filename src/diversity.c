@@ -0,0 +1,313 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      diversity.c
+ *
+ * Purpose:   	Combine frames heard by more than one radio channel.
+ *
+ * Description:	multi_modem.c picks the best copy of a frame when several
+ *		demodulators and slicers, on the same channel, decode it.
+ *		Two radios listening to the same frequency, perhaps with
+ *		different antennas or at different sites, are normally
+ *		separate channels so everything heard by both would be
+ *		printed, digipeated, and IGated twice.
+ *
+ *		The DIVERSITY configuration command groups such channels.
+ *
+ *			DIVERSITY 0 2 [ WINDOW=ms ]
+ *
+ *		The first channel listed is the primary.  A frame received
+ *		on any member is held here for the window time.  If the same
+ *		frame shows up on another member during that time, only the
+ *		better copy is kept.  When the window ends, the winner is
+ *		passed along as though it were heard on the primary channel.
+ *
+ *		Why not do this in multi_modem.c?  Channels on different
+ *		audio devices are serviced by different threads and their
+ *		sample clocks are not related so there is no common sample
+ *		count to line up the candidates.  Instead, we do it in the
+ *		single thread that takes frames from the receive queue,
+ *		using elapsed time.  No locking is needed because only that
+ *		thread calls the functions here.
+ *
+ *---------------------------------------------------------------*/
+
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+
+#include "ax25_pad.h"
+#include "hdlc_rec2.h"		/* for RETRY_MAX */
+#include "textcolor.h"
+#include "dtime_now.h"
+#include "dlq.h"
+#include "audio.h"
+#include "diversity.h"
+
+
+static struct audio_s *save_audio_config_p = NULL;
+
+static int any_groups = 0;	/* Skip everything when no DIVERSITY command. */
+
+
+/*
+ * Frames waiting for the window to close.
+ * They are in order of arrival, which is also the order of deadlines
+ * because all groups use the same window.
+ */
+
+#define MAX_PENDING 32
+
+static struct pending_s {
+	dlq_item_t *pitem;
+	double deadline;		/* dtime_now() value when it can be released. */
+	unsigned short crc;		/* For quick comparison.  */
+	int flen;			/* Packed frame for final comparison. */
+	unsigned char fbuf[AX25_MAX_PACKET_LEN];
+	int score;
+} pending[MAX_PENDING];
+
+static int num_pending = 0;
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        diversity_init
+ *
+ * Purpose:     Check the diversity groups from the configuration file.
+ *
+ * Inputs:	pa	- Audio configuration.  We use
+ *			  diversity_primary[] and diversity_window.
+ *
+ * Description:	Only channels with a modem can be combined.  Anything else
+ *		is dropped from its group with a warning.
+ *
+ *--------------------------------------------------------------------*/
+
+void diversity_init (struct audio_s *pa)
+{
+	int ch;
+
+	save_audio_config_p = pa;
+	num_pending = 0;
+	any_groups = 0;
+
+	for (ch = 0; ch < MAX_CHANS; ch++) {
+	  int p = pa->diversity_primary[ch];
+
+	  if (p < 0) continue;
+
+	  if (pa->chan_medium[ch] != MEDIUM_RADIO || pa->chan_medium[p] != MEDIUM_RADIO) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("DIVERSITY: Channel %d is not a radio channel.  It will not be combined.\n", pa->chan_medium[ch] != MEDIUM_RADIO ? ch : p);
+	    pa->diversity_primary[ch] = -1;
+	    continue;
+	  }
+	  if (p != ch) {
+	    any_groups = 1;
+	  }
+	}
+
+	if (any_groups) {
+	  for (ch = 0; ch < MAX_CHANS; ch++) {
+	    if (pa->diversity_primary[ch] == ch) {
+	      int m;
+	      text_color_set(DW_COLOR_INFO);
+	      dw_printf ("Diversity receive on channel %d using channels", ch);
+	      for (m = 0; m < MAX_CHANS; m++) {
+	        if (pa->diversity_primary[m] == ch) {
+	          dw_printf (" %d", m);
+	        }
+	      }
+	      dw_printf (", %d ms window.\n", pa->diversity_window);
+	    }
+	  }
+	}
+
+} /* end diversity_init */
+
+
+
+/*
+ * Score for a received frame.  This follows pick_best_candidate in
+ * multi_modem.c so a frame that needed no fixing up beats one that did.
+ * The number of decoders, on that channel, that got something is added
+ * as a tie breaker.  It's a rough indication of signal quality.
+ */
+
+static int frame_score (dlq_item_t *pitem)
+{
+	int score;
+	char *p;
+
+	if (pitem->fec_type != fec_type_none) {
+	  score = 9000 - 100 * (int)(pitem->retries);
+	}
+	else {
+	  score = RETRY_MAX * 1000 - ((int)(pitem->retries) * 1000) + 1;
+	}
+
+	for (p = pitem->spectrum; *p != '\0'; p++) {
+	  if (*p != '_') score++;
+	}
+	return (score);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        diversity_hold
+ *
+ * Purpose:     Take a received frame if its channel is in a diversity group.
+ *
+ * Inputs:	pitem	- Item just removed from the receive queue.
+ *
+ * Returns:	1 if we now own the item.  Caller must not process or delete it.
+ *		0 if the caller should carry on as usual.
+ *
+ * Description:	If the same frame, from another member of the group, is
+ *		already waiting, keep the better one and discard the other.
+ *		Otherwise start a new window.
+ *
+ *--------------------------------------------------------------------*/
+
+int diversity_hold (dlq_item_t *pitem)
+{
+	int group;
+	int n;
+	unsigned short crc;
+	unsigned char fbuf[AX25_MAX_PACKET_LEN];
+	int flen;
+	int score;
+
+	if ( ! any_groups) return (0);
+	if (pitem->type != DLQ_REC_FRAME) return (0);
+	if (pitem->chan < 0 || pitem->chan >= MAX_CHANS) return (0);
+
+	group = save_audio_config_p->diversity_primary[pitem->chan];
+	if (group < 0) return (0);
+
+	crc = ax25_m_m_crc (pitem->pp);
+	flen = ax25_pack (pitem->pp, fbuf);
+	score = frame_score (pitem);
+
+	for (n = 0; n < num_pending; n++) {
+	  struct pending_s *q = &(pending[n]);
+
+	  if (save_audio_config_p->diversity_primary[q->pitem->chan] == group &&
+			q->pitem->chan != pitem->chan &&
+			q->crc == crc &&
+			q->flen == flen &&
+			memcmp(q->fbuf, fbuf, flen) == 0) {
+
+	    if (score > q->score) {
+#if DEBUG
+	      text_color_set(DW_COLOR_DEBUG);
+	      dw_printf ("Diversity: channel %d copy replaces channel %d.\n", pitem->chan, q->pitem->chan);
+#endif
+	      dlq_delete (q->pitem);
+	      q->pitem = pitem;
+	      q->score = score;
+	    }
+	    else {
+	      dlq_delete (pitem);
+	    }
+	    return (1);
+	  }
+	}
+
+	if (num_pending >= MAX_PENDING) {
+	  // Should not happen unless the window is unreasonably long.
+	  // Pass it along rather than lose it.
+	  return (0);
+	}
+
+	pending[num_pending].pitem = pitem;
+	pending[num_pending].deadline = dtime_now() + save_audio_config_p->diversity_window * 0.001;
+	pending[num_pending].crc = crc;
+	pending[num_pending].flen = flen;
+	memcpy (pending[num_pending].fbuf, fbuf, flen);
+	pending[num_pending].score = score;
+	num_pending++;
+
+	return (1);
+
+} /* end diversity_hold */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        diversity_release
+ *
+ * Purpose:     Get a frame whose window has closed.
+ *
+ * Returns:	Item, with channel changed to the primary of the group,
+ *		or NULL if nothing is ready.  Caller processes and deletes it.
+ *
+ *--------------------------------------------------------------------*/
+
+dlq_item_t *diversity_release (void)
+{
+	dlq_item_t *pitem;
+
+	if (num_pending == 0) return (NULL);
+
+	if (pending[0].deadline > dtime_now()) return (NULL);
+
+	pitem = pending[0].pitem;
+	pitem->chan = save_audio_config_p->diversity_primary[pitem->chan];
+
+	num_pending--;
+	if (num_pending > 0) {
+	  memmove (&(pending[0]), &(pending[1]), num_pending * sizeof(struct pending_s));
+	}
+	return (pitem);
+
+} /* end diversity_release */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        diversity_next_expiry
+ *
+ * Purpose:     When should the receive queue thread wake up for us?
+ *
+ * Returns:	dtime_now() value for the earliest window to close,
+ *		or 0 if nothing is waiting.
+ *
+ *--------------------------------------------------------------------*/
+
+double diversity_next_expiry (void)
+{
+	if (num_pending == 0) return (0);
+	return (pending[0].deadline);
+}
+
+/* end diversity.c */
@@ -0,0 +1,22 @@
+
+/* diversity.h */
+
+#ifndef DIVERSITY_H
+#define DIVERSITY_H 1
+
+#include "audio.h"		/* for struct audio_s */
+#include "dlq.h"		/* for dlq_item_t */
+
+
+void diversity_init (struct audio_s *pa);
+
+int diversity_hold (dlq_item_t *pitem);
+
+dlq_item_t *diversity_release (void);
+
+double diversity_next_expiry (void);
+
+
+#endif
+
+/* end diversity.h */
@@ -93,6 +93,21 @@ static volatile int s_cdata_new_count = 0;		/* To detect memory leak for connect
 static volatile int s_cdata_delete_count = 0;		// TODO:  need to test.
 
 
+/*
+ * Connected mode data blocks are recycled rather than going back to malloc
+ * for every chunk.  There is a free list for each 128 byte size class
+ * up to the largest information part.  Anything bigger, such as a
+ * reassembled segmented message, is allocated and freed normally.
+ */
+
+#define CDATA_POOL_CLASSES (AX25_MAX_INFO_LEN / 128 + 1)
+#define CDATA_POOL_MAX 64			/* Keep no more than this many of each size. */
+
+static cdata_t *cdata_pool[CDATA_POOL_CLASSES];
+static int cdata_pool_count[CDATA_POOL_CLASSES];
+static dw_mutex_t cdata_pool_mutex;
+
+
 
 /*-------------------------------------------------------------------
  *
@@ -145,6 +160,8 @@ void dlq_init (void)
 	}
 #endif
 
+	dw_mutex_init (&cdata_pool_mutex);
+
 
 
 #if DEBUG
@@ -980,6 +997,49 @@ void dlq_client_cleanup (int client)
 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        dlq_reload_config
+ *
+ * Purpose:     Request that the configuration file be read again.
+ *
+ * Outputs:	Request is appended to queue for processing by
+ *		the receive queue thread.
+ *
+ * Description:	Doing it in the same thread as the digipeater and
+ *		IGate processing means a received packet will never
+ *		see a mixture of old and new settings.
+ *
+ *--------------------------------------------------------------------*/
+
+void dlq_reload_config (void)
+{
+	struct dlq_item_s *pnew;
+#if DEBUG
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("dlq_reload_config ()\n");
+#endif
+
+/* Allocate a new queue item. */
+
+	pnew = (struct dlq_item_s *) calloc (sizeof(struct dlq_item_s), 1);
+	if (pnew == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+	s_new_count++;
+
+	pnew->type = DLQ_RELOAD_CONFIG;
+
+/* Put it into queue. */
+
+	append_to_queue (pnew);
+
+} /* end dlq_reload_config */
+
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        dlq_wait_while_empty
@@ -1226,37 +1286,65 @@ void dlq_delete (struct dlq_item_s *pitem)
  *		Client application calls "dlq_xmit_data_request."
  *		A copy of the data is made with this function and attached to the queue item.
  *		The txdata block is attached to the appropriate link state machine.
+ *		If it is larger than the maximum frame size, it is divided up
+ *		with cdata_slice rather than copying it again.
  *		At the proper time, it is transmitted in an I frame.
  *		It needs to be kept around in case it needs to be retransmitted.
  *		When no longer needed, it is freed with cdata_delete.
  *
  *--------------------------------------------------------------------*/
 
+static cdata_t *cdata_alloc (int size)
+{
+	cdata_t *cdata = NULL;
+	int class = size / 128;
+
+	if (class < CDATA_POOL_CLASSES) {
+	  dw_mutex_lock (&cdata_pool_mutex);
+	  cdata = cdata_pool[class];
+	  if (cdata != NULL) {
+	    cdata_pool[class] = cdata->next;
+	    cdata_pool_count[class]--;
+	  }
+	  dw_mutex_unlock (&cdata_pool_mutex);
+	}
+
+	if (cdata == NULL) {
+	  cdata = malloc ( sizeof(cdata_t) + size );
+	  if (cdata == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("FATAL ERROR: Out of memory.\n");
+	    exit (EXIT_FAILURE);
+	  }
+	}
+
+	s_cdata_new_count++;
+
+	cdata->magic = TXDATA_MAGIC;
+	cdata->next = NULL;
+	cdata->size = size;
+	cdata->refcnt = 1;
+	cdata->base = NULL;
+	cdata->data = cdata->storage;
+	return (cdata);
+}
+
 
 cdata_t *cdata_new (int pid, char *data, int len)
 {
 	int size;
 	cdata_t *cdata;
 
-	s_cdata_new_count++;
-
 	/* Round up the size to the next 128 bytes. */
 	/* The theory is that a smaller number of unique sizes might be */
 	/* beneficial for memory fragmentation and garbage collection. */
+	/* It also makes them interchangeable for reuse. */
 
 	size = ( len + 127 ) & ~0x7f;
 
-	cdata = malloc ( sizeof(cdata_t) + size );
-	if (cdata == NULL) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("FATAL ERROR: Out of memory.\n");
-	  exit (EXIT_FAILURE);
-	}
+	cdata = cdata_alloc (size);
 
-	cdata->magic = TXDATA_MAGIC;
-	cdata->next = NULL;
 	cdata->pid = pid;
-	cdata->size = size;
 	cdata->len = len;
 
 	assert (len >= 0 && len <= size);
@@ -1272,6 +1360,49 @@ cdata_t *cdata_new (int pid, char *data, int len)
 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        cdata_slice
+ *
+ * Purpose:     Refer to part of an existing data block without copying it.
+ *
+ * Inputs:	base	- Existing data block.
+ *		offset	- Where the slice starts within base->data.
+ *		len	- length of slice.
+ *
+ * Returns:	New block, with the same pid, sharing the data of base.
+ *
+ * Description:	The base block stays around until it and all
+ *		of its slices have been given to cdata_delete.
+ *		A slice of a slice refers to the original block.
+ *
+ *--------------------------------------------------------------------*/
+
+cdata_t *cdata_slice (cdata_t *base, int offset, int len)
+{
+	cdata_t *slice;
+
+	assert (base != NULL && base->magic == TXDATA_MAGIC);
+	assert (offset >= 0 && len >= 0 && offset + len <= base->len);
+
+	slice = cdata_alloc (0);
+
+	slice->pid = base->pid;
+	slice->len = len;
+	slice->data = base->data + offset;
+
+	if (base->base != NULL) {
+	  base = base->base;
+	}
+	base->refcnt++;
+	slice->base = base;
+
+	return (slice);
+
+}  /* end cdata_slice */
+
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        cdata_delete
@@ -1280,6 +1411,13 @@ cdata_t *cdata_new (int pid, char *data, int len)
  *
  * Inputs:	cdata		- Pointer to a data block.
  *
+ * Description:	If there are still slices referring to it, the
+ *		storage is released later, when the last one goes.
+ *
+ *		Reference counts are not protected by a lock.  Once the
+ *		data is handed over to the link state machine, everything
+ *		happens in the one thread which processes the dlq queue.
+ *
  *--------------------------------------------------------------------*/
 
 
@@ -1297,11 +1435,35 @@ void cdata_delete (cdata_t *cdata)
 	  return;
 	}
 
+	cdata->refcnt--;
+	if (cdata->refcnt > 0) {
+	  return;		// Slices still using it.
+	}
+
+	if (cdata->base != NULL) {
+	  cdata_delete (cdata->base);
+	}
+
 	s_cdata_delete_count++;
 
 	cdata->magic = 0;
 
-	free (cdata);
+	int class = cdata->size / 128;
+
+	if (class < CDATA_POOL_CLASSES) {
+	  dw_mutex_lock (&cdata_pool_mutex);
+	  if (cdata_pool_count[class] < CDATA_POOL_MAX) {
+	    cdata->next = cdata_pool[class];
+	    cdata_pool[class] = cdata;
+	    cdata_pool_count[class]++;
+	    cdata = NULL;
+	  }
+	  dw_mutex_unlock (&cdata_pool_mutex);
+	}
+
+	if (cdata != NULL) {
+	  free (cdata);
+	}
 
 } /* end cdata_delete */
 
@@ -23,11 +23,20 @@ typedef struct cdata_s {
 
 	int pid;			/* Protocol id. */
 
-	int size;			/* Number of bytes allocated. */
+	int size;			/* Number of bytes allocated in storage. */
+					/* 0 for a slice. */
 
 	int len;			/* Number of bytes actually used. */
 
-	char data[];			/* Variable length data. */
+	int refcnt;			/* 1 for the owner plus 1 for each slice referring to it. */
+
+	struct cdata_s *base;		/* For a slice, the block which holds the data. */
+					/* NULL otherwise. */
+
+	char *data;			/* Start of data.  Points into storage, or base->storage */
+					/* for a slice.  Use this, never storage directly. */
+
+	char storage[];			/* Variable length data. */
 
 } cdata_t;
 
@@ -36,7 +45,7 @@ typedef struct cdata_s {
 
 /* Types of things that can be in queue. */
 
-typedef enum dlq_type_e {DLQ_REC_FRAME, DLQ_CONNECT_REQUEST, DLQ_DISCONNECT_REQUEST, DLQ_XMIT_DATA_REQUEST, DLQ_REGISTER_CALLSIGN, DLQ_UNREGISTER_CALLSIGN, DLQ_OUTSTANDING_FRAMES_REQUEST, DLQ_CHANNEL_BUSY, DLQ_SEIZE_CONFIRM, DLQ_CLIENT_CLEANUP} dlq_type_t;
+typedef enum dlq_type_e {DLQ_REC_FRAME, DLQ_CONNECT_REQUEST, DLQ_DISCONNECT_REQUEST, DLQ_XMIT_DATA_REQUEST, DLQ_REGISTER_CALLSIGN, DLQ_UNREGISTER_CALLSIGN, DLQ_OUTSTANDING_FRAMES_REQUEST, DLQ_CHANNEL_BUSY, DLQ_SEIZE_CONFIRM, DLQ_CLIENT_CLEANUP, DLQ_RELOAD_CONFIG} dlq_type_t;
 
 typedef enum fec_type_e {fec_type_none=0, fec_type_fx25=1, fec_type_il2p=2} fec_type_t;
 
@@ -129,6 +138,8 @@ void dlq_seize_confirm (int chan);
 
 void dlq_client_cleanup (int client);
 
+void dlq_reload_config (void);
+
 
 
 int dlq_wait_while_empty (double timeout_val);
@@ -141,6 +152,8 @@ void dlq_delete (struct dlq_item_s *pitem);
 
 cdata_t *cdata_new (int pid, char *data, int len);
 
+cdata_t *cdata_slice (cdata_t *base, int offset, int len);
+
 void cdata_delete (cdata_t *txdata);
 
 void cdata_check_leak (void);
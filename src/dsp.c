@@ -41,6 +41,7 @@
 #include "fsk_gen_filter.h"
 #include "textcolor.h"
 #include "dsp.h"
+#include "tablecache.h"
 
 
 
@@ -48,6 +49,19 @@
 #define MAX(a,b) ((a)>(b)?(a):(b))
 
 
+/*
+ * Everything used to generate a filter, for looking it up in the
+ * table cache.  See tablecache.c.  Always clear with memset first.
+ */
+
+struct filter_key_s {
+	float f1;
+	float f2;
+	int size;
+	int wtype;
+};
+
+
 // Don't remove this.  It serves as a reminder that an experiment is underway.
 
 #if defined(TUNE_MS_FILTER_SIZE) || defined(TUNE_MS2_FILTER_SIZE) || defined(TUNE_AGC_FAST) || defined(TUNE_LPF_BAUD) || defined(TUNE_PLL_LOCKED) || defined(TUNE_PROFILE)
@@ -141,6 +155,16 @@ void gen_lowpass (float fc, float *lp_filter, int filter_size, bp_window_t wtype
 
 	assert (filter_size >= 3 && filter_size <= MAX_FILTER_SIZE);
 
+	struct filter_key_s key;
+	memset (&key, 0, sizeof(key));
+	key.f1 = fc;
+	key.size = filter_size;
+	key.wtype = wtype;
+
+	if (tablecache_get ("lowpass", &key, sizeof(key), lp_filter, filter_size * sizeof(float))) {
+	  return;
+	}
+
         for (j=0; j<filter_size; j++) {
 	  float center;
 	  float sinc;
@@ -174,6 +198,8 @@ void gen_lowpass (float fc, float *lp_filter, int filter_size, bp_window_t wtype
 	  lp_filter[j] = lp_filter[j] / G;
 	}
 
+	tablecache_put ("lowpass", &key, sizeof(key), lp_filter, filter_size * sizeof(float));
+
 	return;
 
 }  /* end gen_lowpass */
@@ -220,6 +246,17 @@ void gen_bandpass (float f1, float f2, float *bp_filter, int filter_size, bp_win
 
 	assert (filter_size >= 3 && filter_size <= MAX_FILTER_SIZE);
 
+	struct filter_key_s key;
+	memset (&key, 0, sizeof(key));
+	key.f1 = f1;
+	key.f2 = f2;
+	key.size = filter_size;
+	key.wtype = wtype;
+
+	if (tablecache_get ("bandpass", &key, sizeof(key), bp_filter, filter_size * sizeof(float))) {
+	  return;
+	}
+
         for (j=0; j<filter_size; j++) {
 	  float sinc;
 	  float shape;
@@ -260,6 +297,8 @@ void gen_bandpass (float f1, float f2, float *bp_filter, int filter_size, bp_win
 	  bp_filter[j] = bp_filter[j] / G;
 	}
 
+	tablecache_put ("bandpass", &key, sizeof(key), bp_filter, filter_size * sizeof(float));
+
 } /* end gen_bandpass */
 
 
@@ -289,6 +328,18 @@ void gen_ms (int fc, int sps, float *sin_table, float *cos_table, int filter_siz
 	int j;
 	float Gs = 0, Gc = 0;;
 
+	struct filter_key_s key;
+	memset (&key, 0, sizeof(key));
+	key.f1 = fc;
+	key.f2 = sps;
+	key.size = filter_size;
+	key.wtype = wtype;
+
+	if (tablecache_get ("ms_sin", &key, sizeof(key), sin_table, filter_size * sizeof(float)) &&
+	    tablecache_get ("ms_cos", &key, sizeof(key), cos_table, filter_size * sizeof(float))) {
+	  return;
+	}
+
         for (j=0; j<filter_size; j++) {
 
 	  float center = 0.5f * (filter_size - 1);
@@ -318,6 +369,9 @@ void gen_ms (int fc, int sps, float *sin_table, float *cos_table, int filter_siz
 	  cos_table[j] = cos_table[j] / Gc;
 	}
 
+	tablecache_put ("ms_sin", &key, sizeof(key), sin_table, filter_size * sizeof(float));
+	tablecache_put ("ms_cos", &key, sizeof(key), cos_table, filter_size * sizeof(float));
+
 } /* end gen_ms */
 
 
@@ -387,6 +441,16 @@ void gen_rrc_lowpass (float *pfilter, int filter_taps, float rolloff, float samp
 	int k;
 	float t;
 
+	struct filter_key_s key;
+	memset (&key, 0, sizeof(key));
+	key.f1 = rolloff;
+	key.f2 = samples_per_symbol;
+	key.size = filter_taps;
+
+	if (tablecache_get ("rrc", &key, sizeof(key), pfilter, filter_taps * sizeof(float))) {
+	  return;
+	}
+
 	for (k = 0; k < filter_taps; k++) {
 	  t = (k - ((filter_taps - 1.0) / 2.0)) / samples_per_symbol;
 	  pfilter[k] = rrc (t, rolloff);
@@ -401,6 +465,8 @@ void gen_rrc_lowpass (float *pfilter, int filter_taps, float rolloff, float samp
 	for (k = 0; k < filter_taps; k++) {
 	  pfilter[k] = pfilter[k] / t;
 	}
+
+	tablecache_put ("rrc", &key, sizeof(key), pfilter, filter_taps * sizeof(float));
 }
 
 /* end dsp.c */
@@ -245,14 +245,31 @@ void timestamp_now (char *result, int result_size, int show_ms)
 
 void timestamp_user_format (char *result, int result_size, char *user_format)
 {
-	double now = dtime_realtime();
-	time_t t = (int)now;
+	timestamp_user_format_time (result, result_size, user_format, dtime_realtime());
+
+}  /* end timestamp_user_format */
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:	timestamp_user_format_time
+ *
+ * Purpose:   	Same as above for some other time, such as when
+ *		a received frame was captured by the audio device.
+ *
+ * Input:	t		- Time in dtime_realtime() format.
+ *
+ *---------------------------------------------------------------*/
+
+void timestamp_user_format_time (char *result, int result_size, char *user_format, double t)
+{
+	time_t tt = (time_t)t;
 	struct tm tm;
 
-	localtime_r (&t, &tm);
+	localtime_r (&tt, &tm);
 	strftime (result, result_size, user_format, &tm);
 
-}  /* end timestamp_user_format */
+}  /* end timestamp_user_format_time */
 
 
 /*------------------------------------------------------------------
@@ -9,6 +9,8 @@ void timestamp_now (char *result, int result_size, int show_ms);
 
 void timestamp_user_format (char *result, int result_size, char *user_format);
 
+void timestamp_user_format_time (char *result, int result_size, char *user_format, double t);
+
 void timestamp_filename (char *result, int result_size);
 
 
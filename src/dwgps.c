@@ -85,6 +85,8 @@ static dwgps_info_t s_dwgps_info = {
 
 static dw_mutex_t s_gps_mutex;
 
+static void (*s_notify)(dwgps_info_t *gpsinfo) = NULL;	/* See dwgps_set_notify. */
+
 
 /*-------------------------------------------------------------------
  *
@@ -260,9 +262,33 @@ void dwgps_set_data (dwgps_info_t *gpsinfo)
 
 	dw_mutex_unlock (&s_gps_mutex);
 
+	if (s_notify != NULL) {
+	  (*s_notify) (gpsinfo);
+	}
+
 }  /* end dwgps_set_data */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        dwgps_set_notify
+ *
+ * Purpose:     Ask to be told about each new fix rather than polling.
+ *
+ * Inputs:	notify		- Function called, from the GPS interface thread,
+ *				  each time new data is available.
+ *				  It should return quickly.
+ *
+ * Description:	Only one is needed now, for the beacon scheduler.
+ *
+ *--------------------------------------------------------------------*/
+
+void dwgps_set_notify (void (*notify)(dwgps_info_t *gpsinfo))
+{
+	s_notify = notify;
+}
+
+
 /* end dwgps.c */
 
 
@@ -52,6 +52,8 @@ void dwgps_term (void);
 
 void dwgps_set_data (dwgps_info_t *gpsinfo);
 
+void dwgps_set_notify (void (*notify)(dwgps_info_t *gpsinfo));
+
 
 #endif /* DWGPS_H 1 */
 
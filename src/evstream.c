@@ -0,0 +1,1037 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      evstream.c
+ *
+ * Purpose:   	Structured stream of received and transmitted frames
+ *		for other applications.
+ *
+ * Description:	Applications wanting the decoded information had to
+ *		parse the colored console text or the CSV log file,
+ *		or decode the raw frames again themselves.
+ *
+ *		Here we write one event for each frame, using the information
+ *		already available:  channel, modem, slicer, spectrum, audio
+ *		level, bits fixed, FEC type, addresses, frame type,
+ *		and the decoded APRS fields.
+ *
+ *		Configuration:
+ *
+ *			EVENTS  path  [ JSON | CBOR ]
+ *
+ *		path is a file name, appended to, or unix:name to listen
+ *		on a Unix domain socket.  Up to MAX_CLIENTS applications
+ *		can connect to the socket and each gets all events from
+ *		then on.
+ *
+ *		JSON is one object per line, often called NDJSON.
+ *		CBOR (RFC 8949) is a sequence of maps, one per event.
+ *		The keys and values are the same.
+ *
+ *		The information part, "info", is not necessarily text.
+ *		CBOR has it as a byte string.  JSON has no such thing so
+ *		each byte becomes one character, U+0000 thru U+00FF, with
+ *		anything other than printable ASCII written as \u00xx.
+ *		Encoding the JSON string as ISO 8859-1 gives back the
+ *		original bytes exactly.
+ *
+ *		An application that doesn't keep up is disconnected
+ *		rather than holding up the receive or transmit thread.
+ *
+ *		Example:
+ *
+ *		{"event":"rec","time":1700000000.123,"rxtime":1700000000.081734,
+ *		 "sample":1234567,"chan":0,"subchan":0,"slice":0,
+ *		 "fec":"none","retries":0,"level":{"rec":50,"mark":50,"space":48},
+ *		 "src":"WB2OSZ-5","dst":"APDW17","path":["WIDE1-1*","WIDE2-1"],
+ *		 "heard":"WB2OSZ-5","info":"!4237.14NS07120.83W#PHG7140",
+ *		 "aprs":{"type":"Position","lat":42.619,"lon":-71.347, ... }}
+ *
+ *---------------------------------------------------------------*/
+
+#define EVSTREAM_C 1		// for retry_text in hdlc_rec2.h
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#if __WIN32__
+#else
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#endif
+
+#include "textcolor.h"
+#include "ax25_pad.h"
+#include "hdlc_rec2.h"
+#include "dlq.h"
+#include "decode_aprs.h"
+#include "dtime_now.h"
+#include "tq.h"
+#include "evstream.h"
+
+
+#define MAX_CLIENTS 8
+
+static enum evstream_format_e s_format = EVSTREAM_JSON;
+
+static FILE *s_fp = NULL;			/* When writing to a file. */
+
+static int s_listen_fd = -1;			/* When listening on a Unix domain socket. */
+static int s_client_fd[MAX_CLIENTS];
+
+static dw_mutex_t s_mutex;			/* Events come from receive and transmit threads. */
+
+static int s_enabled = 0;
+
+static int s_dropped = 0;			/* Events discarded because memory ran out. */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Building one event.
+ *
+ * The same calls produce either JSON or CBOR.
+ * Maps and arrays use the CBOR "indefinite length" form so
+ * we don't need to know the number of items in advance.
+ *
+ * Most events fit in the space inside the structure.  Binary data
+ * takes 6 bytes per byte in JSON so a large frame can need several
+ * times that.  Then we switch to allocated memory which grows as needed.
+ *
+ *--------------------------------------------------------------------*/
+
+#define EV_MAX_DEPTH 4
+
+struct ev_s {
+	unsigned char *buf;		/* Points to local or allocated. */
+	int size;
+	int len;
+	int overflow;			/* Out of memory.  Event can't be sent. */
+	int depth;
+	int first[EV_MAX_DEPTH];	/* JSON:  No comma needed before next item. */
+	unsigned char local[4096];
+};
+
+
+static void ev_begin (struct ev_s *e)
+{
+	memset (e, 0, sizeof(struct ev_s));
+	e->buf = e->local;
+	e->size = sizeof(e->local);
+}
+
+static void ev_end (struct ev_s *e)
+{
+	if (e->buf != e->local) {
+	  free (e->buf);
+	}
+	e->buf = e->local;
+	e->size = sizeof(e->local);
+}
+
+
+static void ev_put (struct ev_s *e, const void *p, int n)
+{
+	if (e->overflow) {
+	  return;
+	}
+	if (e->len + n > e->size) {
+	  int new_size = e->size * 2;
+	  unsigned char *new_buf;
+
+	  while (new_size < e->len + n) {
+	    new_size *= 2;
+	  }
+	  if (e->buf == e->local) {
+	    new_buf = malloc (new_size);
+	    if (new_buf != NULL) {
+	      memcpy (new_buf, e->buf, e->len);
+	    }
+	  }
+	  else {
+	    new_buf = realloc (e->buf, new_size);
+	  }
+	  if (new_buf == NULL) {
+	    e->overflow = 1;
+	    return;
+	  }
+	  e->buf = new_buf;
+	  e->size = new_size;
+	}
+	memcpy (e->buf + e->len, p, n);
+	e->len += n;
+}
+
+static void ev_putc (struct ev_s *e, int c)
+{
+	unsigned char ch = c;
+	ev_put (e, &ch, 1);
+}
+
+
+// CBOR head: major type and argument.
+
+static void cbor_head (struct ev_s *e, int major, unsigned long long n)
+{
+	major <<= 5;
+	if (n < 24) {
+	  ev_putc (e, major | n);
+	}
+	else if (n < 0x100) {
+	  ev_putc (e, major | 24);
+	  ev_putc (e, n);
+	}
+	else if (n < 0x10000) {
+	  ev_putc (e, major | 25);
+	  ev_putc (e, n >> 8);
+	  ev_putc (e, n);
+	}
+	else if (n < 0x100000000ULL) {
+	  ev_putc (e, major | 26);
+	  for (int k = 24; k >= 0; k -= 8) ev_putc (e, n >> k);
+	}
+	else {
+	  ev_putc (e, major | 27);
+	  for (int k = 56; k >= 0; k -= 8) ev_putc (e, n >> k);
+	}
+}
+
+
+/*
+ * Length of valid UTF-8 sequence starting at p, or 0 if not valid.
+ * Received text is often not UTF-8 so we need to be careful.
+ */
+
+static int utf8_len (const unsigned char *p, int avail)
+{
+	int n, j;
+
+	if (p[0] < 0x80) return (1);
+	else if ((p[0] & 0xe0) == 0xc0 && p[0] >= 0xc2) n = 2;
+	else if ((p[0] & 0xf0) == 0xe0) n = 3;
+	else if ((p[0] & 0xf8) == 0xf0 && p[0] <= 0xf4) n = 4;
+	else return (0);
+
+	if (n > avail) return (0);
+	for (j = 1; j < n; j++) {
+	  if ((p[j] & 0xc0) != 0x80) return (0);
+	}
+	return (n);
+}
+
+
+/*
+ * Text string.  Any byte which is not part of a valid UTF-8 sequence
+ * is taken to be ISO 8859-1 so the result is always valid.
+ */
+
+static void ev_text (struct ev_s *e, const char *s, int n)
+{
+	const unsigned char *p = (const unsigned char *)s;
+	int j, k;
+
+	if (s_format == EVSTREAM_CBOR) {
+	  int olen = 0;
+	  for (j = 0; j < n; j += k) {
+	    k = utf8_len (p + j, n - j);
+	    if (k == 0) { k = 1; olen += 2; } else olen += k;
+	  }
+	  cbor_head (e, 3, olen);
+	  for (j = 0; j < n; j += k) {
+	    k = utf8_len (p + j, n - j);
+	    if (k == 0) {
+	      k = 1;
+	      ev_putc (e, 0xc0 | (p[j] >> 6));
+	      ev_putc (e, 0x80 | (p[j] & 0x3f));
+	    }
+	    else {
+	      ev_put (e, p + j, k);
+	    }
+	  }
+	  return;
+	}
+
+	ev_putc (e, '"');
+	for (j = 0; j < n; j += k) {
+	  k = utf8_len (p + j, n - j);
+	  if (k == 0 || p[j] < 0x20 || p[j] == 0x7f) {
+	    char hex[8];
+	    k = 1;
+	    switch (p[j]) {
+	      case '\n': ev_put (e, "\\n", 2); break;
+	      case '\r': ev_put (e, "\\r", 2); break;
+	      case '\t': ev_put (e, "\\t", 2); break;
+	      default:
+	        snprintf (hex, sizeof(hex), "\\u%04x", p[j]);
+	        ev_put (e, hex, 6);
+	        break;
+	    }
+	  }
+	  else if (p[j] == '"' || p[j] == '\\') {
+	    ev_putc (e, '\\');
+	    ev_putc (e, p[j]);
+	  }
+	  else {
+	    ev_put (e, p + j, k);
+	  }
+	}
+	ev_putc (e, '"');
+}
+
+
+/*
+ * Binary data, such as the information part, exactly as it is.
+ * CBOR byte string.  For JSON, one character for each byte.
+ */
+
+static void ev_bytes (struct ev_s *e, const unsigned char *p, int n)
+{
+	int j;
+
+	if (s_format == EVSTREAM_CBOR) {
+	  cbor_head (e, 2, n);
+	  ev_put (e, p, n);
+	  return;
+	}
+
+	ev_putc (e, '"');
+	for (j = 0; j < n; j++) {
+	  if (p[j] < 0x20 || p[j] >= 0x7f) {
+	    char hex[8];
+	    snprintf (hex, sizeof(hex), "\\u%04x", p[j]);
+	    ev_put (e, hex, 6);
+	  }
+	  else if (p[j] == '"' || p[j] == '\\') {
+	    ev_putc (e, '\\');
+	    ev_putc (e, p[j]);
+	  }
+	  else {
+	    ev_putc (e, p[j]);
+	  }
+	}
+	ev_putc (e, '"');
+}
+
+
+// Before each item in a map or array.
+
+static void ev_key (struct ev_s *e, const char *key)
+{
+	if (s_format == EVSTREAM_JSON && e->depth > 0) {
+	  if ( ! e->first[e->depth-1]) {
+	    ev_putc (e, ',');
+	  }
+	  e->first[e->depth-1] = 0;
+	}
+
+	if (key != NULL) {
+	  ev_text (e, key, strlen(key));
+	  if (s_format == EVSTREAM_JSON) {
+	    ev_putc (e, ':');
+	  }
+	}
+}
+
+
+static void ev_open (struct ev_s *e, const char *key, int is_array)
+{
+	ev_key (e, key);
+	if (s_format == EVSTREAM_CBOR) {
+	  ev_putc (e, is_array ? 0x9f : 0xbf);
+	}
+	else {
+	  ev_putc (e, is_array ? '[' : '{');
+	}
+	if (e->depth < EV_MAX_DEPTH) {
+	  e->first[e->depth] = 1;
+	}
+	e->depth++;
+}
+
+static void ev_close (struct ev_s *e, int is_array)
+{
+	e->depth--;
+	if (s_format == EVSTREAM_CBOR) {
+	  ev_putc (e, 0xff);
+	}
+	else {
+	  ev_putc (e, is_array ? ']' : '}');
+	}
+}
+
+
+static void ev_str (struct ev_s *e, const char *key, const char *val)
+{
+	ev_key (e, key);
+	ev_text (e, val, strlen(val));
+}
+
+static void ev_int (struct ev_s *e, const char *key, long long val)
+{
+	ev_key (e, key);
+	if (s_format == EVSTREAM_CBOR) {
+	  if (val >= 0) cbor_head (e, 0, val);
+	  else cbor_head (e, 1, -1 - val);
+	}
+	else {
+	  char stemp[24];
+	  snprintf (stemp, sizeof(stemp), "%lld", val);
+	  ev_put (e, stemp, strlen(stemp));
+	}
+}
+
+static void ev_num (struct ev_s *e, const char *key, double val, int decimals)
+{
+	ev_key (e, key);
+	if (s_format == EVSTREAM_CBOR) {
+	  unsigned long long u;
+	  memcpy (&u, &val, 8);
+	  ev_putc (e, 0xfb);		// IEEE 754 double, big endian.
+	  for (int k = 56; k >= 0; k -= 8) ev_putc (e, u >> k);
+	}
+	else {
+	  char stemp[40];
+	  snprintf (stemp, sizeof(stemp), "%.*f", decimals, val);
+	  ev_put (e, stemp, strlen(stemp));
+	}
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        evstream_init
+ *
+ * Purpose:     Open the file or start listening for applications.
+ *
+ * Inputs:	path	- File name, "unix:" followed by socket name,
+ *			  or empty string to disable.
+ *
+ *		format	- EVSTREAM_JSON or EVSTREAM_CBOR.
+ *
+ *--------------------------------------------------------------------*/
+
+#if __WIN32__
+#else
+static void * listen_thread (void *arg);
+#endif
+
+void evstream_init (char *path, enum evstream_format_e format)
+{
+	int n;
+
+	s_format = format;
+	for (n = 0; n < MAX_CLIENTS; n++) {
+	  s_client_fd[n] = -1;
+	}
+
+	if (strlen(path) == 0) {
+	  return;
+	}
+
+	dw_mutex_init (&s_mutex);
+
+	if (strncmp(path, "unix:", 5) == 0) {
+#if __WIN32__
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("EVENTS to a Unix domain socket is not supported for Windows.  Use a file name.\n");
+	  return;
+#else
+	  struct sockaddr_un addr;
+	  pthread_t tid;
+
+	  memset (&addr, 0, sizeof(addr));
+	  addr.sun_family = AF_UNIX;
+	  if (strlen(path + 5) >= sizeof(addr.sun_path)) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("EVENTS: Socket name \"%s\" is too long.  Maximum is %d characters.\n", path + 5, (int)sizeof(addr.sun_path) - 1);
+	    return;
+	  }
+	  strlcpy (addr.sun_path, path + 5, sizeof(addr.sun_path));
+
+	  s_listen_fd = socket (AF_UNIX, SOCK_STREAM, 0);
+	  if (s_listen_fd < 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("EVENTS: Can't create socket.  %s\n", strerror(errno));
+	    return;
+	  }
+
+	  struct stat st;
+	  if (stat(addr.sun_path, &st) == 0 && S_ISSOCK(st.st_mode)) {
+	    unlink (addr.sun_path);		// Left over from last time.
+	  }
+
+	  if (bind (s_listen_fd, (struct sockaddr *)&addr, sizeof(addr)) < 0 || listen (s_listen_fd, 5) < 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("EVENTS: Can't listen on \"%s\".  %s\n", addr.sun_path, strerror(errno));
+	    close (s_listen_fd);
+	    s_listen_fd = -1;
+	    return;
+	  }
+
+	  if (pthread_create (&tid, NULL, listen_thread, NULL) != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("EVENTS: Could not create thread.\n");
+	    close (s_listen_fd);
+	    s_listen_fd = -1;
+	    return;
+	  }
+
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Ready to send %s events on Unix domain socket \"%s\".\n", format == EVSTREAM_CBOR ? "CBOR" : "JSON", addr.sun_path);
+#endif
+	}
+	else {
+	  s_fp = fopen (path, format == EVSTREAM_CBOR ? "ab" : "a");
+	  if (s_fp == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("EVENTS: Can't open \"%s\" for write.  %s\n", path, strerror(errno));
+	    return;
+	  }
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Writing %s events to \"%s\".\n", format == EVSTREAM_CBOR ? "CBOR" : "JSON", path);
+	}
+
+	s_enabled = 1;
+}
+
+
+#if __WIN32__
+#else
+
+static void * listen_thread (void *arg)
+{
+	while (1) {
+	  int fd = accept (s_listen_fd, NULL, NULL);
+	  int n;
+
+	  if (fd < 0) {
+	    if (errno == EINTR) continue;
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("EVENTS: accept failed.  %s\n", strerror(errno));
+	    return (NULL);
+	  }
+
+	  dw_mutex_lock (&s_mutex);
+	  for (n = 0; n < MAX_CLIENTS; n++) {
+	    if (s_client_fd[n] < 0) {
+	      s_client_fd[n] = fd;
+	      break;
+	    }
+	  }
+	  dw_mutex_unlock (&s_mutex);
+
+	  text_color_set(DW_COLOR_INFO);
+	  if (n < MAX_CLIENTS) {
+	    dw_printf ("EVENTS: Application connected, slot %d.\n", n);
+	  }
+	  else {
+	    dw_printf ("EVENTS: Too many applications connected.  Maximum is %d.\n", MAX_CLIENTS);
+	    close (fd);
+	  }
+	}
+	return (NULL);
+}
+
+#endif
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        send_event
+ *
+ * Purpose:     Write the completed event to the file or each application.
+ *
+ * Description:	Socket writes never wait.  If it won't all fit, the
+ *		application isn't keeping up so we disconnect it rather
+ *		than sending a partial event.
+ *
+ *		Any allocated memory is released.
+ *
+ *--------------------------------------------------------------------*/
+
+static void send_event (struct ev_s *e)
+{
+	if (s_format == EVSTREAM_JSON) {
+	  ev_putc (e, '\n');
+	}
+
+	if (e->overflow) {
+	  int n = __atomic_add_fetch (&s_dropped, 1, __ATOMIC_RELAXED);
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("EVENTS: Out of memory.  Event discarded.  %d so far.\n", n);
+	  ev_end (e);
+	  return;
+	}
+
+	dw_mutex_lock (&s_mutex);
+
+	if (s_fp != NULL) {
+	  fwrite (e->buf, 1, e->len, s_fp);
+	  fflush (s_fp);
+	}
+
+#if __WIN32__
+#else
+	for (int n = 0; n < MAX_CLIENTS; n++) {
+	  if (s_client_fd[n] >= 0) {
+	    ssize_t sent = send (s_client_fd[n], e->buf, e->len, MSG_DONTWAIT | MSG_NOSIGNAL);
+	    if (sent != e->len) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("EVENTS: Application in slot %d %s.  Disconnecting.\n", n,
+				sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK ? "has gone away" : "is not keeping up");
+	      close (s_client_fd[n]);
+	      s_client_fd[n] = -1;
+	    }
+	  }
+	}
+#endif
+
+	dw_mutex_unlock (&s_mutex);
+
+	ev_end (e);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        add_frame
+ *
+ * Purpose:     Addresses, frame type, and information part.
+ *		Common to received and transmitted.
+ *
+ *--------------------------------------------------------------------*/
+
+static void add_frame (struct ev_s *e, packet_t pp)
+{
+	char addr[AX25_MAX_ADDR_LEN+1];
+	unsigned char *pinfo;
+	int info_len;
+	int n;
+
+	if (ax25_get_num_addr(pp) >= 2) {
+	  ax25_get_addr_with_ssid (pp, AX25_SOURCE, addr);
+	  ev_str (e, "src", addr);
+	  ax25_get_addr_with_ssid (pp, AX25_DESTINATION, addr);
+	  ev_str (e, "dst", addr);
+
+	  if (ax25_get_num_repeaters(pp) > 0) {
+	    ev_open (e, "path", 1);
+	    for (n = AX25_REPEATER_1; n < ax25_get_num_addr(pp); n++) {
+	      ax25_get_addr_with_ssid (pp, n, addr);
+	      if (ax25_get_h(pp, n)) {
+	        strlcat (addr, "*", sizeof(addr));
+	      }
+	      ev_str (e, NULL, addr);
+	    }
+	    ev_close (e, 1);
+	  }
+	}
+
+	if ( ! ax25_is_aprs(pp)) {
+	  cmdres_t cr;
+	  char desc[80];
+	  int pf, nr, ns;
+
+	  (void)ax25_frame_type (pp, &cr, desc, &pf, &nr, &ns);
+	  ev_str (e, "frame", desc);
+	}
+
+	info_len = ax25_get_info (pp, &pinfo);
+	if (info_len > 0) {
+	  ev_key (e, "info");
+	  ev_bytes (e, pinfo, info_len);
+	}
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        evstream_rec
+ *
+ * Purpose:     Event for a received frame.
+ *
+ * Inputs:	chan, subchan, slice, pp, alevel, fec_type, retries, spectrum
+ *			- Same as app_process_rec_packet.
+ *
+ *		A	- Decoded APRS information or NULL if not APRS.
+ *
+ *--------------------------------------------------------------------*/
+
+void evstream_rec (int chan, int subchan, int slice, packet_t pp, alevel_t alevel,
+			fec_type_t fec_type, retry_t retries, char *spectrum, decode_aprs_t *A)
+{
+	struct ev_s e;
+
+	if ( ! s_enabled) {
+	  return;
+	}
+
+	ev_begin (&e);
+
+	ev_open (&e, NULL, 0);
+	ev_str (&e, "event", "rec");
+	ev_num (&e, "time", dtime_realtime(), 3);
+
+	// When the end of the frame was captured by the audio device.
+	// Difference from "time" is the demodulator and queuing latency.
+
+	if (ax25_get_rx_time(pp) > 0) {
+	  ev_num (&e, "rxtime", ax25_get_rx_time(pp), 6);
+	}
+	if (ax25_get_rx_sample(pp) > 0) {
+	  ev_int (&e, "sample", ax25_get_rx_sample(pp));
+	}
+	ev_int (&e, "chan", chan);
+	if (subchan >= 0) {
+	  ev_int (&e, "subchan", subchan);
+	  ev_int (&e, "slice", slice);
+	}
+	if (spectrum != NULL && strlen(spectrum) > 0) {
+	  ev_str (&e, "spectrum", spectrum);
+	}
+	ev_str (&e, "fec", fec_type == fec_type_fx25 ? "fx25" : fec_type == fec_type_il2p ? "il2p" : "none");
+	ev_int (&e, "retries", (int)retries);
+	if (retries >= 0 && retries < (int)(sizeof(retry_text)/sizeof(retry_text[0]))) {
+	  ev_str (&e, "retry", retry_text[(int)retries]);
+	}
+	if (alevel.rec >= 0) {
+	  ev_open (&e, "level", 0);
+	  ev_int (&e, "rec", alevel.rec);
+	  if (alevel.mark >= 0) ev_int (&e, "mark", alevel.mark);
+	  if (alevel.space >= 0) ev_int (&e, "space", alevel.space);
+	  ev_close (&e, 0);
+	}
+
+	add_frame (&e, pp);
+
+	if (ax25_get_num_addr(pp) >= 2) {
+	  char heard[AX25_MAX_ADDR_LEN+1];
+	  ax25_get_addr_with_ssid (pp, ax25_get_heard(pp), heard);
+	  ev_str (&e, "heard", heard);
+	}
+
+	if (A != NULL) {
+	  char stemp[4];
+
+	  ev_open (&e, "aprs", 0);
+	  ev_str (&e, "type", A->g_data_type_desc);
+	  ev_str (&e, "src", A->g_src);
+	  if (strlen(A->g_name) > 0) ev_str (&e, "name", A->g_name);
+	  if (A->g_symbol_code != ' ' && A->g_symbol_code != '\0') {
+	    stemp[0] = A->g_symbol_table;
+	    stemp[1] = A->g_symbol_code;
+	    stemp[2] = '\0';
+	    ev_str (&e, "symbol", stemp);
+	  }
+	  if (A->g_lat != G_UNKNOWN && A->g_lon != G_UNKNOWN) {
+	    ev_num (&e, "lat", A->g_lat, 6);
+	    ev_num (&e, "lon", A->g_lon, 6);
+	  }
+	  if (strlen(A->g_maidenhead) > 0) ev_str (&e, "maidenhead", A->g_maidenhead);
+	  if (A->g_speed_mph != G_UNKNOWN) ev_num (&e, "speed_knots", DW_MPH_TO_KNOTS(A->g_speed_mph), 1);
+	  if (A->g_course != G_UNKNOWN) ev_num (&e, "course", A->g_course, 1);
+	  if (A->g_altitude_ft != G_UNKNOWN) ev_num (&e, "altitude_m", DW_FEET_TO_METERS(A->g_altitude_ft), 1);
+	  if (A->g_freq != G_UNKNOWN) ev_num (&e, "freq_mhz", A->g_freq, 3);
+	  if (A->g_offset != G_UNKNOWN) ev_int (&e, "offset_khz", A->g_offset);
+	  if (A->g_tone != G_UNKNOWN) ev_num (&e, "tone", A->g_tone, 1);
+	  if (A->g_dcs != G_UNKNOWN) ev_int (&e, "dcs", A->g_dcs);
+	  if (strlen(A->g_addressee) > 0) ev_str (&e, "addressee", A->g_addressee);
+	  if (strlen(A->g_message_number) > 0) ev_str (&e, "msgno", A->g_message_number);
+	  if (strlen(A->g_mfr) > 0) ev_str (&e, "system", A->g_mfr);
+	  if (strlen(A->g_mic_e_status) > 0) ev_str (&e, "status", A->g_mic_e_status);
+	  if (strlen(A->g_weather) > 0) ev_str (&e, "weather", A->g_weather);
+	  if (strlen(A->g_telemetry) > 0) ev_str (&e, "telemetry", A->g_telemetry);
+	  if (strlen(A->g_comment) > 0) ev_str (&e, "comment", A->g_comment);
+	  ev_close (&e, 0);
+	}
+
+	ev_close (&e, 0);
+
+	send_event (&e);
+
+} /* end evstream_rec */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        evstream_xmit
+ *
+ * Purpose:     Event for a transmitted frame.
+ *
+ * Inputs:	chan	- Radio channel.
+ *
+ *		prio	- TQ_PRIO_0_HI or TQ_PRIO_1_LO.
+ *
+ *		pp	- Frame being sent.
+ *
+ *--------------------------------------------------------------------*/
+
+void evstream_xmit (int chan, int prio, packet_t pp)
+{
+	struct ev_s e;
+
+	if ( ! s_enabled) {
+	  return;
+	}
+
+	ev_begin (&e);
+
+	ev_open (&e, NULL, 0);
+	ev_str (&e, "event", "xmit");
+	ev_num (&e, "time", dtime_realtime(), 3);
+	ev_int (&e, "chan", chan);
+	ev_str (&e, "prio", prio == TQ_PRIO_0_HI ? "high" : "low");
+	add_frame (&e, pp);
+	ev_close (&e, 0);
+
+	send_event (&e);
+
+} /* end evstream_xmit */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        evstream_term
+ *
+ * Purpose:     Close the file or disconnect applications at shutdown.
+ *
+ *--------------------------------------------------------------------*/
+
+void evstream_term (void)
+{
+	if ( ! s_enabled) {
+	  return;
+	}
+
+	dw_mutex_lock (&s_mutex);
+	if (s_fp != NULL) {
+	  fclose (s_fp);
+	  s_fp = NULL;
+	}
+#if __WIN32__
+#else
+	for (int n = 0; n < MAX_CLIENTS; n++) {
+	  if (s_client_fd[n] >= 0) {
+	    close (s_client_fd[n]);
+	    s_client_fd[n] = -1;
+	  }
+	}
+#endif
+	s_enabled = 0;
+	dw_mutex_unlock (&s_mutex);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        main
+ *
+ * Purpose:     Unit test for the JSON and CBOR encoding.
+ *
+ *		$ gcc -DEVSTREAMTEST -DUSE_REGEX_STATIC -Iregex evstream.c ax25_pad.c fcs_calc.c textcolor.c dtime_now.c regex.a misc.a
+ *
+ *--------------------------------------------------------------------*/
+
+#if EVSTREAMTEST
+
+#include <assert.h>
+
+static void check (struct ev_s *e, const void *expected, int len)
+{
+	if (e->len != len || memcmp(e->buf, expected, len) != 0) {
+	  int n;
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Expected %d bytes, got %d:", len, e->len);
+	  for (n = 0; n < e->len; n++) dw_printf (" %02x", e->buf[n]);
+	  dw_printf ("\n");
+	  exit (EXIT_FAILURE);
+	}
+	ev_end (e);
+}
+
+// Same items in either format.
+
+static void small_map (struct ev_s *e)
+{
+	ev_begin (e);
+	ev_open (e, NULL, 0);
+	ev_int (e, "a", 1);
+	ev_int (e, "b", -2);
+	ev_int (e, "c", 1000000);
+	ev_str (e, "d", "x");
+	ev_open (e, "e", 1);
+	ev_key (e, NULL);
+	ev_text (e, "q\"\\\n\x01\xe9 \xc3\xa9", 9);
+	ev_close (e, 1);
+	ev_close (e, 0);
+}
+
+
+int main (int argc, char *argv[])
+{
+	struct ev_s e;
+	int n;
+
+	s_format = EVSTREAM_JSON;
+	small_map (&e);
+	{
+	  static const char expect[] = "{\"a\":1,\"b\":-2,\"c\":1000000,\"d\":\"x\",\"e\":[\"q\\\"\\\\\\n\\u0001\\u00e9 \xc3\xa9\"]}";
+	  check (&e, expect, strlen(expect));
+	}
+
+	s_format = EVSTREAM_CBOR;
+	small_map (&e);
+	{
+	  static const unsigned char expect[] = {
+		0xbf,
+		0x61, 'a', 0x01,
+		0x61, 'b', 0x21,
+		0x61, 'c', 0x1a, 0x00, 0x0f, 0x42, 0x40,
+		0x61, 'd', 0x61, 'x',
+		0x61, 'e', 0x9f, 0x6a, 'q', '"', '\\', '\n', 0x01, 0xc3, 0xa9, ' ', 0xc3, 0xa9, 0xff,
+		0xff };
+	  check (&e, expect, sizeof(expect));
+	}
+
+/*
+ * Sample count past 2**53 must not be rounded as a double would be.
+ */
+	s_format = EVSTREAM_JSON;
+	ev_begin (&e);
+	ev_int (&e, NULL, 9007199254740993LL);
+	check (&e, "9007199254740993", 16);
+
+	s_format = EVSTREAM_CBOR;
+	ev_begin (&e);
+	ev_int (&e, NULL, 9007199254740993LL);
+	{
+	  static const unsigned char expect[] = { 0x1b, 0x00, 0x20, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01 };
+	  check (&e, expect, sizeof(expect));
+	}
+
+/*
+ * Information part is bytes, not text.  Something which happens to look
+ * like UTF-8 must not be taken as one character.
+ */
+	static const unsigned char info[] = { 'A', '"', 0xe9, 0xc3, 0xa9, '\n' };
+
+	s_format = EVSTREAM_JSON;
+	ev_begin (&e);
+	ev_bytes (&e, info, sizeof(info));
+	{
+	  static const char expect[] = "\"A\\\"\\u00e9\\u00c3\\u00a9\\u000a\"";
+	  check (&e, expect, strlen(expect));
+	}
+
+	s_format = EVSTREAM_CBOR;
+	ev_begin (&e);
+	ev_bytes (&e, info, sizeof(info));
+	{
+	  static const unsigned char expect[] = { 0x46, 'A', '"', 0xe9, 0xc3, 0xa9, '\n' };
+	  check (&e, expect, sizeof(expect));
+	}
+
+/*
+ * Binary data as large as a frame can be.  JSON needs 6 bytes for each.
+ */
+	unsigned char binary[AX25_MAX_INFO_LEN];
+	memset (binary, 0x01, sizeof(binary));
+
+	s_format = EVSTREAM_JSON;
+	ev_begin (&e);
+	ev_key (&e, NULL);
+	ev_bytes (&e, binary, sizeof(binary));
+	assert ( ! e.overflow);
+	assert (e.len == 2 + 6 * (int)sizeof(binary));
+	assert (e.buf[0] == '"' && e.buf[e.len-1] == '"');
+	ev_end (&e);
+
+/*
+ * Complete event written to a file.
+ */
+	const char *fname = "evstreamtest.tmp";
+	char line[20000];
+	FILE *fp;
+	packet_t pp;
+
+	remove (fname);
+	evstream_init ((char *)fname, EVSTREAM_JSON);
+	pp = ax25_from_text ("WB2OSZ-5>APDW17,WIDE1-1:x", 1);
+	assert (pp != NULL);
+	ax25_set_info (pp, binary, 700);
+	evstream_xmit (0, TQ_PRIO_1_LO, pp);
+	ax25_delete (pp);
+	evstream_term ();
+
+	fp = fopen (fname, "r");
+	assert (fp != NULL);
+	assert (fgets (line, sizeof(line), fp) != NULL);
+	n = strlen(line);
+	assert (n > 700 * 6);
+	assert (line[n-1] == '\n');
+	assert (strncmp(line, "{\"event\":\"xmit\",", 16) == 0);
+	assert (strstr(line, "\"src\":\"WB2OSZ-5\",\"dst\":\"APDW17\",\"path\":[\"WIDE1-1\"]") != NULL);
+	assert (strcmp(line + n - 9, "\\u0001\"}\n") == 0);
+	assert (fgets (line, sizeof(line), fp) == NULL);
+	fclose (fp);
+	remove (fname);
+
+	assert (s_dropped == 0);
+
+/*
+ * Socket name too long for sun_path must be rejected, not shortened.
+ */
+#if __WIN32__
+#else
+	{
+	  char longname[300];
+	  strlcpy (longname, "unix:", sizeof(longname));
+	  memset (longname + 5, 'x', 200);
+	  longname[205] = '\0';
+	  evstream_init (longname, EVSTREAM_JSON);
+	  assert (s_listen_fd < 0);
+	  evstream_term ();
+	}
+#endif
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Event stream encoding test passed.\n");
+	exit (EXIT_SUCCESS);
+}
+
+#endif
+
+/* end evstream.c */
@@ -0,0 +1,27 @@
+/* evstream.h */
+
+#ifndef EVSTREAM_H
+#define EVSTREAM_H 1
+
+#include "ax25_pad.h"		// for packet_t, alevel_t
+#include "hdlc_rec2.h"		// for retry_t
+#include "dlq.h"		// for fec_type_t
+#include "decode_aprs.h"	// for decode_aprs_t
+
+
+enum evstream_format_e { EVSTREAM_JSON = 0, EVSTREAM_CBOR };
+
+
+void evstream_init (char *path, enum evstream_format_e format);
+
+void evstream_rec (int chan, int subchan, int slice, packet_t pp, alevel_t alevel,
+			fec_type_t fec_type, retry_t retries, char *spectrum, decode_aprs_t *A);
+
+void evstream_xmit (int chan, int prio, packet_t pp);
+
+void evstream_term (void);
+
+
+#endif
+
+/* end evstream.h */
@@ -65,7 +65,8 @@ void FREE_RS(struct rs *rs);
 
 void fx25_init ( int debug_level );
 int fx25_send_frame (int chan, unsigned char *fbuf, int flen, int fx_mode);
-void fx25_rec_bit (int chan, int subchan, int slice, int dbit);
+int fx25_rec_bit (int chan, int subchan, int slice, int dbit);
+void fx25_rec_tag (int chan, int subchan, int slice, int ctag_num, uint64_t accum);
 int fx25_rec_busy (int chan);
 
 
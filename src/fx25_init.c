@@ -141,10 +141,57 @@ static const struct correlation_tag_s tags[16] = {
 // in an integer.  This can result in a single machine instruction.  You might need
 // to supply your own popcount function if using a different compiler.
 
-int fx25_tag_find_match (uint64_t t)
+// This is called for every received bit of every slicer so it needs to be fast.
+// The builtin is only a single instruction if the target has one.  Our default
+// x86 build does not so it becomes a library call, 11 of them per bit.
+
+// Most of those can be avoided.  Cut the tag into CLOSE_ENOUGH+1 chunks.
+// If no more than CLOSE_ENOUGH bits are wrong, at least one chunk must be
+// exactly right.  chunk_tags[j][v] has bit c set when chunk j of tag c is v.
+// One lookup per chunk gives the only tags worth counting bits for.
+// For random bits that is usually none and seldom more than one.
+// The table is built by fx25_init, before any receive threads start.
+
+#define NCHUNK (CLOSE_ENOUGH + 1)
+#define CHUNK_BITS (64 / NCHUNK)
+#define CHUNK_MASK ((1 << CHUNK_BITS) - 1)
+
+static uint16_t chunk_tags[NCHUNK][1 << CHUNK_BITS];
+static int chunk_tags_built = 0;
+
+static void build_chunk_tags (void)
 {
+	memset (chunk_tags, 0, sizeof(chunk_tags));
 	for (int c = CTAG_MIN; c <= CTAG_MAX; c++) {
-	  if (__builtin_popcountll(t ^ tags[c].value) <= CLOSE_ENOUGH) {
+	  for (int j = 0; j < NCHUNK; j++) {
+	    chunk_tags[j][(tags[c].value >> (j * CHUNK_BITS)) & CHUNK_MASK] |= 1 << c;
+	  }
+	}
+	chunk_tags_built = 1;
+}
+
+static inline int count_ones32 (uint32_t x)
+{
+	x = x - ((x >> 1) & 0x55555555);
+	x = (x & 0x33333333) + ((x >> 2) & 0x33333333);
+	x = (x + (x >> 4)) & 0x0f0f0f0f;
+	return ((x * 0x01010101) >> 24);
+}
+
+int fx25_tag_find_match (uint64_t t)
+{
+	assert (chunk_tags_built);
+
+	unsigned int candidates = 0;
+	for (int j = 0; j < NCHUNK; j++) {
+	  candidates |= chunk_tags[j][(t >> (j * CHUNK_BITS)) & CHUNK_MASK];
+	}
+
+	while (candidates != 0) {
+	  int c = __builtin_ctz (candidates);	// Lowest bit set.
+	  candidates &= candidates - 1;		// Remove it.
+	  uint64_t x = t ^ tags[c].value;
+	  if (count_ones32 ((uint32_t)x) + count_ones32 ((uint32_t)(x >> 32)) <= CLOSE_ENOUGH) {
 	    //printf ("%016" PRIx64 " received\n", t);
 	    //printf ("%016" PRIx64 " tag %d\n", tags[c].value, c);
 	    //printf ("%016" PRIx64 " xor, popcount = %d\n", t ^ tags[c].value, __builtin_popcountll(t ^ tags[c].value));
@@ -198,6 +245,8 @@ void fx25_init ( int debug_level )
 	  }
 	}
 
+	build_chunk_tags ();
+
 	// Verify integrity of tables and assumptions.
 	// This also does a quick check for the popcount function.
 
@@ -218,6 +267,19 @@ void fx25_init ( int debug_level )
 	  assert (tags[j].n_block_rs == FX25_BLOCK_SIZE);
 	}
 
+	// Worst case for the chunk lookup: one error in each of all but one chunk.
+
+	uint64_t spread = 0;
+	for (int j = 0; j < CLOSE_ENOUGH; j++) {
+	  spread |= 1ULL << (j * CHUNK_BITS);
+	}
+	for (int j = CTAG_MIN; j <= CTAG_MAX; j++) {
+	  assert (fx25_tag_find_match (tags[j].value) == j);
+	  assert (fx25_tag_find_match (tags[j].value ^ spread) == j);
+	  assert (fx25_tag_find_match (tags[j].value ^ (spread << 1)) == j);
+	  assert (fx25_tag_find_match (tags[j].value ^ spread ^ (1ULL << 63)) == -1);
+	}
+
 	assert (fx25_pick_mode (100+1, 239) == 1);
 	assert (fx25_pick_mode (100+1, 240) == -1);
 
@@ -61,6 +61,8 @@ struct fx_context_s {
 
 static struct fx_context_s *fx_context[MAX_CHANS][MAX_SUBCHANS][MAX_SLICERS];
 
+static struct fx_context_s *get_context (int chan, int subchan, int slice);
+
 static void process_rs_block (int chan, int subchan, int slice, struct fx_context_s *F);
 
 static int my_unstuff (int chan, int subchan, int slice, unsigned char * restrict pin, int ilen, unsigned char * restrict frame_buf);
@@ -141,29 +143,27 @@ int main ()
  *              dbit	- Data bit after NRZI and any descrambling.
  *			  Any non-zero value is logic '1'.
  *
+ * Returns:	True while a codeblock is being gathered.
+ *		False when searching for a correlation tag.
+ *
  * Description: This is called once for each received bit.
  *              For each valid frame, process_rec_frame() is called for further processing.
  *		It can gather multiple candidates from different parallel demodulators
  *		("subchannels") and slicers, then decide which one is the best.
  *
+ *		hdlc_rec_bit does the correlation tag search itself, from
+ *		the bit history it keeps for HDLC, and calls fx25_rec_tag
+ *		when one is found.  After that it sends bits here only
+ *		until this returns false.  Searching here is still done
+ *		for standalone use such as the FXTEST application.
+ *
  ***********************************************************************************/
 
 #define FENCE 0x55		// to detect buffer overflow.
 
-void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
+int fx25_rec_bit (int chan, int subchan, int slice, int dbit)
 {
-
-// Allocate context blocks only as needed.
-
-	struct fx_context_s *F = fx_context[chan][subchan][slice];
-	if (F == NULL) {
-          assert (chan >= 0 && chan < MAX_CHANS);
-          assert (subchan >= 0 && subchan < MAX_SUBCHANS);
-          assert (slice >= 0 && slice < MAX_SLICERS);
-	  F = fx_context[chan][subchan][slice] = (struct fx_context_s *)malloc(sizeof (struct fx_context_s));
-	  assert (F != NULL);
-	  memset (F, 0, sizeof(struct fx_context_s));
-	}
+	struct fx_context_s *F = get_context (chan, subchan, slice);
 
 // State machine to identify correlation tag then gather appropriate number of data and check bytes.
 	  
@@ -173,28 +173,7 @@ void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
 	    if (dbit) F->accum |= 1LL << 63;
 	    int c = fx25_tag_find_match (F->accum);
 	    if (c >= CTAG_MIN && c <= CTAG_MAX) {
-	      
-	      F->ctag_num = c;
-	      F->k_data_radio = fx25_get_k_data_radio (F->ctag_num);
-	      F->nroots = fx25_get_nroots (F->ctag_num);
-	      F->coffs = fx25_get_k_data_rs (F->ctag_num);
-	      assert (F->coffs == FX25_BLOCK_SIZE - F->nroots);
-
-	      if (fx25_get_debug() >= 2) {
-	        text_color_set(DW_COLOR_INFO);
-	        dw_printf ("FX.25[%d.%d]: Matched correlation tag 0x%02x with %d bit errors.  Expecting %d data & %d check bytes.\n",
-			chan, slice,	// ideally subchan too only if applicable
-			c,
-			__builtin_popcountll(F->accum ^ fx25_get_ctag_value(c)),
-			F->k_data_radio, F->nroots);
-	      }
-
-	      F->imask = 0x01;
-	      F->dlen = 0;
-	      F->clen = 0;
-	      memset (F->block, 0, sizeof(F->block));
-	      F->block[FX25_BLOCK_SIZE] = FENCE;
-	      F->state = FX_DATA;
+	      fx25_rec_tag (chan, subchan, slice, c, F->accum);
 	    }
 	    break;
 
@@ -227,6 +206,73 @@ void fx25_rec_bit (int chan, int subchan, int slice, int dbit)
 	    }
 	    break;
 	}
+	return (F->state != FX_TAG);
+}
+
+
+/***********************************************************************************
+ *
+ * Name:        fx25_rec_tag
+ *
+ * Purpose:     Start gathering a codeblock after a correlation tag was found.
+ *
+ * Inputs:      chan, subchan, slice
+ *
+ *              ctag_num - Correlation tag number, CTAG_MIN to CTAG_MAX,
+ *			   from fx25_tag_find_match.
+ *
+ *		accum	- The most recent 64 data bits, newest in the MSB.
+ *			  Only used to report the number of bit errors.
+ *
+ * Description:	The following bits, sent to fx25_rec_bit, are the data
+ *		and check bytes.
+ *
+ ***********************************************************************************/
+
+void fx25_rec_tag (int chan, int subchan, int slice, int ctag_num, uint64_t accum)
+{
+	struct fx_context_s *F = get_context (chan, subchan, slice);
+
+	assert (ctag_num >= CTAG_MIN && ctag_num <= CTAG_MAX);
+
+	F->ctag_num = ctag_num;
+	F->k_data_radio = fx25_get_k_data_radio (F->ctag_num);
+	F->nroots = fx25_get_nroots (F->ctag_num);
+	F->coffs = fx25_get_k_data_rs (F->ctag_num);
+	assert (F->coffs == FX25_BLOCK_SIZE - F->nroots);
+
+	if (fx25_get_debug() >= 2) {
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("FX.25[%d.%d]: Matched correlation tag 0x%02x with %d bit errors.  Expecting %d data & %d check bytes.\n",
+			chan, slice,	// ideally subchan too only if applicable
+			ctag_num,
+			__builtin_popcountll(accum ^ fx25_get_ctag_value(ctag_num)),
+			F->k_data_radio, F->nroots);
+	}
+
+	F->imask = 0x01;
+	F->dlen = 0;
+	F->clen = 0;
+	memset (F->block, 0, sizeof(F->block));
+	F->block[FX25_BLOCK_SIZE] = FENCE;
+	F->state = FX_DATA;
+}
+
+
+// Allocate context blocks only as needed.
+
+static struct fx_context_s *get_context (int chan, int subchan, int slice)
+{
+	struct fx_context_s *F = fx_context[chan][subchan][slice];
+	if (F == NULL) {
+          assert (chan >= 0 && chan < MAX_CHANS);
+          assert (subchan >= 0 && subchan < MAX_SUBCHANS);
+          assert (slice >= 0 && slice < MAX_SLICERS);
+	  F = fx_context[chan][subchan][slice] = (struct fx_context_s *)malloc(sizeof (struct fx_context_s));
+	  assert (F != NULL);
+	  memset (F, 0, sizeof(struct fx_context_s));
+	}
+	return (F);
 }
 
 
@@ -65,6 +65,13 @@
  *			gen_packets -v 5
  *			gen_packets -v 5,0.5
  *
+ *		Corpus of many files for regression and throughput testing.
+ *		Every combination of modem, FEC, noise, speed, and frequency
+ *		offset listed in corpus.txt goes into its own file in directory zc.
+ *		zc/manifest.csv lists them with the expected frames and atest options.
+ *
+ *			gen_packets -C corpus.txt -o zc
+ *
  *------------------------------------------------------------------*/
 
 
@@ -76,6 +83,15 @@
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <sys/stat.h>
+#include <errno.h>
+
+#if __WIN32__
+#include <direct.h>
+#else
+#include <unistd.h>
+#include <sys/wait.h>
+#endif
 
 #include "audio.h"
 #include "ax25_pad.h"
@@ -113,6 +129,35 @@ static int g_morse_wpm = 0;		/* Send morse code at this speed. */
 static struct audio_s modem;
 
 
+/*
+ * Corpus mode, -C option.
+ * A file lists values for each dimension and we generate
+ * one .WAV file for every combination.
+ */
+
+#define MAX_CORPUS_VALUES 20
+
+#define CORPUS_NO_NOISE 999	/* SNR value for no added noise. */
+
+static struct corpus_s {
+	int num_baud;
+	int baud[MAX_CORPUS_VALUES];		/* MODEM */
+	int num_layer2;
+	char layer2[MAX_CORPUS_VALUES][12];	/* LAYER2 AX25, FX25, FX25-16, IL2P, ... */
+	int num_snr;
+	float snr[MAX_CORPUS_VALUES];		/* SNR in dB or CORPUS_NO_NOISE */
+	int num_speed;
+	float speed[MAX_CORPUS_VALUES];		/* SPEED error in percent */
+	int num_freq;
+	int freq[MAX_CORPUS_VALUES];		/* FREQ offset in Hz, AFSK only */
+	int packets;				/* PACKETS per file */
+	int jobs;				/* JOBS, files generated at the same time */
+} corpus;
+
+static void corpus_read (char *fname);
+static int corpus_generate (char *dir, int amplitude);
+
+
 static void send_packet (char *str)
 {
     	packet_t pp;
@@ -261,9 +306,11 @@ int main(int argc, char **argv)
 
 	int leading_zeros = 12;		/* -z option TODO: not implemented, should replace with txdelay frames. */
 	char output_file[256];		/* -o option */
+	char corpus_file[256];		/* -C option */
 	FILE *input_fp = NULL;		/* File or NULL for built-in message */
 
 	strlcpy (output_file, "", sizeof(output_file));
+	strlcpy (corpus_file, "", sizeof(corpus_file));
 
 /*
  * Parse the command line options.
@@ -281,7 +328,7 @@ int main(int argc, char **argv)
 
 	  /* ':' following option character means arg is required. */
 
-          c = getopt_long(argc, argv, "gjJm:s:a:b:B:r:n:N:o:z:82M:X:I:i:v:",
+          c = getopt_long(argc, argv, "gjJm:s:a:b:B:r:n:N:o:z:82M:X:I:i:v:C:",
                         long_options, &option_index);
           if (c == -1)
             break;
@@ -543,6 +590,11 @@ int main(int argc, char **argv)
 	      }
 	      break;
 
+            case 'C':			// Corpus description file.
+
+              strlcpy (corpus_file, optarg, sizeof(corpus_file));
+              break;
+
             case '?':
 
               /* Unknown option message was already printed. */
@@ -631,6 +683,22 @@ int main(int argc, char **argv)
 	}
 
 
+/*
+ * Corpus mode makes many files in the -o directory.
+ * Other options, except for -a and -r, are ignored.
+ */
+
+	if (strlen(corpus_file) > 0) {
+	  if (strlen(output_file) == 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("ERROR: The -o option must specify an output directory with -C.\n");
+	    usage (argv);
+	  }
+	  corpus_read (corpus_file);
+	  exit (corpus_generate (output_file, amplitude) == 0 ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+
 /*
  * Open the output file.
  */
@@ -840,6 +908,7 @@ static void usage (char **argv)
 	dw_printf ("  -8            8 bit audio rather than 16.\n");
 	dw_printf ("  -2            2 channels (stereo) audio rather than one channel.\n");
 	dw_printf ("  -v max[,incr] Variable speed with specified maximum error and increment.\n");
+	dw_printf ("  -C <file>     Generate a corpus of files, described by file, in -o directory.\n");
 //	dw_printf ("  -z <number>   Number of leading zero bits before frame.\n");
 //	dw_printf ("                  Default is 12 which is .01 seconds at 1200 bits/sec.\n");
 
@@ -875,6 +944,420 @@ static void usage (char **argv)
 
 
 
+
+/*------------------------------------------------------------------
+ *
+ * Name:        corpus_read
+ *
+ * Purpose:     Read the description of a corpus to generate.
+ *
+ * Inputs:      fname		- Name of file.  Each line has a keyword
+ *				  followed by one or more values.
+ *
+ *		MODEM	300 1200 2400 4800 9600	   Data rates.  Modem is chosen as for -B.
+ *		LAYER2	AX25 FX25 FX25-16 FX25-32 FX25-64 IL2P IL2P0
+ *		SNR	none 30 20 15 10	   Signal to noise ratio, in dB.
+ *		SPEED	-2 0 2			   Data rate error, in percent.
+ *		FREQ	-50 0 50		   Tone frequency error, in Hz.  AFSK only.
+ *		PACKETS	100			   Number of frames in each file.
+ *		JOBS	4			   Number of files generated at once.
+ *
+ *		# starts a comment.
+ *
+ * Outputs:	corpus
+ *
+ * Description:	SNR is relative to a sine wave with the same peak amplitude
+ *		and the noise covers the whole audio bandwidth.  It is useful
+ *		for comparing one run to another rather than as an absolute
+ *		measure of what a radio would hear.
+ *
+ *----------------------------------------------------------------*/
+
+static void corpus_read (char *fname)
+{
+	FILE *fp;
+	char line[256];
+	int line_num = 0;
+
+	memset (&corpus, 0, sizeof(corpus));
+	corpus.packets = 100;
+	corpus.jobs = 1;
+
+	fp = fopen (fname, "r");
+	if (fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't open corpus description file %s.\n", fname);
+	  exit (EXIT_FAILURE);
+	}
+
+	while (fgets (line, sizeof(line), fp) != NULL) {
+	  char *save;
+	  char *keyword;
+	  char *t;
+
+	  line_num++;
+	  t = strchr (line, '#');
+	  if (t != NULL) *t = '\0';
+
+	  keyword = strtok_r (line, " ,\t\r\n", &save);
+	  if (keyword == NULL) continue;
+
+	  while ((t = strtok_r (NULL, " ,\t\r\n", &save)) != NULL) {
+
+	    if (strcasecmp(keyword, "MODEM") == 0 && corpus.num_baud < MAX_CORPUS_VALUES) {
+	      int b = atoi(t);
+	      if (b < MIN_BAUD || b > MAX_BAUD) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("%s line %d: Data rate %s is not in range of %d - %d.\n", fname, line_num, t, MIN_BAUD, MAX_BAUD);
+	        exit (EXIT_FAILURE);
+	      }
+	      corpus.baud[corpus.num_baud++] = b;
+	    }
+	    else if (strcasecmp(keyword, "LAYER2") == 0 && corpus.num_layer2 < MAX_CORPUS_VALUES) {
+	      if (strcasecmp(t, "AX25") != 0 && strcasecmp(t, "FX25") != 0 &&
+	          strcasecmp(t, "FX25-16") != 0 && strcasecmp(t, "FX25-32") != 0 && strcasecmp(t, "FX25-64") != 0 &&
+	          strcasecmp(t, "IL2P") != 0 && strcasecmp(t, "IL2P0") != 0) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("%s line %d: Unknown LAYER2 value %s.\n", fname, line_num, t);
+	        exit (EXIT_FAILURE);
+	      }
+	      strlcpy (corpus.layer2[corpus.num_layer2++], t, sizeof(corpus.layer2[0]));
+	    }
+	    else if (strcasecmp(keyword, "SNR") == 0 && corpus.num_snr < MAX_CORPUS_VALUES) {
+	      corpus.snr[corpus.num_snr++] = strcasecmp(t, "none") == 0 ? CORPUS_NO_NOISE : atof(t);
+	    }
+	    else if (strcasecmp(keyword, "SPEED") == 0 && corpus.num_speed < MAX_CORPUS_VALUES) {
+	      corpus.speed[corpus.num_speed++] = atof(t);
+	    }
+	    else if (strcasecmp(keyword, "FREQ") == 0 && corpus.num_freq < MAX_CORPUS_VALUES) {
+	      corpus.freq[corpus.num_freq++] = atoi(t);
+	    }
+	    else if (strcasecmp(keyword, "PACKETS") == 0) {
+	      corpus.packets = atoi(t);
+	    }
+	    else if (strcasecmp(keyword, "JOBS") == 0) {
+	      corpus.jobs = atoi(t);
+	    }
+	    else {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("%s line %d: Unrecognized keyword %s or too many values.\n", fname, line_num, keyword);
+	      exit (EXIT_FAILURE);
+	    }
+	  }
+	}
+	fclose (fp);
+
+/* Anything not specified gets one default value. */
+
+	if (corpus.num_baud == 0) corpus.baud[corpus.num_baud++] = DEFAULT_BAUD;
+	if (corpus.num_layer2 == 0) strlcpy (corpus.layer2[corpus.num_layer2++], "AX25", sizeof(corpus.layer2[0]));
+	if (corpus.num_snr == 0) corpus.snr[corpus.num_snr++] = CORPUS_NO_NOISE;
+	if (corpus.num_speed == 0) corpus.speed[corpus.num_speed++] = 0;
+	if (corpus.num_freq == 0) corpus.freq[corpus.num_freq++] = 0;
+
+	if (corpus.packets < 1 || corpus.packets > 9999) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("%s: PACKETS must be in range of 1 to 9999.\n", fname);
+	  exit (EXIT_FAILURE);
+	}
+	if (corpus.jobs < 1) corpus.jobs = 1;
+}
+
+
+/*
+ * One file of the corpus.
+ */
+
+typedef struct corpus_cell_s {
+	char name[80];		/* File name without directory or extension. */
+	int baud;		/* Nominal data rate. */
+	char *layer2;
+	float snr;
+	float speed;
+	int freq;
+} corpus_cell_t;
+
+
+/*
+ * Set up modem for nominal data rate the same way as -B option.
+ * Returns additional atest options needed to decode it.
+ */
+
+static char *corpus_modem (struct audio_s *pa, int baud)
+{
+	pa->achan[0].baud = baud;
+	pa->achan[0].v26_alternative = V26_UNSPECIFIED;
+
+	if (baud < 600) {
+	  pa->achan[0].modem_type = MODEM_AFSK;
+	  pa->achan[0].mark_freq = 1600;
+	  pa->achan[0].space_freq = 1800;
+	  return ("");
+	}
+	else if (baud < 1800) {
+	  pa->achan[0].modem_type = MODEM_AFSK;
+	  pa->achan[0].mark_freq = DEFAULT_MARK_FREQ;
+	  pa->achan[0].space_freq = DEFAULT_SPACE_FREQ;
+	  return ("");
+	}
+	else if (baud < 3600) {
+	  pa->achan[0].modem_type = MODEM_QPSK;
+	  pa->achan[0].v26_alternative = V26_B;
+	  pa->achan[0].mark_freq = 0;
+	  pa->achan[0].space_freq = 0;
+	  return (" -J");
+	}
+	else if (baud < 7200) {
+	  pa->achan[0].modem_type = MODEM_8PSK;
+	  pa->achan[0].mark_freq = 0;
+	  pa->achan[0].space_freq = 0;
+	  return ("");
+	}
+	pa->achan[0].modem_type = MODEM_SCRAMBLE;
+	return ("");
+}
+
+
+/*
+ * Generate one file of corpus and the list of frames it contains.
+ * Returns 0 for success.
+ */
+
+static int corpus_cell (char *dir, corpus_cell_t *cell, int cell_num, int amplitude, struct audio_s *base)
+{
+	char fname[300];
+	FILE *txt_fp;
+	int i;
+
+	modem = *base;
+	corpus_modem (&modem, cell->baud);
+
+	if (modem.achan[0].modem_type == MODEM_AFSK) {
+	  modem.achan[0].mark_freq += cell->freq;
+	  modem.achan[0].space_freq += cell->freq;
+	}
+	modem.achan[0].baud = (int)round(cell->baud * (1. + cell->speed / 100.));
+
+	if (strncasecmp(cell->layer2, "FX25", 4) == 0) {
+	  modem.achan[0].layer2_xmit = LAYER2_FX25;
+	  modem.achan[0].fx25_strength = cell->layer2[4] == '-' ? atoi(cell->layer2 + 5) : 1;
+	}
+	else if (strncasecmp(cell->layer2, "IL2P", 4) == 0) {
+	  modem.achan[0].layer2_xmit = LAYER2_IL2P;
+	  modem.achan[0].il2p_max_fec = cell->layer2[4] != '0';
+	  modem.achan[0].il2p_invert_polarity = 0;
+	}
+
+/*
+ * audio_put adds uniformly distributed noise of +- 5 * g_noise_level full scale.
+ * Its power is 1/3 of the peak squared.
+ */
+	if (cell->snr == CORPUS_NO_NOISE) {
+	  g_add_noise = 0;
+	  g_noise_level = 0;
+	}
+	else {
+	  double peak = 32767. * (amplitude / 2) / 100.;
+	  double noise_power = (peak * peak / 2.) / pow(10., cell->snr / 10.);
+
+	  g_add_noise = 1;
+	  g_noise_level = sqrt(3. * noise_power) / (5. * 32767.);
+	}
+
+	seed = cell_num + 1;		/* Same result regardless of JOBS. */
+
+	snprintf (fname, sizeof(fname), "%s/%s.wav", dir, cell->name);
+	if (audio_file_open (fname, &modem) < 0) {
+	  return (-1);
+	}
+	snprintf (fname, sizeof(fname), "%s/%s.txt", dir, cell->name);
+	txt_fp = fopen (fname, "w");
+	if (txt_fp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't open file for write: %s\n", fname);
+	  audio_file_close ();
+	  return (-1);
+	}
+
+	gen_tone_init (&modem, amplitude/2, 1);
+
+	for (i = 1; i <= corpus.packets; i++) {
+	  char stemp[200];
+
+	  snprintf (stemp, sizeof(stemp), "WB2OSZ-15>TEST:,The quick brown fox jumps over the lazy dog!  %04d of %04d %s", i, corpus.packets, cell->name);
+	  send_packet (stemp);
+	  fprintf (txt_fp, "%s\n", stemp);
+	}
+
+	fclose (txt_fp);
+	return (audio_file_close ());
+}
+
+
+/*------------------------------------------------------------------
+ *
+ * Name:        corpus_generate
+ *
+ * Purpose:     Generate all files of the corpus.
+ *
+ * Inputs:      dir		- Output directory.  Created if it doesn't exist.
+ *
+ *		amplitude	- From -a option.
+ *
+ *		corpus		- From corpus_read.
+ *
+ * Returns:     0 for success, -1 if any file could not be generated.
+ *
+ * Description:	For each combination we write name.wav and name.txt,
+ *		with the frames in monitor format, one per line.
+ *		manifest.csv has one line per file with the parameters,
+ *		number of frames, and options needed for atest.
+ *		Decode rate is "packets decoded" from atest divided by
+ *		the number of frames.
+ *
+ *		Each file is independent, and all our state is global,
+ *		so we fork a process for each one and run up to JOBS
+ *		at the same time.  On Windows they are done one at a time.
+ *
+ *----------------------------------------------------------------*/
+
+static int corpus_generate (char *dir, int amplitude)
+{
+	struct audio_s base = modem;
+	corpus_cell_t *cells;
+	int num_cells = 0;
+	int ib, il, is, isp, ifr;
+	char fname[300];
+	FILE *mfp;
+	int failed = 0;
+	int k;
+
+#if __WIN32__
+	if (_mkdir (dir) != 0 && errno != EEXIST) {
+#else
+	if (mkdir (dir, 0777) != 0 && errno != EEXIST) {
+#endif
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't create output directory %s.\n", dir);
+	  return (-1);
+	}
+
+	cells = calloc (corpus.num_baud * corpus.num_layer2 * corpus.num_snr * corpus.num_speed * corpus.num_freq, sizeof(corpus_cell_t));
+
+	snprintf (fname, sizeof(fname), "%s/manifest.csv", dir);
+	mfp = fopen (fname, "w");
+	if (mfp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Couldn't open file for write: %s\n", fname);
+	  return (-1);
+	}
+	fprintf (mfp, "file,frames,baud,layer2,snr_db,speed_pct,freq_hz,atest_options\n");
+
+	for (ib = 0; ib < corpus.num_baud; ib++) {
+	  for (il = 0; il < corpus.num_layer2; il++) {
+	    for (is = 0; is < corpus.num_snr; is++) {
+	      for (isp = 0; isp < corpus.num_speed; isp++) {
+	        for (ifr = 0; ifr < corpus.num_freq; ifr++) {
+	          corpus_cell_t *cell = &cells[num_cells];
+	          struct audio_s temp = base;
+	          char *extra = corpus_modem (&temp, corpus.baud[ib]);
+	          char snr_text[16];
+
+	          /* Frequency offset applies only to AFSK.  Make just one file for others. */
+
+	          if (temp.achan[0].modem_type != MODEM_AFSK && ifr > 0) continue;
+
+	          cell->baud = corpus.baud[ib];
+	          cell->layer2 = corpus.layer2[il];
+	          cell->snr = corpus.snr[is];
+	          cell->speed = corpus.speed[isp];
+	          cell->freq = temp.achan[0].modem_type == MODEM_AFSK ? corpus.freq[ifr] : 0;
+
+	          if (cell->snr == CORPUS_NO_NOISE) {
+	            strlcpy (snr_text, "none", sizeof(snr_text));
+	          }
+	          else {
+	            snprintf (snr_text, sizeof(snr_text), "%g", cell->snr);
+	          }
+
+	          snprintf (cell->name, sizeof(cell->name), "%d_%s_snr%s_spd%+.1f_frq%+d",
+				cell->baud, cell->layer2, snr_text, cell->speed, cell->freq);
+
+	          fprintf (mfp, "%s.wav,%d,%d,%s,%s,%.1f,%d,-B %d%s\n", cell->name, corpus.packets,
+				cell->baud, cell->layer2, cell->snr == CORPUS_NO_NOISE ? "" : snr_text,
+				cell->speed, cell->freq, cell->baud, extra);
+	          num_cells++;
+	        }
+	      }
+	    }
+	  }
+	}
+	fclose (mfp);
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Generating %d files, %d frames each, in %s ...\n", num_cells, corpus.packets, dir);
+
+	fx25_init (1);
+	il2p_init (0);
+
+#if __WIN32__
+	for (k = 0; k < num_cells; k++) {
+	  if (corpus_cell (dir, &cells[k], k, amplitude, &base) != 0) {
+	    failed++;
+	  }
+	}
+#else
+	int running = 0;
+	int status;
+
+	fflush (stdout);
+
+	for (k = 0; k < num_cells || running > 0; ) {
+
+	  if (k < num_cells && running < corpus.jobs) {
+	    pid_t pid = fork ();
+
+	    if (pid == 0) {
+	      _exit (corpus_cell (dir, &cells[k], k, amplitude, &base) == 0 ? 0 : 1);
+	    }
+	    if (pid < 0) {
+	      /* Can't fork.  Do it ourselves. */
+	      if (corpus_cell (dir, &cells[k], k, amplitude, &base) != 0) {
+	        failed++;
+	      }
+	    }
+	    else {
+	      running++;
+	    }
+	    k++;
+	    continue;
+	  }
+
+	  if (wait (&status) > 0) {
+	    running--;
+	    if ( ! WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+	      failed++;
+	    }
+	  }
+	  else {
+	    running = 0;
+	  }
+	}
+#endif
+	free (cells);
+
+	if (failed > 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("%d of %d files could not be generated.\n", failed, num_cells);
+	  return (-1);
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Done.  See %s/manifest.csv\n", dir);
+	return (0);
+}
+
+
 /*------------------------------------------------------------------
  *
  * Name:        audio_file_open
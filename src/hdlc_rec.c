@@ -83,11 +83,18 @@ struct hdlc_state_s {
 
 	int prev_descram;		/* Previous descrambled for 9600 baud. */
 
-	unsigned char pat_det; 		/* 8 bit pattern detector shift register. */
-					/* See below for more details. */
+	uint64_t dhist;			/* Most recent 64 data bits, after NRZI */
+					/* and any descrambling, newest in MSB. */
+					/* The top 8 are the HDLC flag pattern */
+					/* detector.  All 64 are compared with the */
+					/* FX.25 correlation tags. */
 
-	unsigned int flag4_det;		/* Last 32 raw bits to look for 4 */
-					/* flag patterns in a row. */
+	unsigned int rhist;		/* Most recent raw bits, newest in LSB, */
+					/* for the IL2P sync word which skips NRZI. */
+
+	int fx25_busy;			/* Set when a sync word or correlation tag */
+	int il2p_busy;			/* is found.  Bits go to that decoder, */
+					/* instead of searching, until it is done. */
 
 	unsigned char oacc;		/* Accumulator for building up an octet. */
 
@@ -118,6 +125,9 @@ static struct hdlc_state_s hdlc_state[MAX_CHANS][MAX_SUBCHANS][MAX_SLICERS];
 
 static int num_subchan[MAX_CHANS];		//TODO1.2 use ptr rather than copy.
 
+static int sync_fx25[MAX_CHANS];		/* Look for FX.25 correlation tags. */
+static int sync_il2p[MAX_CHANS];		/* Look for IL2P sync word. */
+
 static int composite_dcd[MAX_CHANS][MAX_SUBCHANS+1];
 
 
@@ -158,6 +168,11 @@ void hdlc_rec_init (struct audio_s *pa)
 
 	    assert (num_subchan[ch] >= 1 && num_subchan[ch] <= MAX_SUBCHANS);
 
+	    // Don't waste time on FX.25 or IL2P if AIS.  EAS does not use HDLC at all.
+
+	    sync_fx25[ch] = pa->achan[ch].modem_type != MODEM_AIS && ! pa->achan[ch].fx25_rec_disable;
+	    sync_il2p[ch] = pa->achan[ch].modem_type != MODEM_AIS && ! pa->achan[ch].il2p_rec_disable;
+
 	    for (sub = 0; sub < num_subchan[ch]; sub++)
 	    {
 	      for (slice = 0; slice < MAX_SLICERS; slice++) {
@@ -426,6 +441,12 @@ a good modem here and providing a result when it is received.
  *		For each valid frame, process_rec_frame()
  *		is called for further processing.
  *
+ *		The search for the start of HDLC, FX.25, and IL2P frames
+ *		is all done here, from one bit history for each slicer.
+ *		FX.25 and IL2P decoders see bits only after finding their
+ *		correlation tag or sync word.  Searching for either one
+ *		can be turned off for a channel.
+ *
  ***********************************************************************************/
 
 void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled, int not_used_remove)
@@ -433,6 +454,7 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 
 	int dbit;			/* Data bit after undoing NRZI. */
 					/* Should be only 0 or 1. */
+	unsigned char pat_det;		/* Most recent 8 data bits. */
 	struct hdlc_state_s *H;
 
 	assert (was_init == 1);
@@ -492,31 +514,56 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 	  H->prev_raw = raw;
 	}
 
-// After BER insertion, NRZI, and any descrambling, feed into FX.25 decoder as well.
-// Don't waste time on this if AIS.  EAS does not get this far.
-
-	if (g_audio_p->achan[chan].modem_type != MODEM_AIS) {
-	  fx25_rec_bit (chan, subchan, slice, dbit);
-	  il2p_rec_bit (chan, subchan, slice, raw);	// Note: skip NRZI.
-	}
-
 /*
  * Octets are sent LSB first.
- * Shift the most recent 8 bits thru the pattern detector.
+ * Shift the most recent bits thru the pattern detectors.
  */
-	H->pat_det >>= 1;
+	H->dhist >>= 1;
 	if (dbit) {
-	  H->pat_det |= 0x80;
+	  H->dhist |= 1ULL << 63;
 	}
+	pat_det = H->dhist >> 56;
 
-	H->flag4_det >>= 1;
-	if (dbit) {
-	  H->flag4_det |= 0x80000000;
+	H->rhist = (H->rhist << 1) | raw;
+
+// After BER insertion, NRZI, and any descrambling, look for FX.25 and IL2P too.
+// Only one test per bit for each until something is found.
+
+	if (H->fx25_busy) {
+	  H->fx25_busy = fx25_rec_bit (chan, subchan, slice, dbit);
+	}
+	else if (sync_fx25[chan]) {
+	  int c = fx25_tag_find_match (H->dhist);
+	  if (c >= CTAG_MIN) {
+	    fx25_rec_tag (chan, subchan, slice, c, H->dhist);
+	    H->fx25_busy = 1;
+	  }
+	}
+
+	if (H->il2p_busy) {
+	  H->il2p_busy = il2p_rec_bit (chan, subchan, slice, raw);	// Note: skip NRZI.
+	}
+	else if (sync_il2p[chan]) {
+
+	  // Allow a single bit mismatch, with either polarity.
+	  // No more than one bit set means zero or a power of 2.
+
+	  unsigned int x = (H->rhist ^ IL2P_SYNC_WORD) & 0x00ffffff;
+	  unsigned int y = x ^ 0x00ffffff;
+
+	  if ((x & (x - 1)) == 0) {
+	    il2p_rec_sync (chan, subchan, slice, 0);
+	    H->il2p_busy = 1;
+	  }
+	  else if ((y & (y - 1)) == 0) {
+	    il2p_rec_sync (chan, subchan, slice, 1);
+	    H->il2p_busy = 1;
+	  }
 	}
 
 	rrbb_append_bit (H->rrbb, raw);
 
-	if (H->pat_det == 0x7e) {
+	if (pat_det == 0x7e) {
 
 	  rrbb_chop8 (H->rrbb);
 
@@ -618,7 +665,7 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 
 #if EXPERIMENT12B
 
-	else if (H->pat_det == 0xff) {
+	else if (pat_det == 0xff) {
 
 /*
  * Valid data will never have seven 1 bits in a row.
@@ -639,7 +686,7 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
  */
 
 #else
-	else if (H->pat_det == 0xfe) {
+	else if (pat_det == 0xfe) {
 
 /*
  * Valid data will never have 7 one bits in a row.
@@ -657,7 +704,7 @@ void hdlc_rec_bit (int chan, int subchan, int slice, int raw, int is_scrambled,
 	  rrbb_clear (H->rrbb, is_scrambled, H->lfsr, H->prev_descram); 
 
 	}
-	else if ( (H->pat_det & 0xfc) == 0x7c ) {
+	else if ( (pat_det & 0xfc) == 0x7c ) {
 
 /*
  * If we have five '1' bits in a row, followed by a '0' bit,
@@ -115,6 +115,75 @@ int layer2_send_frame (int chan, packet_t pp, int bad_fcs, struct audio_s *audio
 
 
 
+/*-------------------------------------------------------------
+ *
+ * Name:	layer2_frame_bits
+ *
+ * Purpose:	Find how long a frame will take to send, without sending it.
+ *
+ * Inputs:	chan	- Audio channel number, 0 = first.
+ *
+ *		pp	- Packet object.
+ *
+ *		audio_config_p - Configuration for audio and modems.
+ *
+ * Returns:	Number of bits that layer2_send_frame would send.
+ *
+ * Description:	The transmit thread uses this to decide which frames
+ *		will fit into the remaining time for one transmission.
+ *		The encoding is the same as above, including fall back
+ *		to AX.25 when FX.25 or IL2P can't be used.
+ *
+ *--------------------------------------------------------------*/
+
+int layer2_frame_bits (int chan, packet_t pp, struct audio_s *audio_config_p)
+{
+	unsigned char fbuf[AX25_MAX_PACKET_LEN+2];
+	int flen = ax25_pack (pp, fbuf);
+	int fcs = fcs_calc (fbuf, flen);
+	fbuf[flen++] = fcs & 0xff;
+	fbuf[flen++] = (fcs >> 8) & 0xff;
+
+	if (audio_config_p->achan[chan].layer2_xmit == LAYER2_IL2P) {
+	  unsigned char encoded[IL2P_MAX_PACKET_SIZE];
+	  int elen = il2p_encode_frame (pp, audio_config_p->achan[chan].il2p_max_fec, encoded);
+	  if (elen > 0) {
+	    return ((1 + IL2P_SYNC_WORD_SIZE + elen) * 8);	// preamble, sync word, header & payload.
+	  }
+	}
+
+// Count the stuffing bits.  Needed for both AX.25 and FX.25.
+
+	int nbits = 0;
+	int ones = 0;
+	for (int j = 0; j < flen; j++) {
+	  for (int k = 0; k < 8; k++) {
+	    nbits++;
+	    if ((fbuf[j] >> k) & 1) {
+	      ones++;
+	      if (ones == 5) {
+	        nbits++;
+	        ones = 0;
+	      }
+	    }
+	    else {
+	      ones = 0;
+	    }
+	  }
+	}
+
+	if (audio_config_p->achan[chan].layer2_xmit == LAYER2_FX25) {
+	  int dlen = (8 + nbits + 8 + 7) / 8;		// start flag, stuffed data & FCS, end flag.
+	  int ctag_num = fx25_pick_mode (audio_config_p->achan[chan].fx25_strength, dlen);
+	  if (ctag_num >= CTAG_MIN && ctag_num <= CTAG_MAX) {
+	    return ((8 + fx25_get_k_data_radio(ctag_num) + fx25_get_nroots(ctag_num)) * 8);
+	  }
+	}
+
+	return (8 + nbits + 8);				// start flag, end flag.
+}
+
+
 static int ax25_only_hdlc_send_frame (int chan, unsigned char *fbuf, int flen, int bad_fcs)
 {
 	int j, fcs;
@@ -13,6 +13,8 @@
 
 int layer2_send_frame (int chan, packet_t pp, int bad_fcs, struct audio_s *audio_config_p);
 
+int layer2_frame_bits (int chan, packet_t pp, struct audio_s *audio_config_p);
+
 int layer2_preamble_postamble (int chan, int flags, int finish, struct audio_s *audio_config_p);
 
 int eas_send (int chan, unsigned char *str, int repeat, int txdelay, int txtail);
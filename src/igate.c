@@ -298,6 +298,9 @@ static struct igate_config_s	*save_igate_config_p;
 static struct digi_config_s 	*save_digi_config_p;
 static int 			s_debug;
 
+static int s_connect_started = 0;	/* Server connection threads are running. */
+static int s_satgate_started = 0;	/* SATgate delay thread is running. */
+
 
 /*
  * Statistics for IGate function.
@@ -499,6 +502,7 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 	  return;
 	}
 #endif
+	s_connect_started = 1;
 
 /*
  * This lets delayed packets continue after specified amount of time.
@@ -521,11 +525,61 @@ void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_
 	  }
 #endif
 	  dw_mutex_init(&dp_mutex);
+	  s_satgate_started = 1;
 	}
 
 } /* end igate_init */
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        igate_reconfig
+ *
+ * Purpose:     Switch to a new configuration after the configuration
+ *		file has been read again.
+ *
+ * Inputs:	p_igate_config	- New IGate configuration.
+ *
+ *		p_digi_config	- New digipeater configuration.
+ *				  All we care about here is the packet filtering options.
+ *
+ * Returns:	0 for success.
+ *		-1 if the new IGate configuration needs a connection to
+ *		a server which was not started at application start up time.
+ *		-2 if it needs the SATgate delay thread which was not started.
+ *		In these cases, only the packet filters are changed.
+ *
+ * Description:	This is called from the receive queue processing thread
+ *		so it can't happen in the middle of processing a received packet.
+ *		The previous configuration is not freed because the other
+ *		IGate threads might still be looking at it.
+ *
+ *		A changed server name, login, or server side filter
+ *		takes effect the next time we connect to the server.
+ *
+ *--------------------------------------------------------------------*/
+
+int igate_reconfig (struct igate_config_s *p_igate_config, struct digi_config_s *p_digi_config)
+{
+	save_digi_config_p = p_digi_config;
+
+	if ( ! s_connect_started &&
+	    strlen(p_igate_config->t2_server_name) > 0 &&
+	    strlen(p_igate_config->t2_login) > 0 &&
+	    strlen(p_igate_config->t2_passcode) > 0) {
+	  return (-1);
+	}
+
+	if ( ! s_satgate_started && p_igate_config->satgate_delay > 0) {
+	  return (-2);
+	}
+
+	save_igate_config_p = p_igate_config;
+	return (0);
+
+} /* end igate_reconfig */
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        connnect_thread
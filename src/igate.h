@@ -103,6 +103,10 @@ struct igate_config_s {
 
 void igate_init (struct audio_s *p_audio_config, struct igate_config_s *p_igate_config, struct digi_config_s *p_digi_config, int debug_level);
 
+/* Call this after the configuration file has been read again. */
+
+int igate_reconfig (struct igate_config_s *p_igate_config, struct digi_config_s *p_digi_config);
+
 /* Call this with each packet received from the radio. */
 
 void igate_send_rec_packet (int chan, packet_t recv_pp);
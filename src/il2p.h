@@ -52,7 +52,9 @@ extern void il2p_set_debug(int debug);
 
 // Receives a bit stream from demodulator.
 
-extern void il2p_rec_bit (int chan, int subchan, int slice, int dbit);
+extern int il2p_rec_bit (int chan, int subchan, int slice, int dbit);
+
+extern void il2p_rec_sync (int chan, int subchan, int slice, int polarity);
 
 
 
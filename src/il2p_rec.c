@@ -71,6 +71,8 @@ struct il2p_context_s {
 
 static struct il2p_context_s *il2p_context[MAX_CHANS][MAX_SUBCHANS][MAX_SLICERS];
 
+static struct il2p_context_s *get_context (int chan, int subchan, int slice);
+
 
 
 /***********************************************************************************
@@ -87,27 +89,23 @@ static struct il2p_context_s *il2p_context[MAX_CHANS][MAX_SUBCHANS][MAX_SLICERS]
  *
  *              dbit	- One bit from the received data stream.
  *
+ * Returns:	True while a header or payload is being gathered.
+ *		False when searching for the sync word.
+ *
  * Description: This is called once for each received bit.
  *              For each valid packet, process_rec_frame() is called for further processing.
  *		It can gather multiple candidates from different parallel demodulators
  *		("subchannels") and slicers, then decide which one is the best.
  *
+ *		hdlc_rec_bit looks for the sync word itself and calls
+ *		il2p_rec_sync when it is found.  After that it sends bits
+ *		here only until this returns false.
+ *
  ***********************************************************************************/
 
-void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
+int il2p_rec_bit (int chan, int subchan, int slice, int dbit)
 {
-
-// Allocate context blocks only as needed.
-
-	struct il2p_context_s *F = il2p_context[chan][subchan][slice];
-	if (F == NULL) {
-          assert (chan >= 0 && chan < MAX_CHANS);
-          assert (subchan >= 0 && subchan < MAX_SUBCHANS);
-          assert (slice >= 0 && slice < MAX_SLICERS);
-	  F = il2p_context[chan][subchan][slice] = (struct il2p_context_s *)malloc(sizeof (struct il2p_context_s));
-	  assert (F != NULL);
-	  memset (F, 0, sizeof(struct il2p_context_s));
-	}
+	struct il2p_context_s *F = get_context (chan, subchan, slice);
 
 // Accumulate most recent 24 bits received.  Most recent is LSB.
 
@@ -270,7 +268,50 @@ void il2p_rec_bit (int chan, int subchan, int slice, int dbit)
 
 	} // end of switch
 
+	return (F->state != IL2P_SEARCHING);
+
 } // end il2p_rec_bit
 
 
+/***********************************************************************************
+ *
+ * Name:        il2p_rec_sync
+ *
+ * Purpose:     Start gathering the header after the sync word was found.
+ *
+ * Inputs:      chan, subchan, slice
+ *
+ *              polarity - 0 for the sync word as expected.
+ *			   1 if it was inverted.
+ *
+ ***********************************************************************************/
+
+void il2p_rec_sync (int chan, int subchan, int slice, int polarity)
+{
+	struct il2p_context_s *F = get_context (chan, subchan, slice);
+
+	F->polarity = polarity;
+	F->state = IL2P_HEADER;
+	F->bc = 0;
+	F->hc = 0;
+}
+
+
+// Allocate context blocks only as needed.
+
+static struct il2p_context_s *get_context (int chan, int subchan, int slice)
+{
+	struct il2p_context_s *F = il2p_context[chan][subchan][slice];
+	if (F == NULL) {
+          assert (chan >= 0 && chan < MAX_CHANS);
+          assert (subchan >= 0 && subchan < MAX_SUBCHANS);
+          assert (slice >= 0 && slice < MAX_SLICERS);
+	  F = il2p_context[chan][subchan][slice] = (struct il2p_context_s *)malloc(sizeof (struct il2p_context_s));
+	  assert (F != NULL);
+	  memset (F, 0, sizeof(struct il2p_context_s));
+	}
+	return (F);
+}
+
+
 // end il2p_rec.c
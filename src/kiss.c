@@ -396,6 +396,15 @@ void kisspt_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf,  int f
 	  return;
 	}
 
+	// Capture time only if the client asked for it.
+
+	if (kiss_cmd == KISS_CMD_RX_TIME) {
+	  if ( ! kf.rx_time) {
+	    return;
+	  }
+	  kiss_cmd = KISS_CMD_SET_HARDWARE;
+	}
+
 	if (flen < 0) {
 	  flen = strlen((char*)fbuf);
 	  if (kisspt_debug) {
@@ -459,25 +468,23 @@ void kisspt_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf,  int f
  *
  * Name:        kisspt_get
  *
- * Purpose:     Read one byte from the KISS client app.
+ * Purpose:     Read a block of bytes from the KISS client app.
+ *
+ * Inputs:	buf	- Where to put the bytes.
+ *		size	- Size of buf.
  *
  * Global In:	pt_master_fd
  *
- * Returns:	one byte (value 0 - 255) or terminate thread on error.
+ * Returns:	Number of bytes read, at least 1, or terminate thread on error.
  *
- * Description:	There is room for improvement here.  Reading one byte
- *		at a time is inefficient.  We could read a large block
- *		into a local buffer and return a byte from that most of the time.
- *		Is it worth the effort?  I don't know.  With GHz processors and
- *		the low data rate here it might not make a noticeable difference.
+ * Description:	Wait for at least one byte and take whatever else
+ *		has already arrived rather than one byte per system call.
  *
  *--------------------------------------------------------------------*/
 
 
-static int kisspt_get (void)
+static int kisspt_get (unsigned char *buf, int size)
 {
-	unsigned char ch;
-
 	int n = 0;
 	fd_set fd_in, fd_ex;
 	int rc;
@@ -542,7 +549,7 @@ static int kisspt_get (void)
 	  }
 
 	  if (rc == -1
-	      || (n = read(pt_master_fd, &ch, (size_t)1)) != 1)
+	      || (n = read(pt_master_fd, buf, (size_t)size)) <= 0)
 	  {
 
 	    text_color_set(DW_COLOR_ERROR);
@@ -559,10 +566,10 @@ static int kisspt_get (void)
 
 #if DEBUGx
 	text_color_set(DW_COLOR_DEBUG);
-	dw_printf ("kisspt_get(%d) returns 0x%02x\n", fd, ch);
+	dw_printf ("kisspt_get(%d) returns %d bytes\n", fd, n);
 #endif
 
-	return (ch);
+	return (n);
 }
 
 
@@ -575,13 +582,14 @@ static int kisspt_get (void)
  * Global In:
  *
  * Description:	Reads bytes from the KISS client app and
- *		sends them to kiss_rec_byte for processing.
+ *		sends them to kiss_rec_bytes for processing.
  *
  *--------------------------------------------------------------------*/
 
 static void * kisspt_listen_thread (void *arg)
 {
-	unsigned char ch;
+	unsigned char buf[MAX_KISS_LEN];
+	int n;
 			
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -590,8 +598,8 @@ static void * kisspt_listen_thread (void *arg)
 
 
 	while (1) {
-	  ch = kisspt_get();
-	  kiss_rec_byte (&kf, ch, kisspt_debug, NULL, -1, kisspt_send_rec_packet);
+	  n = kisspt_get (buf, sizeof(buf));
+	  kiss_rec_bytes (&kf, buf, n, kisspt_debug, NULL, -1, kisspt_send_rec_packet);
 	}
 
 	return (void *) 0;	/* Unreachable but avoids compiler warning. */
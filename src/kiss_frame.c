@@ -130,7 +130,28 @@ void hex_dump (unsigned char *p, int len)
 
 #if KISSTEST
 
-#define dw_printf printf
+#include <stdarg.h>
+
+/* Count messages, rather than printing, when checking error reports. */
+
+static int test_quiet = 0;
+static int test_messages = 0;
+
+static int test_printf (const char *fmt, ...)
+{
+	va_list args;
+	int n = 0;
+
+	test_messages++;
+	if ( ! test_quiet) {
+	  va_start (args, fmt);
+	  n = vprintf (fmt, args);
+	  va_end (args);
+	}
+	return (n);
+}
+
+#define dw_printf test_printf
 
 void text_color_set (dw_color_t c)
 {
@@ -141,7 +162,7 @@ void text_color_set (dw_color_t c)
 
 #ifndef DECAMAIN
 #ifndef KISSUTIL
-static void kiss_set_hardware (int chan, char *command, int debug, struct kissport_status_s *kps, int client,
+static void kiss_set_hardware (kiss_frame_t *kf, int chan, char *command, int debug, struct kissport_status_s *kps, int client,
 		void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient));
 #endif
 #endif
@@ -294,12 +315,21 @@ int kiss_unwrap (unsigned char *in, int ilen, unsigned char *out)
 	  j = 0;
 	}
 
-	for ( ; j<ilen; j++) {
+/*
+ * A FEND in the middle is an error but it is otherwise treated like any
+ * other byte.  Check for that up front so the loop below only has to
+ * look for FESC.  memchr is much faster than testing one byte at a time.
+ */
+	unsigned char *p = in + j;
+	unsigned char *end = in + ilen;
 
-	  if (in[j] == FEND) {
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("KISS frame should not have FEND in the middle.\n");
-	  }
+	while ((p = memchr(p, FEND, end - p)) != NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("KISS frame should not have FEND in the middle.\n");
+	  p++;
+	}
+
+	while (j < ilen) {
 
 	  if (escaped_mode) {
 
@@ -314,12 +344,22 @@ int kiss_unwrap (unsigned char *in, int ilen, unsigned char *out)
 	      dw_printf ("KISS protocol error.  Found 0x%02x after FESC.\n", in[j]);
 	    }
 	    escaped_mode = 0;
+	    j++;
+	    continue;
 	  }
-	  else if (in[j] == FESC) {
+
+	  /* Copy everything up to the next FESC, or the end, in one piece. */
+
+	  unsigned char *e = memchr(in + j, FESC, ilen - j);
+	  int run = (e != NULL) ? (int)(e - (in + j)) : ilen - j;
+
+	  memcpy (out + olen, in + j, run);
+	  olen += run;
+	  j += run;
+
+	  if (e != NULL) {
 	    escaped_mode = 1;
-	  }
-	  else {
-	    out[olen++] = in[j];
+	    j++;
 	  }
 	}
 	
@@ -330,8 +370,6 @@ int kiss_unwrap (unsigned char *in, int ilen, unsigned char *out)
 
 #ifndef DECAMAIN
 
-#ifndef KISSTEST
-
 
 
 /*-------------------------------------------------------------------
@@ -457,6 +495,14 @@ void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug,
 		/* Empty frame.  Just go on collecting. */
 	        return;
 	      }
+	      if (kf->kiss_len >= MAX_KISS_LEN) {
+		/* Too long.  No room for the FEND so discard it. */
+		/* Might have been reported already but not if it filled the buffer exactly. */
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("KISS message exceeded maximum length.\n");
+	        kf->state = KS_SEARCHING;
+	        return;
+	      }
 
 	      kf->kiss_msg[kf->kiss_len++] = ch;
 	      if (debug) {
@@ -476,7 +522,7 @@ void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug,
 	        hex_dump (unwrapped+1, ulen-1);
 	      }
 
-	      kiss_process_msg (unwrapped, ulen, debug, kps, client, sendfun);
+	      kiss_process_msg (kf, unwrapped, ulen, debug, kps, client, sendfun);
 
 	      kf->state = KS_SEARCHING;
 	      return;
@@ -496,8 +542,77 @@ void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug,
 	return;	/* unreachable but suppress compiler warning. */
 
 } /* end kiss_rec_byte */   
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        kiss_rec_bytes
+ *
+ * Purpose:     Process a block of bytes from a KISS client app.
+ *
+ * Inputs:	kf	- Current state of building a frame.
+ *		buf	- Bytes from the input stream.
+ *		len	- Number of bytes in buf.
+ *		debug, kps, client, sendfun - Same as kiss_rec_byte.
+ *
+ * Outputs:	kf	- Current state is updated.
+ *
+ * Returns:	none.
+ *
+ * Description:	The result is exactly the same as calling kiss_rec_byte
+ *		for each byte but it is much faster for the common case.
+ *		While collecting a frame, the only byte of interest is
+ *		the ending FEND.  Everything up to that is copied in one
+ *		piece.  Noise between frames is rare and short so it
+ *		still goes through kiss_rec_byte one byte at a time.
+ *
+ *-----------------------------------------------------------------*/
+
+void kiss_rec_bytes (kiss_frame_t *kf, unsigned char *buf, int len, int debug,
+			struct kissport_status_s *kps, int client,
+			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient))
+{
+	int j = 0;
+
+	while (j < len) {
+
+	  if (kf->state != KS_COLLECTING) {
+	    kiss_rec_byte (kf, buf[j], debug, kps, client, sendfun);
+	    j++;
+	    continue;
+	  }
+
+	  unsigned char *e = memchr(buf + j, FEND, len - j);
+	  int run = (e != NULL) ? (int)(e - (buf + j)) : len - j;
+
+	  if (run > 0) {
+	    int room = MAX_KISS_LEN - kf->kiss_len;
+
+	    if (run <= room) {
+	      memcpy (kf->kiss_msg + kf->kiss_len, buf + j, run);
+	      kf->kiss_len += run;
+	    }
+	    else {
+	      memcpy (kf->kiss_msg + kf->kiss_len, buf + j, room);
+	      kf->kiss_len += room;
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("KISS message exceeded maximum length.\n");
+	    }
+	    j += run;
+	  }
+
+	  if (e != NULL) {
+	    kiss_rec_byte (kf, FEND, debug, kps, client, sendfun);
+	    j++;
+	  }
+	}
+
+} /* end kiss_rec_bytes */
 	      	    
 
+#ifndef KISSTEST
+
 
 
 /*-------------------------------------------------------------------
@@ -506,7 +621,10 @@ void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug,
  *
  * Purpose:     Process a message from the KISS client.
  *
- * Inputs:	kiss_msg	- Kiss frame with FEND and escapes removed.
+ * Inputs:	kf		- Decoder state for this client.
+ *				  Also holds options set by the client.
+ *
+ *		kiss_msg	- Kiss frame with FEND and escapes removed.
  *				  The first byte contains channel and command.
  *
  *		kiss_len	- Number of bytes including the command.
@@ -531,7 +649,7 @@ void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug,
 
 // This is used only by the TNC side.
 
-void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
+void kiss_process_msg (kiss_frame_t *kf, unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
 			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *kps, int client))
 {
 	int chan;
@@ -744,7 +862,7 @@ void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct
 	  kiss_msg[kiss_len] = '\0';
           text_color_set(DW_COLOR_INFO);
 	  dw_printf ("KISS protocol set hardware \"%s\", chan %d\n", (char*)(kiss_msg+1), chan);
-	  kiss_set_hardware (chan, (char*)(kiss_msg+1), debug, kps, client, sendfun);
+	  kiss_set_hardware (kf, chan, (char*)(kiss_msg+1), debug, kps, client, sendfun);
 	  break;
 
         case KISS_CMD_END_KISS:			/* 15 = End KISS mode, channel should be 15. */
@@ -786,7 +904,10 @@ void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct
  *
  * Purpose:     Process the "set hardware" command.
  *
- * Inputs:	chan		- channel, 0 - 15.
+ * Inputs:	kf		- Decoder state for the client.  Options, set by
+ *				  the client, are kept here.
+ *
+ *		chan		- channel, 0 - 15.
  *
  *		command		- All but the first byte.  e.g.  "TXBUF:99"
  *				  Case sensitive.
@@ -852,7 +973,22 @@ void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct
  *
  * Commands:	(Client to TNC, with parameter(s) to set something.)
  *
- *			none yet
+ *			Command		Response		Comment
+ *			-------		--------		-------
+ *
+ *			TIMESTAMP:ON	TIMESTAMP:ON		Send capture time before each received frame.
+ *			TIMESTAMP:OFF	TIMESTAMP:OFF		Stop doing that.  This is the default.
+ *
+ *		With TIMESTAMP on, each received data frame is preceded by a Set
+ *		Hardware frame, on the same channel, such as
+ *
+ *			RXTIME:1700000000.081734
+ *
+ *		This is when the end of the frame was captured by the audio device,
+ *		in seconds since 1970-01-01 UTC.  It is not affected by demodulator,
+ *		queuing, or processing delays so it is suitable for time difference
+ *		of arrival and latency measurements.  Nothing is sent if the time
+ *		is not known, e.g. for frames from another network interface.
  *
  * Queries:	(Client to TNC, no parameters, generate a response.)
  *
@@ -863,11 +999,13 @@ void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct
  *
  *			TXBUF:		TXBUF:999		Number of bytes (not frames) in transmit queue.
  *
+ *			TIMESTAMP:	TIMESTAMP:ON or OFF	Current setting.
+ *
  *--------------------------------------------------------------------*/
 
 #ifndef KISSUTIL
 
-static void kiss_set_hardware (int chan, char *command, int debug, struct kissport_status_s *kps, int client,
+static void kiss_set_hardware (kiss_frame_t *kf, int chan, char *command, int debug, struct kissport_status_s *kps, int client,
 		void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient))
 {
 	char *param;
@@ -901,6 +1039,23 @@ static void kiss_set_hardware (int chan, char *command, int debug, struct kisspo
 	    (*sendfun) (chan, KISS_CMD_SET_HARDWARE, (unsigned char *)response, strlen(response), kps, client);
 	  }
 
+	  else if (strcmp(command, "TIMESTAMP") == 0) {	/* TIMESTAMP - Capture time of received frames. */
+
+	    if (strcasecmp(param, "ON") == 0 || strcmp(param, "1") == 0) {
+	      kf->rx_time = 1;
+	    }
+	    else if (strcasecmp(param, "OFF") == 0 || strcmp(param, "0") == 0) {
+	      kf->rx_time = 0;
+	    }
+	    else if (strlen(param) > 0) {
+              text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("KISS Set Hardware TIMESTAMP: Expected ON or OFF, not \"%s\".\n", param);
+	    }
+
+	    snprintf (response, sizeof(response), "TIMESTAMP:%s", kf->rx_time ? "ON" : "OFF");
+	    (*sendfun) (chan, KISS_CMD_SET_HARDWARE, (unsigned char *)response, strlen(response), kps, client);
+	  }
+
 	  else {
             text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("KISS Set Hardware unrecognized command: %s.\n", command);
@@ -974,7 +1129,7 @@ void kiss_debug_print (fromto_t fromto, char *special, unsigned char *pmsg, int
 
 #endif /* DECAMAIN */
 
-/* Quick unit test for encapsulate & unwrap */
+/* Quick unit test for encapsulate & unwrap, and receive in pieces. */
 
 // $ gcc -DKISSTEST kiss_frame.c ; ./a
 // Quick KISS test passed OK.
@@ -983,6 +1138,163 @@ void kiss_debug_print (fromto_t fromto, char *special, unsigned char *pmsg, int
 #if KISSTEST
 
 
+/*
+ * Stand-ins for what kiss_rec_byte calls.
+ * Received frames are saved so the different ways of feeding the same
+ * stream can be compared.
+ */
+
+#define TEST_MAX_FRAMES 10
+
+static struct {
+	int count;
+	int len[TEST_MAX_FRAMES];
+	unsigned char msg[TEST_MAX_FRAMES][MAX_KISS_LEN];
+} rec;
+
+void kiss_process_msg (kiss_frame_t *kf, unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
+			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient))
+{
+	assert (rec.count < TEST_MAX_FRAMES);
+	rec.len[rec.count] = kiss_len;
+	memcpy (rec.msg[rec.count], kiss_msg, kiss_len);
+	rec.count++;
+}
+
+void kiss_debug_print (fromto_t fromto, char *special, unsigned char *pmsg, int msg_len)
+{
+}
+
+void hex_dump (unsigned char *p, int len)
+{
+}
+
+static void test_sendfun (int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient)
+{
+}
+
+
+/*
+ * kiss_rec_bytes must give exactly the same frames and leave the same state
+ * as kiss_rec_byte, no matter where the input is broken into pieces.
+ */
+
+static void rec_bytes_test (void)
+{
+	static unsigned char stream[3 * MAX_KISS_LEN + 200];
+	static kiss_frame_t expect_kf, kf;
+	static unsigned char expect_msg[TEST_MAX_FRAMES][MAX_KISS_LEN];
+	int expect_len[TEST_MAX_FRAMES];
+	int expect_count;
+	int slen = 0;
+	int k, split, chunk;
+
+	/* Noise, then empty frames. */
+	memcpy (stream + slen, "reset\r", 6);
+	slen += 6;
+	stream[slen++] = FEND;
+	stream[slen++] = FEND;
+	stream[slen++] = FEND;
+
+	/* Escapes, including FESC as the last byte before the FEND. */
+	unsigned char esc[] = { 0x00, 'a', FESC, TFEND, FESC, TFESC, 'b', FESC, TFEND };
+	memcpy (stream + slen, esc, sizeof(esc));
+	slen += sizeof(esc);
+	stream[slen++] = FEND;
+
+	/* Largest that fits.  Leading FEND, body, ending FEND fill kiss_msg. */
+	stream[slen++] = FEND;
+	stream[slen++] = 0x00;
+	for (k = 0; k < MAX_KISS_LEN - 3; k++) stream[slen++] = 'L';
+	stream[slen++] = FEND;
+
+	/* One more fills kiss_msg with no room for the ending FEND. */
+	stream[slen++] = FEND;
+	stream[slen++] = 0x00;
+	for (k = 0; k < MAX_KISS_LEN - 2; k++) stream[slen++] = 'X';
+	stream[slen++] = FEND;
+
+	/* Well past the limit. */
+	stream[slen++] = FEND;
+	stream[slen++] = 0x00;
+	for (k = 0; k < MAX_KISS_LEN + 50; k++) stream[slen++] = 'Y';
+	stream[slen++] = FEND;
+
+	/* Another good one, then an incomplete one ending in FESC. */
+	unsigned char last[] = { FEND, 0x00, 'z', FEND, FEND, 0x00, 'p', 'q', FESC };
+	memcpy (stream + slen, last, sizeof(last));
+	slen += sizeof(last);
+	assert (slen <= (int)sizeof(stream));
+
+	/* Frame that exactly fills kiss_msg must be reported, not silently dropped. */
+
+	unsigned char *full = stream + 6 + 3 + sizeof(esc) + 1 + MAX_KISS_LEN;
+	assert (full[0] == FEND && full[2] == 'X' && full[MAX_KISS_LEN] == FEND);
+
+	test_quiet = 1;
+	test_messages = 0;
+	memset (&rec, 0, sizeof(rec));
+	memset (&kf, 0, sizeof(kf));
+	for (k = 0; k <= MAX_KISS_LEN; k++) {
+	  kiss_rec_byte (&kf, full[k], 0, NULL, -1, test_sendfun);
+	}
+	assert (rec.count == 0 && test_messages == 1);
+
+	test_messages = 0;
+	memset (&kf, 0, sizeof(kf));
+	kiss_rec_bytes (&kf, full, MAX_KISS_LEN + 1, 0, NULL, -1, test_sendfun);
+	assert (rec.count == 0 && test_messages == 1);
+
+	/* Reference: one byte at a time. */
+
+	memset (&rec, 0, sizeof(rec));
+	memset (&expect_kf, 0, sizeof(expect_kf));
+	for (k = 0; k < slen; k++) {
+	  kiss_rec_byte (&expect_kf, stream[k], 0, NULL, -1, test_sendfun);
+	}
+	expect_count = rec.count;
+	memcpy (expect_len, rec.len, sizeof(expect_len));
+	memcpy (expect_msg, rec.msg, sizeof(expect_msg));
+
+	assert (expect_count == 3);
+	assert (expect_len[0] == 6 && memcmp(expect_msg[0], "\0a\xc0\xdb" "b\xc0", 6) == 0);
+	assert (expect_len[1] == MAX_KISS_LEN - 2 && expect_msg[1][MAX_KISS_LEN - 3] == 'L');
+	assert (expect_len[2] == 2 && memcmp(expect_msg[2], "\0z", 2) == 0);
+	assert (expect_kf.state == KS_COLLECTING && expect_kf.kiss_len == 5);
+
+	/* Two pieces, split at every possible place, then many equal size pieces. */
+
+	for (split = 0; split <= slen + 64; split++) {
+
+	  memset (&rec, 0, sizeof(rec));
+	  memset (&kf, 0, sizeof(kf));
+
+	  if (split <= slen) {
+	    kiss_rec_bytes (&kf, stream, split, 0, NULL, -1, test_sendfun);
+	    kiss_rec_bytes (&kf, stream + split, slen - split, 0, NULL, -1, test_sendfun);
+	  }
+	  else {
+	    chunk = split - slen;
+	    for (k = 0; k < slen; k += chunk) {
+	      kiss_rec_bytes (&kf, stream + k, k + chunk <= slen ? chunk : slen - k, 0, NULL, -1, test_sendfun);
+	    }
+	  }
+
+	  assert (rec.count == expect_count);
+	  for (k = 0; k < expect_count; k++) {
+	    assert (rec.len[k] == expect_len[k]);
+	    assert (memcmp(rec.msg[k], expect_msg[k], expect_len[k]) == 0);
+	  }
+	  assert (kf.state == expect_kf.state);
+	  assert (kf.kiss_len == expect_kf.kiss_len);
+	  assert (memcmp(kf.kiss_msg, expect_kf.kiss_msg, kf.kiss_len) == 0);
+	  assert (kf.noise_len == expect_kf.noise_len);
+	}
+
+	test_quiet = 0;
+}
+
+
 int main ()
 {
 	unsigned char din[512];
@@ -1012,6 +1324,24 @@ int main ()
 	assert (dlen == 512);
 	assert (memcmp(din, dout, 512) == 0);
 
+	/* Escapes back to back and at both ends. */
+
+	unsigned char esc_in[] = { FEND, FEND, FESC, FESC, 'a', FESC, 'b', 'c', FEND };
+	klen = kiss_encapsulate (esc_in, sizeof(esc_in), kissed);
+	assert (klen == (int)sizeof(esc_in) + 6 + 2);
+	dlen = kiss_unwrap (kissed, klen, dout);
+	assert (dlen == (int)sizeof(esc_in));
+	assert (memcmp(esc_in, dout, sizeof(esc_in)) == 0);
+
+	/* Invalid byte after FESC is dropped. */
+
+	unsigned char bad[] = { FEND, 0, 'x', FESC, 'y', 'z', FEND };
+	dlen = kiss_unwrap (bad, sizeof(bad), dout);
+	assert (dlen == 3);
+	assert (memcmp(dout, "\0xz", 3) == 0);
+
+	rec_bytes_test ();
+
 	dw_printf ("Quick KISS test passed OK.\n");
 	exit (EXIT_SUCCESS);
 }
@@ -25,6 +25,10 @@
 #define XKISS_CMD_POLL		14	// Not supported.
 #define KISS_CMD_END_KISS	15
 
+#define KISS_CMD_RX_TIME	0x106	// Not a real command.  Tells the send functions that
+					// this is SET_HARDWARE "RXTIME:..." which should go only
+					// to clients that asked for it with "TIMESTAMP:ON".
+
 
 
 /*
@@ -62,6 +66,9 @@ typedef struct kiss_frame_s {
 	unsigned char noise[MAX_NOISE_LEN];
 	int noise_len;
 
+	int rx_time;		/* Client wants capture time of received frames. */
+				/* Set with "TIMESTAMP:ON".  See kiss_set_hardware. */
+
 } kiss_frame_t;
 
 
@@ -112,9 +119,12 @@ int kiss_unwrap (unsigned char *in, int ilen, unsigned char *out);
 void kiss_rec_byte (kiss_frame_t *kf, unsigned char ch, int debug, struct kissport_status_s *kps, int client,
 			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient));
 
+void kiss_rec_bytes (kiss_frame_t *kf, unsigned char *buf, int len, int debug, struct kissport_status_s *kps, int client,
+			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient));
+
 typedef enum fromto_e { FROM_CLIENT=0, TO_CLIENT=1 } fromto_t;
 
-void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
+void kiss_process_msg (kiss_frame_t *kf, unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
 			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient));
 
 void kiss_debug_print (fromto_t fromto, char *special, unsigned char *pmsg, int msg_len);
@@ -719,9 +719,19 @@ void kissnet_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf, int f
 	          }
 	          else {
 	            unsigned char stemp[AX25_MAX_PACKET_LEN + 1];
+	            int cmd = kiss_cmd;
 
 	            assert (flen < (int)(sizeof(stemp)));
 
+	            // Capture time only to clients which asked for it.
+
+	            if (cmd == KISS_CMD_RX_TIME) {
+	              if ( ! kps->kf[client].rx_time) {
+	                continue;
+	              }
+	              cmd = KISS_CMD_SET_HARDWARE;
+	            }
+
 	            // New in 1.7.
 	            // Previously all channels were sent to everyone.
 	            // We now have tcp ports which carry only a single radio channel.
@@ -729,11 +739,11 @@ void kissnet_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf, int f
 
 	            if (kps->chan == -1) {
 	              // Normal case, all channels.
-	              stemp[0] = (chan << 4) | kiss_cmd;
+	              stemp[0] = (chan << 4) | cmd;
 	            }
 	            else if (kps->chan == chan) {
 	              // Single radio channel for this port.  Application sees 0.
-	              stemp[0] = (0 << 4) | kiss_cmd;
+	              stemp[0] = (0 << 4) | cmd;
 	            }
 	            else {
 	              // Skip it.
@@ -902,10 +912,10 @@ void kissnet_copy (unsigned char *in_msg, int in_len, int chan, int cmd, struct
  *--------------------------------------------------------------------*/
 
 
-/* Return one byte (value 0 - 255) */
+/* Return number of bytes placed in buf, at least 1. */
 
 
-static int kiss_get (struct kissport_status_s *kps, int client)
+static int kiss_get (struct kissport_status_s *kps, int client, unsigned char *buf, int size)
 {
 
 	while (1) {
@@ -914,26 +924,29 @@ static int kiss_get (struct kissport_status_s *kps, int client)
 	    SLEEP_SEC(1);			/* Not connected.  Try again later. */
 	  }
 
-	  /* Just get one byte at a time. */
+	  /* Take whatever has arrived rather than one byte per system call. */
 
-	  unsigned char ch;
-	  int n = SOCK_RECV (kps->client_sock[client], (char *)(&ch), 1);
+	  int n = SOCK_RECV (kps->client_sock[client], (char *)buf, size);
 
-	  if (n == 1) {
+	  if (n > 0) {
 #if DEBUG9
-	    dw_printf (log_fp, "%02x %c %c", ch, 
+	    int k;
+	    for (k = 0; k < n; k++) {
+	      unsigned char ch = buf[k];
+	      dw_printf (log_fp, "%02x %c %c", ch, 
 			isprint(ch) ? ch : '.' , 
 			(isupper(ch>>1) || isdigit(ch>>1) || (ch>>1) == ' ') ? (ch>>1) : '.');
-	    if (ch == FEND) fprintf (log_fp, "  FEND");
-	    if (ch == FESC) fprintf (log_fp, "  FESC");
-	    if (ch == TFEND) fprintf (log_fp, "  TFEND");
-	    if (ch == TFESC) fprintf (log_fp, "  TFESC");
-	    if (ch == '\r') fprintf (log_fp, "  CR");
-	    if (ch == '\n') fprintf (log_fp, "  LF");
-	    fprintf (log_fp, "\n");
-	    if (ch == FEND) fflush (log_fp);
+	      if (ch == FEND) fprintf (log_fp, "  FEND");
+	      if (ch == FESC) fprintf (log_fp, "  FESC");
+	      if (ch == TFEND) fprintf (log_fp, "  TFEND");
+	      if (ch == TFESC) fprintf (log_fp, "  TFESC");
+	      if (ch == '\r') fprintf (log_fp, "  CR");
+	      if (ch == '\n') fprintf (log_fp, "  LF");
+	      fprintf (log_fp, "\n");
+	      if (ch == FEND) fflush (log_fp);
+	    }
 #endif
-	    return(ch);	
+	    return(n);	
 	  }
 
           text_color_set(DW_COLOR_ERROR);
@@ -979,8 +992,9 @@ static THREAD_F kissnet_listen_thread (void *arg)
 
 
 	while (1) {
-	  unsigned char ch = kiss_get(kps, client);
-	  kiss_rec_byte (&(kps->kf[client]), ch, kiss_debug, kps, client, kissnet_send_rec_packet);
+	  unsigned char buf[MAX_KISS_LEN];
+	  int n = kiss_get(kps, client, buf, sizeof(buf));
+	  kiss_rec_bytes (&(kps->kf[client]), buf, n, kiss_debug, kps, client, kissnet_send_rec_packet);
 	}  
 
 #if __WIN32__
@@ -287,6 +287,15 @@ void kissserial_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf,  i
 	if (serialport_fd == MYFDERROR) {
 	  return;
 	}
+
+	// Capture time only if the client asked for it.
+
+	if (kiss_cmd == KISS_CMD_RX_TIME) {
+	  if ( ! kf.rx_time) {
+	    return;
+	  }
+	  kiss_cmd = KISS_CMD_SET_HARDWARE;
+	}
 	
 	if (flen < 0) {
 	  flen = strlen((char*)fbuf);
@@ -366,33 +375,33 @@ void kissserial_send_rec_packet (int chan, int kiss_cmd, unsigned char *fbuf,  i
  *
  * Name:        kissserial_get
  *
- * Purpose:     Read one byte from the KISS client app.
+ * Purpose:     Read a block of bytes from the KISS client app.
+ *
+ * Inputs:	buf	- Where to put the bytes.
+ *		size	- Size of buf.
  *
  * Global In:	serialport_fd
  *
- * Returns:	one byte (value 0 - 255) or terminate thread on error.
+ * Returns:	Number of bytes read, at least 1, or terminate thread on error.
  *
- * Description:	There is room for improvement here.  Reading one byte
- *		at a time is inefficient.  We could read a large block
- *		into a local buffer and return a byte from that most of the time.
- *		Is it worth the effort?  I don't know.  With GHz processors and
- *		the low data rate here it might not make a noticeable difference.
+ * Description:	Wait for at least one byte and take whatever else
+ *		has already arrived rather than one byte per system call.
  *
  *--------------------------------------------------------------------*/
 
 
-static int kissserial_get (void)
+static int kissserial_get (unsigned char *buf, int size)
 {
-	int ch;		// normally 0-255 but -1 for error.
+	int n;		// number of bytes or -1 for error.
 
 
 	if (g_misc_config_p->kiss_serial_poll == 0) {
 /*
  * Normal case, was opened at start up time.
  */  
-	  ch = serial_port_get1 (serialport_fd);
+	  n = serial_port_get (serialport_fd, buf, size);
 
-	  if (ch < 0) {
+	  if (n < 0) {
 
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("\nSerial Port KISS read error. Closing connection.\n\n");
@@ -407,9 +416,9 @@ static int kissserial_get (void)
 
 #if DEBUGx
 	  text_color_set(DW_COLOR_DEBUG);
-	  dw_printf ("kissserial_get(%d) returns 0x%02x\n", fd, ch);
+	  dw_printf ("kissserial_get(%d) returns %d bytes\n", fd, n);
 #endif
-	  return (ch);
+	  return (n);
 	}
 
 /*
@@ -421,10 +430,10 @@ static int kissserial_get (void)
 
 	    // Open, try to read.
 
-	    ch = serial_port_get1 (serialport_fd);
+	    n = serial_port_get (serialport_fd, buf, size);
 
-	    if (ch >= 0) {
-	       return (ch);
+	    if (n > 0) {
+	       return (n);
 	    }
 
 	    text_color_set(DW_COLOR_ERROR);
@@ -472,8 +481,8 @@ static int kissserial_get (void)
  * Global In:	serialport_fd  
  *
  * Description:	Reads bytes from the serial port KISS client app and
- *		sends them to kiss_rec_byte for processing.
- *		kiss_rec_byte is a common function used by all 3 KISS
+ *		sends them to kiss_rec_bytes for processing.
+ *		kiss_rec_bytes is a common function used by all 3 KISS
  *		interfaces: serial port, pseudo terminal, and TCP.
  *
  *--------------------------------------------------------------------*/
@@ -481,7 +490,8 @@ static int kissserial_get (void)
 
 static THREAD_F kissserial_listen_thread (void *arg)
 {
-	unsigned char ch;
+	unsigned char buf[MAX_KISS_LEN];
+	int n;
 			
 #if DEBUG
 	text_color_set(DW_COLOR_DEBUG);
@@ -489,8 +499,8 @@ static THREAD_F kissserial_listen_thread (void *arg)
 #endif
 
 	while (1) {
-	  ch = kissserial_get();
-	  kiss_rec_byte (&kf, ch, kissserial_debug, NULL, -1, kissserial_send_rec_packet);
+	  n = kissserial_get (buf, sizeof(buf));
+	  kiss_rec_bytes (&kf, buf, n, kissserial_debug, NULL, -1, kissserial_send_rec_packet);
 	}
 
 #if __WIN32__
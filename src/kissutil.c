@@ -46,7 +46,6 @@
 #else 
 
 #include <stdlib.h>
-#include <errno.h>
 #include <sys/types.h>
 #include <sys/socket.h>
 
@@ -54,6 +53,7 @@
 
 #include <unistd.h>
 #include <stdio.h>
+#include <errno.h>
 #include <assert.h>
 #include <ctype.h>
 #include <stddef.h>
@@ -62,6 +62,10 @@
 #include <dirent.h>
 #include <sys/stat.h>
 
+#if __linux__
+#include <sys/inotify.h>
+#endif
+
 #include "ax25_pad.h"
 #include "textcolor.h"
 #include "serial_port.h"
@@ -88,6 +92,7 @@ static THREAD_F tnc_listen_net (void *arg);
 static THREAD_F tnc_listen_serial (void *arg);
 
 static void send_to_kiss_tnc (int chan, int cmd, char *data, int dlen);
+static void flush_to_kiss_tnc (void);
 static void hex_dump (unsigned char *p, int len);
 
 static void usage(void);
@@ -154,6 +159,18 @@ static char timestamp_format[60] = "";		/* -T option */
 
 static void process_input (char *stuff);
 
+
+/*
+ * When processing the transmit queue directory, the KISS frames from one file
+ * are collected here and sent with as few writes as possible.
+ * Otherwise (stdin) each frame is sent right away.
+ */
+
+static int batching = 0;
+static unsigned char tx_batch[AX25_MAX_PACKET_LEN*4];
+static int tx_batch_len = 0;
+static int tx_writes = 0;		/* Number of socket / serial port writes, for statistics. */
+
 /* Trim any CR, LF from the end of line. */
 
 static void trim (char *stuff)
@@ -167,6 +184,193 @@ static void trim (char *stuff)
 } /* end trim */
 
 
+/*------------------------------------------------------------------
+ *
+ * Name: 	process_file
+ *
+ * Purpose:   	Send everything in one file from the transmit queue directory, then delete it.
+ *
+ * Inputs:	name	- File name, without the directory.
+ *
+ * Description:	All of the KISS frames from the file are collected and sent
+ *		with as few writes as possible.
+ *		Report how long it took, from when the file was last written,
+ *		until everything was handed over to the TNC.
+ *
+ *---------------------------------------------------------------*/
+
+static void process_file (char *name)
+{
+	char path [300];
+	char stuff[AX25_MAX_PACKET_LEN];
+	struct stat st;
+	double written;
+	FILE *fp;
+	int lines = 0;
+
+	strlcpy (path, transmit_from, sizeof(path));
+	strlcat (path, DIR_CHAR, sizeof(path));
+	strlcat (path, name, sizeof(path));
+
+	fp = fopen (path, "r");
+	if (fp == NULL) {
+	  if (errno != ENOENT) {	// Otherwise already processed, e.g. noticed by both scan and inotify.
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf("Can't open for read: %s\n", path);
+	  }
+	  return;
+	}
+
+	written = dtime_now();
+	if (fstat(fileno(fp), &st) == 0) {
+#if __linux__
+	  written = st.st_mtim.tv_sec + st.st_mtim.tv_nsec * 0.000000001;
+#else
+	  written = st.st_mtime;
+#endif
+	}
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Processing %s for transmit...\n", name);
+
+	batching = 1;
+	tx_writes = 0;
+	while (fgets(stuff, sizeof(stuff), fp) != NULL) {
+	  trim (stuff);
+	  text_color_set(DW_COLOR_DEBUG);
+	  dw_printf ("%s\n", stuff);
+	  // TODO: Don't delete file if errors encountered?
+	  process_input (stuff);
+	  lines++;
+	}
+	flush_to_kiss_tnc ();
+	batching = 0;
+
+	fclose (fp);
+	unlink (path);
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Sent %d line%s from %s in %d write%s, %.3f seconds after file was written.\n",
+			lines, lines == 1 ? "" : "s", name, tx_writes, tx_writes == 1 ? "" : "s",
+			dtime_now() - written);
+
+} /* end process_file */
+
+
+/*------------------------------------------------------------------
+ *
+ * Name: 	scan_transmit_dir
+ *
+ * Purpose:   	Process and delete all files currently in the transmit queue directory.
+ *
+ * Description:	Names starting with "." are skipped so an application can
+ *		write a file under such a name and then rename it.
+ *		Quit if the directory can't be accessed.
+ *
+ *---------------------------------------------------------------*/
+
+static void scan_transmit_dir (void)
+{
+	DIR *dp;
+	struct dirent *ep;
+
+	//text_color_set(DW_COLOR_DEBUG);
+        //dw_printf("Get directory listing...\n");
+
+	dp = opendir (transmit_from);
+	if (dp == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+          dw_printf("Can't access transmit queue directory %s.  Quitting.\n", transmit_from);
+	  exit (EXIT_FAILURE);
+	}
+
+	while ((ep = readdir(dp)) != NULL) {
+	  if (ep->d_name[0] == '.')
+	    continue;
+	  process_file (ep->d_name);
+	}
+	closedir (dp);
+
+} /* end scan_transmit_dir */
+
+
+/*------------------------------------------------------------------
+ *
+ * Name: 	watch_transmit_dir
+ *
+ * Purpose:   	Send files from the transmit queue directory as soon as they appear.
+ *
+ * Description:	Rather than listing the directory every second, ask the
+ *		kernel to tell us when a file there has been closed after
+ *		writing, or moved into it.  A file is not picked up while
+ *		another application is still writing it.
+ *
+ *		Anything already there is processed first.
+ *		If the kernel event queue overflows, scan the directory again
+ *		so nothing is missed.
+ *
+ * Returns:	Only if inotify is not available.  Caller should fall back to polling.
+ *
+ *---------------------------------------------------------------*/
+
+#if __linux__
+
+static void watch_transmit_dir (void)
+{
+	int fd;
+	char buf[4096] __attribute__ ((aligned(__alignof__(struct inotify_event))));
+
+	fd = inotify_init1 (IN_CLOEXEC);
+	if (fd < 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't watch transmit queue directory (%s).  Checking every second instead.\n", strerror(errno));
+	  return;
+	}
+	if (inotify_add_watch (fd, transmit_from, IN_CLOSE_WRITE | IN_MOVED_TO | IN_DELETE_SELF | IN_MOVE_SELF) < 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Can't watch transmit queue directory %s (%s).  Checking every second instead.\n", transmit_from, strerror(errno));
+	  close (fd);
+	  return;
+	}
+
+	scan_transmit_dir ();		// Anything written before we started watching.
+
+	while (1) {
+	  ssize_t n;
+	  char *p;
+
+	  n = read (fd, buf, sizeof(buf));
+	  if (n < 0) {
+	    if (errno == EINTR) continue;
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Error reading transmit queue directory events (%s).  Checking every second instead.\n", strerror(errno));
+	    close (fd);
+	    return;
+	  }
+
+	  for (p = buf; p < buf + n; ) {
+	    struct inotify_event *ev = (struct inotify_event *)p;
+
+	    if (ev->mask & IN_Q_OVERFLOW) {
+	      scan_transmit_dir ();
+	    }
+	    else if (ev->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+	      text_color_set(DW_COLOR_ERROR);
+              dw_printf("Transmit queue directory %s has been removed or renamed.  Quitting.\n", transmit_from);
+	      exit (EXIT_FAILURE);
+	    }
+	    else if (ev->len > 0 && ev->name[0] != '.') {
+	      process_file (ev->name);
+	    }
+	    p += sizeof(struct inotify_event) + ev->len;
+	  }
+	}
+
+} /* end watch_transmit_dir */
+
+#endif
+
+
 /*------------------------------------------------------------------
  *
  * Name: 	main
@@ -320,54 +524,20 @@ int main (int argc, char *argv[])
 	if (strlen(transmit_from) > 0) {
 /*
  * Process and delete all files in specified directory.
- * When done, sleep for a second and try again.
+ *
+ * On Linux, inotify tells us when a file has been closed after writing
+ * (or moved into the directory) so it can be sent immediately.
+ * watch_transmit_dir returns only if that is not possible.
+ *
+ * Otherwise, fall back to scanning the directory every second.
  * This doesn't take them in any particular order.
  * A future enhancement might sort by name or timestamp.
  */
+#if __linux__
+	  watch_transmit_dir ();
+#endif
 	  while (1) {
-	    DIR *dp;
-	    struct dirent *ep;
-
-	    //text_color_set(DW_COLOR_DEBUG);
-            //dw_printf("Get directory listing...\n");
-
-	    dp = opendir (transmit_from);
-	    if (dp != NULL) {
-	      while ((ep = readdir(dp)) != NULL) {
-	        char path [300];
-	        FILE *fp;
-	        if (ep->d_name[0] == '.')
-	          continue;
-
-	        text_color_set(DW_COLOR_DEBUG);
-	        dw_printf ("Processing %s for transmit...\n", ep->d_name);
-		strlcpy (path, transmit_from, sizeof(path));
-	        strlcat (path, DIR_CHAR, sizeof(path));
-	        strlcat (path, ep->d_name, sizeof(path));
-	        fp = fopen (path, "r");
-		if (fp != NULL) {
-	          while (fgets(stuff, sizeof(stuff), fp) != NULL) {         
-	            trim (stuff);
-	            text_color_set(DW_COLOR_DEBUG);
-	            dw_printf ("%s\n", stuff);
-		    // TODO: Don't delete file if errors encountered?
-	            process_input (stuff);
-	          }
-	          fclose (fp);
-		  unlink (path);
-	        }
-	        else {
-	          text_color_set(DW_COLOR_ERROR);
-                  dw_printf("Can't open for read: %s\n", path);
-	        }
-	      }
-	      closedir (dp);
-	    }
-	    else {
-	      text_color_set(DW_COLOR_ERROR);
-              dw_printf("Can't access transmit queue directory %s.  Quitting.\n", transmit_from);
-	      exit (EXIT_FAILURE);
-	    }
+	    scan_transmit_dir ();
 	    SLEEP_SEC (1);
 	  }
 	}
@@ -528,6 +698,59 @@ static void process_input (char *stuff)
 
  
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        write_to_kiss_tnc
+ *
+ * Purpose:     Send one or more KISS frames to the TNC.
+ *
+ * Inputs:	buf	- Already encapsulated KISS frame(s).
+ *
+ *		len	- Number of bytes.
+ *
+ *--------------------------------------------------------------------*/
+
+static void write_to_kiss_tnc (unsigned char *buf, int len)
+{
+	tx_writes++;
+
+	if (using_tcp) {
+	  int rc = SOCK_SEND(server_sock, (char*)buf, len);
+	  if (rc != len) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("ERROR writing KISS frame to socket.\n");
+	  }
+	}
+	else {
+	  int rc = serial_port_write (serial_fd, (char*)buf, len);
+	  if (rc != len) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("ERROR writing KISS frame to serial port.\n");
+	    //dw_printf ("DEBUG wanted %d, got %d\n", len, rc);
+	  }
+	}
+
+} /* end write_to_kiss_tnc */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        flush_to_kiss_tnc
+ *
+ * Purpose:     Send any KISS frames collected while batching.
+ *
+ *--------------------------------------------------------------------*/
+
+static void flush_to_kiss_tnc (void)
+{
+	if (tx_batch_len > 0) {
+	  write_to_kiss_tnc (tx_batch, tx_batch_len);
+	  tx_batch_len = 0;
+	}
+
+} /* end flush_to_kiss_tnc */
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        send_to_kiss_tnc
@@ -543,6 +766,8 @@ static void process_input (char *stuff)
  *		dlen	- Number of bytes in data.
  *
  * Description:	Encapsulate as KISS frame and send to TNC.
+ *		When processing a transmit queue file, it is only added
+ *		to tx_batch.  flush_to_kiss_tnc sends it later.
  *
  *--------------------------------------------------------------------*/
 
@@ -579,20 +804,15 @@ static void send_to_kiss_tnc (int chan, int cmd, char *data, int dlen)
 	  hex_dump (kissed, klen);
 	}
 
-	if (using_tcp) {
-	  int rc = SOCK_SEND(server_sock, (char*)kissed, klen);
-	  if (rc != klen) {
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("ERROR writing KISS frame to socket.\n");
+	if (batching) {
+	  if (tx_batch_len + klen > (int)sizeof(tx_batch)) {
+	    flush_to_kiss_tnc ();
 	  }
+	  memcpy (tx_batch + tx_batch_len, kissed, klen);
+	  tx_batch_len += klen;
 	}
 	else {
-	  int rc = serial_port_write (serial_fd, (char*)kissed, klen);
-	  if (rc != klen) {
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("ERROR writing KISS frame to serial port.\n");
-	    //dw_printf ("DEBUG wanted %d, got %d\n", klen, rc);
-	  }
+	  write_to_kiss_tnc (kissed, klen);
 	}
 
 } /* end send_to_kiss_tnc */
@@ -653,23 +873,20 @@ static THREAD_F tnc_listen_net (void *arg)
 	int len;
 
 	while ((len = SOCK_RECV (server_sock, (char*)(data), sizeof(data))) > 0) {
-	  int j;
-	  for (j = 0; j < len; j++) {
-	  
-	    // Feed in one byte at a time.
-	    // kiss_process_msg is called when a complete frame has been accumulated.
-
-	    // When verbose is specified, we get debug output like this:
-	    //
-	    // <<< Data frame from KISS client application, port 0, total length = 46
-  	    // 000:  c0 00 82 a0 88 ae 62 6a e0 ae 84 64 9e a6 b4 ff  ......bj...d....
-	    // ...
-	    // It says "from KISS client application" because it was written
-	    // on the assumption it was being used in only one direction.
-	    // Not worried enough about it to do anything at this time.
-
-	    kiss_rec_byte (&kstate, data[j], verbose, NULL, client, NULL);
-	  }
+
+	  // Feed in the whole block.
+	  // kiss_process_msg is called when a complete frame has been accumulated.
+
+	  // When verbose is specified, we get debug output like this:
+	  //
+	  // <<< Data frame from KISS client application, port 0, total length = 46
+	  // 000:  c0 00 82 a0 88 ae 62 6a e0 ae 84 64 9e a6 b4 ff  ......bj...d....
+	  // ...
+	  // It says "from KISS client application" because it was written
+	  // on the assumption it was being used in only one direction.
+	  // Not worried enough about it to do anything at this time.
+
+	  kiss_rec_bytes (&kstate, (unsigned char *)data, len, verbose, NULL, client, NULL);
 	}
 
 	text_color_set(DW_COLOR_ERROR);
@@ -719,19 +936,20 @@ static THREAD_F tnc_listen_serial (void *arg)
  * Read and print.
  */
 	while (1) {
-	  int ch;
+	  unsigned char data[MAX_KISS_LEN];
+	  int len;
 
-	  ch = serial_port_get1(serial_fd);
+	  len = serial_port_get(serial_fd, data, sizeof(data));
 
-	  if (ch < 0) {
+	  if (len < 0) {
  	    dw_printf("Read error from serial port KISS TNC.\n");
 	    exit (EXIT_FAILURE);
 	  }
 
-	  // Feed in one byte at a time.
+	  // Feed in whatever has arrived.
 	  // kiss_process_msg is called when a complete frame has been accumulated.
 
-	  kiss_rec_byte (&kstate, ch, verbose, NULL, client, NULL);
+	  kiss_rec_bytes (&kstate, data, len, verbose, NULL, client, NULL);
 	}
 
 } /* end tnc_listen_serial */
@@ -746,7 +964,9 @@ static THREAD_F tnc_listen_serial (void *arg)
  *		This is called when a complete frame has been accumulated.
  *		In this case, we simply print it.
  *
- * Inputs:	kiss_msg	- Kiss frame with FEND and escapes removed.
+ * Inputs:	kf		- Not used in this case.
+ *
+ *		kiss_msg	- Kiss frame with FEND and escapes removed.
  *				  The first byte contains channel and command.
  *
  *		kiss_len	- Number of bytes including the command.
@@ -759,7 +979,7 @@ static THREAD_F tnc_listen_serial (void *arg)
  *
  *-----------------------------------------------------------------*/
 
-void kiss_process_msg (unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
+void kiss_process_msg (kiss_frame_t *kf, unsigned char *kiss_msg, int kiss_len, int debug, struct kissport_status_s *kps, int client,
 			void (*sendfun)(int chan, int kiss_cmd, unsigned char *fbuf, int flen, struct kissport_status_s *onlykps, int onlyclient))
 {
 	int chan;
@@ -922,6 +1142,7 @@ static void usage(void)
  	dw_printf ("	-s	Serial port speed, default 9600.\n");
 	dw_printf ("	-v	Verbose.  Show the KISS frame contents.\n");
 	dw_printf ("	-f	Transmit files directory.  Process and delete files here.\n");
+	dw_printf ("		Names starting with \".\" are ignored.\n");
 	dw_printf ("	-o	Receive output queue directory.  Store received frames here.\n");
 	dw_printf ("	-T	Precede received frames with 'strftime' format time stamp.\n");
 	usage2();
@@ -0,0 +1,1169 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      linksim.c
+ *
+ * Purpose:   	Measure connected mode throughput without radios.
+ *
+ * Description:	tnctest.c needs real TNC instances, radios or audio cables,
+ *		and runs in real time.  Here we run the real data link state
+ *		machine, ax25_link.c, for two stations over a simulated radio
+ *		channel and a simulated clock.  A transfer which would take
+ *		several minutes at 1200 bits per second runs in a fraction
+ *		of a second.
+ *
+ *		Station A is radio channel 0 and connects to station B on
+ *		radio channel 1.  Both are handled by the same ax25_link
+ *		instance, the same way a single Dire Wolf could have one
+ *		client app connecting to another on a different channel.
+ *
+ *		The parts of Dire Wolf around ax25_link are replaced by
+ *		functions here:
+ *
+ *			dtime_realtime		- Simulated clock.
+ *			lm_data_request		- Put frame in transmit queue for station.
+ *			lm_seize_request	- Station needs to transmit something.
+ *			server_...		- Client applications.  A sends, B checks.
+ *			ptt_set			- Nothing.
+ *
+ *		The channel model:
+ *
+ *		- Half duplex.  A station can't hear anything while transmitting.
+ *		- Carrier detect, DWAIT, SLOTTIME and PERSIST before transmitting,
+ *		  like xmit.c.  Carrier detect can be disabled for hidden stations.
+ *		- TXDELAY, bit stuffing, FCS, flags and TXTAIL in airtime.
+ *		- Independent bit errors.  A frame is lost if any bit is wrong.
+ *		- One way delay, e.g. for a digipeater or linked repeater.
+ *		  Carrier detect also lags by this amount so collisions are possible.
+ *		- Optional traffic from other stations, occupying part of the channel.
+ *		  These are not hidden:  A and B defer to them and they defer to A and B.
+ *		  Collisions are still possible when both start at about the same time.
+ *		- A frame is lost if any other transmission, including our own,
+ *		  is heard at the same time.
+ *
+ *		The data sent includes a chunk number and pattern so B
+ *		can verify that everything arrived, in order, without corruption.
+ *
+ * Usage:	linksim [ options ]
+ *
+ *		With no options, one transfer is done with default settings.
+ *		-x runs a set of protocol versions, window sizes, and bit error rates.
+ *
+ *		The exit status is non-zero if any transfer was corrupted or
+ *		did not complete.  This is used for regression testing.
+ *
+ *---------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <getopt.h>
+#include <math.h>
+
+#include "textcolor.h"
+#include "ax25_pad.h"
+#include "ax25_pad2.h"
+#include "config.h"
+#include "dlq.h"
+#include "ax25_link.h"
+#include "tq.h"
+#include "server.h"
+#include "ptt.h"
+#include "fcs_calc.h"
+#include "dtime_now.h"
+
+
+#define NUM_STA 2
+#define CHAN_A 0
+#define CHAN_B 1
+#define CLIENT_A 0
+#define CLIENT_B 1
+
+static char *mycall[NUM_STA] = { "WB2OSZ-1", "WB2OSZ-2" };
+
+
+/* Own random number generator so we can get */
+/* same results on Windows and Linux. */
+
+#define MY_RAND_MAX 0x7fffffff
+static int seed = 1;
+
+static int my_rand (void) {
+	// Perform the calculation as unsigned to avoid signed overflow error.
+	seed = (int)(((unsigned)seed * 1103515245) + 12345) & MY_RAND_MAX;
+	return (seed);
+}
+
+static double my_uniform (void) {
+	return ((double)my_rand() / ((double)MY_RAND_MAX + 1.0));
+}
+
+
+/*
+ * What we are going to try.
+ */
+
+enum mode_e { MODE_REJ, MODE_SREJ, MODE_MULTI_SREJ };
+
+static const char *mode_name[3] = { "REJ", "SREJ", "M-SREJ" };
+
+struct scenario_s {
+	enum mode_e mode;	// REJ for v2.0, modulo 8.
+				// SREJ for v2.2, modulo 128, without XID.
+				// Multi-SREJ for v2.2 with XID.
+	int k;			// MAXFRAME or EMAXFRAME.
+	int paclen;
+	int frack;		// Initial T1, seconds.
+	int retry;
+
+	int bps;		// Bits per second.
+	double ber;		// Bit error rate.
+	double delay;		// One way delay, seconds.
+	int txdelay;		// Milliseconds.  Usual config file values are in units of 10 ms.
+	int txtail;
+	int slottime;
+	int persist;
+	int dwait;
+	int no_dcd;		// Stations can't hear each other's carrier.
+	double other_load;	// Fraction of time other stations would like to transmit.
+
+	int total_bytes;	// Amount of data to send from A to B.
+	double time_limit;	// Give up after this many seconds.
+};
+
+
+struct result_s {
+	int completed;		// All data received and link disconnected normally.
+	int corrupted;		// Data received did not match.
+	double elapsed;		// From connected until all data received.
+	int received;		// Bytes received by B.
+
+	int i_frames;		// I frames sent by A.
+	int i_resent;		// ... of which were retransmissions.
+	int polls;		// RR/RNR command with P=1 from A.  Usually due to T1 timeout.
+	int rej;		// Sent by B.
+	int srej;
+	int rr;
+	int transmissions[NUM_STA];
+
+	int lost_ber;		// Frames lost due to bit errors.
+	int lost_collision;	// Frames lost because more than one was heard at once.
+
+	double latency_sum;	// From first time chunk queued for transmission until
+	double latency_max;	// delivered to B's client app.
+	int latency_count;
+};
+
+
+/*
+ * Simulated clock.  Must not be zero because timers use that to mean not running.
+ */
+
+#define SIM_START 1000000.
+
+static double s_now;
+
+double dtime_realtime (void)
+{
+	return (s_now);
+}
+
+
+/*
+ * A transmission, from PTT on to PTT off, containing one or more frames.
+ */
+
+#define MAX_FRAMES 200
+
+struct xmit_s {
+	int from;		// Station index, or -1 for other traffic.
+	double start;		// PTT on.
+	double end;		// PTT off.
+	int nframes;
+	double fstart[MAX_FRAMES];
+	double fend[MAX_FRAMES];
+	int flen[MAX_FRAMES];
+	unsigned char *fdata[MAX_FRAMES];
+	int delivered;		// Number of frames processed at receiving end.
+	struct xmit_s *next;
+};
+
+static struct xmit_s *air = NULL;	// Recent transmissions, most recent first.
+
+
+/*
+ * Each station's transmitter.
+ */
+
+#define TXQ_SIZE 512
+
+enum tx_state_e { TX_IDLE, TX_DEFER, TX_ON };
+
+struct station_s {
+	packet_t txq[TXQ_SIZE];		// Waiting for transmit.  Circular buffer.
+	int txq_head;
+	int txq_tail;
+	int seize_pending;
+
+	enum tx_state_e tx_state;
+	double t_next;			// TX_DEFER: when to check channel again.  0 while waiting for clear channel.
+	double tx_end;			// TX_ON: when PTT goes off.
+
+	int reported_dcd;		// What we last told the data link state machine.
+	int reported_ptt;
+};
+
+static struct station_s sta[NUM_STA];
+
+static struct scenario_s *sc;
+static struct result_s *res;
+static struct misc_config_s misc_config;
+
+static double other_next;		// Next transmission from other stations.
+
+
+/*
+ * Client applications.
+ */
+
+static int a_connected;
+static int a_sent;
+static int a_outstanding;
+static int a_disconnected;
+static int a_terminated;
+static int a_timeout;
+
+static double t_connected;
+static int num_chunks;
+static double *first_tx;		// When each chunk was first queued for transmission.
+
+static int s_verbose = 0;
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        expected_byte
+ *
+ * Purpose:     Data to be sent from A to B.
+ *
+ * Description:	Each chunk fills one I frame.  It starts with the chunk number
+ *		so we can tell when each arrives.  The rest is a pattern
+ *		so we can detect anything dropped, duplicated, or out of order.
+ *
+ *--------------------------------------------------------------------*/
+
+static int expected_byte (int offset)
+{
+	int c = offset / sc->paclen;
+	int n = offset % sc->paclen;
+
+	if (n < 4) {
+	  return ((c >> (8 * (3 - n))) & 0xff);
+	}
+	return ((offset * 7 + c) & 0xff);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Replacements for functions called by ax25_link.c
+ *
+ *--------------------------------------------------------------------*/
+
+void lm_data_request (int chan, int prio, packet_t pp)
+{
+	struct station_s *s;
+	cmdres_t cr;
+	char desc[80];
+	int pf, nr, ns;
+	ax25_frame_type_t ftype;
+
+	assert (chan == CHAN_A || chan == CHAN_B);
+	s = &sta[chan];
+
+	ftype = ax25_frame_type (pp, &cr, desc, &pf, &nr, &ns);
+
+	if (chan == CHAN_A) {
+	  if (ftype == frame_type_I) {
+	    unsigned char *pinfo;
+	    int info_len = ax25_get_info (pp, &pinfo);
+
+	    res->i_frames++;
+	    if (info_len >= 4) {
+	      int c = (pinfo[0] << 24) | (pinfo[1] << 16) | (pinfo[2] << 8) | pinfo[3];
+	      if (c >= 0 && c < num_chunks) {
+	        if (first_tx[c] == 0) {
+	          first_tx[c] = s_now;
+	        }
+	        else {
+	          res->i_resent++;
+	        }
+	      }
+	    }
+	  }
+	  else if ((ftype == frame_type_S_RR || ftype == frame_type_S_RNR) && cr == cr_cmd && pf) {
+	    res->polls++;
+	  }
+	}
+	else {
+	  switch (ftype) {
+	    case frame_type_S_RR:	res->rr++;	break;
+	    case frame_type_S_REJ:	res->rej++;	break;
+	    case frame_type_S_SREJ:	res->srej++;	break;
+	    default:					break;
+	  }
+	}
+
+// Sending end of the queue:  high priority first.
+
+	int next = (s->txq_tail + 1) % TXQ_SIZE;
+	if (next == s->txq_head) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Transmit queue full for channel %d.\n", chan);
+	  ax25_delete (pp);
+	  return;
+	}
+	if (prio == TQ_PRIO_0_HI) {
+	  s->txq_head = (s->txq_head + TXQ_SIZE - 1) % TXQ_SIZE;
+	  s->txq[s->txq_head] = pp;
+	}
+	else {
+	  s->txq[s->txq_tail] = pp;
+	  s->txq_tail = next;
+	}
+
+} /* end lm_data_request */
+
+
+void lm_seize_request (int chan)
+{
+	assert (chan == CHAN_A || chan == CHAN_B);
+	sta[chan].seize_pending = 1;
+}
+
+
+void ptt_set (int octype, int chan, int ptt)
+{
+	(void)octype; (void)chan; (void)ptt;
+}
+
+
+void server_link_established (int chan, int client, char *remote_call, char *own_call, int incoming)
+{
+	(void)client; (void)remote_call; (void)own_call; (void)incoming;
+
+	if (chan == CHAN_B) {
+	  return;
+	}
+
+// A is connected.  Data will be sent from the main loop, as though
+// it came from the client app thru the dlq.
+
+	a_connected = 1;
+	t_connected = s_now;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        send_data
+ *
+ * Purpose:     Client app A sends everything at once.
+ *
+ *--------------------------------------------------------------------*/
+
+static void send_data (void)
+{
+	int offset = 0;
+	int c;
+
+	for (c = 0; c < num_chunks; c++) {
+	  char chunk[AX25_MAX_INFO_LEN];
+	  int len = sc->total_bytes - offset < sc->paclen ? sc->total_bytes - offset : sc->paclen;
+	  int j;
+
+	  for (j = 0; j < len; j++) {
+	    chunk[j] = expected_byte (offset + j);
+	  }
+	  offset += len;
+
+	  dlq_item_t E;
+	  memset (&E, 0, sizeof(E));
+	  strlcpy (E.addrs[AX25_SOURCE], mycall[CHAN_A], sizeof(E.addrs[AX25_SOURCE]));
+	  strlcpy (E.addrs[AX25_DESTINATION], mycall[CHAN_B], sizeof(E.addrs[AX25_DESTINATION]));
+	  E.num_addr = 2;
+	  E.chan = CHAN_A;
+	  E.client = CLIENT_A;
+	  E.txdata = cdata_new (AX25_PID_NO_LAYER_3, chunk, len);
+	  dl_data_request (&E);
+	  if (E.txdata != NULL) {
+	    cdata_delete (E.txdata);
+	  }
+	}
+}
+
+
+void server_link_terminated (int chan, int client, char *remote_call, char *own_call, int timeout)
+{
+	(void)client; (void)remote_call; (void)own_call;
+
+	if (chan == CHAN_A) {
+	  a_terminated = 1;
+	  a_timeout = timeout;
+	}
+}
+
+
+void server_rec_conn_data (int chan, int client, char *remote_call, char *own_call, int pid, char *data_ptr, int data_len)
+{
+	int j;
+
+	(void)client; (void)remote_call; (void)own_call; (void)pid;
+
+	if (chan != CHAN_B) {
+	  return;
+	}
+
+	for (j = 0; j < data_len; j++) {
+
+	  if (res->received >= sc->total_bytes || (data_ptr[j] & 0xff) != expected_byte(res->received)) {
+	    if ( ! res->corrupted) {
+	      text_color_set(DW_COLOR_ERROR);
+	      dw_printf ("Data received does not match what was sent, offset %d.\n", res->received);
+	    }
+	    res->corrupted = 1;
+	  }
+	  res->received++;
+
+	  // Chunk complete?
+
+	  if (res->received % sc->paclen == 0 || res->received == sc->total_bytes) {
+	    int c = (res->received - 1) / sc->paclen;
+	    if (c < num_chunks && first_tx[c] != 0) {
+	      double lat = s_now - first_tx[c];
+	      res->latency_sum += lat;
+	      res->latency_count++;
+	      if (lat > res->latency_max) res->latency_max = lat;
+	    }
+	  }
+	}
+
+	if (res->received == sc->total_bytes && res->elapsed == 0) {
+	  res->elapsed = s_now - t_connected;
+	}
+}
+
+
+void server_outstanding_frames_reply (int chan, int client, char *own_call, char *remote_call, int count)
+{
+	(void)client; (void)own_call; (void)remote_call;
+
+	if (chan == CHAN_A) {
+	  a_outstanding = count;
+	}
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        frame_bits
+ *
+ * Purpose:     Number of bits to transmit a frame:  FCS, bit stuffing,
+ *		and one flag to separate it from the next.
+ *
+ *--------------------------------------------------------------------*/
+
+static int frame_bits (unsigned char *fbuf, int flen)
+{
+	unsigned short fcs = fcs_calc (fbuf, flen);
+	int ones = 0;
+	int stuffed = 0;
+	int j, b;
+
+	for (j = 0; j < flen + 2; j++) {
+	  int x = j < flen ? fbuf[j] : (j == flen ? fcs & 0xff : (fcs >> 8) & 0xff);
+	  for (b = 0; b < 8; b++) {
+	    if (x & (1 << b)) {
+	      if (++ones == 5) {
+	        stuffed++;
+	        ones = 0;
+	      }
+	    }
+	    else {
+	      ones = 0;
+	    }
+	  }
+	}
+	return ((flen + 2) * 8 + stuffed + 8);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        heard_delay
+ *
+ * Purpose:     How long before a transmission is heard by a station.
+ *
+ *--------------------------------------------------------------------*/
+
+static double heard_delay (struct xmit_s *x, int r)
+{
+	if (x->from == r || x->from < 0) {
+	  return (0);
+	}
+	return (sc->delay);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        is_dcd
+ *
+ * Purpose:     Does station r hear someone else transmitting?
+ *
+ *--------------------------------------------------------------------*/
+
+static int is_dcd (int r)
+{
+	struct xmit_s *x;
+
+	for (x = air; x != NULL; x = x->next) {
+	  if (x->from != r && ! (sc->no_dcd && x->from >= 0)) {
+	    double d = heard_delay (x, r);
+	    if (s_now >= x->start + d && s_now < x->end + d) {
+	      return (1);
+	    }
+	  }
+	}
+	return (0);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        other_busy
+ *
+ * Purpose:     Do other stations hear anyone transmitting?
+ *
+ * Description:	They are assumed to be close to both A and B.
+ *
+ *--------------------------------------------------------------------*/
+
+static int other_busy (void)
+{
+	struct xmit_s *x;
+
+	for (x = air; x != NULL; x = x->next) {
+	  if (s_now >= x->start && s_now < x->end) {
+	    return (1);
+	  }
+	}
+	return (0);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        report_channel_busy
+ *
+ * Purpose:     Inform data link state machine of DCD and PTT changes,
+ *		as would happen thru the dlq from hdlc_rec and xmit.
+ *
+ *--------------------------------------------------------------------*/
+
+static void report_channel_busy (void)
+{
+	int r;
+
+	for (r = 0; r < NUM_STA; r++) {
+	  int dcd = is_dcd (r);
+	  int ptt = sta[r].tx_state == TX_ON;
+	  dlq_item_t E;
+
+	  memset (&E, 0, sizeof(E));
+	  E.chan = r;
+
+	  if (dcd != sta[r].reported_dcd) {
+	    sta[r].reported_dcd = dcd;
+	    E.activity = OCTYPE_DCD;
+	    E.status = dcd;
+	    lm_channel_busy (&E);
+
+	    // Waiting for clear channel?
+
+	    if ( ! dcd && sta[r].tx_state == TX_DEFER && sta[r].t_next == 0) {
+	      sta[r].t_next = s_now + sc->dwait / 1000.;
+	    }
+	  }
+	  if (ptt != sta[r].reported_ptt) {
+	    sta[r].reported_ptt = ptt;
+	    E.activity = OCTYPE_PTT;
+	    E.status = ptt;
+	    lm_channel_busy (&E);
+	  }
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        start_transmit
+ *
+ * Purpose:     Station has the channel.  Send everything in its queue.
+ *
+ *--------------------------------------------------------------------*/
+
+static void start_transmit (int r)
+{
+	struct station_s *s = &sta[r];
+	dlq_item_t E;
+
+// Like xmit.c, let the data link state machine know that the transmission
+// opportunity has arrived.  It can add new I frames and acknowledgements.
+
+	s->seize_pending = 0;
+	memset (&E, 0, sizeof(E));
+	E.chan = r;
+	lm_seize_confirm (&E);
+
+	if (s->txq_head == s->txq_tail) {
+	  s->tx_state = TX_IDLE;
+	  return;
+	}
+
+	struct xmit_s *x = calloc (sizeof(struct xmit_s), 1);
+	x->from = r;
+	x->start = s_now;
+
+	double t = s_now + sc->txdelay / 1000.;
+
+	while (s->txq_head != s->txq_tail && x->nframes < MAX_FRAMES) {
+	  packet_t pp = s->txq[s->txq_head];
+	  s->txq_head = (s->txq_head + 1) % TXQ_SIZE;
+
+	  unsigned char fbuf[AX25_MAX_PACKET_LEN];
+	  int flen = ax25_pack (pp, fbuf);
+	  ax25_delete (pp);
+
+	  x->fstart[x->nframes] = t;
+	  t += (double)frame_bits (fbuf, flen) / sc->bps;
+	  x->fend[x->nframes] = t;
+	  x->flen[x->nframes] = flen;
+	  x->fdata[x->nframes] = malloc (flen);
+	  memcpy (x->fdata[x->nframes], fbuf, flen);
+	  x->nframes++;
+	}
+
+	x->end = t + sc->txtail / 1000.;
+	x->next = air;
+	air = x;
+
+	s->tx_state = TX_ON;
+	s->tx_end = x->end;
+	res->transmissions[r]++;
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        deliver_frames
+ *
+ * Purpose:     Give frames to the receiving station when the last bit
+ *		arrives, unless they were damaged.
+ *
+ *--------------------------------------------------------------------*/
+
+static void deliver_frames (void)
+{
+	struct xmit_s *x, *y;
+
+	for (x = air; x != NULL; x = x->next) {
+
+	  if (x->from < 0) continue;
+
+	  int r = NUM_STA - 1 - x->from;	// The other station.
+	  double d = heard_delay (x, r);
+
+	  while (x->delivered < x->nframes && x->fend[x->delivered] + d <= s_now) {
+
+	    int n = x->delivered++;
+	    int bits = frame_bits (x->fdata[n], x->flen[n]);
+	    double fs = x->fstart[n] + d;
+	    double fe = x->fend[n] + d;
+	    const char *lost = NULL;
+
+	    // Anything else heard at the same time, including own transmitter?
+
+	    for (y = air; y != NULL && lost == NULL; y = y->next) {
+	      if (y != x) {
+	        double yd = heard_delay (y, r);
+	        if (y->start + yd < fe && y->end + yd > fs) {
+	          lost = "collision";
+	          res->lost_collision++;
+	        }
+	      }
+	    }
+
+	    if (lost == NULL && sc->ber > 0 && my_uniform() >= pow(1. - sc->ber, bits)) {
+	      lost = "bit error";
+	      res->lost_ber++;
+	    }
+
+	    alevel_t alevel;
+	    memset (&alevel, 0xff, sizeof(alevel));
+	    packet_t pp = ax25_from_frame (x->fdata[n], x->flen[n], alevel);
+	    assert (pp != NULL);
+
+	    if (s_verbose) {
+	      char addrs[AX25_MAX_ADDRS*AX25_MAX_ADDR_LEN];
+	      char desc[80];
+	      cmdres_t cr;
+	      int pf, nr, ns;
+
+	      ax25_set_modulo (pp, sc->mode == MODE_REJ ? modulo_8 : modulo_128);
+	      ax25_format_addrs (pp, addrs);
+	      ax25_frame_type (pp, &cr, desc, &pf, &nr, &ns);
+	      text_color_set(lost == NULL ? DW_COLOR_REC : DW_COLOR_ERROR);
+	      dw_printf ("%9.3f  [%d] %s %s  %s\n", s_now - SIM_START, r, addrs, desc, lost == NULL ? "" : lost);
+	    }
+
+	    if (lost == NULL) {
+	      dlq_item_t E;
+
+	      memset (&E, 0, sizeof(E));
+	      E.chan = r;
+	      E.pp = pp;
+	      lm_data_indication (&E);
+	    }
+	    ax25_delete (pp);
+	  }
+	}
+
+// Discard transmissions long ago.  Keep them a while longer
+// in case they overlap with something still to be delivered.
+
+	struct xmit_s **px = &air;
+	while (*px != NULL) {
+	  x = *px;
+	  if (x->delivered == x->nframes && x->end + sc->delay + 30 < s_now) {
+	    int n;
+	    *px = x->next;
+	    for (n = 0; n < x->nframes; n++) free (x->fdata[n]);
+	    free (x);
+	  }
+	  else {
+	    px = &(x->next);
+	  }
+	}
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        next_event
+ *
+ * Purpose:     Find the earliest time, after now, that something happens.
+ *
+ * Returns:	Time or 0 if nothing more will happen.
+ *
+ *--------------------------------------------------------------------*/
+
+#define EARLIER(t) { if ((t) > 0 && (tnext == 0 || (t) < tnext)) tnext = (t); }
+
+static double next_event (void)
+{
+	double tnext = 0;
+	struct xmit_s *x;
+	int r;
+
+	EARLIER (ax25_link_get_next_timer_expiry());
+
+	for (r = 0; r < NUM_STA; r++) {
+	  if (sta[r].tx_state == TX_DEFER) {
+	    EARLIER (sta[r].t_next);
+	  }
+	  else if (sta[r].tx_state == TX_ON) {
+	    EARLIER (sta[r].tx_end);
+	  }
+	}
+
+	for (x = air; x != NULL; x = x->next) {
+	  for (r = 0; r < NUM_STA; r++) {
+	    double d = heard_delay (x, r);
+	    if (x->start + d > s_now) EARLIER (x->start + d);
+	    if (x->end + d > s_now) EARLIER (x->end + d);
+	  }
+	  if (x->from >= 0 && x->delivered < x->nframes) {
+	    EARLIER (x->fend[x->delivered] + heard_delay (x, NUM_STA - 1 - x->from));
+	  }
+	}
+
+	if (sc->other_load > 0) {
+	  EARLIER (other_next);
+	}
+
+	return (tnext);
+}
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        run_scenario
+ *
+ * Purpose:     Connect, send data from A to B, disconnect.
+ *
+ *--------------------------------------------------------------------*/
+
+static void run_scenario (struct scenario_s *scenario, struct result_s *result)
+{
+	int r;
+	dlq_item_t E;
+
+	sc = scenario;
+	res = result;
+	memset (res, 0, sizeof(struct result_s));
+	memset (sta, 0, sizeof(sta));
+
+	s_now = SIM_START;
+
+	a_connected = 0;
+	a_sent = 0;
+	a_disconnected = 0;
+	a_terminated = 0;
+	a_timeout = 0;
+	t_connected = 0;
+
+	num_chunks = (sc->total_bytes + sc->paclen - 1) / sc->paclen;
+	first_tx = calloc (num_chunks, sizeof(double));
+
+	misc_config.frack = sc->frack;
+	misc_config.retry = sc->retry;
+	misc_config.paclen = sc->paclen;
+	misc_config.maxframe_basic = sc->k;
+	misc_config.maxframe_extended = sc->k;
+	misc_config.maxv22 = sc->mode == MODE_REJ ? 0 : sc->retry / 3;
+	misc_config.noxid_addrs = &mycall[CHAN_B];	// Don't send XID so SREJ is limited to single.
+	misc_config.noxid_count = sc->mode == MODE_SREJ ? 1 : 0;
+	ax25_link_init (&misc_config);
+
+// Other station traffic:  128 byte frames.
+
+	double other_len = sc->txdelay / 1000. + 128. * 8. * 1.02 / sc->bps + sc->txtail / 1000.;
+	if (sc->other_load > 0) {
+	  other_next = s_now + my_uniform() * other_len * (1 - sc->other_load) / sc->other_load;
+	}
+
+// B waits for incoming connection.  A connects.
+
+	memset (&E, 0, sizeof(E));
+	strlcpy (E.addrs[0], mycall[CHAN_B], sizeof(E.addrs[0]));
+	E.chan = CHAN_B;
+	E.client = CLIENT_B;
+	dl_register_callsign (&E);
+
+	memset (&E, 0, sizeof(E));
+	strlcpy (E.addrs[AX25_SOURCE], mycall[CHAN_A], sizeof(E.addrs[AX25_SOURCE]));
+	strlcpy (E.addrs[AX25_DESTINATION], mycall[CHAN_B], sizeof(E.addrs[AX25_DESTINATION]));
+	E.num_addr = 2;
+	E.chan = CHAN_A;
+	E.client = CLIENT_A;
+	dl_connect_request (&E);
+
+	while ( ! a_terminated && s_now < SIM_START + sc->time_limit) {
+
+	  for (r = 0; r < NUM_STA; r++) {
+	    if (sta[r].tx_state == TX_ON && sta[r].tx_end <= s_now) {
+	      sta[r].tx_state = TX_IDLE;
+	    }
+	  }
+
+	  deliver_frames ();
+	  report_channel_busy ();
+	  dl_timer_expiry ();
+
+	  // Client app A.
+
+	  if (a_connected && ! a_sent) {
+	    send_data ();
+	    a_sent = 1;
+	  }
+	  if (a_sent && ! a_disconnected) {
+	    memset (&E, 0, sizeof(E));
+	    strlcpy (E.addrs[AX25_SOURCE], mycall[CHAN_A], sizeof(E.addrs[AX25_SOURCE]));
+	    strlcpy (E.addrs[AX25_DESTINATION], mycall[CHAN_B], sizeof(E.addrs[AX25_DESTINATION]));
+	    E.num_addr = 2;
+	    E.chan = CHAN_A;
+	    E.client = CLIENT_A;
+	    dl_outstanding_frames_request (&E);
+
+	    if (a_outstanding == 0) {		// Everything has been acknowledged.
+	      dl_disconnect_request (&E);
+	      a_disconnected = 1;
+	    }
+	  }
+
+	  for (r = 0; r < NUM_STA; r++) {
+	    struct station_s *s = &sta[r];
+
+	    if (s->tx_state == TX_IDLE && (s->txq_head != s->txq_tail || s->seize_pending)) {
+	      s->tx_state = TX_DEFER;
+	      s->t_next = is_dcd(r) ? 0 : s_now + sc->dwait / 1000.;
+	    }
+
+	    if (s->tx_state == TX_DEFER && s->t_next != 0 && s->t_next <= s_now) {
+	      if (is_dcd(r)) {
+	        s->t_next = 0;			// Wait for clear channel.
+	      }
+	      else if ((my_rand() & 0xff) <= sc->persist) {
+	        start_transmit (r);
+	      }
+	      else {
+	        s->t_next = s_now + sc->slottime / 1000.;
+	      }
+	    }
+	  }
+
+	  if (sc->other_load > 0 && other_next <= s_now && other_busy()) {
+	    other_next = s_now + sc->slottime / 1000. * (1 + my_rand() % 4);
+	  }
+	  else if (sc->other_load > 0 && other_next <= s_now) {
+	    struct xmit_s *x = calloc (sizeof(struct xmit_s), 1);
+	    x->from = -1;
+	    x->start = s_now;
+	    x->end = s_now + other_len;
+	    x->next = air;
+	    air = x;
+	    if (s_verbose) {
+	      text_color_set(DW_COLOR_INFO);
+	      dw_printf ("%9.3f  Other station transmitting for %.3f seconds.\n", s_now - SIM_START, other_len);
+	    }
+	    other_next = x->end + (-log(1. - my_uniform())) * other_len * (1 - sc->other_load) / sc->other_load;
+	  }
+
+	  report_channel_busy ();
+
+	  double tnext = next_event ();
+	  if (tnext == 0) {
+	    break;			// Nothing more will ever happen.
+	  }
+	  if (tnext > s_now) {
+	    s_now = tnext;
+	  }
+	}
+
+	res->completed = a_terminated && ! a_timeout && res->received == sc->total_bytes && ! res->corrupted;
+
+// Clean up for next time.
+
+	memset (&E, 0, sizeof(E));
+	E.client = CLIENT_A;
+	dl_client_cleanup (&E);
+	E.client = CLIENT_B;
+	dl_client_cleanup (&E);
+
+	for (r = 0; r < NUM_STA; r++) {
+	  while (sta[r].txq_head != sta[r].txq_tail) {
+	    ax25_delete (sta[r].txq[sta[r].txq_head]);
+	    sta[r].txq_head = (sta[r].txq_head + 1) % TXQ_SIZE;
+	  }
+	}
+	while (air != NULL) {
+	  struct xmit_s *x = air;
+	  int n;
+	  air = x->next;
+	  for (n = 0; n < x->nframes; n++) free (x->fdata[n]);
+	  free (x);
+	}
+	free (first_tx);
+	first_tx = NULL;
+
+} /* end run_scenario */
+
+
+
+static void print_heading (void)
+{
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n");
+	dw_printf ("mode     k  paclen     BER   delay  other  result   seconds  bytes/sec   eff.   I sent  resent  polls   REJ  SREJ  lost bit/coll   latency avg/max\n");
+	dw_printf ("------  --  ------  ------  ------  -----  ------  --------  ---------  -----   ------  ------  -----  ----  ----  -------------   ---------------\n");
+}
+
+static void print_result (struct scenario_s *s, struct result_s *r)
+{
+	double elapsed = r->elapsed > 0 ? r->elapsed : s->time_limit;
+	double goodput = r->received / elapsed;
+
+	text_color_set(r->completed ? DW_COLOR_INFO : DW_COLOR_ERROR);
+	dw_printf ("%-6s  %2d  %6d  %6.0e  %6.2f  %4.0f%%  %-6s  %8.1f  %9.1f  %4.0f%%   %6d  %6d  %5d  %4d  %4d   %5d / %-5d   %6.1f / %-6.1f\n",
+		mode_name[s->mode], s->k, s->paclen, s->ber, s->delay, s->other_load * 100,
+		r->corrupted ? "BAD" : r->completed ? "ok" : "FAIL",
+		elapsed, goodput, goodput * 8 * 100 / s->bps,
+		r->i_frames, r->i_resent, r->polls, r->rej, r->srej,
+		r->lost_ber, r->lost_collision,
+		r->latency_count ? r->latency_sum / r->latency_count : 0, r->latency_max);
+}
+
+
+static void usage (void)
+{
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("\n");
+	dw_printf ("Simulated radio channel for connected mode throughput testing.\n");
+	dw_printf ("\n");
+	dw_printf ("Usage:  linksim [ options ]\n");
+	dw_printf ("\n");
+	dw_printf ("	-m mode		rej = v2.0 modulo 8,\n");
+	dw_printf ("			srej = v2.2 modulo 128 without XID,\n");
+	dw_printf ("			msrej = v2.2 with XID for multi-SREJ.  Default.\n");
+	dw_printf ("	-k n		MAXFRAME / EMAXFRAME.  Default 4 or 32.\n");
+	dw_printf ("	-p n		PACLEN.  Default %d.\n", AX25_N1_PACLEN_DEFAULT);
+	dw_printf ("	-f n		FRACK.  Default %d.\n", AX25_T1V_FRACK_DEFAULT);
+	dw_printf ("	-B n		Bits per second.  Default 1200.\n");
+	dw_printf ("	-e n		Bit error rate, e.g. 1e-4.  Default 0.\n");
+	dw_printf ("	-d n		One way delay, seconds.  Default 0.\n");
+	dw_printf ("	-t n		TXDELAY, ms.  Default 300.\n");
+	dw_printf ("	-o n		Other stations try to use the channel n percent of the time.  Default 0.\n");
+	dw_printf ("	-c		Stations can't hear each other's carrier.\n");
+	dw_printf ("	-n n		Number of bytes to send.  Default 16384.\n");
+	dw_printf ("	-s n		Random number seed.\n");
+	dw_printf ("	-x		Try several modes, window sizes, and bit error rates.\n");
+	dw_printf ("	-v		Display frames on the channel.\n");
+	exit (EXIT_FAILURE);
+}
+
+
+int main (int argc, char *argv[])
+{
+	struct scenario_s base;
+	struct result_s result;
+	int sweep = 0;
+	int k = 0;
+	int failures = 0;
+	int ch;
+
+	text_color_init (1);
+	dlq_init ();
+
+	memset (&base, 0, sizeof(base));
+	base.mode = MODE_MULTI_SREJ;
+	base.paclen = AX25_N1_PACLEN_DEFAULT;
+	base.frack = AX25_T1V_FRACK_DEFAULT;
+	base.retry = AX25_N2_RETRY_DEFAULT;
+	base.bps = 1200;
+	base.txdelay = 300;
+	base.txtail = 100;
+	base.slottime = 100;
+	base.persist = 63;
+	base.dwait = 0;
+	base.total_bytes = 16384;
+
+	while ((ch = getopt (argc, argv, "m:k:p:f:B:e:d:t:o:cn:s:xvh")) != -1) {
+	  switch (ch) {
+	    case 'm':
+	      if (strcasecmp(optarg, "rej") == 0) base.mode = MODE_REJ;
+	      else if (strcasecmp(optarg, "srej") == 0) base.mode = MODE_SREJ;
+	      else if (strcasecmp(optarg, "msrej") == 0) base.mode = MODE_MULTI_SREJ;
+	      else usage ();
+	      break;
+	    case 'k':	k = atoi(optarg);			break;
+	    case 'p':	base.paclen = atoi(optarg);		break;
+	    case 'f':	base.frack = atoi(optarg);		break;
+	    case 'B':	base.bps = atoi(optarg);		break;
+	    case 'e':	base.ber = atof(optarg);		break;
+	    case 'd':	base.delay = atof(optarg);		break;
+	    case 't':	base.txdelay = atoi(optarg);		break;
+	    case 'o':	base.other_load = atof(optarg) / 100.;	break;
+	    case 'c':	base.no_dcd = 1;			break;
+	    case 'n':	base.total_bytes = atoi(optarg);	break;
+	    case 's':	seed = atoi(optarg);			break;
+	    case 'x':	sweep = 1;				break;
+	    case 'v':	s_verbose = 1;				break;
+	    default:	usage ();				break;
+	  }
+	}
+
+	if (base.paclen < 8 || base.paclen > AX25_N1_PACLEN_MAX || base.bps < 100 ||
+	    base.total_bytes < 1 || base.other_load < 0 || base.other_load >= 0.9) {
+	  usage ();
+	}
+
+// Allow time for airtime at 10% efficiency.
+
+	base.time_limit = 60 + base.total_bytes * 8. * 10. / base.bps;
+
+	if ( ! sweep) {
+	  base.k = k > 0 ? k : (base.mode == MODE_REJ ? AX25_K_MAXFRAME_BASIC_DEFAULT : AX25_K_MAXFRAME_EXTENDED_DEFAULT);
+	  run_scenario (&base, &result);
+	  print_heading ();
+	  print_result (&base, &result);
+	  return (result.completed ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+
+	static const struct { enum mode_e mode; int k; } try[] = {
+		{ MODE_REJ, 1 }, { MODE_REJ, 4 }, { MODE_REJ, 7 },
+		{ MODE_SREJ, 4 }, { MODE_SREJ, 7 }, { MODE_SREJ, 32 },
+		{ MODE_MULTI_SREJ, 7 }, { MODE_MULTI_SREJ, 32 } };
+	static const double try_ber[] = { 0, 1e-5, 1e-4 };
+
+	struct result_s results[sizeof(try)/sizeof(try[0])][sizeof(try_ber)/sizeof(try_ber[0])];
+	int i, j;
+
+	for (i = 0; i < (int)(sizeof(try)/sizeof(try[0])); i++) {
+	  for (j = 0; j < (int)(sizeof(try_ber)/sizeof(try_ber[0])); j++) {
+	    struct scenario_s s = base;
+	    s.mode = try[i].mode;
+	    s.k = try[i].k;
+	    if (base.ber == 0) s.ber = try_ber[j];	// -e replaces the list.
+	    run_scenario (&s, &results[i][j]);
+	    if ( ! results[i][j].completed) failures++;
+	    if (base.ber != 0) break;
+	  }
+	}
+
+	print_heading ();
+	for (i = 0; i < (int)(sizeof(try)/sizeof(try[0])); i++) {
+	  for (j = 0; j < (int)(sizeof(try_ber)/sizeof(try_ber[0])); j++) {
+	    struct scenario_s s = base;
+	    s.mode = try[i].mode;
+	    s.k = try[i].k;
+	    if (base.ber == 0) s.ber = try_ber[j];
+	    print_result (&s, &results[i][j]);
+	    if (base.ber != 0) break;
+	  }
+	}
+
+	if (failures) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("\n%d transfers did not complete.\n", failures);
+	  return (EXIT_FAILURE);
+	}
+	return (EXIT_SUCCESS);
+
+} /* end main */
+
+/* end linksim.c */
@@ -61,6 +61,16 @@
 #include "log.h"
 
 
+/*
+ * First line of the file, for importing into a spreadsheet.
+ * Files written before rxtime was added don't have the last column.
+ */
+
+#define LOG_HEADER_NO_RXTIME "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,telemetry,comment"
+
+#define LOG_HEADER LOG_HEADER_NO_RXTIME ",rxtime"
+
+
 /*
  * CSV format needs quotes if value contains comma or quote.
  */
@@ -96,6 +106,82 @@ static void quote_for_csv (char *out, size_t outsize, const char *in) {
 }
 
 
+/*------------------------------------------------------------------
+ *
+ * Function:	upgrade_header
+ *
+ * Purpose:	Replace the header of a log file written by an earlier
+ *		version, without the rxtime column, before appending.
+ *
+ * Inputs:	path		- Existing log file.
+ *
+ * Description:	Otherwise a spreadsheet would take the column names from
+ *		the old header and the new column would have no name.
+ *		The earlier lines simply end one field short, which
+ *		reads as an empty rxtime.
+ *
+ *		The file is copied with the new header then renamed.
+ *		If anything goes wrong, the original is left alone.
+ *
+ *------------------------------------------------------------------*/
+
+static void upgrade_header (const char *path)
+{
+	FILE *in, *out;
+	char line[sizeof(LOG_HEADER) + 8];
+	char temp_path[140];
+	char buf[4096];
+	size_t n;
+	int ok = 1;
+
+	in = fopen (path, "r");
+	if (in == NULL) {
+	  return;
+	}
+	if (fgets (line, sizeof(line), in) == NULL) {
+	  fclose (in);
+	  return;
+	}
+	line[strcspn(line, "\r\n")] = '\0';
+	if (strcmp(line, LOG_HEADER_NO_RXTIME) != 0) {
+	  fclose (in);
+	  return;		// Current or something we don't know about.
+	}
+
+	snprintf (temp_path, sizeof(temp_path), "%s.tmp", path);
+	out = fopen (temp_path, "w");
+	if (out == NULL) {
+	  fclose (in);
+	  return;
+	}
+
+	ok = fprintf (out, "%s\n", LOG_HEADER) > 0;
+	while (ok && (n = fread (buf, 1, sizeof(buf), in)) > 0) {
+	  ok = fwrite (buf, n, 1, out) == 1;
+	}
+	if (ferror(in)) {
+	  ok = 0;
+	}
+	fclose (in);
+	if (fclose (out) != 0) {
+	  ok = 0;
+	}
+
+#if __WIN32__
+	if (ok) {
+	  remove (path);		// Windows rename won't replace existing file.
+	}
+#endif
+	if ( ! ok || rename (temp_path, path) != 0) {
+	  remove (temp_path);
+	  return;
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Added rxtime column to header of log file \"%s\".\n", path);
+}
+
+
 /*------------------------------------------------------------------
  *
  * Function:	log_init
@@ -222,7 +308,20 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 
 	if (strlen(g_log_path) == 0) return;
 
-	now = time(NULL);			// Get current time.
+	// Use the time the frame was captured by the audio device, if known,
+	// rather than the time we finally got around to writing it out.
+
+	double rx_time = 0;
+	if (pp != NULL) {
+	  rx_time = ax25_get_rx_time(pp);
+	}
+
+	if (rx_time > 0) {
+	  now = (time_t)rx_time;
+	}
+	else {
+	  now = time(NULL);			// Get current time.
+	}
 	(void)gmtime_r (&now, &tm);	
 // FIXME:  https://github.com/wb2osz/direwolf/issues/473
 
@@ -265,6 +364,9 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	    // This is used later to write a header if it did not exist already.
 
 	    already_there = (stat(full_path,&st) == 0) && (st.st_size > 0);
+	    if (already_there) {
+	      upgrade_header (full_path);
+	    }
 
 	    text_color_set(DW_COLOR_INFO);
 	    dw_printf("Opening log file \"%s\".\n", fname);
@@ -286,7 +388,7 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	    // only if this will be the first line.
 	
 	    if ( ! already_there) {
-	      fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,telemetry,comment\n");
+	      fprintf (g_log_fp, "%s\n", LOG_HEADER);
 	    }
 	  }
 	}
@@ -304,6 +406,9 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	    // This is used later to write a header if it did not exist already.
 
 	    already_there = (stat(g_log_path,&st) == 0) && (st.st_size > 0);
+	    if (already_there) {
+	      upgrade_header (g_log_path);
+	    }
 
 	    text_color_set(DW_COLOR_INFO);
 	    dw_printf("Opening log file \"%s\"\n", g_log_path);
@@ -322,7 +427,7 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	    // only if this will be the first line.
 
 	    if ( ! already_there) {
-	      fprintf (g_log_fp, "chan,utime,isotime,source,heard,level,error,dti,name,symbol,latitude,longitude,speed,course,altitude,frequency,offset,tone,system,status,telemetry,comment\n");
+	      fprintf (g_log_fp, "%s\n", LOG_HEADER);
 	    }
 	  }
 	}
@@ -346,6 +451,7 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	  char stelemetry[200];
 	  char scomment[256];
 	  char alevel_text[40];
+	  char srxtime[24];
 
 
 
@@ -413,13 +519,17 @@ void log_write (int chan, decode_aprs_t *A, packet_t pp, alevel_t alevel, retry_
 	  strlcpy (stone, "", sizeof(stone));  if (A->g_tone   != G_UNKNOWN) snprintf (stone, sizeof(stone), "%.1f", A->g_tone);
 	                       if (A->g_dcs    != G_UNKNOWN) snprintf (stone, sizeof(stone), "D%03o", A->g_dcs);
 
-	  fprintf (g_log_fp, "%d,%d,%s,%s,%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", 
+	  // Full resolution capture time for time difference of arrival, etc.
+
+	  strlcpy (srxtime, "", sizeof(srxtime));  if (rx_time > 0) snprintf (srxtime, sizeof(srxtime), "%.6f", rx_time);
+
+	  fprintf (g_log_fp, "%d,%d,%s,%s,%s,%s,%d,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s,%s\n", 
 			chan, (int)now, itime, 
 			A->g_src, heard, alevel_text, (int)retries, sdti,
 			sname, ssymbol,
 			slat, slon, sspd, scse, salt, 
 			sfreq, soffs, stone, 
-			smfr, sstatus, stelemetry, scomment);
+			smfr, sstatus, stelemetry, scomment, srxtime);
 
 	  fflush (g_log_fp);
 	}
@@ -23,6 +23,14 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdio.h>
+#include <stdint.h>
+#include <limits.h>
+#include <getopt.h>
+
+#if ! __WIN32__
+#include <unistd.h>
+#include <pthread.h>
+#endif
 
 
 /*
@@ -41,86 +49,224 @@ typedef struct thing_s {
 	char comment[80];	/* Combined mic-e status and comment text */
 } thing_t;
 
-static thing_t *things;		/* Dynamically sized array. */
-static int max_things;		/* Current size. */
-static int num_things;		/* Number of elements currently in use. */
+
+/*
+ * Log archives can be much larger than available memory so we do an external sort.
+ *
+ * Records are read into a fixed size chunk.  When it fills up, the chunk is sorted
+ * and written to a temporary file as a "run."  At the end, all runs are merged,
+ * in order, and the GPX is written as we go.  Memory use depends on the -m option
+ * and not on the amount of data.  If everything fits in one chunk, nothing is
+ * written to temporary files and the result is the same as before.
+ *
+ * With -j, several files are read and sorted at the same time.
+ */
+
+/* Largest -m.  Anything more than a 32 bit process could hope to get */
+/* would overflow the size calculation there. */
+
+#define MAX_MEM_MB (SIZE_MAX > 0xffffffffu ? 1048576 : 2047)
+
+typedef struct chunk_s {
+	thing_t *things;	/* Fixed size array. */
+	int max_things;		/* Its size. */
+	int num_things;		/* Number of elements currently in use. */
+} chunk_t;
+
+typedef struct run_s {
+	FILE *fp;		/* Sorted records in a temporary file, or */
+	thing_t *mem;		/* sorted records still in memory. */
+	long count;		/* Number of records. */
+	long next;		/* Index of next one to read. */
+	thing_t cur;		/* Current record during merge. */
+} run_t;
+
+static run_t **runs;		/* All runs produced so far. */
+static int max_runs;
+static int num_runs;
+
+#define MAX_MERGE 100		/* Maximum number of runs merged at once.  More require extra passes. */
+
+#define RUN_BUF_SIZE 65536	/* stdio buffer for each temporary file. */
+
+static char *tmp_dir = NULL;	/* -T option.  NULL for system default. */
+
+static char **file_names;	/* Files to read. */
+static int num_files;
+static int next_file;		/* Next one for a reader to take. */
+
+#if ! __WIN32__
+static pthread_mutex_t runs_mutex = PTHREAD_MUTEX_INITIALIZER;
+#define LOCK   pthread_mutex_lock (&runs_mutex)
+#define UNLOCK pthread_mutex_unlock (&runs_mutex)
+#else
+#define LOCK
+#define UNLOCK
+#endif
+
 
 #define UNKNOWN_VALUE (-999)	/* Special value to indicate unknown altitude, speed, course. */
 
 #define KNOTS_TO_METERS_PER_SEC(x) ((x)*0.51444444444)
 
 
-static void read_csv(FILE *fp);
+static void usage (void);
+static void *reader_thread (void *arg);
+static void read_csv(FILE *fp, chunk_t *ch);
+static int parse_csv (char *raw, thing_t *t);
 static void unquote (char *in, char *out);
 static int compar(const void *a, const void *b);
-static void process_things (int first, int last);
+static void spill_chunk (chunk_t *ch);
+static void add_run (run_t *r);
+static void merge_runs (run_t **r, int n, void (*put)(thing_t *, void *), void *ctx);
+static void put_file (thing_t *t, void *ctx);
+static void put_gpx (thing_t *t, void *ctx);
+static void end_group (void);
+static FILE *temp_file (void);
+static void xml_text (char *in, char *out);
 
 
 int main (int argc, char *argv[]) 
 {
-	int first, last;
-	
+	int mem_mb = 256;		/* -m option. */
+	int num_readers = 1;		/* -j option. */
+	chunk_t *chunks;
+	char *stdin_name[1] = { "-" };
+	int n;
+
+	while (1) {
+	  int c = getopt (argc, argv, "m:j:T:h");
+
+	  if (c == -1) break;
+
+	  switch (c) {
+
+	    case 'm':				/* -m megabytes for sorting. */
+	      mem_mb = atoi(optarg);
+	      if (mem_mb < 1 || mem_mb > MAX_MEM_MB) {
+	        fprintf (stderr, "Memory size for -m must be in range of 1 to %d megabytes.\n", MAX_MEM_MB);
+	        exit (1);
+	      }
+	      break;
+
+	    case 'j':				/* -j number of files read at once. */
+	      num_readers = atoi(optarg);
+	      if (num_readers < 1 || num_readers > 64) {
+	        fprintf (stderr, "Number of readers for -j must be in range of 1 to 64.\n");
+	        exit (1);
+	      }
+#if __WIN32__
+	      num_readers = 1;
+#endif
+	      break;
+
+	    case 'T':				/* -T directory for temporary files. */
+	      tmp_dir = optarg;
+	      break;
+
+	    case 'h':
+	    case '?':
+	    default:
+	      usage ();
+	      break;
+	  }
+	}
 
 /*
- * Allocate array for data.
- * Expand it as needed if initial size is inadequate.
+ * Files listed or stdin if none.
  */
+	if (optind < argc) {
+	  file_names = argv + optind;
+	  num_files = argc - optind;
+	}
+	else {
+	  file_names = stdin_name;
+	  num_files = 1;
+	}
+	next_file = 0;
 
-	num_things = 0;
-	max_things = 1000;
-	things = malloc (max_things * sizeof(thing_t));
+	if (num_readers > num_files) {
+	  num_readers = num_files;
+	}
 
 /*
- * Read files listed or stdin if none.
+ * Allocate a fixed size chunk for each reader.
  */
-
-	if (argc == 1) {
-	  read_csv (stdin);
+	chunks = calloc (num_readers, sizeof(chunk_t));
+	for (n = 0; n < num_readers; n++) {
+	  size_t bytes = (size_t)mem_mb * 1024 * 1024 / num_readers;
+	  size_t things = bytes / sizeof(thing_t);
+	  if (things > INT_MAX) things = INT_MAX;
+	  chunks[n].max_things = things;
+	  if (chunks[n].max_things < 1000) chunks[n].max_things = 1000;
+	  chunks[n].num_things = 0;
+	  chunks[n].things = malloc (chunks[n].max_things * sizeof(thing_t));
+	  if (chunks[n].things == NULL) {
+	    fprintf (stderr, "Not enough memory.  Try a smaller value for -m.\n");
+	    exit (1);
+	  }
 	}
-	else {
-	  int n;
 
-	  for (n=1; n<argc; n++) {
-	    if (strcmp(argv[n], "-") == 0) {
-	      read_csv (stdin);
-	    }
-	    else {
-	      FILE *fp;
+#if ! __WIN32__
+	if (num_readers > 1) {
+	  pthread_t *tid = calloc (num_readers, sizeof(pthread_t));
 
-	      fp = fopen (argv[n], "r");
-	      if (fp != NULL) {
-	        read_csv (fp);
-	        fclose (fp);
-	      }
-	      else {
-	        fprintf (stderr, "Can't open %s for read.\n", argv[n]);
-	        exit (1);
-	      }
+	  for (n = 0; n < num_readers; n++) {
+	    if (pthread_create (&tid[n], NULL, reader_thread, &chunks[n]) != 0) {
+	      fprintf (stderr, "Could not create reader thread.\n");
+	      exit (1);
 	    }
 	  }
+	  for (n = 0; n < num_readers; n++) {
+	    pthread_join (tid[n], NULL);
+	  }
+	  free (tid);
 	}
-	
-	if (num_things == 0) {
-	  fprintf (stderr, "Nothing to process.\n");
-	  exit (1);
+	else
+#endif
+	{
+	  reader_thread (&chunks[0]);
 	}
 
 /*
- * Sort the data so everything for the same name is adjacent and
- * in order of time.
+ * Whatever is left in each chunk becomes a run without going to a file.
  */
+	for (n = 0; n < num_readers; n++) {
+	  if (chunks[n].num_things > 0) {
+	    run_t *r = calloc (1, sizeof(run_t));
+
+	    qsort (chunks[n].things, chunks[n].num_things, sizeof(thing_t), compar);
+	    r->mem = chunks[n].things;
+	    r->count = chunks[n].num_things;
+	    add_run (r);
+	  }
+	  else {
+	    free (chunks[n].things);
+	  }
+	}
+	free (chunks);
 
-	qsort (things, num_things, sizeof(thing_t), compar);
+	if (num_runs == 0) {
+	  fprintf (stderr, "Nothing to process.\n");
+	  exit (1);
+	}
 
-	//for (i=0; i<num_things; i++) {
-	//  printf ("%d: %s %.6f %.6f %.1f %s\n", 
-	//    i,
-	//    things[i].time,
-	//    things[i].lat,
-	//    things[i].lon,
-	//    things[i].alt,
-	//    things[i].name);
-	//}
+/*
+ * Too many runs to merge at once?  Combine groups of them into longer runs.
+ */
+	while (num_runs > MAX_MERGE) {
+	  run_t *r = calloc (1, sizeof(run_t));
+	  run_t **group = malloc (MAX_MERGE * sizeof(run_t *));
+
+	  memcpy (group, runs, MAX_MERGE * sizeof(run_t *));
+	  memmove (runs, runs + MAX_MERGE, (num_runs - MAX_MERGE) * sizeof(run_t *));
+	  num_runs -= MAX_MERGE;
+
+	  r->fp = temp_file ();
+	  merge_runs (group, MAX_MERGE, put_file, r);
+	  free (group);
+	  add_run (r);
+	}
 
 /*
  * GPX file header.
@@ -129,17 +275,11 @@ int main (int argc, char *argv[])
 	printf ("<gpx version=\"1.1\" creator=\"Dire Wolf\">\n");
 
 /*
- * Group together all records for the same entity.
+ * Merge everything so all records for the same name are together
+ * and in order of time.
  */
-	last = first = 0;
-	while (first < num_things) {
-
-	  while (last < num_things-1 && strcmp(things[first].name, things[last+1].name) == 0) {
-	    last++;
-	  }
-	  process_things (first, last);
-	  first = last + 1;
-	}
+	merge_runs (runs, num_runs, put_gpx, NULL);
+	end_group ();
 
 /*
  *  GPX file tail.
@@ -150,187 +290,290 @@ int main (int argc, char *argv[])
 }
 
 
+static void usage (void)
+{
+	fprintf (stderr, "\n");
+	fprintf (stderr, "Usage: log2gpx [options] [ file ... ]\n");
+	fprintf (stderr, "\n");
+	fprintf (stderr, "  -m n    Memory to use for sorting, in megabytes.  Default 256.\n");
+	fprintf (stderr, "          Anything larger is sorted in pieces using temporary files.\n");
+#if ! __WIN32__
+	fprintf (stderr, "  -j n    Read and sort up to n files at the same time.  Default 1.\n");
+#endif
+	fprintf (stderr, "  -T dir  Directory for temporary files.\n");
+	fprintf (stderr, "\n");
+	fprintf (stderr, "Log files are read from stdin if none are listed.\n");
+	fprintf (stderr, "GPX is written to stdout.\n");
+	exit (1);
+}
+
+
 /*
- * Read from given file, already open, into things array. 
+ * Temporary file for a sorted run.  It goes away when closed.
  */
 
-static void read_csv(FILE *fp)
+static FILE *temp_file (void)
+{
+	FILE *fp = NULL;
+
+#if ! __WIN32__
+	if (tmp_dir != NULL) {
+	  char path[300];
+	  int fd;
+
+	  snprintf (path, sizeof(path), "%s/log2gpx-XXXXXX", tmp_dir);
+	  fd = mkstemp (path);
+	  if (fd >= 0) {
+	    unlink (path);
+	    fp = fdopen (fd, "w+b");
+	  }
+	}
+	else
+#endif
+	{
+	  fp = tmpfile ();
+	}
+
+	if (fp == NULL) {
+	  fprintf (stderr, "Can't create temporary file%s%s.\n", tmp_dir != NULL ? " in " : "", tmp_dir != NULL ? tmp_dir : "");
+	  exit (1);
+	}
+	setvbuf (fp, NULL, _IOFBF, RUN_BUF_SIZE);
+	return (fp);
+}
+
+
+/*
+ * Read files, taking the next one not yet claimed by another reader, until there are no more.
+ */
+
+static void *reader_thread (void *arg)
+{
+	chunk_t *ch = (chunk_t *)arg;
+
+	while (1) {
+	  char *fname;
+	  FILE *fp;
+
+	  LOCK;
+	  fname = next_file < num_files ? file_names[next_file++] : NULL;
+	  UNLOCK;
+
+	  if (fname == NULL) break;
+
+	  if (strcmp(fname, "-") == 0) {
+	    read_csv (stdin, ch);
+	  }
+	  else {
+	    fp = fopen (fname, "r");
+	    if (fp != NULL) {
+	      read_csv (fp, ch);
+	      fclose (fp);
+	    }
+	    else {
+	      fprintf (stderr, "Can't open %s for read.\n", fname);
+	      exit (1);
+	    }
+	  }
+	}
+	return (NULL);
+}
+
+
+/*
+ * Read from given file, already open, into chunk.
+ * Sort it and move to a temporary file each time it fills up.
+ */
+
+static void read_csv(FILE *fp, chunk_t *ch)
 {
 	char raw[500];
-	char csv[500];
-	int n;
 
 	while (fgets(raw, sizeof(raw), fp) != NULL) {
 
-	  char *next;
-
-	  char *pchan;
-	  char *putime;
-	  char *pisotime;
-	  char *psource;
-	  char *pheard;
-	  char *plevel;
-	  char *perror;
-	  char *pdti;
-	  char *pname;
-	  char *psymbol;
-	  char *platitude;
-	  char *plongitude;
-	  char *pspeed;
-	  char *pcourse;
-	  char *paltitude;
-	  char *pfreq;
-	  char *poffset;
-	  char *ptone;
-	  char *psystem;
-	  char *pstatus;
-	  char *ptelemetry;
-	  char *pcomment;
-
-
-	  n = strlen(raw) - 1;
-	  while (n >= 0 && (raw[n] == '\r' || raw[n] == '\n')) {
-	    raw[n] = '\0';
-	    n--;
-	  }
-
-	  unquote (raw, csv);
+	  if (ch->num_things == ch->max_things) {
+	    spill_chunk (ch);
+	  }
+	  if (parse_csv (raw, &(ch->things[ch->num_things]))) {
+	    ch->num_things++;
+	  }
+	}
+}
+
+
+/*
+ * Extract information from one line of log file.
+ * Returns 1 if it has a position, 0 if it should be ignored.
+ */
+
+static int parse_csv (char *raw, thing_t *t)
+{
+	char csv[500];
+	int n;
+	char *next;
+
+	char *pchan;
+	char *putime;
+	char *pisotime;
+	char *psource;
+	char *pheard;
+	char *plevel;
+	char *perror;
+	char *pdti;
+	char *pname;
+	char *psymbol;
+	char *platitude;
+	char *plongitude;
+	char *pspeed;
+	char *pcourse;
+	char *paltitude;
+	char *pfreq;
+	char *poffset;
+	char *ptone;
+	char *psystem;
+	char *pstatus;
+	char *ptelemetry;
+	char *pcomment;
+
+
+	n = strlen(raw) - 1;
+	while (n >= 0 && (raw[n] == '\r' || raw[n] == '\n')) {
+	  raw[n] = '\0';
+	  n--;
+	}
+
+	unquote (raw, csv);
 	 
-	  //printf ("%s\n", csv);
+	//printf ("%s\n", csv);
 
 /*
  * Separate out the fields.
  */	
-    	  next = csv;
-	  pchan = strsep(&next,"\t");
-	  putime = strsep(&next,"\t");
-	  pisotime = strsep(&next,"\t");
-	  psource = strsep(&next,"\t");
-	  pheard = strsep(&next,"\t");
-	  plevel = strsep(&next,"\t");
-	  perror = strsep(&next,"\t");
-	  pdti = strsep(&next,"\t");
-	  pname = strsep(&next,"\t");
-	  psymbol = strsep(&next,"\t");
-	  platitude = strsep(&next,"\t");
-	  plongitude = strsep(&next,"\t");
-	  pspeed = strsep(&next,"\t");		/* Knots, must convert. */
-	  pcourse = strsep(&next,"\t");
-	  paltitude = strsep(&next,"\t");	/* Meters, already correct units. */
-	  pfreq = strsep(&next,"\t");
-	  poffset = strsep(&next,"\t");
-	  ptone = strsep(&next,"\t");
-	  psystem = strsep(&next,"\t");
-	  pstatus = strsep(&next,"\t");
-	  ptelemetry = strsep(&next,"\t");	/* Currently unused.  Add to description? */
-	  pcomment = strsep(&next,"\t");
-
-	  /* Suppress the 'set but not used' warnings. */
-	  /* Alternatively, we might use __attribute__((unused)) */
-
-	  (void)(ptelemetry);
-	  (void)(psystem);
-	  (void)(psymbol);
-	  (void)(pdti);
-	  (void)(perror);
-	  (void)(plevel);
-	  (void)(pheard);
-	  (void)(psource);
-	  (void)(putime);
+	next = csv;
+	pchan = strsep(&next,"\t");
+	putime = strsep(&next,"\t");
+	pisotime = strsep(&next,"\t");
+	psource = strsep(&next,"\t");
+	pheard = strsep(&next,"\t");
+	plevel = strsep(&next,"\t");
+	perror = strsep(&next,"\t");
+	pdti = strsep(&next,"\t");
+	pname = strsep(&next,"\t");
+	psymbol = strsep(&next,"\t");
+	platitude = strsep(&next,"\t");
+	plongitude = strsep(&next,"\t");
+	pspeed = strsep(&next,"\t");		/* Knots, must convert. */
+	pcourse = strsep(&next,"\t");
+	paltitude = strsep(&next,"\t");	/* Meters, already correct units. */
+	pfreq = strsep(&next,"\t");
+	poffset = strsep(&next,"\t");
+	ptone = strsep(&next,"\t");
+	psystem = strsep(&next,"\t");
+	pstatus = strsep(&next,"\t");
+	ptelemetry = strsep(&next,"\t");	/* Currently unused.  Add to description? */
+	pcomment = strsep(&next,"\t");
+
+	/* Suppress the 'set but not used' warnings. */
+	/* Alternatively, we might use __attribute__((unused)) */
+
+	(void)(ptelemetry);
+	(void)(psystem);
+	(void)(psymbol);
+	(void)(pdti);
+	(void)(perror);
+	(void)(plevel);
+	(void)(pheard);
+	(void)(psource);
+	(void)(putime);
 
 
 /*
  * Skip header line with names of fields.
  */
-	  if (strcmp(pchan, "chan") == 0) {
-	    continue;
-	  }
+	if (strcmp(pchan, "chan") == 0) {
+	  return (0);
+	}
 
 /* 
  * Save only if we have valid data.
  * (Some packets don't contain a position.)
  */
-	  if (pisotime != NULL && strlen(pisotime) > 0 &&
-	      pname != NULL && strlen(pname) > 0 &&
-	      platitude != NULL && strlen(platitude) > 0 &&
-	      plongitude != NULL && strlen(plongitude) > 0) {
+	if (pisotime != NULL && strlen(pisotime) > 0 &&
+	    pname != NULL && strlen(pname) > 0 &&
+	    platitude != NULL && strlen(platitude) > 0 &&
+	    plongitude != NULL && strlen(plongitude) > 0) {
 	
-	    float speed = UNKNOWN_VALUE;
-	    float course = UNKNOWN_VALUE;
-	    float alt = UNKNOWN_VALUE;
-	    char stemp[16], desc[32], comment[256];
+	  float speed = UNKNOWN_VALUE;
+	  float course = UNKNOWN_VALUE;
+	  float alt = UNKNOWN_VALUE;
+	  char stemp[16], desc[32], comment[256];
 
-	    if (pspeed != NULL && strlen(pspeed) > 0) {
-	      speed = KNOTS_TO_METERS_PER_SEC(atof(pspeed));
-	    }
-	    if (pcourse != NULL && strlen(pcourse) > 0) {
-	      course = atof(pcourse);
-	    }
-	    if (paltitude != NULL && strlen(paltitude) > 0) {
-	      alt = atof(platitude);
-	    }
+	  if (pspeed != NULL && strlen(pspeed) > 0) {
+	    speed = KNOTS_TO_METERS_PER_SEC(atof(pspeed));
+	  }
+	  if (pcourse != NULL && strlen(pcourse) > 0) {
+	    course = atof(pcourse);
+	  }
+	  if (paltitude != NULL && strlen(paltitude) > 0) {
+	    alt = atof(paltitude);
+	  }
 
 /* combine freq/offset/tone into one description string. */
 
-	    if (pfreq != NULL && strlen(pfreq) > 0) {
-	      double freq = atof(pfreq);
-	      snprintf (desc, sizeof(desc), "%.3f MHz", freq);
-	    }
-	    else {
-	      strlcpy (desc, "", sizeof(desc));
-	    }
+	  if (pfreq != NULL && strlen(pfreq) > 0) {
+	    double freq = atof(pfreq);
+	    snprintf (desc, sizeof(desc), "%.3f MHz", freq);
+	  }
+	  else {
+	    strlcpy (desc, "", sizeof(desc));
+	  }
 
-	    if (poffset != NULL && strlen(poffset) > 0) {
-	      int offset = atoi(poffset);
-	      if (offset != 0 && offset % 1000 == 0) {
-	        snprintf (stemp, sizeof(stemp), "%+dM", offset / 1000);
-	      }
-	      else {
-	        snprintf (stemp, sizeof(stemp), "%+dk", offset);
-	      }
-	      if (strlen(desc) > 0) strlcat (desc, " ", sizeof(desc));
-	      strlcat (desc, stemp, sizeof(desc));
+	  if (poffset != NULL && strlen(poffset) > 0) {
+	    int offset = atoi(poffset);
+	    if (offset != 0 && offset % 1000 == 0) {
+	      snprintf (stemp, sizeof(stemp), "%+dM", offset / 1000);
 	    }
-
-	    if (ptone != NULL && strlen(ptone) > 0) {
-	      if (*ptone == 'D') {
-	        snprintf (stemp, sizeof(stemp), "DCS %s", ptone+1);
-	      }
-	      else {
-	        snprintf (stemp, sizeof(stemp), "PL %s", ptone);
-	      }
-	      if (strlen(desc) > 0) strlcat (desc, " ", sizeof(desc));
-	      strlcat (desc, stemp, sizeof(desc));
+	    else {
+	      snprintf (stemp, sizeof(stemp), "%+dk", offset);
 	    }
+	    if (strlen(desc) > 0) strlcat (desc, " ", sizeof(desc));
+	    strlcat (desc, stemp, sizeof(desc));
+	  }
 
-	    strlcpy (comment, "", sizeof(comment));
-	    if (pstatus != NULL && strlen(pstatus) > 0) {
-	      strlcpy (comment, pstatus, sizeof(comment));
-	    }
-	    if (pcomment != NULL && strlen(pcomment) > 0) {
-	      if (strlen(comment) > 0) strlcat (comment, ", ", sizeof(comment));
-	      strlcat (comment, pcomment, sizeof(comment));
+	  if (ptone != NULL && strlen(ptone) > 0) {
+	    if (*ptone == 'D') {
+	      snprintf (stemp, sizeof(stemp), "DCS %s", ptone+1);
 	    }
-	    
-	    if (num_things == max_things) {
-	      /* It's full.  Grow the array by 50%. */
-  	      max_things += max_things / 2;
-	      things = realloc (things, max_things*sizeof(thing_t));	
+	    else {
+	      snprintf (stemp, sizeof(stemp), "PL %s", ptone);
 	    }
+	    if (strlen(desc) > 0) strlcat (desc, " ", sizeof(desc));
+	    strlcat (desc, stemp, sizeof(desc));
+	  }
 
-	    things[num_things].lat = atof(platitude);
-	    things[num_things].lon = atof(plongitude);
-	    things[num_things].speed = speed;
-	    things[num_things].course = course;
-	    things[num_things].alt = alt;
-	    strlcpy (things[num_things].time, pisotime, sizeof(things[num_things].time));
-	    strlcpy (things[num_things].name, pname, sizeof(things[num_things].name));
-	    strlcpy (things[num_things].desc, desc, sizeof(things[num_things].desc));
-	    strlcpy (things[num_things].comment, comment, sizeof(things[num_things].comment));
-
-	    num_things++;
+	  strlcpy (comment, "", sizeof(comment));
+	  if (pstatus != NULL && strlen(pstatus) > 0) {
+	    strlcpy (comment, pstatus, sizeof(comment));
+	  }
+	  if (pcomment != NULL && strlen(pcomment) > 0) {
+	    if (strlen(comment) > 0) strlcat (comment, ", ", sizeof(comment));
+	    strlcat (comment, pcomment, sizeof(comment));
 	  }
+
+	  memset (t, 0, sizeof(thing_t));
+	  t->lat = atof(platitude);
+	  t->lon = atof(plongitude);
+	  t->speed = speed;
+	  t->course = course;
+	  t->alt = alt;
+	  strlcpy (t->time, pisotime, sizeof(t->time));
+	  strlcpy (t->name, pname, sizeof(t->name));
+	  strlcpy (t->desc, desc, sizeof(t->desc));
+	  strlcpy (t->comment, comment, sizeof(t->comment));
+
+	  return (1);
 	}
+	return (0);
 }
 
 
@@ -352,6 +595,136 @@ static int compar(const void *a, const void *b)
 }
 
 
+/*
+ * Sort full chunk and write it to a temporary file.  Empty the chunk for reuse.
+ */
+
+static void spill_chunk (chunk_t *ch)
+{
+	run_t *r = calloc (1, sizeof(run_t));
+
+	qsort (ch->things, ch->num_things, sizeof(thing_t), compar);
+
+	r->fp = temp_file ();
+	if (fwrite (ch->things, sizeof(thing_t), ch->num_things, r->fp) != (size_t)(ch->num_things)) {
+	  fprintf (stderr, "Error writing temporary file.  Is the disk full?\n");
+	  exit (1);
+	}
+	r->count = ch->num_things;
+	ch->num_things = 0;
+
+	add_run (r);
+}
+
+
+static void add_run (run_t *r)
+{
+	LOCK;
+	if (num_runs == max_runs) {
+	  max_runs += max_runs / 2 + 16;
+	  runs = realloc (runs, max_runs * sizeof(run_t *));
+	}
+	runs[num_runs++] = r;
+	UNLOCK;
+}
+
+
+/*
+ * Get next record of a run into r->cur.  Returns 0 when there are no more.
+ */
+
+static int run_next (run_t *r)
+{
+	if (r->next >= r->count) {
+	  return (0);
+	}
+	if (r->mem != NULL) {
+	  r->cur = r->mem[r->next];
+	}
+	else if (fread (&(r->cur), sizeof(thing_t), 1, r->fp) != 1) {
+	  fprintf (stderr, "Error reading temporary file.\n");
+	  exit (1);
+	}
+	r->next++;
+	return (1);
+}
+
+
+/*
+ * Merge sorted runs and pass each record, in order, to put function.
+ * The runs are released when done.
+ *
+ * A small binary heap keeps the run with the lowest current record on top.
+ */
+
+static void sift_down (run_t **h, int n, int i)
+{
+	while (1) {
+	  int low = i;
+	  int c = 2 * i + 1;
+	  run_t *tmp;
+
+	  if (c < n && compar(&(h[c]->cur), &(h[low]->cur)) < 0) low = c;
+	  if (c + 1 < n && compar(&(h[c+1]->cur), &(h[low]->cur)) < 0) low = c + 1;
+	  if (low == i) break;
+	  tmp = h[i]; h[i] = h[low]; h[low] = tmp;
+	  i = low;
+	}
+}
+
+static void merge_runs (run_t **r, int n, void (*put)(thing_t *, void *), void *ctx)
+{
+	run_t **heap = malloc (n * sizeof(run_t *));
+	int num_heap = 0;
+	int i;
+
+	for (i = 0; i < n; i++) {
+	  r[i]->next = 0;
+	  if (r[i]->fp != NULL) {
+	    fflush (r[i]->fp);
+	    rewind (r[i]->fp);
+	  }
+	  if (run_next(r[i])) {
+	    heap[num_heap++] = r[i];
+	  }
+	}
+	for (i = num_heap / 2 - 1; i >= 0; i--) {
+	  sift_down (heap, num_heap, i);
+	}
+
+	while (num_heap > 0) {
+	  (*put) (&(heap[0]->cur), ctx);
+	  if ( ! run_next(heap[0])) {
+	    heap[0] = heap[--num_heap];
+	  }
+	  sift_down (heap, num_heap, 0);
+	}
+	free (heap);
+
+	for (i = 0; i < n; i++) {
+	  if (r[i]->fp != NULL) fclose (r[i]->fp);
+	  if (r[i]->mem != NULL) free (r[i]->mem);
+	  free (r[i]);
+	}
+}
+
+
+/*
+ * Merge output going to a longer run in a temporary file.
+ */
+
+static void put_file (thing_t *t, void *ctx)
+{
+	run_t *r = (run_t *)ctx;
+
+	if (fwrite (t, sizeof(thing_t), 1, r->fp) != 1) {
+	  fprintf (stderr, "Error writing temporary file.  Is the disk full?\n");
+	  exit (1);
+	}
+	r->count++;
+}
+
+
 /*
  * Take quoting out of CSV data.
  * Replace field separator commas with tabs while retaining 
@@ -462,63 +835,154 @@ static void xml_text (char *in, char *out)
 
 
 /*
- * Process all things with the same name.
- * They should be sorted by time.
+ * Process all things with the same name, as they arrive in order of time.
  * For stationary entities, generate just one GPX waypoint.
  * For moving entities, generate a GPX track.
+ *
+ * We don't know whether it is moving until the position changes so points
+ * before that are held.  Usually there are only a few but a fixed station
+ * could have years of beacons so they overflow into a temporary file.
  */
 
-static void process_things (int first, int last)
+#define MAX_PENDING 1000
+
+static struct {
+	int active;		/* Group in progress. */
+	int moved;		/* Track has been started. */
+	thing_t first;
+	thing_t last;
+	char safe_comment[120];	/* Comment from first, used for all track points. */
+	thing_t pending[MAX_PENDING];
+	int num_pending;
+	FILE *pending_fp;	/* Overflow from pending. */
+	long num_pending_fp;
+} grp;
+
+
+static void put_trkpt (thing_t *t)
 {
-	//printf ("process %d to %d\n", first, last);
-	int i;
-	int moved = 0;
-	char safe_name[30];
-	char safe_comment[120];
+	printf ("      <trkpt lat=\"%.6f\" lon=\"%.6f\">\n", t->lat, t->lon);
+	if (t->speed != UNKNOWN_VALUE) {
+	  printf ("        <speed>%.1f</speed>\n", t->speed);
+	}
+	if (t->course != UNKNOWN_VALUE) {
+	  printf ("        <course>%.1f</course>\n", t->course);
+	}
+	if (t->alt != UNKNOWN_VALUE) {
+	  printf ("        <ele>%.1f</ele>\n", t->alt);
+	}
+	if (strlen(t->desc) > 0) {
+	  printf ("        <desc>%s</desc>\n", t->desc);
+	}
+	if (strlen(grp.safe_comment) > 0) {
+	  printf ("        <cmt>%s</cmt>\n", grp.safe_comment);
+	}
+	printf ("        <time>%s</time>\n", t->time);
+	printf ("      </trkpt>\n");
+}
+
+
+static void discard_pending (void)
+{
+	grp.num_pending = 0;
+	if (grp.pending_fp != NULL) {
+	  fclose (grp.pending_fp);
+	  grp.pending_fp = NULL;
+	}
+	grp.num_pending_fp = 0;
+}
+
+
+static void put_gpx (thing_t *t, void *ctx)
+{
+	(void)ctx;
 
-	for (i=first+1; i<=last; i++) {
-	  if (things[i].lat != things[first].lat) moved = 1;
-	  if (things[i].lon != things[first].lon) moved = 1;
+	if (grp.active && strcmp(t->name, grp.first.name) != 0) {
+	  end_group ();
 	}
 
-	if (moved) {
+	if ( ! grp.active) {
+	  grp.active = 1;
+	  grp.moved = 0;
+	  grp.first = *t;
+	}
+	grp.last = *t;
+
+	if (grp.moved) {
+	  put_trkpt (t);
+	  return;
+	}
+
+	if (t->lat != grp.first.lat || t->lon != grp.first.lon) {
 
 /*
- * Generate track for moving thing.
+ * Generate track for moving thing, starting with the points held so far.
  */
-	  xml_text (things[first].name, safe_name);
-	  xml_text (things[first].comment, safe_comment);
+	  char safe_name[30];
+	  long i;
+
+	  grp.moved = 1;
+
+	  xml_text (grp.first.name, safe_name);
+	  xml_text (grp.first.comment, grp.safe_comment);
 
 	  printf ("  <trk>\n");
 	  printf ("    <name>%s</name>\n", safe_name);
 	  printf ("    <trkseg>\n");
 
-	  for (i=first; i<=last; i++) {
-	    printf ("      <trkpt lat=\"%.6f\" lon=\"%.6f\">\n", things[i].lat, things[i].lon);
-	    if (things[i].speed != UNKNOWN_VALUE) {
-	      printf ("        <speed>%.1f</speed>\n", things[i].speed);
-	    }
-	    if (things[i].course != UNKNOWN_VALUE) {
-	      printf ("        <course>%.1f</course>\n", things[i].course);
-	    }
-	    if (things[i].alt != UNKNOWN_VALUE) {
-	      printf ("        <ele>%.1f</ele>\n", things[i].alt);
-	    }
-	    if (strlen(things[i].desc) > 0) {
-	      printf ("        <desc>%s</desc>\n", things[i].desc);
-	    }
-	    if (strlen(safe_comment) > 0) {
-	      printf ("        <cmt>%s</cmt>\n", safe_comment);
+	  for (i = 0; i < grp.num_pending; i++) {
+	    put_trkpt (&(grp.pending[i]));
+	  }
+	  if (grp.pending_fp != NULL) {
+	    thing_t held;
+
+	    rewind (grp.pending_fp);
+	    for (i = 0; i < grp.num_pending_fp; i++) {
+	      if (fread (&held, sizeof(thing_t), 1, grp.pending_fp) != 1) {
+	        fprintf (stderr, "Error reading temporary file.\n");
+	        exit (1);
+	      }
+	      put_trkpt (&held);
 	    }
-	    printf ("        <time>%s</time>\n", things[i].time);
-	    printf ("      </trkpt>\n");
 	  }
+	  discard_pending ();
+
+	  put_trkpt (t);
+	  return;
+	}
 
+	if (grp.num_pending < MAX_PENDING) {
+	  grp.pending[grp.num_pending++] = *t;
+	}
+	else {
+	  if (grp.pending_fp == NULL) {
+	    grp.pending_fp = temp_file ();
+	  }
+	  if (fwrite (t, sizeof(thing_t), 1, grp.pending_fp) != 1) {
+	    fprintf (stderr, "Error writing temporary file.  Is the disk full?\n");
+	    exit (1);
+	  }
+	  grp.num_pending_fp++;
+	}
+}
+
+
+static void end_group (void)
+{
+	char safe_name[30];
+	char safe_comment[120];
+
+	if ( ! grp.active) {
+	  return;
+	}
+
+	if (grp.moved) {
 	  printf ("    </trkseg>\n");
 	  printf ("  </trk>\n");
 
 	  /* Also generate waypoint for last location. */
 	}
+	discard_pending ();
 
 	// Future possibility?
 	// <sym>Symbol Name</sym>	-- not standardized.
@@ -526,19 +990,21 @@ static void process_things (int first, int last)
 /*
  * Generate waypoint for stationary thing or last known position for moving thing.
  */
-	xml_text (things[last].name, safe_name);
-	xml_text (things[last].comment, safe_comment);
+	xml_text (grp.last.name, safe_name);
+	xml_text (grp.last.comment, safe_comment);
 
-	printf ("  <wpt lat=\"%.6f\" lon=\"%.6f\">\n", things[last].lat, things[last].lon);
-	if (things[last].alt != UNKNOWN_VALUE) {
-	  printf ("    <ele>%.1f</ele>\n", things[last].alt);
+	printf ("  <wpt lat=\"%.6f\" lon=\"%.6f\">\n", grp.last.lat, grp.last.lon);
+	if (grp.last.alt != UNKNOWN_VALUE) {
+	  printf ("    <ele>%.1f</ele>\n", grp.last.alt);
 	}
-	if (strlen(things[i].desc) > 0) {
-	  printf ("    <desc>%s</desc>\n", things[i].desc);
+	if (strlen(grp.last.desc) > 0) {
+	  printf ("    <desc>%s</desc>\n", grp.last.desc);
 	}
 	if (strlen(safe_comment) > 0) {
 	  printf ("    <cmt>%s</cmt>\n", safe_comment);
 	}
 	printf ("    <name>%s</name>\n", safe_name);
 	printf ("  </wpt>\n");
+
+	grp.active = 0;
 }
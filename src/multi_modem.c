@@ -103,6 +103,7 @@
 #include "fx25.h"
 #include "version.h"
 #include "ais.h"
+#include "audio_stats.h"
 
 
 
@@ -137,6 +138,13 @@ static struct {
 
 static int process_age[MAX_CHANS];
 
+
+// Number of audio samples processed for each channel since start up.
+// Compared with the audio device time reference to find out when
+// the end of a frame was captured.
+
+static long long sample_count[MAX_CHANS];
+
 static void pick_best_candidate (int chan);
 
 
@@ -168,6 +176,7 @@ void multi_modem_init (struct audio_s *pa)
 	save_audio_config_p = pa;
 
 	memset (candidate, 0, sizeof(candidate));
+	memset (sample_count, 0, sizeof(sample_count));
 
 	demod_init (save_audio_config_p);
 	hdlc_rec_init (save_audio_config_p);
@@ -242,6 +251,8 @@ void multi_modem_process_sample (int chan, int audio_sample)
 
 	dc_average[chan] = dc_average[chan] * 0.999f + (float)audio_sample * 0.001f;
 
+	sample_count[chan]++;
+
 
 // Issue 128.  Someone ran into this.
 
@@ -360,6 +371,22 @@ void multi_modem_process_rec_packet (int chan, int subchan, int slice, packet_t
 	  return;	/* oops!  why would it fail? */
 	}
 
+/*
+ * We are called synchronously from the demodulator and HDLC decoder so the
+ * current sample is the one at the end of the frame.  Convert that to the
+ * time it was captured, before any delays from picking the best candidate,
+ * queuing, or processing by the application.
+ */
+	long long frames_ref;
+	double time_ref;
+	double rx_time = 0;
+	int a = ACHAN2ADEV(chan);
+
+	if (audio_stats_time_ref (a, &frames_ref, &time_ref)) {
+	  rx_time = time_ref - (double)(frames_ref - sample_count[chan]) / save_audio_config_p->adev[a].samples_per_sec;
+	}
+	ax25_set_rx_time (pp, rx_time, sample_count[chan]);
+
 /*
  * If only one demodulator/slicer, and no FX.25 in progress,
  * push it thru and forget about all this foolishness.
@@ -0,0 +1,136 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2026  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      pktbench.c
+ *
+ * Purpose:   	Measure memory and time for a lot of queued packet objects.
+ *
+ * Description:	This is what the transmit queue, SATgate delay queue and
+ *		receive queue do with packets:  build from text or a frame,
+ *		make a copy, keep it on a list for a while, look at the
+ *		addresses and information part, then delete.
+ *
+ *		Only the ordinary ax25_pad.h functions are used so the
+ *		same program can be built with an older ax25_pad.c for
+ *		comparison.
+ *
+ * Usage:	pktbench  [ packets  [ rounds ] ]
+ *
+ *		Default is 250 packets and 20000 rounds.  ax25_new complains
+ *		about a leak when more than 256 packets exist at once, so
+ *		that's about as many as a real queue will ever hold.
+ *		Heap in use is reported only for glibc.
+ *		For cache misses, run it under "perf stat -e cache-misses".
+ *
+ *---------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#if __GLIBC__
+#include <malloc.h>
+#endif
+
+#include "ax25_pad.h"
+#include "textcolor.h"
+#include "dtime_now.h"
+
+
+/* Typical APRS traffic. */
+
+static char *sample[] = {
+	"W1AAA-9>APDW17,WIDE1-1,WIDE2-1:!4237.14N/07120.83W>360/040 mobile",
+	"N2BBB>APRS,K1XX-3*,WIDE2-1:@092345z4903.50N/07201.75W_220/004g005t077r000p000P000h50b09900wRSW",
+	"KC3CCC-7>T2QW4P,WIDE1-1:`c52l!k>/]\"4L}=",
+	"W4DDD>APN391:;147.210NC*111111z4134.45N/07235.06WrT100 R40m" };
+
+
+int main (int argc, char *argv[])
+{
+	int npackets = 250;
+	int rounds = 20000;
+	packet_t *all;
+	long sum = 0;
+	double start;
+
+	if (argc >= 2) npackets = atoi(argv[1]);
+	if (argc >= 3) rounds = atoi(argv[2]);
+	if (npackets < 1 || npackets > 250 || rounds < 1) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Usage: %s [ packets [ rounds ] ]\n", argv[0]);
+	  dw_printf ("Number of packets must be 1 to 250.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	all = malloc (npackets * sizeof(packet_t));
+	assert (all != NULL);
+
+#if __GLIBC__ && __GLIBC_PREREQ(2,33)
+	size_t heap_before = mallinfo2().uordblks;
+#endif
+
+	start = dtime_monotonic();
+
+	for (int r = 0; r < rounds; r++) {
+	  packet_t head = NULL;
+
+	  for (int n = 0; n < npackets; n++) {
+	    packet_t pp = ax25_from_text (sample[n % 4], 1);
+	    assert (pp != NULL);
+	    all[n] = ax25_dup (pp);
+	    ax25_delete (pp);
+	    ax25_set_nextp (all[n], head);
+	    head = all[n];
+	  }
+
+#if __GLIBC__ && __GLIBC_PREREQ(2,33)
+	  if (r == 0) {
+	    size_t heap = mallinfo2().uordblks - heap_before;
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("%d packets queued: heap in use %zu bytes, %zu bytes per packet.\n",
+			npackets, heap, heap / (size_t)npackets);
+	  }
+#endif
+
+	  for (packet_t pp = head; pp != NULL; pp = ax25_get_nextp(pp)) {
+	    unsigned char *pinfo;
+	    sum += ax25_get_info (pp, &pinfo);
+	    sum += ax25_get_ssid (pp, AX25_SOURCE);
+	    sum += pinfo[0];
+	  }
+
+	  for (int n = 0; n < npackets; n++) {
+	    ax25_delete (all[n]);
+	  }
+	}
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("%d rounds of %d packets: %.3f seconds.  (%ld)\n", rounds, npackets, dtime_monotonic() - start, sum);
+
+	free (all);
+	exit (EXIT_SUCCESS);
+}
+
+/* end pktbench.c */
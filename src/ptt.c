@@ -54,6 +54,15 @@
  *
  * Version 1.5:	Ability to use GPIO pins of CM108/CM119 for PTT signal.
  *
+ * Version 1.7:	Keep the GPIO "value" files open rather than opening and closing
+ *		them for each transition.  This takes the file system lookups out
+ *		of the transmitter keying path and the channel busy check.
+ *
+ *		Add GPIOD method which uses the GPIO character device (/dev/gpiochipN),
+ *		the replacement for the deprecated /sys/class/gpio interface.
+ *		Inputs are edge triggered so TXINH is a simple variable
+ *		reference rather than a system call.
+ *
  *
  * References:	http://www.robbayer.com/files/serial-win.pdf
  *
@@ -142,6 +151,7 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <stddef.h>
 #include <assert.h>
 #include <string.h>
 #include <time.h>
@@ -162,6 +172,11 @@
 #include <hamlib/rig.h>
 #endif
 
+#ifdef USE_GPIOD
+#include <linux/gpio.h>
+#include <poll.h>
+#endif
+
 /* So we can have more common code for fd. */
 typedef int HANDLE;
 #define INVALID_HANDLE_VALUE (-1)
@@ -203,6 +218,30 @@ static struct audio_s *save_audio_config_p;	/* Save config information for later
 
 static int ptt_debug_level = 0;
 
+#ifndef __WIN32__
+
+static int gpio_out_fd[MAX_CHANS][NUM_OCTYPES];
+					/* Open "value" file for GPIO method, or */
+					/* line request for GPIOD method. */
+					/* Stays open until ptt_term. */
+static int gpio_in_fd[MAX_CHANS][NUM_ICTYPES];
+					/* Same thing for inputs. */
+#endif
+
+#ifdef USE_GPIOD
+static volatile int gpiod_in_value[MAX_CHANS][NUM_ICTYPES];
+					/* Most recent input line level, before inversion. */
+					/* Maintained by gpiod_input_thread. */
+
+static pthread_t gpiod_input_tid[MAX_CHANS][NUM_ICTYPES];
+static int gpiod_input_started[MAX_CHANS][NUM_ICTYPES];
+
+static int gpiod_wake_pipe[2] = { -1, -1 };
+					/* ptt_term writes to this so the input */
+					/* threads stop.  Closing the line doesn't */
+					/* wake up a read already waiting on it. */
+#endif
+
 void ptt_set_debug(int debug)
 {
 	ptt_debug_level = debug;
@@ -628,15 +667,193 @@ void export_gpio(int ch, int ot, int invert, int direction)
 /*
  * Make sure that we have access to 'value'.
  * Do it once here, rather than each time we want to use it.
+ *
+ * Since version 1.7, we also keep it open so later changes and
+ * inquiries don't need to go thru the file system each time.
  */
 
 	snprintf (gpio_value_path, sizeof(gpio_value_path), "/sys/class/gpio/%s/value", gpio_name);
 	get_access_to_gpio (gpio_value_path);
+
+	fd = open(gpio_value_path, direction ? O_WRONLY : O_RDONLY);
+	if (fd < 0) {
+	  int e = errno;
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Error opening %s\n", gpio_value_path);
+	  dw_printf ("%s\n", strerror(e));
+	  exit (1);
+	}
+
+	if (direction) {
+	  gpio_out_fd[ch][ot] = fd;
+	}
+	else {
+	  gpio_in_fd[ch][ot] = fd;
+	}
 }
 
 #endif   /* not __WIN32__ */
 
 
+
+/*-------------------------------------------------------------------
+ *
+ * Name:	gpiod_request_line
+ *
+ * Purpose:	Obtain a GPIO line thru the GPIO character device.
+ *
+ * Inputs:	chip_name	- Name of GPIO chip, e.g.  gpiochip0  or  /dev/gpiochip0
+ *		line		- Line offset within the chip.
+ *		what		- PTT, DCD, TXINH, etc. for error messages.
+ *		direction	- 0 for input, 1 for output.
+ *		initial		- Initial output level, already inverted if appropriate.
+ *
+ * Returns:	File descriptor for the line request or -1 for failure.
+ *
+ * Description:	This is the replacement for the /sys/class/gpio interface.
+ *		There is no "export" step and the kernel releases the line
+ *		when the file descriptor is closed.
+ *		Inputs are requested with both edges enabled so we are
+ *		told about changes rather than asking each time.
+ *
+ *		We use the kernel interface directly, rather than libgpiod,
+ *		to avoid an extra dependency for something this simple.
+ *
+ *------------------------------------------------------------------*/
+
+#ifdef USE_GPIOD
+
+static int gpiod_request_line (const char *chip_name, int line, const char *what, int direction, int initial)
+{
+	char chip_path[40];
+	int chip_fd;
+	struct gpio_v2_line_request req;
+
+	if (chip_name[0] == '/') {
+	  strlcpy (chip_path, chip_name, sizeof(chip_path));
+	}
+	else {
+	  snprintf (chip_path, sizeof(chip_path), "/dev/%s", chip_name);
+	}
+
+	chip_fd = open (chip_path, O_RDWR | O_CLOEXEC);
+	if (chip_fd < 0) {
+	  int e = errno;
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Error opening %s for %s control.\n", chip_path, what);
+	  dw_printf ("%s\n", strerror(e));
+	  if (e == EACCES) {
+	    dw_printf ("If operating system has 'gpio' group, add your user id to it.\n");
+	  }
+	  return (-1);
+	}
+
+	memset (&req, 0, sizeof(req));
+	req.offsets[0] = line;
+	req.num_lines = 1;
+	strlcpy (req.consumer, "direwolf", sizeof(req.consumer));
+
+	if (direction) {
+	  req.config.flags = GPIO_V2_LINE_FLAG_OUTPUT;
+	  req.config.num_attrs = 1;
+	  req.config.attrs[0].attr.id = GPIO_V2_LINE_ATTR_ID_OUTPUT_VALUES;
+	  req.config.attrs[0].attr.values = initial ? 1 : 0;
+	  req.config.attrs[0].mask = 1;
+	}
+	else {
+	  req.config.flags = GPIO_V2_LINE_FLAG_INPUT | GPIO_V2_LINE_FLAG_EDGE_RISING | GPIO_V2_LINE_FLAG_EDGE_FALLING;
+	}
+
+	if (ioctl (chip_fd, GPIO_V2_GET_LINE_IOCTL, &req) < 0) {
+	  int e = errno;
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not get %s line %d for %s control.\n", chip_path, line, what);
+	  dw_printf ("%s\n", strerror(e));
+	  if (e == EBUSY) {
+	    dw_printf ("Some other application, or the /sys/class/gpio interface, is already using it.\n");
+	  }
+	  close (chip_fd);
+	  return (-1);
+	}
+
+	close (chip_fd);		// Line request remains valid.
+
+	if (ptt_debug_level >= 2) {
+	  text_color_set(DW_COLOR_DEBUG);
+	  dw_printf ("%s line %d, fd %d, for %s %s.\n", chip_path, line, req.fd, what, direction ? "output" : "input");
+	}
+
+	return (req.fd);
+
+} /* end gpiod_request_line */
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:	gpiod_input_thread
+ *
+ * Purpose:	Keep track of an input line level by waiting for edge events.
+ *
+ * Inputs:	arg	- Channel * NUM_ICTYPES + input type.
+ *
+ * Description:	get_input is called frequently while waiting for a clear
+ *		channel.  Rather than a system call each time, we sleep here
+ *		until the kernel reports a change and save the new level
+ *		where get_input can find it.
+ *
+ *		We also wait for gpiod_wake_pipe to become readable.
+ *		That means ptt_term wants us to stop.
+ *
+ *------------------------------------------------------------------*/
+
+static void * gpiod_input_thread (void *arg)
+{
+	int chan = (int)(ptrdiff_t)arg / NUM_ICTYPES;
+	int it = (int)(ptrdiff_t)arg % NUM_ICTYPES;
+	struct gpio_v2_line_event ev;
+
+	while (1) {
+	  struct pollfd fds[2];
+
+	  fds[0].fd = gpio_in_fd[chan][it];
+	  fds[0].events = POLLIN;
+	  fds[1].fd = gpiod_wake_pipe[0];
+	  fds[1].events = POLLIN;
+
+	  if (poll (fds, 2, -1) < 0) {
+	    if (errno == EINTR) continue;
+	    break;
+	  }
+	  if (fds[1].revents != 0) {
+	    break;			// ptt_term.
+	  }
+	  if (fds[0].revents == 0) {
+	    continue;
+	  }
+
+	  int n = read (gpio_in_fd[chan][it], &ev, sizeof(ev));
+
+	  if (n != sizeof(ev)) {
+	    if (n < 0 && errno == EINTR) continue;
+	    // Something went badly wrong.
+	    break;
+	  }
+
+	  gpiod_in_value[chan][it] = (ev.id == GPIO_V2_LINE_EVENT_RISING_EDGE);
+
+	  if (ptt_debug_level >= 1) {
+	    text_color_set(DW_COLOR_DEBUG);
+	    dw_printf ("Channel %d input %d is now %d.\n", chan, it, gpiod_in_value[chan][it]);
+	  }
+	}
+
+	return (NULL);
+
+} /* end gpiod_input_thread */
+
+#endif   /* USE_GPIOD */
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        ptt_init
@@ -654,6 +871,7 @@ void export_gpio(int ch, int ot, int invert, int direction)
  *					PTT_METHOD_LPT - Parallel printer port. 
  *                  			PTT_METHOD_HAMLIB - HAMLib rig control.
  *					PTT_METHOD_CM108 - GPIO pins of CM108 etc. USB Audio.
+ *					PTT_METHOD_GPIOD - GPIO character device.
  *			
  *			ptt_device	Name of serial port device.  
  *					 e.g. COM1 or /dev/ttyS0. 
@@ -695,6 +913,7 @@ static RIG *rig[MAX_CHANS][NUM_OCTYPES];
 #endif
 
 static char otnames[NUM_OCTYPES][8];
+static char itnames[NUM_ICTYPES][8];
 
 void ptt_init (struct audio_s *audio_config_p)
 {
@@ -715,6 +934,7 @@ void ptt_init (struct audio_s *audio_config_p)
 	strlcpy (otnames[OCTYPE_PTT], "PTT", sizeof(otnames[OCTYPE_PTT]));
 	strlcpy (otnames[OCTYPE_DCD], "DCD", sizeof(otnames[OCTYPE_DCD]));
 	strlcpy (otnames[OCTYPE_CON], "CON", sizeof(otnames[OCTYPE_CON]));
+	strlcpy (itnames[ICTYPE_TXINH], "TXINH", sizeof(itnames[ICTYPE_TXINH]));
 
 
 	for (ch = 0; ch < MAX_CHANS; ch++) {
@@ -723,6 +943,9 @@ void ptt_init (struct audio_s *audio_config_p)
 	  for (ot = 0; ot < NUM_OCTYPES; ot++) {
 
 	    ptt_fd[ch][ot] = INVALID_HANDLE_VALUE;
+#ifndef __WIN32__
+	    gpio_out_fd[ch][ot] = -1;
+#endif
 #if USE_HAMLIB
 	    rig[ch][ot] = NULL;
 #endif
@@ -740,6 +963,12 @@ void ptt_init (struct audio_s *audio_config_p)
 		audio_config_p->achan[ch].octrl[ot].ptt_invert);
 	    }
 	  }
+#ifndef __WIN32__
+	  int it;
+	  for (it = 0; it < NUM_ICTYPES; it++) {
+	    gpio_in_fd[ch][it] = -1;
+	  }
+#endif
 	}
 
 /*
@@ -907,6 +1136,90 @@ void ptt_init (struct audio_s *audio_config_p)
 #endif
 
 
+/*
+ * Set up GPIO character device lines.
+ */
+
+#ifdef USE_GPIOD
+
+	for (ch = 0; ch < MAX_CHANS; ch++) {
+	  if (save_audio_config_p->chan_medium[ch] == MEDIUM_RADIO) {
+
+	    int ot;	// output control type, PTT, DCD, CON, ...
+	    int it;	// input control type
+
+	    for (ot = 0; ot < NUM_OCTYPES; ot++) {
+	      if (audio_config_p->achan[ch].octrl[ot].ptt_method == PTT_METHOD_GPIOD) {
+
+	        // Initial state is off, which is high if inverted.
+
+	        gpio_out_fd[ch][ot] = gpiod_request_line (audio_config_p->achan[ch].octrl[ot].out_gpio_name,
+					audio_config_p->achan[ch].octrl[ot].out_gpio_num,
+					otnames[ot], 1,
+					audio_config_p->achan[ch].octrl[ot].ptt_invert);
+
+	        if (gpio_out_fd[ch][ot] < 0) {
+	          /* Don't try using it later if device open failed. */
+	          audio_config_p->achan[ch].octrl[ot].ptt_method = PTT_METHOD_NONE;
+	        }
+	      }
+	    }
+
+	    for (it = 0; it < NUM_ICTYPES; it++) {
+	      if (audio_config_p->achan[ch].ictrl[it].method == PTT_METHOD_GPIOD) {
+
+	        gpio_in_fd[ch][it] = gpiod_request_line (audio_config_p->achan[ch].ictrl[it].in_gpio_name,
+					audio_config_p->achan[ch].ictrl[it].in_gpio_num,
+					itnames[it], 0, 0);
+
+	        struct gpio_v2_line_values lv;
+	        memset (&lv, 0, sizeof(lv));
+	        lv.mask = 1;
+
+	        if (gpio_in_fd[ch][it] >= 0 && ioctl (gpio_in_fd[ch][it], GPIO_V2_LINE_GET_VALUES_IOCTL, &lv) < 0) {
+	          int e = errno;
+	          text_color_set(DW_COLOR_ERROR);
+	          dw_printf ("Error getting initial value of channel %d %s input.\n", ch, itnames[it]);
+	          dw_printf ("%s\n", strerror(e));
+	          close (gpio_in_fd[ch][it]);
+	          gpio_in_fd[ch][it] = -1;
+	        }
+
+	        if (gpio_in_fd[ch][it] >= 0 && gpiod_wake_pipe[0] < 0 && pipe (gpiod_wake_pipe) != 0) {
+	          text_color_set(DW_COLOR_ERROR);
+	          perror("Could not create pipe for GPIO input thread");
+	          gpiod_wake_pipe[0] = gpiod_wake_pipe[1] = -1;
+	          close (gpio_in_fd[ch][it]);
+	          gpio_in_fd[ch][it] = -1;
+	        }
+
+	        if (gpio_in_fd[ch][it] >= 0) {
+	          int e;
+
+	          gpiod_in_value[ch][it] = lv.bits & 1;
+
+	          e = pthread_create (&(gpiod_input_tid[ch][it]), NULL, gpiod_input_thread, (void *)(ptrdiff_t)(ch * NUM_ICTYPES + it));
+	          if (e != 0) {
+	            text_color_set(DW_COLOR_ERROR);
+	            perror("Could not create GPIO input thread");
+	            close (gpio_in_fd[ch][it]);
+	            gpio_in_fd[ch][it] = -1;
+	          }
+	          else {
+	            gpiod_input_started[ch][it] = 1;
+	          }
+	        }
+
+	        if (gpio_in_fd[ch][it] < 0) {
+	          audio_config_p->achan[ch].ictrl[it].method = PTT_METHOD_NONE;
+	        }
+	      }
+	    }
+	  }
+	}
+#endif
+
+
 
 /*
  * Set up parallel printer port.
@@ -1109,6 +1422,13 @@ void ptt_init (struct audio_s *audio_config_p)
 			audio_config_p->achan[ch].octrl[ot].out_gpio_num,
 			ch,
 			otnames[ot]);
+
+/*
+ * Set initial state off.
+ * This also opens the device, while we are still single threaded,
+ * so it is ready to go when we first need to transmit.
+ */
+	        ptt_set (ot, ch, 0);
 	      }
 	    }
 	  }
@@ -1271,32 +1591,41 @@ void ptt_set (int ot, int chan, int ptt_signal)
 #if __WIN32__
 #else
 
-	if (save_audio_config_p->achan[chan].octrl[ot].ptt_method == PTT_METHOD_GPIO) {
-	  int fd;
-	  char gpio_value_path[80];
-	  char stemp[16];
+	if (save_audio_config_p->achan[chan].octrl[ot].ptt_method == PTT_METHOD_GPIO &&
+		gpio_out_fd[chan][ot] >= 0) {
 
-	  snprintf (gpio_value_path, sizeof(gpio_value_path), "/sys/class/gpio/%s/value", save_audio_config_p->achan[chan].octrl[ot].out_gpio_name);
+	  char stemp = ptt ? '1' : '0';
 
-	  fd = open(gpio_value_path, O_WRONLY);
-	  if (fd < 0) {
+	  if (pwrite (gpio_out_fd[chan][ot], &stemp, 1, 0) != 1) {
 	    int e = errno;
 	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Error opening %s to set %s signal.\n", stemp, otnames[ot]);
+	    dw_printf ("Error setting GPIO %d for %s\n", save_audio_config_p->achan[chan].octrl[ot].out_gpio_num, otnames[ot]);
 	    dw_printf ("%s\n", strerror(e));
-	    return;
 	  }
+	}
+#endif
 
-	  snprintf (stemp, sizeof(stemp), "%d", ptt);
+/*
+ * Using GPIO character device?
+ */
 
-	  if (write (fd, stemp, 1) != 1) {
+#ifdef USE_GPIOD
+
+	if (save_audio_config_p->achan[chan].octrl[ot].ptt_method == PTT_METHOD_GPIOD &&
+		gpio_out_fd[chan][ot] >= 0) {
+
+	  struct gpio_v2_line_values lv;
+
+	  lv.mask = 1;
+	  lv.bits = ptt ? 1 : 0;
+
+	  if (ioctl (gpio_out_fd[chan][ot], GPIO_V2_LINE_SET_VALUES_IOCTL, &lv) < 0) {
 	    int e = errno;
 	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Error setting GPIO %d for %s\n", save_audio_config_p->achan[chan].octrl[ot].out_gpio_num, otnames[ot]);
+	    dw_printf ("Error setting %s line %d for %s\n", save_audio_config_p->achan[chan].octrl[ot].out_gpio_name,
+			save_audio_config_p->achan[chan].octrl[ot].out_gpio_num, otnames[ot]);
 	    dw_printf ("%s\n", strerror(e));
 	  }
-	  close (fd);
-
 	}
 #endif
 	
@@ -1406,31 +1735,20 @@ int get_input (int it, int chan)
 	
 #if __WIN32__
 #else
-	if (save_audio_config_p->achan[chan].ictrl[it].method == PTT_METHOD_GPIO) {
-	  int fd;
-	  char gpio_value_path[80];
+	if (save_audio_config_p->achan[chan].ictrl[it].method == PTT_METHOD_GPIO &&
+		gpio_in_fd[chan][it] >= 0) {
 
-	  snprintf (gpio_value_path, sizeof(gpio_value_path), "/sys/class/gpio/%s/value", save_audio_config_p->achan[chan].ictrl[it].in_gpio_name);
+	  char vtemp[2];
 
-	  get_access_to_gpio (gpio_value_path);
+	  // Reading again from the beginning gets the current value.
 
-	  fd = open(gpio_value_path, O_RDONLY);
-	  if (fd < 0) {
-	    int e = errno;
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Error opening %s to check input.\n", gpio_value_path);
-	    dw_printf ("%s\n", strerror(e));
-	    return -1;
-	  }
-
-	  char vtemp[2];
-	  if (read (fd, vtemp, 1) != 1) {
+	  if (pread (gpio_in_fd[chan][it], vtemp, 1, 0) != 1) {
 	    int e = errno;
 	    text_color_set(DW_COLOR_ERROR);
 	    dw_printf ("Error getting GPIO %d value\n", save_audio_config_p->achan[chan].ictrl[it].in_gpio_num);
 	    dw_printf ("%s\n", strerror(e));
+	    return -1;
 	  }
-	  close (fd);
 
 	  vtemp[1] = '\0';
 	  if (atoi(vtemp) != save_audio_config_p->achan[chan].ictrl[it].invert) {
@@ -1442,6 +1760,21 @@ int get_input (int it, int chan)
 	}
 #endif
 
+#ifdef USE_GPIOD
+	// No system call here.  gpiod_input_thread keeps track of changes.
+
+	if (save_audio_config_p->achan[chan].ictrl[it].method == PTT_METHOD_GPIOD &&
+		gpio_in_fd[chan][it] >= 0) {
+
+	  if (gpiod_in_value[chan][it] != save_audio_config_p->achan[chan].ictrl[it].invert) {
+	    return 1;
+	  }
+	  else {
+	    return 0;
+	  }
+	}
+#endif
+
 	return -1;	/* Method was none, or something went wrong */
 }
 
@@ -1461,6 +1794,10 @@ void ptt_term (void)
 {
 	int n;
 
+	if (save_audio_config_p == NULL) {
+	  return;		/* Ctrl-C before ptt_init. */
+	}
+
 	for (n = 0; n < MAX_CHANS; n++) {
 	  if (save_audio_config_p->chan_medium[n] == MEDIUM_RADIO) {
 	    int ot;
@@ -1470,6 +1807,26 @@ void ptt_term (void)
 	  }
 	}
 
+#ifdef USE_GPIOD
+
+	// Stop the input threads before closing the lines they are using.
+	// The pipe is never read so it stays readable for all of them.
+
+	if (gpiod_wake_pipe[1] >= 0) {
+	  if (write (gpiod_wake_pipe[1], "x", 1) == 1) {
+	    int it;
+	    for (n = 0; n < MAX_CHANS; n++) {
+	      for (it = 0; it < NUM_ICTYPES; it++) {
+	        if (gpiod_input_started[n][it]) {
+	          pthread_join (gpiod_input_tid[n][it], NULL);
+	          gpiod_input_started[n][it] = 0;
+	        }
+	      }
+	    }
+	  }
+	}
+#endif
+
 	for (n = 0; n < MAX_CHANS; n++) {
 	  if (save_audio_config_p->chan_medium[n] == MEDIUM_RADIO) {
 	    int ot;
@@ -1482,7 +1839,22 @@ void ptt_term (void)
 #endif
 	        ptt_fd[n][ot] = INVALID_HANDLE_VALUE;
 	      }
+#ifndef __WIN32__
+	      if (gpio_out_fd[n][ot] >= 0) {
+	        close (gpio_out_fd[n][ot]);
+	        gpio_out_fd[n][ot] = -1;
+	      }
+#endif
+	    }
+#ifndef __WIN32__
+	    int it;
+	    for (it = 0; it < NUM_ICTYPES; it++) {
+	      if (gpio_in_fd[n][it] >= 0) {
+	        close (gpio_in_fd[n][it]);
+	        gpio_in_fd[n][it] = -1;
+	      }
 	    }
+#endif
 	  }
 	}
 
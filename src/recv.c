@@ -108,6 +108,8 @@
 #include "dtmf.h"
 #include "aprs_tt.h"
 #include "ax25_link.h"
+#include "reload.h"
+#include "diversity.h"
 
 
 #if __WIN32__
@@ -150,6 +152,8 @@ void recv_init (struct audio_s *pa)
 
 	save_pa = pa;
 
+	diversity_init (pa);
+
 	for (a=0; a<MAX_ADEVS; a++) {
 
 	  if (pa->adev[a].defined) {
@@ -286,6 +290,27 @@ static void * recv_adev_thread (void *arg)
 
 
 
+/*
+ * This is the traditional processing.
+ * For all frames:
+ *	- Print in standard monitoring format.
+ *	- Send to KISS client applications.
+ *	- Send to AGw client applications in raw mode.
+ * For APRS frames:
+ *	- Explain what it means.
+ *	- Send to Igate.
+ *	- Digipeater.
+ * Then link processing.
+ */
+
+static void process_rec_frame (struct dlq_item_s *pitem)
+{
+	app_process_rec_packet (pitem->chan, pitem->subchan, pitem->slice, pitem->pp, pitem->alevel, pitem->fec_type, pitem->retries, pitem->spectrum);
+
+	lm_data_indication(pitem);
+}
+
+
 void recv_process (void) 
 {
 
@@ -297,6 +322,13 @@ void recv_process (void)
 
 	  double timeout_value =  ax25_link_get_next_timer_expiry();
 
+	  /* Also wake up when a diversity group window closes. */
+
+	  double diversity_value = diversity_next_expiry();
+	  if (diversity_value != 0 && (timeout_value == 0 || diversity_value < timeout_value)) {
+	    timeout_value = diversity_value;
+	  }
+
 	  timed_out = dlq_wait_while_empty (timeout_value);
 
 
@@ -327,26 +359,12 @@ void recv_process (void)
 	      switch (pitem->type) {
 
 	        case DLQ_REC_FRAME:
-/*
- * This is the traditional processing.
- * For all frames:
- *	- Print in standard monitoring format.
- *	- Send to KISS client applications.
- *	- Send to AGw client applications in raw mode.
- * For APRS frames:
- *	- Explain what it means.
- *	- Send to Igate.
- *	- Digipeater.
- */
-
-		  app_process_rec_packet (pitem->chan, pitem->subchan, pitem->slice, pitem->pp, pitem->alevel, pitem->fec_type, pitem->retries, pitem->spectrum);
-
-
-/*
- * Link processing.
- */
-	          lm_data_indication(pitem);
 
+	          if (diversity_hold (pitem)) {
+	            pitem = NULL;		/* Now belongs to diversity.c. */
+	            break;
+	          }
+	          process_rec_frame (pitem);
 	          break;
 
 
@@ -395,9 +413,16 @@ void recv_process (void)
 	          dl_client_cleanup (pitem);
 	          break;
 
+	        case DLQ_RELOAD_CONFIG:
+
+	          reload_config ();
+	          break;
+
 	      }
 
-	      dlq_delete (pitem);
+	      if (pitem != NULL) {
+	        dlq_delete (pitem);
+	      }
 	    }
 #if DEBUG
 	    else {
@@ -407,6 +432,14 @@ void recv_process (void)
 #endif
 	  }
 
+/*
+ * Frames from diversity groups, when no better copy arrived in time.
+ */
+	  while ((pitem = diversity_release()) != NULL) {
+	    process_rec_frame (pitem);
+	    dlq_delete (pitem);
+	  }
+
 	}
 
 } /* end recv_process */
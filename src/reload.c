@@ -0,0 +1,592 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      reload.c
+ *
+ * Purpose:   	Read the configuration file again without restarting.
+ *
+ * Description:	Changing a digipeater rule, filter, or beacon used to
+ *		require a restart.  That means reopening the audio device,
+ *		setting up PTT, logging in to the IGate server again, and
+ *		losing any connected mode sessions.
+ *
+ *		On Linux, sending SIGHUP to the process causes the
+ *		configuration file to be read again.  The new settings
+ *		are compared to those currently in use and only the
+ *		following are switched over:
+ *
+ *			- APRS digipeater rules.
+ *			- Connected mode digipeater rules.
+ *			- Packet filters.
+ *			- IGate settings.
+ *			- Beacons and SmartBeaconing.
+ *
+ *		Everything else, such as audio devices, modems, channel
+ *		call signs, PTT, and network ports, requires a restart.
+ *
+ *		The actual switch happens in the receive queue thread,
+ *		the same one that calls the digipeaters and IGate,
+ *		so a packet never sees a mixture of old and new settings.
+ *
+ *		Previous configurations are not freed.  Other threads,
+ *		such as the IGate server listener, might still be using them.
+ *
+ *---------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#if __WIN32__
+#else
+#include <signal.h>
+#endif
+
+#include "textcolor.h"
+#include "audio.h"
+#include "config.h"
+#include "digipeater.h"
+#include "cdigipeater.h"
+#include "igate.h"
+#include "pfilter.h"
+#include "beacon.h"
+#include "aprs_tt.h"
+#include "dlq.h"
+#include "reload.h"
+
+
+static char save_config_file[100];
+static struct audio_s *save_audio_config_p;
+static int s_pfilter_debug;
+
+/*
+ * Configurations currently in use.
+ */
+
+static struct digi_config_s *running_digi_p;
+static struct cdigi_config_s *running_cdigi_p;
+static struct igate_config_s *running_igate_p;
+
+/*
+ * beacon_init modifies the beacon table, e.g. calculating the next
+ * transmit time, so keep a copy as it came from the configuration
+ * file for comparison.
+ */
+
+static struct misc_config_s *parsed_misc_p;
+
+
+#if __WIN32__
+#else
+static void * sighup_thread (void *arg);
+#endif
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        reload_signal_init
+ *
+ * Purpose:     Block SIGHUP so it is delivered only to sighup_thread.
+ *
+ * Description:	Signal masks are inherited by new threads so this
+ *		must be called before any other threads are created.
+ *
+ *--------------------------------------------------------------------*/
+
+void reload_signal_init (void)
+{
+#if __WIN32__
+#else
+	sigset_t set;
+
+	sigemptyset (&set);
+	sigaddset (&set, SIGHUP);
+	pthread_sigmask (SIG_BLOCK, &set, NULL);
+#endif
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        reload_init
+ *
+ * Purpose:     Remember configuration in use and start waiting for SIGHUP.
+ *
+ * Inputs:	config_file	- Name of configuration file.
+ *
+ *		p_audio_config	- Audio and channel configuration.
+ *				  This is never changed but the digipeaters need it.
+ *
+ *		p_digi_config, p_cdigi_config, p_igate_config, p_misc_config
+ *				- As read from the configuration file at startup.
+ *
+ *		pfilter_debug	- Debug level for pfilter_init.
+ *
+ * Description:	This must be called before beacon_init.
+ *
+ *--------------------------------------------------------------------*/
+
+void reload_init (char *config_file, struct audio_s *p_audio_config,
+			struct digi_config_s *p_digi_config,
+			struct cdigi_config_s *p_cdigi_config,
+			struct igate_config_s *p_igate_config,
+			struct misc_config_s *p_misc_config,
+			int pfilter_debug)
+{
+#if __WIN32__
+#else
+	pthread_t sighup_tid;
+	int e;
+#endif
+
+	strlcpy (save_config_file, config_file, sizeof(save_config_file));
+	save_audio_config_p = p_audio_config;
+	s_pfilter_debug = pfilter_debug;
+
+	running_digi_p = p_digi_config;
+	running_cdigi_p = p_cdigi_config;
+	running_igate_p = p_igate_config;
+
+	parsed_misc_p = malloc (sizeof(struct misc_config_s));
+	if (parsed_misc_p == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+	memcpy (parsed_misc_p, p_misc_config, sizeof(struct misc_config_s));
+
+#if __WIN32__
+#else
+	e = pthread_create (&sighup_tid, NULL, sighup_thread, NULL);
+	if (e != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  perror("Could not create SIGHUP thread");
+	  return;
+	}
+#endif
+
+} /* end reload_init */
+
+
+
+#if __WIN32__
+#else
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        sighup_thread
+ *
+ * Purpose:     Wait for SIGHUP and ask the receive queue thread
+ *		to read the configuration file again.
+ *
+ * Description:	Using sigwait in a thread, rather than a signal handler,
+ *		means we can safely print and use the queue.
+ *
+ *--------------------------------------------------------------------*/
+
+static void * sighup_thread (void *arg)
+{
+	sigset_t set;
+	int sig;
+
+	sigemptyset (&set);
+	sigaddset (&set, SIGHUP);
+
+	while (1) {
+	  if (sigwait (&set, &sig) == 0 && sig == SIGHUP) {
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("\nReceived SIGHUP.  Configuration file will be read again.\n");
+	    dlq_reload_config ();
+	  }
+	}
+
+	return (NULL);	/* Unreachable but avoids compiler warning. */
+}
+
+#endif
+
+
+
+/*
+ * Compare strings where either could be NULL.
+ */
+
+static int str_differ (const char *a, const char *b)
+{
+	if (a == NULL || b == NULL) {
+	  return (a != b);
+	}
+	return (strcmp(a, b) != 0);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        digi_rules_differ, digi_filters_differ, etc.
+ *
+ * Purpose:     Compare new configuration with the one in use.
+ *
+ * Returns:	1 if different.
+ *
+ * Description:	These are separate so we can report filter changes
+ *		separately.  Both end up in the same structure.
+ *
+ *--------------------------------------------------------------------*/
+
+static int digi_rules_differ (struct digi_config_s *a, struct digi_config_s *b)
+{
+	int from_chan, to_chan;
+
+	if (a->dedupe_time != b->dedupe_time) return (1);
+
+	for (from_chan = 0; from_chan < MAX_CHANS; from_chan++) {
+	  for (to_chan = 0; to_chan < MAX_CHANS; to_chan++) {
+
+	    if (a->enabled[from_chan][to_chan] != b->enabled[from_chan][to_chan]) return (1);
+	    if (a->preempt[from_chan][to_chan] != b->preempt[from_chan][to_chan]) return (1);
+	    if (a->regen[from_chan][to_chan] != b->regen[from_chan][to_chan]) return (1);
+	    if (strcmp(a->atgp[from_chan][to_chan], b->atgp[from_chan][to_chan]) != 0) return (1);
+	    if (str_differ(a->alias[from_chan][to_chan].pattern, b->alias[from_chan][to_chan].pattern)) return (1);
+	    if (str_differ(a->wide[from_chan][to_chan].pattern, b->wide[from_chan][to_chan].pattern)) return (1);
+	  }
+	}
+	return (0);
+}
+
+
+static int digi_filters_differ (struct digi_config_s *a, struct digi_config_s *b)
+{
+	int from_chan, to_chan;
+
+	for (from_chan = 0; from_chan <= MAX_CHANS; from_chan++) {
+	  for (to_chan = 0; to_chan <= MAX_CHANS; to_chan++) {
+	    if (str_differ(a->filter_str[from_chan][to_chan], b->filter_str[from_chan][to_chan])) return (1);
+	  }
+	}
+	return (0);
+}
+
+
+static int cdigi_differ (struct cdigi_config_s *a, struct cdigi_config_s *b)
+{
+	int from_chan, to_chan;
+
+	for (from_chan = 0; from_chan < MAX_CHANS; from_chan++) {
+	  for (to_chan = 0; to_chan < MAX_CHANS; to_chan++) {
+
+	    if (a->enabled[from_chan][to_chan] != b->enabled[from_chan][to_chan]) return (1);
+	    if (a->has_alias[from_chan][to_chan] != b->has_alias[from_chan][to_chan]) return (1);
+	    if (str_differ(a->alias[from_chan][to_chan].pattern, b->alias[from_chan][to_chan].pattern)) return (1);
+	  }
+	}
+	return (0);
+}
+
+
+static int cdigi_filters_differ (struct cdigi_config_s *a, struct cdigi_config_s *b)
+{
+	int from_chan, to_chan;
+
+	for (from_chan = 0; from_chan < MAX_CHANS; from_chan++) {
+	  for (to_chan = 0; to_chan < MAX_CHANS; to_chan++) {
+	    if (str_differ(a->cfilter_str[from_chan][to_chan], b->cfilter_str[from_chan][to_chan])) return (1);
+	  }
+	}
+	return (0);
+}
+
+
+static int igate_differ (struct igate_config_s *a, struct igate_config_s *b)
+{
+	if (strcmp(a->t2_server_name, b->t2_server_name) != 0) return (1);
+	if (a->t2_server_port != b->t2_server_port) return (1);
+	if (strcmp(a->t2_login, b->t2_login) != 0) return (1);
+	if (strcmp(a->t2_passcode, b->t2_passcode) != 0) return (1);
+	if (str_differ(a->t2_filter, b->t2_filter)) return (1);
+	if (a->tx_chan != b->tx_chan) return (1);
+	if (strcmp(a->tx_via, b->tx_via) != 0) return (1);
+	if (a->max_digi_hops != b->max_digi_hops) return (1);
+	if (a->tx_limit_1 != b->tx_limit_1) return (1);
+	if (a->tx_limit_5 != b->tx_limit_5) return (1);
+	if (a->igmsp != b->igmsp) return (1);
+	if (a->rx2ig_dedupe_time != b->rx2ig_dedupe_time) return (1);
+	if (a->satgate_delay != b->satgate_delay) return (1);
+	return (0);
+}
+
+
+/*
+ * Line numbers are not compared.  Adding a comment to the
+ * configuration file should not reset the beacon schedule.
+ */
+
+static int beacons_differ (struct misc_config_s *a, struct misc_config_s *b)
+{
+	int j;
+
+	if (a->sb_configured != b->sb_configured) return (1);
+	if (a->sb_fast_speed != b->sb_fast_speed) return (1);
+	if (a->sb_fast_rate != b->sb_fast_rate) return (1);
+	if (a->sb_slow_speed != b->sb_slow_speed) return (1);
+	if (a->sb_slow_rate != b->sb_slow_rate) return (1);
+	if (a->sb_turn_time != b->sb_turn_time) return (1);
+	if (a->sb_turn_angle != b->sb_turn_angle) return (1);
+	if (a->sb_turn_slope != b->sb_turn_slope) return (1);
+
+	if (a->num_beacons != b->num_beacons) return (1);
+
+	for (j = 0; j < a->num_beacons; j++) {
+	  struct beacon_s *pa = &(a->beacon[j]);
+	  struct beacon_s *pb = &(b->beacon[j]);
+
+	  if (pa->btype != pb->btype) return (1);
+	  if (pa->sendto_type != pb->sendto_type) return (1);
+	  if (pa->sendto_chan != pb->sendto_chan) return (1);
+	  if (pa->delay != pb->delay) return (1);
+	  if (pa->slot != pb->slot) return (1);
+	  if (pa->every != pb->every) return (1);
+	  if (str_differ(pa->source, pb->source)) return (1);
+	  if (str_differ(pa->dest, pb->dest)) return (1);
+	  if (pa->compress != pb->compress) return (1);
+	  if (strcmp(pa->objname, pb->objname) != 0) return (1);
+	  if (str_differ(pa->via, pb->via)) return (1);
+	  if (str_differ(pa->custom_info, pb->custom_info)) return (1);
+	  if (str_differ(pa->custom_infocmd, pb->custom_infocmd)) return (1);
+	  if (pa->messaging != pb->messaging) return (1);
+	  if (pa->lat != pb->lat) return (1);
+	  if (pa->lon != pb->lon) return (1);
+	  if (pa->ambiguity != pb->ambiguity) return (1);
+	  if (pa->alt_m != pb->alt_m) return (1);
+	  if (pa->symtab != pb->symtab) return (1);
+	  if (pa->symbol != pb->symbol) return (1);
+	  if (pa->power != pb->power) return (1);
+	  if (pa->height != pb->height) return (1);
+	  if (pa->gain != pb->gain) return (1);
+	  if (strcmp(pa->dir, pb->dir) != 0) return (1);
+	  if (pa->freq != pb->freq) return (1);
+	  if (pa->tone != pb->tone) return (1);
+	  if (pa->offset != pb->offset) return (1);
+	  if (str_differ(pa->comment, pb->comment)) return (1);
+	  if (str_differ(pa->commentcmd, pb->commentcmd)) return (1);
+	}
+	return (0);
+}
+
+
+
+/*
+ * Release a digipeater configuration that was not put into use.
+ */
+
+static void digi_free (struct digi_config_s *p)
+{
+	int from_chan, to_chan;
+
+	for (from_chan = 0; from_chan <= MAX_CHANS; from_chan++) {
+	  for (to_chan = 0; to_chan <= MAX_CHANS; to_chan++) {
+	    if (from_chan < MAX_CHANS && to_chan < MAX_CHANS) {
+	      digimatch_free (&(p->alias[from_chan][to_chan]));
+	      digimatch_free (&(p->wide[from_chan][to_chan]));
+	    }
+	    if (p->filter_str[from_chan][to_chan] != NULL) {
+	      free (p->filter_str[from_chan][to_chan]);
+	    }
+	  }
+	}
+	free (p);
+}
+
+
+static void cdigi_free (struct cdigi_config_s *p)
+{
+	int from_chan, to_chan;
+
+	for (from_chan = 0; from_chan < MAX_CHANS; from_chan++) {
+	  for (to_chan = 0; to_chan < MAX_CHANS; to_chan++) {
+	    digimatch_free (&(p->alias[from_chan][to_chan]));
+	    if (p->cfilter_str[from_chan][to_chan] != NULL) {
+	      free (p->cfilter_str[from_chan][to_chan]);
+	    }
+	  }
+	}
+	free (p);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        reload_config
+ *
+ * Purpose:     Read the configuration file again and switch over
+ *		to any changed settings.
+ *
+ * Description:	This is called from the receive queue thread when
+ *		DLQ_RELOAD_CONFIG is removed from the queue.
+ *
+ *--------------------------------------------------------------------*/
+
+void reload_config (void)
+{
+	struct audio_s *new_audio;
+	struct digi_config_s *new_digi;
+	struct cdigi_config_s *new_cdigi;
+	struct tt_config_s *new_tt;
+	struct igate_config_s *new_igate;
+	struct misc_config_s *new_misc;
+	int chan;
+	int digi_changed, filters_changed, cdigi_changed, igate_changed, beacons_changed;
+	int restart_needed = 0;
+
+	if ( ! config_file_exists(save_config_file)) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not open configuration file %s.  Continuing with current settings.\n", save_config_file);
+	  return;
+	}
+
+	new_audio = malloc (sizeof(struct audio_s));
+	new_digi = malloc (sizeof(struct digi_config_s));
+	new_cdigi = malloc (sizeof(struct cdigi_config_s));
+	new_tt = malloc (sizeof(struct tt_config_s));
+	new_igate = malloc (sizeof(struct igate_config_s));
+	new_misc = malloc (sizeof(struct misc_config_s));
+
+	if (new_audio == NULL || new_digi == NULL || new_cdigi == NULL ||
+	    new_tt == NULL || new_igate == NULL || new_misc == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	if (config_init (save_config_file, new_audio, new_digi, new_cdigi, new_tt, new_igate, new_misc) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Error in configuration file %s.  Continuing with current settings.\n", save_config_file);
+	  digi_free (new_digi);
+	  cdigi_free (new_cdigi);
+	  tt_config_free (new_tt);
+	  igate_config_free (new_igate);
+	  misc_config_free (new_misc);
+	  free (new_audio);
+	  free (new_tt);
+	  free (new_igate);
+	  free (new_misc);
+	  return;
+	}
+
+/*
+ * Channel call signs are used all over the place.
+ * Those can't be changed on the fly.
+ */
+	for (chan = 0; chan < MAX_CHANS; chan++) {
+	  if (save_audio_config_p->chan_medium[chan] != MEDIUM_NONE &&
+	      strcmp(new_audio->achan[chan].mycall, save_audio_config_p->achan[chan].mycall) != 0) {
+	    restart_needed = 1;
+	  }
+	}
+
+	digi_changed = digi_rules_differ (new_digi, running_digi_p);
+	filters_changed = digi_filters_differ (new_digi, running_digi_p) || cdigi_filters_differ (new_cdigi, running_cdigi_p);
+	cdigi_changed = cdigi_differ (new_cdigi, running_cdigi_p);
+	igate_changed = igate_differ (new_igate, running_igate_p);
+	beacons_changed = beacons_differ (new_misc, parsed_misc_p);
+
+	text_color_set(DW_COLOR_INFO);
+
+/*
+ * The digipeater and IGate share the digipeater configuration for packet filtering.
+ */
+	if (digi_changed || cdigi_changed || filters_changed) {
+
+	  digipeater_reconfig (new_digi);
+	  if (digi_changed) dw_printf ("Digipeater rules have been updated.\n");
+	  if (filters_changed) dw_printf ("Packet filters have been updated.\n");
+
+	  cdigipeater_init (save_audio_config_p, new_cdigi);
+	  if (cdigi_changed) dw_printf ("Connected digipeater rules have been updated.\n");
+
+	  running_digi_p = new_digi;
+	  running_cdigi_p = new_cdigi;
+	}
+	else {
+	  digi_free (new_digi);
+	  cdigi_free (new_cdigi);
+	}
+
+	if (igate_changed || digi_changed || cdigi_changed || filters_changed) {
+	  int err = igate_reconfig (igate_changed ? new_igate : running_igate_p, running_digi_p);
+	  if (err == -2) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("SATGATE change requires restart.\n");
+	    igate_changed = 0;
+	  }
+	  else if (err != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("IGate was not running when application started.  Restart is required.\n");
+	    igate_changed = 0;
+	  }
+	  else if (igate_changed) {
+	    dw_printf ("IGate settings have been updated.\n");
+	    running_igate_p = new_igate;
+	    pfilter_init (running_igate_p, s_pfilter_debug);
+	  }
+	}
+
+	if (beacons_changed || igate_changed) {
+	  /* The copy shares strings with new_misc.  Those belong to the */
+	  /* beacon module now and live until it is given something newer. */
+	  memcpy (parsed_misc_p, new_misc, sizeof(struct misc_config_s));
+	  beacon_reconfig (new_misc, running_igate_p);
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("Beacons have been updated.\n");
+	}
+	else {
+	  misc_config_free (new_misc);
+	  free (new_misc);
+	}
+
+	if ( ! igate_changed) {
+	  igate_config_free (new_igate);
+	  free (new_igate);
+	}
+
+	if ( ! (digi_changed || cdigi_changed || filters_changed || igate_changed || beacons_changed)) {
+	  text_color_set(DW_COLOR_INFO);
+	  dw_printf ("No changes to digipeater, filter, IGate, or beacon settings.\n");
+	}
+
+	if (restart_needed) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("MYCALL has changed.  Restart is required for that to take effect.\n");
+	}
+
+	free (new_audio);
+	tt_config_free (new_tt);
+	free (new_tt);
+
+} /* end reload_config */
+
+/* end reload.c */
@@ -0,0 +1,34 @@
+
+/* reload.h */
+
+#ifndef RELOAD_H
+#define RELOAD_H 1
+
+#include "audio.h"
+#include "config.h"
+#include "digipeater.h"
+#include "cdigipeater.h"
+#include "igate.h"
+
+
+/* Call this before any threads are created. */
+
+void reload_signal_init (void);
+
+/* Call this once at startup, before the subsystems are initialized. */
+
+void reload_init (char *config_file, struct audio_s *p_audio_config,
+			struct digi_config_s *p_digi_config,
+			struct cdigi_config_s *p_cdigi_config,
+			struct igate_config_s *p_igate_config,
+			struct misc_config_s *p_misc_config,
+			int pfilter_debug);
+
+/* Called from the receive queue thread for DLQ_RELOAD_CONFIG. */
+
+void reload_config (void);
+
+
+#endif
+
+/* end reload.h */
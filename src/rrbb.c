@@ -31,6 +31,16 @@
  *
  * Version 1.3:	Store as bytes rather than packing 8 bits per byte.
  *
+ * Version 1.7:	Start small and grow as needed, rather than always having
+ *		room for the largest possible frame.  Keep finished buffers
+ *		in a pool for reuse instead of freeing and allocating again
+ *		for every frame.
+ *
+ *		There is a separate pool for each channel.  All of the
+ *		demodulators and slicers for a channel are serviced by the
+ *		same thread.  hdlc_rec2_block, which deletes the buffer,
+ *		is called from that same thread so no locking is needed.
+ *
  *******************************************************************************/
 
 #define RRBB_C
@@ -55,6 +65,20 @@ volatile static int new_count = 0;
 volatile static int delete_count = 0;
 
 
+#define POOL_MAX 8		/* Maximum number idle for each channel. */
+
+static rrbb_t pool[MAX_CHANS];		/* Linked with nextp. */
+static int pool_count[MAX_CHANS];
+
+/* Statistics are updated by more than one audio thread. */
+
+static int stat_allocated = 0;
+static int stat_reused = 0;
+static int stat_grown = 0;
+static long stat_bytes = 0;
+static int stat_max_bits = 0;
+
+
 /***********************************************************************************
  *
  * Name:	rrbb_new	
@@ -87,11 +111,26 @@ rrbb_t rrbb_new (int chan, int subchan, int slice, int is_scrambled, int descram
 	assert (subchan >= 0 && subchan < MAX_SUBCHANS);
 	assert (slice >= 0 && slice < MAX_SLICERS);
 
-	result = malloc(sizeof(struct rrbb_s));
-	if (result == NULL) {
-	  text_color_set(DW_COLOR_ERROR);
-	  dw_printf ("FATAL ERROR: Out of memory.\n");
-	  exit (EXIT_FAILURE);
+	if (pool[chan] != NULL) {
+	  result = pool[chan];
+	  pool[chan] = result->nextp;
+	  pool_count[chan]--;
+	  __atomic_fetch_add (&stat_reused, 1, __ATOMIC_RELAXED);
+	}
+	else {
+	  result = malloc(sizeof(struct rrbb_s));
+	  if (result != NULL) {
+	    result->fdata = malloc(RRBB_INITIAL_BITS);
+	  }
+	  if (result == NULL || result->fdata == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("FATAL ERROR: Out of memory.\n");
+	    exit (EXIT_FAILURE);
+	  }
+	  result->size = RRBB_INITIAL_BITS;
+	  __atomic_fetch_add (&stat_allocated, 1, __ATOMIC_RELAXED);
+	  __atomic_fetch_add (&stat_bytes, (long)(sizeof(struct rrbb_s) + RRBB_INITIAL_BITS), __ATOMIC_RELAXED);
+	  if (RRBB_INITIAL_BITS > stat_max_bits) stat_max_bits = RRBB_INITIAL_BITS;
 	}
 	result->magic1 = MAGIC1;
 	result->chan = chan;
@@ -150,6 +189,58 @@ void rrbb_clear (rrbb_t b, int is_scrambled, int descram_state, int prev_descram
 }
 
 
+/***********************************************************************************
+ *
+ * Name:	rrbb_grow	
+ *
+ * Purpose:	Make room for more bits.
+ *
+ * Inputs:	b	- Handle for bit array which is full.
+ *
+ * Returns:	1 if there is now more room.
+ *		0 if already at MAX_NUM_BITS.
+ *
+ * Description:	Called by rrbb_append_bit.  Double the size each time so
+ *		a long frame needs only a few of these.  The buffer stays
+ *		at its larger size when it goes back to the pool.
+ *
+ ***********************************************************************************/
+
+int rrbb_grow (rrbb_t b)
+{
+	unsigned int new_size;
+	unsigned char *p;
+
+	assert (b != NULL);
+	assert (b->magic1 == MAGIC1);
+	assert (b->magic2 == MAGIC2);
+
+	if (b->size >= MAX_NUM_BITS) {
+	  return (0);
+	}
+
+	new_size = b->size * 2;
+	if (new_size > MAX_NUM_BITS) {
+	  new_size = MAX_NUM_BITS;
+	}
+
+	p = realloc (b->fdata, new_size);
+	if (p == NULL) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("FATAL ERROR: Out of memory.\n");
+	  exit (EXIT_FAILURE);
+	}
+
+	__atomic_fetch_add (&stat_grown, 1, __ATOMIC_RELAXED);
+	__atomic_fetch_add (&stat_bytes, (long)(new_size - b->size), __ATOMIC_RELAXED);
+	if ((int)new_size > stat_max_bits) stat_max_bits = new_size;
+
+	b->fdata = p;
+	b->size = new_size;
+	return (1);
+}
+
+
 /***********************************************************************************
  *
  * Name:	rrbb_append_bit	
@@ -268,12 +359,21 @@ void rrbb_delete (rrbb_t b)
 	assert (b->magic1 == MAGIC1);
 	assert (b->magic2 == MAGIC2);
 
+	delete_count++;
+
+	if (pool_count[b->chan] < POOL_MAX) {
+	  b->nextp = pool[b->chan];
+	  pool[b->chan] = b;
+	  pool_count[b->chan]++;
+	  return;
+	}
+
 	b->magic1 = 0;
 	b->magic2 = 0;
-	
-	free (b);
 
-	delete_count++;
+	__atomic_fetch_sub (&stat_bytes, (long)(sizeof(struct rrbb_s) + b->size), __ATOMIC_RELAXED);
+	free (b->fdata);
+	free (b);
 }
 
 
@@ -533,6 +633,47 @@ int rrbb_get_prev_descram (rrbb_t b)
 
 
 
-/* end rrbb.c */
+/***********************************************************************************
+ *
+ * Name:	rrbb_get_stats
+ *
+ * Purpose:	Get information about memory used for bit buffers.
+ *
+ * Outputs:	stats	- See rrbb.h.
+ *
+ * Description:	This is only for information.  Values can be slightly
+ *		out of date if the audio threads are running.
+ *
+ ***********************************************************************************/
 
+void rrbb_get_stats (struct rrbb_stats_s *stats)
+{
+	int ch;
+
+	memset (stats, 0, sizeof(struct rrbb_stats_s));
+
+	for (ch = 0; ch < MAX_CHANS; ch++) {
+	  stats->idle += pool_count[ch];
+	}
+	stats->in_use = new_count - delete_count;
+	stats->allocated = stat_allocated;
+	stats->reused = stat_reused;
+	stats->grown = stat_grown;
+	stats->bytes = stat_bytes;
+	stats->max_bits = stat_max_bits;
+}
 
+
+void rrbb_print_stats (void)
+{
+	struct rrbb_stats_s s;
+
+	rrbb_get_stats (&s);
+
+	text_color_set(DW_COLOR_DEBUG);
+	dw_printf ("Bit buffers: %d in use, %d idle, %d allocated, %d reused, %d grown, largest %d bits, %ld bytes total.\n",
+		s.in_use, s.idle, s.allocated, s.reused, s.grown, s.max_bits, s.bytes);
+}
+
+
+/* end rrbb.c */
@@ -24,6 +24,15 @@
 
 #define MAX_NUM_BITS (MAX_FRAME_LEN * 8 * 6 / 5)
 
+/*
+ * That is about 20 KB, one byte per bit, and there is a buffer for
+ * every channel, demodulator, and slicer.  Most frames are much
+ * smaller so start with this and grow as needed.  Enough for a
+ * typical APRS frame without growing.
+ */
+
+#define RRBB_INITIAL_BITS 2048
+
 typedef struct rrbb_s {
 	int magic1;
 	struct rrbb_s* nextp;	/* Next pointer to maintain a queue. */
@@ -35,27 +44,47 @@ typedef struct rrbb_s {
 	alevel_t alevel;	/* Received audio level at time of frame capture. */
 	float speed_error;	/* Received data speed error as percentage. */
 	unsigned int len;	/* Current number of samples in array. */
+	unsigned int size;	/* Number of samples allocated for fdata. */
 
 	int is_scrambled;	/* Is data scrambled G3RUH / K9NG style? */
 	int descram_state;	/* Descrambler state before first data bit of frame. */
 	int prev_descram;	/* Previous descrambled bit. */
 
-	unsigned char fdata[MAX_NUM_BITS];
+	unsigned char *fdata;	/* Grows, up to MAX_NUM_BITS, by rrbb_grow. */
 
 	int magic2;
 } *rrbb_t;
 
 
+/*
+ * Statistics for the pool of bit buffers.
+ */
+
+struct rrbb_stats_s {
+	int in_use;		/* Currently held by HDLC decoders or being decoded. */
+	int idle;		/* In the pools waiting to be reused. */
+	int allocated;		/* Total number of times malloc was needed. */
+	int reused;		/* Total number of times one came from a pool. */
+	int grown;		/* Total number of times a buffer was enlarged. */
+	long bytes;		/* Current memory for all bit buffers. */
+	int max_bits;		/* Largest buffer, in bits. */
+};
+
+
 
 rrbb_t rrbb_new (int chan, int subchan, int slice, int is_scrambled, int descram_state, int prev_descram);
 
 void rrbb_clear (rrbb_t b, int is_scrambled, int descram_state, int prev_descram);
 
+int rrbb_grow (rrbb_t b);
+
 
 static inline /*__attribute__((always_inline))*/ void rrbb_append_bit (rrbb_t b, const unsigned char val)
 {
-	if (b->len >= MAX_NUM_BITS) {
-	  return;	/* Silently discard if full. */
+	if (b->len >= b->size) {
+	  if ( ! rrbb_grow (b)) {
+	    return;	/* Silently discard if full. */
+	  }
 	}
 	b->fdata[b->len] = val;
 	b->len++;
@@ -92,5 +121,9 @@ int rrbb_get_is_scrambled (rrbb_t b);
 int rrbb_get_descram_state (rrbb_t b);
 int rrbb_get_prev_descram (rrbb_t b);
 
+void rrbb_get_stats (struct rrbb_stats_s *stats);
+
+void rrbb_print_stats (void);
+
 
 #endif
@@ -438,6 +438,58 @@ int serial_port_get1 (MYFDTYPE fd)
 }
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        serial_port_get
+ *
+ * Purpose:     Get whatever bytes are available from the serial port.
+ *		Wait if nothing is ready.
+ *
+ * Inputs:	fd	- Handle from open.
+ *		buf	- Where to put the bytes.
+ *		size	- Size of buf.
+ *
+ * Returns:	Number of bytes read, at least 1.
+ *		-1 if error.
+ *
+ * Description:	The port was opened with VMIN = 1 so read returns as
+ *		soon as there is at least one byte, along with anything
+ *		else that has already arrived.
+ *
+ *		For Windows, we would need to set COMMTIMEOUTS to get the
+ *		same behavior.  Until then, get just one byte at a time.
+ *
+ *--------------------------------------------------------------------*/
+
+int serial_port_get (MYFDTYPE fd, unsigned char *buf, int size)
+{
+
+#if __WIN32__
+
+	int ch = serial_port_get1 (fd);
+
+	if (ch < 0) {
+	  return (-1);
+	}
+	buf[0] = ch;
+	return (1);
+
+#else
+
+	int n;
+
+	n = read(fd, buf, (size_t)size);
+
+	if (n <= 0) {
+	  return (-1);
+	}
+	return (n);
+
+#endif
+
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        serial_port_close
@@ -26,6 +26,8 @@ extern int serial_port_write (MYFDTYPE fd, char *str, int len);
 
 extern int serial_port_get1 (MYFDTYPE fd);
 
+extern int serial_port_get (MYFDTYPE fd, unsigned char *buf, int size);
+
 extern void serial_port_close (MYFDTYPE fd);
 
 
@@ -88,6 +88,9 @@
  *
  *			'K'	Received AX.25 frame in raw format.
  *				(Enabled with 'k' command.)
+ *				The otherwise unused "user" field of the header has
+ *				the time the frame was captured by the audio device,
+ *				as milliseconds past midnight UTC.  0 if unknown.
  *
  *			'U'	Received AX.25 "UI" frames in monitor format.
  *				(Enabled with 'm' command.)
@@ -148,6 +151,7 @@
 #include <sys/types.h>
 #include <sys/ioctl.h>
 #include <sys/socket.h>
+#include <sys/uio.h>
 #include <netinet/in.h>
 #include <errno.h>
 #endif
@@ -157,6 +161,7 @@
 #include <assert.h>
 #include <string.h>
 #include <time.h>
+#include <math.h>
 #include <ctype.h>
 #include <stddef.h>
 
@@ -280,6 +285,7 @@ struct agwpe_s {
 
 
 static void send_to_client (int client, void *reply_p);
+static void send_to_client_gather (int client, struct agwpe_s *hdr, char *data, int data_len);
 
 
 /*-------------------------------------------------------------------
@@ -818,6 +824,11 @@ void server_send_rec_packet (int chan, packet_t pp, unsigned char *fbuf,  int fl
 
 	    agwpe_msg.hdr.data_len_NETLE = host2netle(flen + 1);
 
+	    double rx_time = ax25_get_rx_time (pp);
+	    if (rx_time > 0) {
+	      agwpe_msg.hdr.user_reserved_NETLE = host2netle((int)(fmod(rx_time, 86400.) * 1000.));
+	    }
+
 	    /* Stick in extra byte for the "TNC" to use. */
 
 	    agwpe_msg.data[0] = 0;
@@ -915,8 +926,10 @@ void server_send_monitored (int chan, packet_t pp, int own_xmit)
 	    strlcat ((char*)(agwpe_msg.data), desc, sizeof(agwpe_msg.data));
 
 	    // Timestamp with [...]\r
+	    // Use the audio capture time, for received frames, rather than now.
 
-	    time_t clock = time(NULL);
+	    double rx_time = ax25_get_rx_time (pp);
+	    time_t clock = (rx_time > 0 && ! own_xmit) ? (time_t)rx_time : time(NULL);
 	    struct tm *tm = localtime(&clock);		// TODO: use localtime_r ?
 	    char ts[32];
 	    snprintf (ts, sizeof(ts), "[%02d:%02d:%02d]\r", tm->tm_hour, tm->tm_min, tm->tm_sec);
@@ -1197,25 +1210,24 @@ void server_link_terminated (int chan, int client, char *remote_call, char *own_
  *
  *		data_len	- Number of bytes.  Could be zero.
  *
+ * Description:	The data is sent from where it is, usually the received
+ *		frame, rather than being copied after the header first.
+ *
  *--------------------------------------------------------------------*/
 
 void server_rec_conn_data (int chan, int client, char *remote_call, char *own_call, int pid, char *data_ptr, int data_len)
 {
 
-	struct {
-	  struct agwpe_s hdr;
-	  char info[AX25_MAX_INFO_LEN];		// I suppose there is potential for something larger.
-						// We'll cross that bridge if we ever come to it.
-	} reply;
+	struct agwpe_s hdr;
 
 
-	memset (&reply.hdr, 0, sizeof(reply.hdr));
-	reply.hdr.portx = chan;
-	reply.hdr.datakind = 'D';
-	reply.hdr.pid = pid;
+	memset (&hdr, 0, sizeof(hdr));
+	hdr.portx = chan;
+	hdr.datakind = 'D';
+	hdr.pid = pid;
 
-	strlcpy (reply.hdr.call_from, remote_call, sizeof(reply.hdr.call_from));
-	strlcpy (reply.hdr.call_to,   own_call,    sizeof(reply.hdr.call_to));
+	strlcpy (hdr.call_from, remote_call, sizeof(hdr.call_from));
+	strlcpy (hdr.call_to,   own_call,    sizeof(hdr.call_to));
 
 	if (data_len < 0) {
 	  text_color_set(DW_COLOR_ERROR);
@@ -1228,10 +1240,7 @@ void server_rec_conn_data (int chan, int client, char *remote_call, char *own_ca
 	  data_len = AX25_MAX_INFO_LEN;
 	}
 
-	memcpy (reply.info, data_ptr, data_len);
-	reply.hdr.data_len_NETLE = host2netle(data_len);
-
-	send_to_client (client, &reply);
+	send_to_client_gather (client, &hdr, data_ptr, data_len);
 
 } /* end server_rec_conn_data */
 
@@ -1372,6 +1381,60 @@ static void send_to_client (int client, void *reply_p)
 }
 
 
+/*
+ * Same thing for a header and data which are not next to each other.
+ * Both go out in a single system call without copying the data.
+ * The debug option needs them together so take the slow path for that.
+ */
+
+static void send_to_client_gather (int client, struct agwpe_s *hdr, char *data, int data_len)
+{
+	int err;
+
+	hdr->data_len_NETLE = host2netle(data_len);
+
+	if (debug_client) {
+	  struct {
+	    struct agwpe_s hdr;
+	    char info[AX25_MAX_INFO_LEN];
+	  } reply;
+
+	  memcpy (&reply.hdr, hdr, sizeof(reply.hdr));
+	  memcpy (reply.info, data, data_len);
+	  send_to_client (client, &reply);
+	  return;
+	}
+
+#if __WIN32__
+	WSABUF wbuf[2];
+	DWORD sent;
+
+	wbuf[0].buf = (char*)hdr;
+	wbuf[0].len = sizeof(*hdr);
+	wbuf[1].buf = data;
+	wbuf[1].len = data_len;
+	err = WSASend (client_sock[client], wbuf, data_len > 0 ? 2 : 1, &sent, 0, NULL, NULL);
+#else
+	struct iovec iov[2];
+	struct msghdr msg;
+
+	iov[0].iov_base = hdr;
+	iov[0].iov_len = sizeof(*hdr);
+	iov[1].iov_base = data;
+	iov[1].iov_len = data_len;
+	memset (&msg, 0, sizeof(msg));
+	msg.msg_iov = iov;
+	msg.msg_iovlen = data_len > 0 ? 2 : 1;
+#if __APPLE__
+	err = sendmsg (client_sock[client], &msg, 0);
+#else
+	err = sendmsg (client_sock[client], &msg, MSG_NOSIGNAL);
+#endif
+#endif
+	(void)err;
+}
+
+
 static THREAD_F cmd_listen_thread (void *arg)
 {
 	int n;
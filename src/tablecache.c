@@ -0,0 +1,775 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      tablecache.c
+ *
+ * Purpose:   	Save precomputed tables between runs.
+ *
+ * Description:	Each demodulator has its own filter kernels, generated
+ *		at startup from the sample rate, baud, tones, and profile.
+ *		With several channels and multiple decoders per channel,
+ *		there can be dozens of them.  A slow single board computer,
+ *		restarted by a watchdog, spends time recalculating exactly
+ *		the same numbers as last time.
+ *
+ *		Here we keep the results in a file.  The file is simply
+ *		a header followed by entries, each with a name, the inputs
+ *		(key) used to generate it, and the result.  Everything is
+ *		aligned on 8 byte boundaries so it can be mapped into memory
+ *		and used in place.
+ *
+ *		The file is rewritten only when something was added.
+ *		Entries used this time are kept, followed by the new ones,
+ *		then any others until the file reaches TC_MAX_SIZE.
+ *		Anything not used for a while drifts toward the end and
+ *		eventually falls off so the file can't grow without bound.
+ *
+ *		The header has a key made by cmake from the table generator
+ *		source code, compiler, and compiler options, so a change in
+ *		any of those makes the old tables unusable.  It also has
+ *		the file layout version and the application version.
+ *		Each entry has a checksum.  Anything that doesn't match,
+ *		or is cut short, is silently discarded and those tables
+ *		are generated as before.
+ *
+ *		Usage:
+ *
+ *			tablecache_open (NULL);
+ *			... initialization which calls tablecache_get / tablecache_put ...
+ *			tablecache_close ();
+ *
+ *		This is intended for use only during initialization,
+ *		from a single thread, so there is no locking.
+ *
+ *---------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#if __WIN32__
+#else
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+#include "tablecache.h"
+#include "tablegen.h"		// TABLE_GENERATOR_KEY
+
+
+#define TC_MAGIC "DWTCACHE"
+
+#define TC_FORMAT_VERSION 2		// Layout of this file.  Generators are covered
+					// by TABLE_GENERATOR_KEY.
+
+#define TC_BYTE_ORDER 0x01020304
+
+#define TC_NAME_LEN 16
+
+#define TC_ALIGN(n) (((n) + 7) & ~((size_t)7))
+
+#define TC_MAX_SIZE (4 * 1024 * 1024)	// Unused entries are dropped beyond this.
+
+
+struct tc_header_s {
+	char magic[8];
+	uint32_t format_version;
+	uint32_t byte_order;		// Detect file from another type of machine.
+	uint32_t major_version;		// Application version.
+	uint32_t minor_version;
+	uint32_t num_entries;
+	uint32_t reserved;
+	uint64_t generator_key;		// TABLE_GENERATOR_KEY.
+};
+
+struct tc_entry_s {
+	char name[TC_NAME_LEN];
+	uint32_t key_len;
+	uint32_t data_len;
+	uint32_t check;			// See entry_check.
+	uint32_t reserved;
+					// Followed by key then data,
+					// each padded to multiple of 8 bytes.
+};
+
+
+static int tc_is_open = 0;
+static char tc_path[256];
+
+/* Existing file, mapped into memory. */
+
+static unsigned char *tc_map = NULL;
+static size_t tc_map_len = 0;
+static int tc_map_entries = 0;
+
+struct tc_index_s {
+	size_t offset;			// Entry header position in tc_map.
+	size_t len;			// Including header, key, and data.
+	int hit;			// Used this time.
+};
+
+static struct tc_index_s *tc_map_index = NULL;	// One for each entry in tc_map.
+
+/* Additions, to be written when closed. */
+
+struct tc_new_s {
+	struct tc_new_s *next;
+	struct tc_entry_s e;
+	unsigned char kd[];		// key followed by data, same layout as file.
+};
+
+static struct tc_new_s *tc_new_head = NULL;
+static struct tc_new_s **tc_new_tail = &tc_new_head;
+
+
+
+/*
+ * Checksum of an entry.  FNV-1a of the name, key, and data.
+ * kd is the key followed by the data, as in the file.
+ */
+
+static uint32_t entry_check (const struct tc_entry_s *e, const unsigned char *kd)
+{
+	uint32_t h = 2166136261u;
+	size_t j;
+
+	for (j = 0; j < TC_NAME_LEN; j++) {
+	  h = (h ^ (unsigned char)(e->name[j])) * 16777619u;
+	}
+	for (j = 0; j < e->key_len; j++) {
+	  h = (h ^ kd[j]) * 16777619u;
+	}
+	kd += TC_ALIGN((size_t)(e->key_len));
+	for (j = 0; j < e->data_len; j++) {
+	  h = (h ^ kd[j]) * 16777619u;
+	}
+	return (h);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        default_path
+ *
+ * Purpose:     Pick location for the cache file.
+ *
+ * Outputs:	path	- $XDG_CACHE_HOME/direwolf/tables.bin or
+ *			  $HOME/.cache/direwolf/tables.bin on Linux.
+ *			  Current working directory for Windows.
+ *
+ * Returns:	1 for success, 0 if no suitable place.
+ *
+ *--------------------------------------------------------------------*/
+
+static int default_path (char *path, size_t path_size)
+{
+#if __WIN32__
+	strlcpy (path, "direwolf-tables.bin", path_size);
+	return (1);
+#else
+	char *p;
+
+	p = getenv("XDG_CACHE_HOME");
+	if (p != NULL && strlen(p) > 0) {
+	  strlcpy (path, p, path_size);
+	}
+	else {
+	  p = getenv("HOME");
+	  if (p == NULL || strlen(p) == 0) {
+	    return (0);
+	  }
+	  strlcpy (path, p, path_size);
+	  strlcat (path, "/.cache", path_size);
+	  mkdir (path, 0777);
+	}
+	strlcat (path, "/direwolf", path_size);
+	mkdir (path, 0777);		// Might already exist.
+	strlcat (path, "/tables.bin", path_size);
+	return (1);
+#endif
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tablecache_open
+ *
+ * Purpose:     Make previously saved tables available.
+ *
+ * Inputs:	path	- Name of cache file or NULL for default location.
+ *
+ * Description:	A missing or unusable file is not an error.
+ *		We start with an empty cache in that case.
+ *
+ *--------------------------------------------------------------------*/
+
+void tablecache_open (const char *path)
+{
+	struct tc_header_s *h;
+
+	if (tc_is_open) {
+	  return;
+	}
+
+	if (path != NULL) {
+	  strlcpy (tc_path, path, sizeof(tc_path));
+	}
+	else if ( ! default_path (tc_path, sizeof(tc_path))) {
+	  return;
+	}
+
+	tc_is_open = 1;
+
+#if __WIN32__
+	FILE *fp = fopen (tc_path, "rb");
+	if (fp == NULL) {
+	  return;
+	}
+	fseek (fp, 0, SEEK_END);
+	tc_map_len = ftell (fp);
+	fseek (fp, 0, SEEK_SET);
+	if (tc_map_len >= sizeof(struct tc_header_s)) {
+	  tc_map = malloc (tc_map_len);
+	  if (tc_map != NULL && fread (tc_map, tc_map_len, 1, fp) != 1) {
+	    free (tc_map);
+	    tc_map = NULL;
+	  }
+	}
+	fclose (fp);
+#else
+	int fd;
+	struct stat st;
+
+	fd = open (tc_path, O_RDONLY);
+	if (fd < 0) {
+	  return;
+	}
+	if (fstat (fd, &st) == 0 && st.st_size >= (off_t)sizeof(struct tc_header_s)) {
+	  tc_map_len = st.st_size;
+	  tc_map = mmap (NULL, tc_map_len, PROT_READ, MAP_PRIVATE, fd, 0);
+	  if (tc_map == MAP_FAILED) {
+	    tc_map = NULL;
+	  }
+	}
+	close (fd);
+#endif
+
+	if (tc_map == NULL) {
+	  tc_map_len = 0;
+	  return;
+	}
+
+	h = (struct tc_header_s *)tc_map;
+
+	if (memcmp(h->magic, TC_MAGIC, sizeof(h->magic)) != 0 ||
+	    h->format_version != TC_FORMAT_VERSION ||
+	    h->byte_order != TC_BYTE_ORDER ||
+	    h->major_version != MAJOR_VERSION ||
+	    h->minor_version != MINOR_VERSION ||
+	    h->generator_key != TABLE_GENERATOR_KEY) {
+	  tc_map_entries = 0;		// Ignore it.  Will be replaced.
+	  return;
+	}
+
+/*
+ * The file could be truncated or otherwise damaged.
+ * Keep only the complete entries with the right checksum.
+ * After a bad length, we can't find the rest so stop there.
+ */
+	size_t offset = sizeof(struct tc_header_s);
+	int n;
+
+	tc_map_index = calloc (h->num_entries > 0 ? h->num_entries : 1, sizeof(struct tc_index_s));
+	if (tc_map_index == NULL) {
+	  return;
+	}
+
+	tc_map_entries = 0;
+	for (n = 0; n < (int)(h->num_entries); n++) {
+	  const struct tc_entry_s *e;
+	  size_t next;
+
+	  if (offset + sizeof(struct tc_entry_s) > tc_map_len) {
+	    break;
+	  }
+	  e = (const struct tc_entry_s *)(tc_map + offset);
+	  if (e->key_len > tc_map_len || e->data_len > tc_map_len) {
+	    break;
+	  }
+	  next = offset + sizeof(struct tc_entry_s) + TC_ALIGN((size_t)(e->key_len)) + TC_ALIGN((size_t)(e->data_len));
+	  if (next > tc_map_len) {
+	    break;
+	  }
+	  if (e->check == entry_check (e, tc_map + offset + sizeof(struct tc_entry_s))) {
+	    tc_map_index[tc_map_entries].offset = offset;
+	    tc_map_index[tc_map_entries].len = next - offset;
+	    tc_map_entries++;
+	  }
+	  offset = next;
+	}
+
+} /* end tablecache_open */
+
+
+
+/*
+ * Find entry in the mapped file.
+ * Returns pointer to data or NULL if not found.
+ */
+
+static const unsigned char *find_mapped (const char *name, const void *key, size_t key_len, size_t data_len)
+{
+	int n;
+
+	for (n = 0; n < tc_map_entries; n++) {
+	  const struct tc_entry_s *e;
+	  const unsigned char *k;
+
+	  e = (const struct tc_entry_s *)(tc_map + tc_map_index[n].offset);
+	  k = tc_map + tc_map_index[n].offset + sizeof(struct tc_entry_s);
+
+	  if (e->key_len == key_len && e->data_len == data_len &&
+	      strncmp(e->name, name, TC_NAME_LEN) == 0 &&
+	      memcmp(k, key, key_len) == 0) {
+	    tc_map_index[n].hit = 1;
+	    return (k + TC_ALIGN(key_len));
+	  }
+	}
+	return (NULL);
+}
+
+
+/*
+ * Same thing for those added this time.
+ */
+
+static const unsigned char *find_new (const char *name, const void *key, size_t key_len, size_t data_len)
+{
+	struct tc_new_s *n;
+
+	for (n = tc_new_head; n != NULL; n = n->next) {
+	  if (n->e.key_len == key_len && n->e.data_len == data_len &&
+	      strncmp(n->e.name, name, TC_NAME_LEN) == 0 &&
+	      memcmp(n->kd, key, key_len) == 0) {
+	    return (n->kd + TC_ALIGN(key_len));
+	  }
+	}
+	return (NULL);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tablecache_get
+ *
+ * Purpose:     Retrieve a previously generated table.
+ *
+ * Inputs:	name		- Kind of table, e.g. "lowpass".
+ *		key		- Everything used to generate the table.
+ *				  Should be a structure cleared with memset
+ *				  so padding doesn't cause mismatches.
+ *		key_len		- Size of key.
+ *		data_len	- Expected size of result.
+ *
+ * Outputs:	data		- Copy of table if found.
+ *
+ * Returns:	1 if found.  0 if not, or cache not open.
+ *
+ *--------------------------------------------------------------------*/
+
+int tablecache_get (const char *name, const void *key, size_t key_len, void *data, size_t data_len)
+{
+	const unsigned char *p;
+
+	if ( ! tc_is_open) {
+	  return (0);
+	}
+
+	p = find_mapped (name, key, key_len, data_len);
+	if (p == NULL) {
+	  p = find_new (name, key, key_len, data_len);
+	}
+	if (p != NULL) {
+	  memcpy (data, p, data_len);
+	  return (1);
+	}
+	return (0);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tablecache_put
+ *
+ * Purpose:     Remember a newly generated table.
+ *
+ * Inputs:	Same as tablecache_get with data being the result.
+ *
+ * Description:	This is kept in memory and written out by tablecache_close.
+ *		Nothing happens if it is already there.  That can happen
+ *		when tables are generated in pairs and only one was found.
+ *
+ *--------------------------------------------------------------------*/
+
+void tablecache_put (const char *name, const void *key, size_t key_len, const void *data, size_t data_len)
+{
+	struct tc_new_s *n;
+
+	if ( ! tc_is_open) {
+	  return;
+	}
+
+	if (find_mapped (name, key, key_len, data_len) != NULL ||
+	    find_new (name, key, key_len, data_len) != NULL) {
+	  return;
+	}
+
+	n = calloc (sizeof(struct tc_new_s) + TC_ALIGN(key_len) + TC_ALIGN(data_len), 1);
+	if (n == NULL) {
+	  return;		// Just means we don't save it.
+	}
+	memcpy (n->e.name, name, strnlen(name, TC_NAME_LEN));	// Not necessarily nul terminated.
+	n->e.key_len = key_len;
+	n->e.data_len = data_len;
+	memcpy (n->kd, key, key_len);
+	memcpy (n->kd + TC_ALIGN(key_len), data, data_len);
+	n->e.check = entry_check (&(n->e), n->kd);
+
+	*tc_new_tail = n;
+	tc_new_tail = &(n->next);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tablecache_close
+ *
+ * Purpose:     Write the cache file if anything was added and
+ *		release the resources.
+ *
+ * Description:	A new file is written then renamed so another
+ *		instance never sees a partially written file.
+ *		The temporary name includes the process id so two
+ *		instances finishing at the same time don't write
+ *		into the same file.  The last rename wins.
+ *
+ *		Existing entries are carried over, space permitting,
+ *		so two different configurations, run alternately,
+ *		don't keep replacing each other's tables.
+ *
+ *--------------------------------------------------------------------*/
+
+void tablecache_close (void)
+{
+	struct tc_new_s *n, *next;
+
+	if ( ! tc_is_open) {
+	  return;
+	}
+
+	if (tc_new_head != NULL) {
+	  char temp_path[sizeof(tc_path) + 24];
+	  FILE *fp;
+
+#if __WIN32__
+	  snprintf (temp_path, sizeof(temp_path), "%s.%lu.tmp", tc_path, (unsigned long)GetCurrentProcessId());
+#else
+	  snprintf (temp_path, sizeof(temp_path), "%s.%ld.tmp", tc_path, (long)getpid());
+#endif
+	  fp = fopen (temp_path, "wb");
+	  if (fp != NULL) {
+	    struct tc_header_s h;
+	    size_t total;
+	    int keep_unused;
+	    int j;
+	    int ok;
+
+/*
+ * Decide which of the unused old entries still fit.
+ */
+	    memset (&h, 0, sizeof(h));
+	    total = sizeof(h);
+	    for (j = 0; j < tc_map_entries; j++) {
+	      if (tc_map_index[j].hit) {
+	        total += tc_map_index[j].len;
+	        h.num_entries++;
+	      }
+	    }
+	    for (n = tc_new_head; n != NULL; n = n->next) {
+	      total += sizeof(struct tc_entry_s) + TC_ALIGN(n->e.key_len) + TC_ALIGN(n->e.data_len);
+	      h.num_entries++;
+	    }
+	    keep_unused = 0;
+	    for (j = 0; j < tc_map_entries; j++) {
+	      if ( ! tc_map_index[j].hit) {
+	        if (total + tc_map_index[j].len > TC_MAX_SIZE) {
+	          break;
+	        }
+	        total += tc_map_index[j].len;
+	        keep_unused++;
+	      }
+	    }
+	    h.num_entries += keep_unused;
+
+	    memcpy (h.magic, TC_MAGIC, sizeof(h.magic));
+	    h.format_version = TC_FORMAT_VERSION;
+	    h.byte_order = TC_BYTE_ORDER;
+	    h.major_version = MAJOR_VERSION;
+	    h.minor_version = MINOR_VERSION;
+	    h.generator_key = TABLE_GENERATOR_KEY;
+
+	    ok = fwrite (&h, sizeof(h), 1, fp) == 1;
+	    for (j = 0; ok && j < tc_map_entries; j++) {
+	      if (tc_map_index[j].hit) {
+	        ok = fwrite (tc_map + tc_map_index[j].offset, tc_map_index[j].len, 1, fp) == 1;
+	      }
+	    }
+	    for (n = tc_new_head; ok && n != NULL; n = n->next) {
+	      ok = fwrite (&(n->e), sizeof(struct tc_entry_s), 1, fp) == 1 &&
+		   fwrite (n->kd, TC_ALIGN(n->e.key_len) + TC_ALIGN(n->e.data_len), 1, fp) == 1;
+	    }
+	    for (j = 0; ok && j < tc_map_entries && keep_unused > 0; j++) {
+	      if ( ! tc_map_index[j].hit) {
+	        ok = fwrite (tc_map + tc_map_index[j].offset, tc_map_index[j].len, 1, fp) == 1;
+	        keep_unused--;
+	      }
+	    }
+	    if (fclose (fp) != 0) {
+	      ok = 0;
+	    }
+
+#if __WIN32__
+	    remove (tc_path);		// Windows rename won't replace existing file.
+#endif
+	    if ( ! ok || rename (temp_path, tc_path) != 0) {
+	      remove (temp_path);
+	    }
+	  }
+	}
+
+	for (n = tc_new_head; n != NULL; n = next) {
+	  next = n->next;
+	  free (n);
+	}
+	tc_new_head = NULL;
+	tc_new_tail = &tc_new_head;
+
+	if (tc_map != NULL) {
+#if __WIN32__
+	  free (tc_map);
+#else
+	  munmap (tc_map, tc_map_len);
+#endif
+	  tc_map = NULL;
+	}
+	free (tc_map_index);
+	tc_map_index = NULL;
+	tc_map_len = 0;
+	tc_map_entries = 0;
+	tc_is_open = 0;
+
+} /* end tablecache_close */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        main
+ *
+ * Purpose:     Unit test.  Write some tables, read them back, and make
+ *		sure a damaged file can't supply anything wrong.
+ *
+ *--------------------------------------------------------------------*/
+
+#if TABLECACHETEST
+
+#include <assert.h>
+#include "textcolor.h"
+
+static const char *fname = "tablecachetest.tmp";
+
+static unsigned char good[4096];
+static size_t good_len;
+
+static struct key_s {
+	int filter_size;
+	float cutoff;
+} key1, key2;
+
+static float t1[100], t2[50];
+
+
+// Replace the file with a modified copy of the good one.
+
+static void write_file (const unsigned char *p, size_t len)
+{
+	FILE *fp = fopen (fname, "wb");
+	assert (fp != NULL);
+	assert (len == 0 || fwrite (p, len, 1, fp) == 1);
+	fclose (fp);
+}
+
+// Which of the two tables can be found now?
+
+static void expect (int want1, int want2)
+{
+	float out[100];
+
+	tablecache_open (fname);
+	memset (out, 0, sizeof(out));
+	assert (tablecache_get ("lowpass", &key1, sizeof(key1), out, sizeof(t1)) == want1);
+	if (want1) assert (memcmp (out, t1, sizeof(t1)) == 0);
+	memset (out, 0, sizeof(out));
+	assert (tablecache_get ("bandpass", &key2, sizeof(key2), out, sizeof(t2)) == want2);
+	if (want2) assert (memcmp (out, t2, sizeof(t2)) == 0);
+	tablecache_close ();
+}
+
+
+int main (int argc, char *argv[])
+{
+	unsigned char bad[sizeof(good)];
+	struct tc_header_s *h = (struct tc_header_s *)bad;
+	struct tc_entry_s *e = (struct tc_entry_s *)(bad + sizeof(struct tc_header_s));
+	float out[100];
+	FILE *fp;
+	int j;
+
+	memset (&key1, 0, sizeof(key1));
+	key1.filter_size = 100;
+	key1.cutoff = 0.25;
+	memset (&key2, 0, sizeof(key2));
+	key2.filter_size = 50;
+	key2.cutoff = 0.125;
+	for (j = 0; j < 100; j++) t1[j] = j * 0.5f;
+	for (j = 0; j < 50; j++) t2[j] = -j * 0.25f;
+
+	remove (fname);
+
+/*
+ * Nothing at first.  Added ones can be found right away.
+ */
+	tablecache_open (fname);
+	assert (tablecache_get ("lowpass", &key1, sizeof(key1), out, sizeof(t1)) == 0);
+	tablecache_put ("lowpass", &key1, sizeof(key1), t1, sizeof(t1));
+	tablecache_put ("bandpass", &key2, sizeof(key2), t2, sizeof(t2));
+	assert (tablecache_get ("lowpass", &key1, sizeof(key1), out, sizeof(t1)) == 1);
+	tablecache_close ();
+
+/*
+ * Round trip through the file.  Different key or size is not a match.
+ */
+	expect (1, 1);
+
+	tablecache_open (fname);
+	assert (tablecache_get ("lowpass", &key2, sizeof(key2), out, sizeof(t1)) == 0);
+	assert (tablecache_get ("lowpass", &key1, sizeof(key1), out, sizeof(t2)) == 0);
+	assert (tablecache_get ("highpass", &key1, sizeof(key1), out, sizeof(t1)) == 0);
+	tablecache_close ();
+
+	fp = fopen (fname, "rb");
+	assert (fp != NULL);
+	good_len = fread (good, 1, sizeof(good), fp);
+	fclose (fp);
+	assert (good_len == sizeof(struct tc_header_s) +
+		2 * sizeof(struct tc_entry_s) + sizeof(key1) + sizeof(t1) + sizeof(key2) + sizeof(t2));
+
+/*
+ * Truncated in the second table, or in the header.
+ */
+	write_file (good, good_len - 8);
+	expect (1, 0);
+
+	write_file (good, sizeof(struct tc_header_s) - 4);
+	expect (0, 0);
+
+	write_file (good, 0);
+	expect (0, 0);
+
+/*
+ * Damaged data in the first table.  The other is still good.
+ */
+	memcpy (bad, good, good_len);
+	bad[sizeof(struct tc_header_s) + sizeof(struct tc_entry_s) + sizeof(key1) + 40] ^= 0x10;
+	write_file (bad, good_len);
+	expect (0, 1);
+
+/*
+ * Damaged length.  Can't find anything after that.
+ */
+	memcpy (bad, good, good_len);
+	e->data_len = 0xfffffff0;
+	write_file (bad, good_len);
+	expect (0, 0);
+
+	memcpy (bad, good, good_len);
+	e->key_len += 8;
+	write_file (bad, good_len);
+	expect (0, 0);
+
+/*
+ * Made by different generator code or another version.
+ */
+	memcpy (bad, good, good_len);
+	h->generator_key ^= 1;
+	write_file (bad, good_len);
+	expect (0, 0);
+
+	memcpy (bad, good, good_len);
+	h->format_version++;
+	write_file (bad, good_len);
+	expect (0, 0);
+
+/*
+ * Putting the missing one back repairs the file.
+ */
+	memcpy (bad, good, good_len);
+	bad[sizeof(struct tc_header_s) + sizeof(struct tc_entry_s) + sizeof(key1) + 40] ^= 0x10;
+	write_file (bad, good_len);
+	tablecache_open (fname);
+	assert (tablecache_get ("bandpass", &key2, sizeof(key2), out, sizeof(t2)) == 1);
+	assert (tablecache_get ("lowpass", &key1, sizeof(key1), out, sizeof(t1)) == 0);
+	tablecache_put ("lowpass", &key1, sizeof(key1), t1, sizeof(t1));
+	tablecache_close ();
+	expect (1, 1);
+
+	remove (fname);
+
+	text_color_set(DW_COLOR_INFO);
+	dw_printf ("Table cache test passed.\n");
+	exit (EXIT_SUCCESS);
+}
+
+#endif
+
+/* end tablecache.c */
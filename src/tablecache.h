@@ -0,0 +1,29 @@
+
+/* tablecache.h */
+
+#ifndef TABLECACHE_H
+#define TABLECACHE_H 1
+
+#include <stddef.h>
+
+
+/*
+ * Keep precomputed tables, such as demodulator filter kernels,
+ * in a file so they don't need to be generated again at next startup.
+ *
+ * Nothing is cached unless tablecache_open has been called so
+ * the test and utility applications are not affected.
+ */
+
+void tablecache_open (const char *path);
+
+int tablecache_get (const char *name, const void *key, size_t key_len, void *data, size_t data_len);
+
+void tablecache_put (const char *name, const void *key, size_t key_len, const void *data, size_t data_len);
+
+void tablecache_close (void);
+
+
+#endif
+
+/* end tablecache.h */
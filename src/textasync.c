@@ -0,0 +1,619 @@
+//
+//    This file is part of Dire Wolf, an amateur radio packet TNC.
+//
+//    Copyright (C) 2024  John Langner, WB2OSZ
+//
+//    This program is free software: you can redistribute it and/or modify
+//    it under the terms of the GNU General Public License as published by
+//    the Free Software Foundation, either version 2 of the License, or
+//    (at your option) any later version.
+//
+//    This program is distributed in the hope that it will be useful,
+//    but WITHOUT ANY WARRANTY; without even the implied warranty of
+//    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+//    GNU General Public License for more details.
+//
+//    You should have received a copy of the GNU General Public License
+//    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+//
+
+
+/*------------------------------------------------------------------
+ *
+ * Module:      textasync.c
+ *
+ * Purpose:   	Write console output from a separate thread so the
+ *		receive and transmit threads never wait for it.
+ *
+ * Description:	Every decoded packet produces several dw_printf and
+ *		text_color_set calls.  These used to write directly to stdout
+ *		from whatever thread called them.  When stdout is a slow terminal,
+ *		a pipe, or journald, the decoder would stop until the write
+ *		completed.
+ *
+ *		Now each thread has its own circular buffer.  Only that thread
+ *		adds to it and only the writer thread takes from it.
+ *		Adding an item takes no lock.  Each item gets a sequence
+ *		number, from an atomic counter, so the writer can keep the
+ *		original order across threads.  The number is taken just
+ *		before the item is made visible.  If the writer finds the
+ *		next number missing, another thread is between those two
+ *		steps, so it looks again rather than skipping ahead.
+ *		Only the first output from a new thread takes a lock,
+ *		to add its buffer to the list.
+ *
+ *		If a buffer fills up, because the console is not keeping up,
+ *		we can either:
+ *
+ *			- Wait for space, as it would have before.  (default)
+ *			- Discard lines, and count them.
+ *			  If the buffer fills part way through a line, the part
+ *			  already there is ended with a newline so the next line
+ *			  doesn't get joined onto it.  A little space is always
+ *			  kept in reserve for that.
+ *
+ *		The writer is woken up only when it is idle.  Otherwise
+ *		it keeps going until all buffers are empty.
+ *
+ *		Not available for Windows yet.  Output is synchronous there,
+ *		as in earlier versions.
+ *
+ *---------------------------------------------------------------*/
+
+#include "direwolf.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#if __WIN32__
+#else
+#include <pthread.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+#include <sched.h>
+#endif
+
+#include "textcolor.h"
+#include "textasync.h"
+
+
+#if __WIN32__
+
+void text_async_init (enum text_async_e policy)
+{
+}
+
+int text_async_dropped (void)
+{
+	return (0);
+}
+
+void text_async_flush (void)
+{
+}
+
+#else
+
+
+#define RING_SIZE 16384		/* Per thread.  Multiple of 8. */
+
+#define KIND_TEXT -1		/* Otherwise, >= 0 is a color. */
+#define KIND_WRAP -2		/* Rest of buffer is unused.  Continue at beginning. */
+
+
+struct item_s {
+	unsigned int seq;	/* For keeping order between threads. */
+	short kind;
+	unsigned short len;	/* Length of text which follows. */
+};
+
+#define ITEM_SIZE(len) ((sizeof(struct item_s) + (len) + 7) & ~7)
+
+#define NEWLINE_RESERVE (2 * ITEM_SIZE(1))	/* Room to end a line, even if it must wrap. */
+
+
+struct ring_s {
+	char buf[RING_SIZE];	/* First so items are aligned. */
+	unsigned int head;	/* Total bytes added.  Written only by owner thread. */
+	unsigned int tail;	/* Total bytes removed.  Written only by writer thread. */
+	int dead;		/* Owner thread has exited.  Free when empty. */
+	int dropping;		/* Discarding until end of line. */
+	int mid_line;		/* Last text added did not end with newline. */
+	struct ring_s *next;
+};
+
+
+static enum text_async_e s_policy = TEXT_ASYNC_OFF;
+
+static pthread_key_t s_ring_key;
+
+static struct ring_s *s_ring_list = NULL;	/* All buffers.  Protected by s_list_mutex. */
+static pthread_mutex_t s_list_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int s_seq = 0;			/* Next sequence number.  Atomic. */
+static unsigned int s_next_out = 0;		/* Next sequence number to write.  Writer only. */
+
+static int s_dropped = 0;			/* Lines discarded. */
+static int s_dropped_reported = 0;
+
+static int s_writer_idle = 0;			/* Writer is waiting for more. */
+static pthread_mutex_t s_wake_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_wake_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t s_writer_tid;
+
+static int s_space_waiters = 0;			/* Producers waiting for the writer to make room. */
+static pthread_mutex_t s_space_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t s_space_cond = PTHREAD_COND_INITIALIZER;
+
+static void async_put (int kind, const char *text, int len);
+static int room_for (struct ring_s *r, unsigned int need, unsigned int reserve);
+static void wait_for_space (struct ring_s *r, unsigned int need);
+static void add_item (struct ring_s *r, int kind, const char *text, int len);
+static void * writer_thread (void *arg);
+static void ring_destructor (void *arg);
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        text_async_init
+ *
+ * Purpose:     Start the writer thread and take over dw_printf and
+ *		text_color_set.
+ *
+ * Inputs:	policy	- TEXT_ASYNC_OFF to leave it synchronous.
+ *			  TEXT_ASYNC_DROP to discard lines when behind.
+ *			  TEXT_ASYNC_WAIT to wait when behind.
+ *
+ *--------------------------------------------------------------------*/
+
+void text_async_init (enum text_async_e policy)
+{
+	if (policy == TEXT_ASYNC_OFF) {
+	  return;
+	}
+
+	if (pthread_key_create (&s_ring_key, ring_destructor) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not set up asynchronous console output.\n");
+	  return;
+	}
+
+	if (pthread_create (&s_writer_tid, NULL, writer_thread, NULL) != 0) {
+	  text_color_set(DW_COLOR_ERROR);
+	  dw_printf ("Could not create console output thread.\n");
+	  return;
+	}
+
+	fflush (stdout);
+	s_policy = policy;
+	text_output_hook (async_put);
+	atexit (text_async_flush);
+}
+
+
+int text_async_dropped (void)
+{
+	return (__atomic_load_n (&s_dropped, __ATOMIC_RELAXED));
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        get_ring
+ *
+ * Purpose:     Find the buffer for the current thread, creating it
+ *		the first time.
+ *
+ * Returns:	Pointer to buffer or NULL if out of memory.
+ *
+ *--------------------------------------------------------------------*/
+
+static struct ring_s *get_ring (void)
+{
+	struct ring_s *r = pthread_getspecific (s_ring_key);
+
+	if (r == NULL) {
+	  r = calloc (1, sizeof(struct ring_s));
+	  if (r == NULL) {
+	    return (NULL);
+	  }
+	  pthread_setspecific (s_ring_key, r);
+
+	  pthread_mutex_lock (&s_list_mutex);
+	  r->next = s_ring_list;
+	  s_ring_list = r;
+	  pthread_mutex_unlock (&s_list_mutex);
+	}
+	return (r);
+}
+
+
+// Called when a thread exits.  The writer frees the buffer after emptying it.
+
+static void ring_destructor (void *arg)
+{
+	struct ring_s *r = arg;
+
+	__atomic_store_n (&(r->dead), 1, __ATOMIC_RELEASE);
+}
+
+
+static void wake_writer (void)
+{
+	if (__atomic_load_n (&s_writer_idle, __ATOMIC_SEQ_CST)) {
+	  pthread_mutex_lock (&s_wake_mutex);
+	  pthread_cond_signal (&s_wake_cond);
+	  pthread_mutex_unlock (&s_wake_mutex);
+	}
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        async_put
+ *
+ * Purpose:     Add text or a color change to the current thread's buffer.
+ *
+ * Inputs:	kind	- Color, or KIND_TEXT.
+ *
+ *		text	- Text for KIND_TEXT.
+ *
+ *		len	- Length of text.
+ *
+ * Description:	This is called by dw_printf and text_color_set in place
+ *		of writing to stdout.
+ *
+ *--------------------------------------------------------------------*/
+
+static void async_put (int kind, const char *text, int len)
+{
+	struct ring_s *r = get_ring ();
+
+	if (r == NULL) {
+	  if (kind == KIND_TEXT) text_output_apply (text, len);
+	  else text_color_apply (kind);
+	  return;
+	}
+
+	if (len > RING_SIZE / 4) {
+	  len = RING_SIZE / 4;		// dw_printf has a smaller limit anyway.
+	}
+	int ends_line = kind == KIND_TEXT && len > 0 && text[len-1] == '\n';
+	unsigned int need = ITEM_SIZE(len);
+
+	if (r->dropping) {
+	  if (ends_line) {
+	    r->dropping = 0;		// Resume at the start of the next line.
+	  }
+	  return;
+	}
+
+	if (s_policy == TEXT_ASYNC_DROP) {
+	  if ( ! room_for (r, need, NEWLINE_RESERVE)) {
+	    __atomic_add_fetch (&s_dropped, 1, __ATOMIC_RELAXED);
+	    if (r->mid_line) {
+	      add_item (r, KIND_TEXT, "\n", 1);	// Uses the reserve.
+	      r->mid_line = 0;
+	      wake_writer ();
+	    }
+	    if ( ! ends_line) {
+	      r->dropping = 1;
+	    }
+	    return;
+	  }
+	}
+	else if ( ! room_for (r, need, 0)) {
+	  wait_for_space (r, need);
+	}
+
+	add_item (r, kind, text, len);
+	if (kind == KIND_TEXT && len > 0) {
+	  r->mid_line = ! ends_line;
+	}
+
+	wake_writer ();
+}
+
+
+/*
+ * Is there room for an item of size need, plus reserve, after
+ * allowing for skipping the unused end of the buffer?
+ * Only the owner thread should call this.
+ */
+
+static int room_for (struct ring_s *r, unsigned int need, unsigned int reserve)
+{
+	unsigned int h = r->head;
+	unsigned int t = __atomic_load_n (&(r->tail), __ATOMIC_SEQ_CST);
+	unsigned int pos = h % RING_SIZE;
+	unsigned int wrap = (pos + need > RING_SIZE) ? RING_SIZE - pos : 0;
+
+	return (RING_SIZE - (h - t) >= wrap + need + reserve);
+}
+
+
+/*
+ * Wait until the writer has made enough room.
+ */
+
+static void wait_for_space (struct ring_s *r, unsigned int need)
+{
+	wake_writer ();
+
+	pthread_mutex_lock (&s_space_mutex);
+	__atomic_add_fetch (&s_space_waiters, 1, __ATOMIC_SEQ_CST);
+
+	while ( ! room_for (r, need, 0)) {
+	  struct timespec ts;		// Timeout is only a safety net.
+	  clock_gettime (CLOCK_REALTIME, &ts);
+	  ts.tv_nsec += 200 * 1000000;
+	  if (ts.tv_nsec >= 1000000000) {
+	    ts.tv_sec++;
+	    ts.tv_nsec -= 1000000000;
+	  }
+	  pthread_cond_timedwait (&s_space_cond, &s_space_mutex, &ts);
+	}
+
+	__atomic_sub_fetch (&s_space_waiters, 1, __ATOMIC_SEQ_CST);
+	pthread_mutex_unlock (&s_space_mutex);
+}
+
+
+/*
+ * Add an item.  The caller has already made sure there is room.
+ * Nothing between taking the sequence number and making the item
+ * visible can block so the writer never has to wait long for it.
+ */
+
+static void add_item (struct ring_s *r, int kind, const char *text, int len)
+{
+	unsigned int need = ITEM_SIZE(len);
+	unsigned int h = r->head;
+	unsigned int pos = h % RING_SIZE;
+
+	if (pos + need > RING_SIZE) {
+	  struct item_s *w = (struct item_s *)(r->buf + pos);
+	  w->kind = KIND_WRAP;
+	  w->len = 0;
+	  h += RING_SIZE - pos;
+	  pos = 0;
+	}
+
+	struct item_s *item = (struct item_s *)(r->buf + pos);
+	item->kind = kind;
+	item->len = len;
+	if (len > 0) {
+	  memcpy ((char *)(item + 1), text, len);
+	}
+
+	item->seq = __atomic_fetch_add (&s_seq, 1, __ATOMIC_SEQ_CST);
+	__atomic_store_n (&(r->head), h + need, __ATOMIC_SEQ_CST);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        peek_item
+ *
+ * Purpose:     Get the next item in a buffer, without removing it.
+ *		Only the writer thread should call this.
+ *
+ * Returns:	Item or NULL if buffer is empty.
+ *
+ *--------------------------------------------------------------------*/
+
+static struct item_s *peek_item (struct ring_s *r)
+{
+	while (1) {
+	  unsigned int t = r->tail;
+	  unsigned int h = __atomic_load_n (&(r->head), __ATOMIC_SEQ_CST);
+
+	  if (t == h) {
+	    return (NULL);
+	  }
+
+	  struct item_s *item = (struct item_s *)(r->buf + t % RING_SIZE);
+
+	  if (item->kind != KIND_WRAP) {
+	    return (item);
+	  }
+	  __atomic_store_n (&(r->tail), t + (RING_SIZE - t % RING_SIZE), __ATOMIC_RELEASE);
+	}
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        write_pending
+ *
+ * Purpose:     Write out everything currently in the buffers,
+ *		in order of sequence number.
+ *
+ * Returns:	Number of items written.
+ *
+ * Description:	Buffers of threads which have exited are freed here
+ *		once they are empty.
+ *
+ *		If the earliest item found is not the next number expected,
+ *		another thread has taken that number but not quite finished
+ *		adding the item.  Let it run and look again.
+ *
+ *--------------------------------------------------------------------*/
+
+static int write_pending (void)
+{
+	int count = 0;
+
+	while (1) {
+	  struct ring_s *best = NULL;
+	  struct item_s *best_item = NULL;
+	  struct ring_s **pr;
+
+	  pthread_mutex_lock (&s_list_mutex);
+
+	  pr = &s_ring_list;
+	  while (*pr != NULL) {
+	    struct ring_s *r = *pr;
+	    struct item_s *item = peek_item (r);
+
+	    if (item == NULL) {
+	      if (__atomic_load_n (&(r->dead), __ATOMIC_ACQUIRE) && peek_item(r) == NULL) {
+	        *pr = r->next;
+	        free (r);
+	        continue;
+	      }
+	    }
+	    else if (best_item == NULL || (int)(item->seq - best_item->seq) < 0) {
+	      best = r;
+	      best_item = item;
+	    }
+	    pr = &(r->next);
+	  }
+
+	  pthread_mutex_unlock (&s_list_mutex);
+
+	  if (best == NULL) {
+	    break;
+	  }
+
+	  if (best_item->seq != s_next_out) {
+	    sched_yield ();
+	    continue;
+	  }
+	  s_next_out = best_item->seq + 1;
+
+	  if (best_item->kind == KIND_TEXT) {
+	    text_output_apply ((char *)(best_item + 1), best_item->len);
+	  }
+	  else {
+	    text_color_apply (best_item->kind);
+	  }
+	  count++;
+
+	  __atomic_store_n (&(best->tail), best->tail + ITEM_SIZE(best_item->len), __ATOMIC_SEQ_CST);
+
+	  if (__atomic_load_n (&s_space_waiters, __ATOMIC_SEQ_CST) > 0) {
+	    pthread_mutex_lock (&s_space_mutex);
+	    pthread_cond_broadcast (&s_space_cond);
+	    pthread_mutex_unlock (&s_space_mutex);
+	  }
+	}
+
+	return (count);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        writer_thread
+ *
+ * Purpose:     Write buffered console output.  Wait when there is none.
+ *
+ *--------------------------------------------------------------------*/
+
+static void * writer_thread (void *arg)
+{
+	while (1) {
+
+	  if (write_pending() > 0) {
+	    continue;
+	  }
+
+	  int d = __atomic_load_n (&s_dropped, __ATOMIC_RELAXED);
+	  if (d != s_dropped_reported) {
+	    char msg[100];
+	    snprintf (msg, sizeof(msg), "[%d line%s of console output discarded because it was not keeping up.  %d total.]\n",
+				d - s_dropped_reported, d - s_dropped_reported == 1 ? "" : "s", d);
+	    text_color_apply (DW_COLOR_ERROR);
+	    text_output_apply (msg, strlen(msg));
+	    text_color_apply (DW_COLOR_INFO);
+	    s_dropped_reported = d;
+	  }
+
+	  fflush (stdout);
+
+// Let producers know we need to be woken up.  Check again in case
+// something was added just before that.  The timeout is only a safety net.
+
+	  pthread_mutex_lock (&s_wake_mutex);
+	  __atomic_store_n (&s_writer_idle, 1, __ATOMIC_SEQ_CST);
+
+	  int more = 0;
+	  struct ring_s *r;
+	  pthread_mutex_lock (&s_list_mutex);
+	  for (r = s_ring_list; r != NULL && ! more; r = r->next) {
+	    more = peek_item(r) != NULL;
+	  }
+	  pthread_mutex_unlock (&s_list_mutex);
+
+	  if ( ! more) {
+	    struct timespec ts;
+	    clock_gettime (CLOCK_REALTIME, &ts);
+	    ts.tv_nsec += 200 * 1000000;
+	    if (ts.tv_nsec >= 1000000000) {
+	      ts.tv_sec++;
+	      ts.tv_nsec -= 1000000000;
+	    }
+	    pthread_cond_timedwait (&s_wake_cond, &s_wake_mutex, &ts);
+	  }
+
+	  __atomic_store_n (&s_writer_idle, 0, __ATOMIC_SEQ_CST);
+	  pthread_mutex_unlock (&s_wake_mutex);
+	}
+
+	return (NULL);
+}
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        text_async_flush
+ *
+ * Purpose:     Give the writer a chance to empty the buffers before
+ *		the application exits.
+ *
+ * Description:	Don't wait forever.  The console might be stuck.
+ *
+ *--------------------------------------------------------------------*/
+
+void text_async_flush (void)
+{
+	int n;
+
+	if (s_policy == TEXT_ASYNC_OFF) {
+	  return;
+	}
+
+	for (n = 0; n < 200; n++) {
+	  int empty = 1;
+	  struct ring_s *r;
+
+	  pthread_mutex_lock (&s_list_mutex);
+	  for (r = s_ring_list; r != NULL; r = r->next) {
+	    if (__atomic_load_n (&(r->tail), __ATOMIC_ACQUIRE) != __atomic_load_n (&(r->head), __ATOMIC_ACQUIRE)) {
+	      empty = 0;
+	    }
+	  }
+	  pthread_mutex_unlock (&s_list_mutex);
+
+	  if (empty) {
+	    break;
+	  }
+	  wake_writer ();
+	  SLEEP_MS (10);
+	}
+	fflush (stdout);
+}
+
+#endif
+
+/* end textasync.c */
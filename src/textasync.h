@@ -0,0 +1,34 @@
+/* textasync.h */
+
+#ifndef TEXTASYNC_H
+#define TEXTASYNC_H 1
+
+
+/*
+ * What to do when a thread has filled its console output buffer
+ * because the console can't keep up.
+ */
+
+enum text_async_e {
+	TEXT_ASYNC_OFF = 0,	/* Synchronous, as in earlier versions. */
+	TEXT_ASYNC_DROP,	/* Discard whole lines.  Never wait. */
+	TEXT_ASYNC_WAIT		/* Wait for space.  Nothing is lost. */
+};
+
+
+/* Call this once at startup, before any other threads are created. */
+
+void text_async_init (enum text_async_e policy);
+
+/* Number of lines discarded so far. */
+
+int text_async_dropped (void);
+
+/* Wait, briefly, for everything buffered to be written.  Called at exit. */
+
+void text_async_flush (void);
+
+
+#endif
+
+/* end textasync.h */
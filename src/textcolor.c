@@ -173,6 +173,19 @@ static const char clear_eos[]	= "\e[0J";
 static int g_enable_color = 1;
 
 
+/*
+ * Normally NULL so output happens right away in the calling thread.
+ * See textasync.c.
+ */
+
+static text_output_fn_t g_output_hook = NULL;
+
+void text_output_hook (text_output_fn_t fn)
+{
+	g_output_hook = fn;
+}
+
+
 void text_color_init (int enable_color)
 {
 
@@ -245,7 +258,7 @@ void text_color_init (int enable_color)
 /* Seems that ANSI.SYS is no longer available. */
 
 
-void text_color_set ( enum dw_color_e c )
+void text_color_apply ( enum dw_color_e c )
 {
 	WORD attr;
 	HANDLE h;
@@ -294,7 +307,7 @@ void text_color_set ( enum dw_color_e c )
 
 #else
 
-void text_color_set ( enum dw_color_e c )
+void text_color_apply ( enum dw_color_e c )
 {
 
 	if (g_enable_color == 0) {
@@ -341,6 +354,16 @@ void text_color_set ( enum dw_color_e c )
 #endif
 
 
+void text_color_set ( enum dw_color_e c )
+{
+	if (g_output_hook != NULL) {
+	  (*g_output_hook) ((int)c, NULL, 0);
+	  return;
+	}
+	text_color_apply (c);
+}
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        dw_printf 
@@ -375,6 +398,14 @@ int dw_printf (const char *fmt, ...)
 	len = vsnprintf (buffer, BSIZE, fmt, args);
 	va_end (args);
 
+	if (g_output_hook != NULL) {
+	  int n = len;
+	  if (n < 0) n = 0;
+	  if (n > BSIZE - 1) n = BSIZE - 1;	// Was truncated.
+	  (*g_output_hook) (-1, buffer, n);
+	  return (len);
+	}
+
 // TODO: other possible destinations...
 
 	fputs (buffer, stdout);
@@ -382,6 +413,12 @@ int dw_printf (const char *fmt, ...)
 }
 
 
+void text_output_apply (const char *text, int len)
+{
+	fwrite (text, 1, len, stdout);
+}
+
+
 
 #if TESTC
 main () 
@@ -27,6 +27,22 @@ void text_color_set (dw_color_t c);
 void text_color_term (void);
 
 
+/*
+ * textasync.c can take over the output so it is done by another thread.
+ * The hook is called with a color, and no text, for text_color_set,
+ * or a color of -1 and the text for dw_printf.
+ * The other thread then uses these to actually do it.
+ */
+
+typedef void (*text_output_fn_t) (int color, const char *text, int len);
+
+void text_output_hook (text_output_fn_t fn);
+
+void text_color_apply (dw_color_t c);
+
+void text_output_apply (const char *text, int len);
+
+
 /* Degree symbol. */
 
 #if __WIN32__
@@ -928,6 +928,96 @@ packet_t tq_peek (int chan, int prio)
 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        tq_peek_next
+ *
+ * Purpose:     Look further into a queue, beyond the head.
+ *
+ * Inputs:	chan	- Channel, 0 is first.
+ *
+ *		prio	- Priority, use TQ_PRIO_0_HI or TQ_PRIO_1_LO.
+ *
+ *		pp	- Previous packet from this queue, or NULL to start at the head.
+ *
+ * Returns:	The packet after pp, or NULL at the end of the queue.
+ *
+ *		Caller should NOT destroy it because it is still in the queue.
+ *
+ * Description:	This is for the transmit thread, which is the only one removing
+ *		frames, deciding which can be bundled into one transmission.
+ *		Other threads only append so pp remains valid.
+ *
+ *--------------------------------------------------------------------*/
+
+packet_t tq_peek_next (int chan, int prio, packet_t pp)
+{
+	packet_t result_p;
+
+	dw_mutex_lock (&tq_mutex);
+
+	if (pp == NULL) {
+	  result_p = queue_head[chan][prio];
+	}
+	else {
+	  result_p = ax25_get_nextp(pp);
+	}
+
+	dw_mutex_unlock (&tq_mutex);
+
+	return (result_p);
+
+} /* end tq_peek_next */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        tq_remove_packet
+ *
+ * Purpose:     Remove a specific packet from anywhere in the specified queue.
+ *
+ * Inputs:	chan	- Channel, 0 is first.
+ *
+ *		prio	- Priority, use TQ_PRIO_0_HI or TQ_PRIO_1_LO.
+ *
+ *		pp	- Packet, previously found with tq_peek or tq_peek_next.
+ *
+ * Returns:	1 if removed, 0 if not found.
+ *		Caller should destroy it with ax25_delete when finished with it.	
+ *
+ *--------------------------------------------------------------------*/
+
+int tq_remove_packet (int chan, int prio, packet_t pp)
+{
+	packet_t p;
+	packet_t prev = NULL;
+	int found = 0;
+
+	dw_mutex_lock (&tq_mutex);
+
+	for (p = queue_head[chan][prio]; p != NULL; prev = p, p = ax25_get_nextp(p)) {
+	  if (p == pp) {
+	    if (prev == NULL) {
+	      queue_head[chan][prio] = ax25_get_nextp(p);
+	    }
+	    else {
+	      ax25_set_nextp (prev, ax25_get_nextp(p));
+	    }
+	    ax25_set_nextp (p, NULL);
+	    found = 1;
+	    break;
+	  }
+	}
+
+	dw_mutex_unlock (&tq_mutex);
+
+	return (found);
+
+} /* end tq_remove_packet */
+
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        tq_is_empty
@@ -34,6 +34,10 @@ packet_t tq_remove (int chan, int prio);
 
 packet_t tq_peek (int chan, int prio);
 
+packet_t tq_peek_next (int chan, int prio, packet_t pp);
+
+int tq_remove_packet (int chan, int prio, packet_t pp);
+
 int tq_count (int chan, int prio, char *source, char *dest, int bytes);
 
 #endif
@@ -26,6 +26,19 @@
  * Module:      waypoint.c
  *
  * Purpose:   	Send NMEA waypoint sentences to GPS display or mapping application.
+ *
+ * Description:	In a busy area, there can be more than a 4800 baud serial
+ *		port can carry.  Writing directly from the receive thread
+ *		would then hold up everything else.
+ *
+ *		Instead, the sentences for each waypoint are put in a queue
+ *		for each destination and a separate thread writes them
+ *		no faster than the configured rate.  If a newer update for the
+ *		same station arrives while one is still waiting, it replaces
+ *		the older one rather than adding to the backlog.  Updates for
+ *		the same station are also spaced out by the hold time so a
+ *		frame heard directly and then again through a digipeater
+ *		results in only one.
  *		
  *---------------------------------------------------------------*/
 
@@ -51,7 +64,12 @@
 
 #include <assert.h>
 #include <string.h>
+#include <stddef.h>
 #include <time.h>
+#if __WIN32__
+#else
+#include <pthread.h>
+#endif
 
 
 #include "config.h"
@@ -63,6 +81,7 @@
 #include "dwgpsnmea.h"
 #include "serial_port.h"
 #include "dwsock.h"
+#include "dtime_now.h"
 
 
 static MYFDTYPE s_waypoint_serial_port_fd = MYFDERROR;
@@ -74,9 +93,57 @@ static int s_waypoint_formats = 0;	/* which formats should we generate? */
 static int s_waypoint_debug = 0;	/* Print information flowing to attached device. */
 
 
+/*
+ * Output queue for each destination.
+ */
+
+#define WPL_MAX_PENDING 100	/* Oldest is discarded when this many are waiting. */
+#define WPL_RECENT 128		/* Remember this many recently sent for hold time. */
+
+struct wpl_item_s {
+	struct wpl_item_s *next;
+	char key[12];		/* Waypoint name.  Empty for AIS, which is never combined. */
+	double not_before;	/* dtime_now() value when hold time for this station ends. */
+	int len;
+	char text[];		/* One or more sentences, each with CR LF. */
+};
+
+enum wpl_dest_e { WPL_DEST_SERIAL = 0, WPL_DEST_UDP, WPL_NUM_DEST };
+
+static struct wpl_dest_s {
+	int enabled;		/* Writer thread is running. */
+	int rate;		/* Bytes per second.  0 for no limit. */
+	int hold;		/* Seconds between updates for same station. */
+#if __WIN32__
+	HANDLE writer_th;
+	HANDLE wake_up_event;	/* Something was queued or time to stop. */
+#else
+	pthread_t writer_tid;
+	pthread_cond_t wake_up_cond;
+#endif
+	dw_mutex_t lock;	/* For everything below. */
+	int stop;		/* Set by waypoint_term. */
+	double next_send;	/* dtime_now() value when rate limit allows more. */
+	struct wpl_item_s *head;	/* In order of arrival. */
+	int count;
+	int dropped;
+	struct {
+	  char key[12];
+	  double when;
+	} recent[WPL_RECENT];
+	int recent_next;
+} s_dest[WPL_NUM_DEST];
+
+#if __WIN32__
+static unsigned __stdcall wpl_writer_thread (void *arg);
+#else
+static void * wpl_writer_thread (void *arg);
+#endif
+
 
 static void append_checksum (char *sentence);
-static void send_sentence (char *sent);
+static void add_sentence (char *batch, size_t batch_size, char *sent);
+static void wpl_queue (char *key, char *batch);
 
 
 
@@ -193,6 +260,44 @@ void waypoint_init (struct misc_config_s *mc)
 	  s_waypoint_formats |= WPL_FORMAT_NMEA_GENERIC;		/* See explanation below. */
 	}
 
+// Start a writer thread for each destination.
+
+	for (int d = 0; d < WPL_NUM_DEST; d++) {
+	  struct wpl_dest_s *dp = &(s_dest[d]);
+
+	  memset (dp, 0, sizeof(struct wpl_dest_s));
+	  if (d == WPL_DEST_SERIAL) {
+	    dp->enabled = s_waypoint_serial_port_fd != MYFDERROR;
+	    dp->rate = mc->waypoint_serial_rate;
+	    dp->hold = mc->waypoint_serial_hold;
+	  }
+	  else {
+	    dp->enabled = s_waypoint_udp_sock_fd != -1;
+	    dp->rate = mc->waypoint_udp_rate;
+	    dp->hold = mc->waypoint_udp_hold;
+	  }
+	  if ( ! dp->enabled) continue;
+
+	  dw_mutex_init (&(dp->lock));
+
+#if __WIN32__
+	  dp->wake_up_event = CreateEvent (NULL, 0, 0, NULL);		// Auto reset.
+	  dp->writer_th = (HANDLE)_beginthreadex (NULL, 0, wpl_writer_thread, (void*)(ptrdiff_t)d, 0, NULL);
+	  if (dp->writer_th == NULL) {
+	    text_color_set(DW_COLOR_ERROR);
+	    dw_printf ("Could not create waypoint output thread\n");
+	    dp->enabled = 0;
+	  }
+#else
+	  pthread_cond_init (&(dp->wake_up_cond), NULL);
+	  if (pthread_create (&(dp->writer_tid), NULL, wpl_writer_thread, (void*)(ptrdiff_t)d) != 0) {
+	    text_color_set(DW_COLOR_ERROR);
+	    perror("Could not create waypoint output thread");
+	    dp->enabled = 0;
+	  }
+#endif
+	}
+
 #if DEBUG
 	text_color_set (DW_COLOR_DEBUG);
 	dw_printf ("end of waypoint_init: s_waypoint_serial_port_fd = %d\n", s_waypoint_serial_port_fd);
@@ -292,6 +397,7 @@ void waypoint_send_sentence (char *name_in, double dlat, double dlong, char symt
 	char *p;
 
 	char sentence[500];
+	char batch[2100];	/* All sentences for this waypoint. */
 
 #if DEBUG
 	text_color_set (DW_COLOR_DEBUG);
@@ -318,6 +424,8 @@ void waypoint_send_sentence (char *name_in, double dlat, double dlong, char symt
  * Needs to be left intact for other icon/symbol conversions.
  */
 
+	strcpy (batch, "");
+
 	strlcpy (wname, name_in, sizeof(wname));
 	for (p=wname; *p != '\0'; p++) {
 	  if (*p == ',') *p = '|';
@@ -380,7 +488,7 @@ void waypoint_send_sentence (char *name_in, double dlat, double dlong, char symt
 
 	  snprintf (sentence, sizeof(sentence), "$GPWPL,%s,%s,%s,%s,%s", slat, slat_ns, slong, slong_ew, wname);
 	  append_checksum (sentence);
-	  send_sentence (sentence);
+	  add_sentence (batch, sizeof(batch), sentence);
 	}
 
 
@@ -425,7 +533,7 @@ void waypoint_send_sentence (char *name_in, double dlat, double dlong, char symt
 
 	  snprintf (sentence, sizeof(sentence), "$PGRMW,%s,%s,%04X,%s", wname, salt, grm_sym, wcomment);
 	  append_checksum (sentence);
-	  send_sentence (sentence);
+	  add_sentence (batch, sizeof(batch), sentence);
 	}
 
 
@@ -475,7 +583,7 @@ void waypoint_send_sentence (char *name_in, double dlat, double dlong, char symt
 	  snprintf (sentence, sizeof(sentence), "$PMGNWPL,%s,%s,%s,%s,%s,M,%s,%s,%s",
 			slat, slat_ns, slong, slong_ew, salt, wname, wcomment, sicon);
 	  append_checksum (sentence);
-	  send_sentence (sentence);
+	  add_sentence (batch, sizeof(batch), sentence);
 	}
 
 
@@ -600,7 +708,7 @@ void waypoint_send_sentence (char *name_in, double dlat, double dlong, char symt
 			stime, slat, slat_ns, slong, slong_ew, 
 			sspeed, scourse, sdate, salt, wname, symtab, ken_sym);
 	  append_checksum (sentence);
-	  send_sentence (sentence);
+	  add_sentence (batch, sizeof(batch), sentence);
 	}
 
 
@@ -631,6 +739,7 @@ void waypoint_send_sentence (char *name_in, double dlat, double dlong, char symt
  * 
  */
 
+	wpl_queue (wname, batch);
 
 } /* end waypoint_send_sentence */
 
@@ -655,46 +764,300 @@ void waypoint_send_ais (char *sentence)
 	}
 
 	if (s_waypoint_formats & WPL_FORMAT_AIS) {
-	  send_sentence (sentence);
+	  char batch[300];
+
+	  strcpy (batch, "");
+	  add_sentence (batch, sizeof(batch), sentence);
+	  wpl_queue ("", batch);
 	}
 }
 
 
 /*
- * Append CR LF and send it.
+ * Append CR LF and add to the sentences for one waypoint.
  */
 
-static void send_sentence (char *sent)
+static void add_sentence (char *batch, size_t batch_size, char *sent)
 {
-	char final[256];
+	strlcat (batch, sent, batch_size);
+	strlcat (batch, "\r\n", batch_size);
+}
 
-	if (s_waypoint_debug) {
-	  text_color_set(DW_COLOR_XMIT);
-	  dw_printf ("waypoint send sentence: \"%s\"\n", sent);
-	}
 
-	strlcpy (final, sent, sizeof(final));
-	strlcat (final, "\r\n", sizeof(final));
-	int final_len = strlen(final);
 
-	if (s_waypoint_serial_port_fd != MYFDERROR) {
-	  serial_port_write (s_waypoint_serial_port_fd, final, final_len);
+/*-------------------------------------------------------------------
+ *
+ * Name:        wpl_queue
+ *
+ * Purpose:     Put the sentences for one waypoint in the queue for each destination.
+ *
+ * Inputs:	key	- Waypoint name.  An update waiting for the same
+ *			  name is replaced.  Empty string to always add.
+ *		batch	- One or more sentences, each ending with CR LF.
+ *
+ * Description:	This only takes a moment so the receive thread is not held up.
+ *
+ *--------------------------------------------------------------------*/
+
+static void wpl_queue (char *key, char *batch)
+{
+	int len = strlen(batch);
+
+	if (len == 0) return;
+
+	for (int d = 0; d < WPL_NUM_DEST; d++) {
+	  struct wpl_dest_s *dp = &(s_dest[d]);
+
+	  if ( ! dp->enabled) continue;
+
+	  struct wpl_item_s *item = malloc (sizeof(struct wpl_item_s) + len + 1);
+	  if (item == NULL) continue;	// Others might still get it.
+	  item->next = NULL;
+	  strlcpy (item->key, key, sizeof(item->key));
+	  item->not_before = 0;
+	  item->len = len;
+	  memcpy (item->text, batch, len + 1);
+
+	  dw_mutex_lock (&(dp->lock));
+
+	  if (dp->stop) {		// waypoint_term got here first.
+	    dw_mutex_unlock (&(dp->lock));
+	    free (item);
+	    continue;
+	  }
+
+	  struct wpl_item_s **pp;
+	  int replaced = 0;
+
+	  if (strlen(key) > 0) {
+
+	    // Replace any waiting for the same station, keeping its place in line.
+
+	    for (pp = &(dp->head); *pp != NULL; pp = &((*pp)->next)) {
+	      if (strcmp((*pp)->key, key) == 0) {
+	        struct wpl_item_s *old = *pp;
+	        item->next = old->next;
+	        item->not_before = old->not_before;
+	        *pp = item;
+	        free (old);
+	        replaced = 1;
+	        break;
+	      }
+	    }
+
+	    // Otherwise, don't send until the hold time after the previous one.
+
+	    if ( ! replaced && dp->hold > 0) {
+	      for (int n = 0; n < WPL_RECENT; n++) {
+	        if (strcmp(dp->recent[n].key, key) == 0 && dp->recent[n].when + dp->hold > item->not_before) {
+	          item->not_before = dp->recent[n].when + dp->hold;
+	        }
+	      }
+	    }
+	  }
+
+	  if ( ! replaced) {
+	    if (dp->count >= WPL_MAX_PENDING) {
+	      struct wpl_item_s *old = dp->head;
+	      dp->head = old->next;
+	      free (old);
+	      dp->count--;
+	      dp->dropped++;
+	      if (dp->dropped == 1 || dp->dropped % 100 == 0) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Waypoint output to %s can't keep up.  %d discarded so far.\n",
+				d == WPL_DEST_SERIAL ? "serial port" : "UDP", dp->dropped);
+	      }
+	    }
+	    for (pp = &(dp->head); *pp != NULL; pp = &((*pp)->next)) {
+	      ;
+	    }
+	    *pp = item;
+	    dp->count++;
+	  }
+
+#if __WIN32__
+	  SetEvent (dp->wake_up_event);
+#else
+	  pthread_cond_signal (&(dp->wake_up_cond));
+#endif
+	  dw_mutex_unlock (&(dp->lock));
 	}
 
-	if (s_waypoint_udp_sock_fd != -1) {
-	  int n = sendto(s_waypoint_udp_sock_fd, final, final_len, 0, (struct sockaddr*)(&s_udp_dest_addr), sizeof(struct sockaddr_in));
-	  if (n != final_len) {
-	    text_color_set(DW_COLOR_ERROR);
-	    dw_printf ("Failed to send waypoint via UDP, errno=%d\n", errno);
+} /* end wpl_queue */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        wpl_writer_thread
+ *
+ * Purpose:     Send waiting sentences to one destination.
+ *
+ * Inputs:	arg	- Destination, WPL_DEST_SERIAL or WPL_DEST_UDP.
+ *
+ * Description:	Take the oldest one that is not being held.
+ *		After sending, wait long enough to stay within the rate limit.
+ *		Anything still in the queue can then be replaced by a newer update.
+ *
+ *		Each sentence goes in its own UDP datagram, as they did
+ *		before queuing, so a receiver sees one sentence per packet.
+ *
+ *--------------------------------------------------------------------*/
+
+#if __WIN32__
+static unsigned __stdcall wpl_writer_thread (void *arg)
+#else
+static void * wpl_writer_thread (void *arg)
+#endif
+{
+	int d = (int)(ptrdiff_t)arg;
+	struct wpl_dest_s *dp = &(s_dest[d]);
+
+	while (1) {
+
+	  struct wpl_item_s *item = NULL;
+	  struct wpl_item_s **pp;
+
+	  dw_mutex_lock (&(dp->lock));
+
+	  while ( ! dp->stop) {
+
+	    double now = dtime_now();
+	    double until = 0;		// Zero to wait until something is queued.
+
+	    if (now < dp->next_send) {
+	      until = dp->next_send;
+	    }
+	    else {
+	      for (pp = &(dp->head); *pp != NULL; pp = &((*pp)->next)) {
+	        if ((*pp)->not_before <= now) {
+	          item = *pp;
+	          *pp = item->next;
+	          dp->count--;
+	          if (strlen(item->key) > 0) {
+	            strlcpy (dp->recent[dp->recent_next].key, item->key, sizeof(dp->recent[0].key));
+	            dp->recent[dp->recent_next].when = now;
+	            dp->recent_next = (dp->recent_next + 1) % WPL_RECENT;
+	          }
+	          break;
+	        }
+	        if (until == 0 || (*pp)->not_before < until) {
+	          until = (*pp)->not_before;
+	        }
+	      }
+	      if (item != NULL) break;
+	    }
+
+// Sleep until the earliest time something could be sent or wpl_queue / waypoint_term wakes us.
+
+#if __WIN32__
+	    dw_mutex_unlock (&(dp->lock));
+	    WaitForSingleObject (dp->wake_up_event, until == 0 ? INFINITE : (DWORD)((until - now) * 1000) + 1);
+	    dw_mutex_lock (&(dp->lock));
+#else
+	    if (until == 0) {
+	      pthread_cond_wait (&(dp->wake_up_cond), &(dp->lock));
+	    }
+	    else {
+	      struct timespec abstime;
+	      abstime.tv_sec = (time_t)until;
+	      abstime.tv_nsec = (long)((until - (double)abstime.tv_sec) * 1000000000.);
+	      pthread_cond_timedwait (&(dp->wake_up_cond), &(dp->lock), &abstime);
+	    }
+#endif
+	  }
+
+	  if (item != NULL && dp->rate > 0) {
+	    dp->next_send = dtime_now() + (double)item->len / dp->rate;
 	  }
+
+	  dw_mutex_unlock (&(dp->lock));
+
+	  if (item == NULL) {
+	    break;		// Stopped by waypoint_term.
+	  }
+
+	  char *p, *e;
+	  for (p = item->text; (e = strstr(p, "\r\n")) != NULL; p = e + 2) {
+	    int len = (int)(e + 2 - p);
+
+	    if (s_waypoint_debug) {
+	      text_color_set(DW_COLOR_XMIT);
+	      dw_printf ("waypoint send sentence: \"%.*s\"\n", len - 2, p);
+	    }
+
+	    if (d == WPL_DEST_SERIAL) {
+	      serial_port_write (s_waypoint_serial_port_fd, p, len);
+	    }
+	    else {
+	      int n = sendto(s_waypoint_udp_sock_fd, p, len, 0, (struct sockaddr*)(&s_udp_dest_addr), sizeof(struct sockaddr_in));
+	      if (n != len) {
+	        text_color_set(DW_COLOR_ERROR);
+	        dw_printf ("Failed to send waypoint via UDP, errno=%d\n", errno);
+	      }
+	    }
+	  }
+
+	  free (item);
 	}
 
-} /* send_sentence */
+#if __WIN32__
+	return (0);
+#else
+	return (NULL);
+#endif
+
+} /* end wpl_writer_thread */
 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        waypoint_term
+ *
+ * Purpose:     Stop the writer threads and close the output devices.
+ *
+ * Description:	Anything still waiting in the queue is discarded.
+ *		The writers must be finished before the file descriptors
+ *		go away because they use them without any lock.
+ *
+ *--------------------------------------------------------------------*/
+
 void waypoint_term (void)
 {
+	for (int d = 0; d < WPL_NUM_DEST; d++) {
+	  struct wpl_dest_s *dp = &(s_dest[d]);
+
+	  if ( ! dp->enabled) continue;
+
+	  dw_mutex_lock (&(dp->lock));
+	  dp->enabled = 0;		// wpl_queue adds no more.
+	  dp->stop = 1;
+#if __WIN32__
+	  SetEvent (dp->wake_up_event);
+#else
+	  pthread_cond_signal (&(dp->wake_up_cond));
+#endif
+	  dw_mutex_unlock (&(dp->lock));
+
+#if __WIN32__
+	  WaitForSingleObject (dp->writer_th, INFINITE);
+	  CloseHandle (dp->writer_th);
+	  CloseHandle (dp->wake_up_event);
+#else
+	  pthread_join (dp->writer_tid, NULL);
+	  pthread_cond_destroy (&(dp->wake_up_cond));
+#endif
+
+	  while (dp->head != NULL) {
+	    struct wpl_item_s *old = dp->head;
+	    dp->head = old->next;
+	    free (old);
+	  }
+	  dp->count = 0;
+	}
+
 	if (s_waypoint_serial_port_fd != MYFDERROR) {
 	  //serial_port_close (s_waypoint_port_fd);
 	  s_waypoint_serial_port_fd = MYFDERROR;
@@ -77,6 +77,7 @@
 #include "xid.h"
 #include "dlq.h"
 #include "server.h"
+#include "evstream.h"
 
 
 /*
@@ -105,6 +106,9 @@ static int xmit_txtail[MAX_CHANS];	/* Amount of time to keep transmitting after
 
 static int xmit_fulldup[MAX_CHANS];	/* Full duplex if non-zero. */
 
+static int xmit_maxtxtime[MAX_CHANS];	/* Limit for bundling frames into one transmission. */
+					/* 10 mS units.  0 for no limit. */
+
 static int xmit_bits_per_sec[MAX_CHANS];	/* Data transmission rate. */
 					/* Often called baud rate which is equivalent for */
 					/* 1200 & 9600 cases but could be different with other */
@@ -171,10 +175,27 @@ static void * xmit_thread (void *arg);
 static dw_mutex_t audio_out_dev_mutex[MAX_ADEVS];
 
 
+/*
+ * Statistics for bundling frames into a transmission.
+ * Only the transmit thread for the channel updates them.
+ */
+
+static struct {
+	int keyups;		/* Number of transmissions from xmit_ax25_frames. */
+	int frames;		/* Number of frames in those transmissions. */
+	int max_frames;		/* Most frames in one transmission. */
+	int limited;		/* Number of transmissions where a frame was left */
+				/* for later because it would exceed MAXTXTIME. */
+	long saved_ms;		/* TXDELAY + TXTAIL we didn't need, because frames */
+				/* were bundled rather than sent separately. */
+} bundle_stats[MAX_CHANS];
+
+
 
 static int wait_for_clear_channel (int channel, int slotttime, int persist, int fulldup);
 static void xmit_ax25_frames (int c, int p, packet_t pp, int max_bundle);
 static int send_one_frame (int c, int p, packet_t pp);
+static packet_t pick_next_frame (int chan, int bits_used, int *prio, int *link_hold, int *limited);
 static void xmit_speech (int c, packet_t pp);
 static void xmit_morse (int c, packet_t pp, int wpm);
 static void xmit_dtmf (int c, packet_t pp, int speed);
@@ -254,6 +275,7 @@ void xmit_init (struct audio_s *p_modem, int debug_xmit_packet)
 	  xmit_txdelay[j] = p_modem->achan[j].txdelay;
 	  xmit_txtail[j] = p_modem->achan[j].txtail;
 	  xmit_fulldup[j] = p_modem->achan[j].fulldup;
+	  xmit_maxtxtime[j] = p_modem->achan[j].maxtxtime;
 	}
 
 #if DEBUG
@@ -720,6 +742,9 @@ static void * xmit_thread (void *arg)
  *
  * Version 1.5:	Add full duplex option.
  *
+ * Version 1.8:	Frames are no longer taken strictly from the head of the queues.
+ *		See pick_next_frame.  MAXTXTIME can limit the transmission length.
+ *
  *--------------------------------------------------------------------*/
 
 
@@ -805,68 +830,53 @@ static void xmit_ax25_frames (int chan, int prio, packet_t pp, int max_bundle)
 
 /*
  * See if we can bundle additional frames into this transmission.
+ * pick_next_frame decides which of the queued frames can go.
+ * It is called again after each one because the data link state
+ * machine could be adding more while we are transmitting.
  */
+	post_flags = MS_TO_BITS(xmit_txtail[chan] * 10, chan) / 8;
 
-	int done = 0;
-	while (numframe < max_bundle && ! done) {
-
-/*
- * Peek at what is available.
- * Don't remove from queue yet because it might not be eligible.
- */
-	  prio = TQ_PRIO_1_LO;
-	  pp = tq_peek (chan, TQ_PRIO_0_HI);
-	  if (pp != NULL) {
-	    prio = TQ_PRIO_0_HI;
-	  }
-	  else {
-	    pp = tq_peek (chan, TQ_PRIO_1_LO);
-	  }
-
-	  if (pp != NULL) {
-
-	    switch (frame_flavor(pp)) {
-
-	      case FLAVOR_SPEECH:
-	      case FLAVOR_MORSE:
-	      case FLAVOR_DTMF:
-	      case FLAVOR_APRS_DIGI:
-	      default:
-		done = 1;		// not eligible for bundling.
-	        break;
+	int link_hold = 0;
+	int limited = 0;
 
-	      case FLAVOR_APRS_NEW:
-	      case FLAVOR_OTHER:
+	while (numframe < max_bundle) {
 
-	        pp = tq_remove (chan, prio);
+	  pp = pick_next_frame (chan, num_bits + post_flags * 8, &prio, &link_hold, &limited);
+	  if (pp == NULL) {
+	    break;
+	  }
 #if DEBUG
-	        text_color_set(DW_COLOR_DEBUG);
-	        dw_printf ("xmit_thread: t=%.3f, tq_remove(chan=%d, prio=%d) returned %p\n", dtime_now()-time_ptt, chan, prio, pp);
+	  text_color_set(DW_COLOR_DEBUG);
+	  dw_printf ("xmit_thread: t=%.3f, pick_next_frame(chan=%d) returned %p, prio=%d\n", dtime_now()-time_ptt, chan, pp, prio);
 #endif
 
-	        nb = send_one_frame (chan, prio, pp);
+	  nb = send_one_frame (chan, prio, pp);
 
-	        num_bits += nb;
-	        if (nb > 0) numframe++;
+	  num_bits += nb;
+	  if (nb > 0) numframe++;
 #if DEBUG
-	        text_color_set(DW_COLOR_DEBUG);
-	        dw_printf ("xmit_thread: t=%.3f, nb=%d, num_bits=%d, numframe=%d\n", dtime_now()-time_ptt, nb, num_bits, numframe);
+	  text_color_set(DW_COLOR_DEBUG);
+	  dw_printf ("xmit_thread: t=%.3f, nb=%d, num_bits=%d, numframe=%d\n", dtime_now()-time_ptt, nb, num_bits, numframe);
 #endif
-	        ax25_delete (pp);
+	  ax25_delete (pp);
+	}
 
-	        break;
-	    }
-	  }
-	  else {
-	    done = 1;
-	  }
+	bundle_stats[chan].keyups++;
+	bundle_stats[chan].frames += numframe;
+	if (numframe > bundle_stats[chan].max_frames) {
+	  bundle_stats[chan].max_frames = numframe;
+	}
+	if (limited) {
+	  bundle_stats[chan].limited++;
+	}
+	if (numframe > 1) {
+	  bundle_stats[chan].saved_ms += (numframe - 1) * (xmit_txdelay[chan] + xmit_txtail[chan]) * 10;
 	}
 
 /* 
  * Need TXTAIL because we don't know exactly when the sound is done.
  */
 
-	post_flags = MS_TO_BITS(xmit_txtail[chan] * 10, chan) / 8;
 	nb = layer2_preamble_postamble (chan, post_flags, 1, save_audio_config_p);
 	num_bits += nb;
 #if DEBUG
@@ -939,6 +949,149 @@ static void xmit_ax25_frames (int chan, int prio, packet_t pp, int max_bundle)
 
 
 
+/*-------------------------------------------------------------------
+ *
+ * Name:        pick_next_frame
+ *
+ * Purpose:     Decide which queued frame, if any, should be added
+ *		to the current transmission.
+ *
+ * Inputs:	chan		- Channel number.
+ *
+ *		bits_used	- Bits in the transmission so far, including
+ *				  TXDELAY and the TXTAIL still to come.
+ *
+ * In/Out:	link_hold	- Set when a connected mode frame is passed over
+ *				  because it would not fit.
+ *
+ *		limited		- Set when any frame is passed over because it would
+ *				  not fit.
+ *
+ *		Both should be 0 at the start of each transmission.
+ *
+ * Outputs:	prio		- Priority of the frame.
+ *
+ * Returns:	Frame removed from the queue, or NULL if nothing more should
+ *		go in this transmission.
+ *
+ * Description:	Previously we took the frame at the head of the high, then low,
+ *		priority queue and stopped at the first one not eligible for
+ *		bundling.  Now we look at everything queued:
+ *
+ *		- Speech, Morse code, DTMF, and digipeated APRS still get their
+ *		  own transmissions.  One of those in the high priority queue
+ *		  ends the bundle so it goes out next.  In the low priority queue
+ *		  it is left for later and we keep looking past it.
+ *
+ *		- With MAXTXTIME, a frame which would make the transmission
+ *		  too long is left for the next one, but a smaller frame behind
+ *		  it might still fit.
+ *
+ *		- Connected mode frames (I, S, U other than UI) must stay in order,
+ *		  otherwise the other end would see out of sequence N(S) or N(R).
+ *		  Once one has been passed over, none of them are taken.
+ *		  UI frames, i.e. APRS, can go in any order.
+ *
+ *		The time is calculated from the actual encoded size, with
+ *		bit stuffing, FX.25, or IL2P, so it should be exact.
+ *
+ *--------------------------------------------------------------------*/
+
+static packet_t pick_next_frame (int chan, int bits_used, int *prio, int *link_hold, int *limited)
+{
+	int p;
+	packet_t pp;
+
+	for (p = TQ_PRIO_0_HI; p <= TQ_PRIO_1_LO; p++) {
+
+	  for (pp = tq_peek_next (chan, p, NULL); pp != NULL; pp = tq_peek_next (chan, p, pp)) {
+
+	    switch (frame_flavor(pp)) {
+
+	      case FLAVOR_SPEECH:
+	      case FLAVOR_MORSE:
+	      case FLAVOR_DTMF:
+	      case FLAVOR_APRS_DIGI:
+	      default:
+		if (p == TQ_PRIO_0_HI) {
+		  return (NULL);		// Must go next, by itself.
+		}
+	        continue;
+
+	      case FLAVOR_APRS_NEW:
+	      case FLAVOR_OTHER:
+	        break;
+	    }
+
+	    int is_ui = (ax25_get_control(pp) & 0xef) == 0x03;
+
+	    if ( ! is_ui && *link_hold) {
+	      continue;
+	    }
+
+	    if (xmit_maxtxtime[chan] > 0) {
+	      int nb = layer2_frame_bits (chan, pp, save_audio_config_p);
+
+	      if (BITS_TO_MS(bits_used + nb, chan) > xmit_maxtxtime[chan] * 10) {
+	        *limited = 1;
+	        if ( ! is_ui) {
+	          *link_hold = 1;
+	        }
+	        continue;
+	      }
+	    }
+
+	    if (tq_remove_packet (chan, p, pp)) {
+	      *prio = p;
+	      return (pp);
+	    }
+	    return (NULL);		// Shouldn't happen.
+	  }
+	}
+
+	return (NULL);
+
+} /* end pick_next_frame */
+
+
+
+/*-------------------------------------------------------------------
+ *
+ * Name:        xmit_print_stats
+ *
+ * Purpose:     Summarize how well frames were bundled into transmissions.
+ *
+ * Description:	Called when the application is shutting down.
+ *		Airtime saved is the TXDELAY and TXTAIL which would have been
+ *		needed if each frame had been sent separately.
+ *		It doesn't count the random wait before each transmission.
+ *
+ *--------------------------------------------------------------------*/
+
+void xmit_print_stats (void)
+{
+	int chan;
+
+	for (chan = 0; chan < MAX_CHANS; chan++) {
+
+	  if (bundle_stats[chan].keyups > 0) {
+	    text_color_set(DW_COLOR_INFO);
+	    dw_printf ("Channel %d: %d frames in %d transmissions, %.2f frames per transmission, max %d.  Airtime saved %.1f sec.",
+			chan, bundle_stats[chan].frames, bundle_stats[chan].keyups,
+			(double)(bundle_stats[chan].frames) / bundle_stats[chan].keyups,
+			bundle_stats[chan].max_frames,
+			bundle_stats[chan].saved_ms / 1000.);
+	    if (bundle_stats[chan].limited > 0) {
+	      dw_printf ("  %d limited by MAXTXTIME.", bundle_stats[chan].limited);
+	    }
+	    dw_printf ("\n");
+	  }
+	}
+
+} /* end xmit_print_stats */
+
+
+
 /*-------------------------------------------------------------------
  *
  * Name:        send_one_frame
@@ -1048,6 +1201,8 @@ static int send_one_frame (int c, int p, packet_t pp)
 
 	(void)ax25_check_addresses (pp);
 
+	evstream_xmit (c, p, pp);
+
 /* Optional hex dump of packet. */
 
 	if (g_debug_xmit_packet) {
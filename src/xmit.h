@@ -18,6 +18,8 @@ extern void xmit_set_txtail (int channel, int value);
 
 extern void xmit_set_fulldup (int channel, int value);
 
+extern void xmit_print_stats (void);
+
 
 extern int xmit_speak_it (char *script, int c, char *msg);
 